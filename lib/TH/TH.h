@@ -9,10 +9,12 @@
 #endif
 
 #include "THAtomic.h"
+#include "THThreadPool.h"
 #include "THVector.h"
 #include "THLogAdd.h"
 #include "THRandom.h"
 #include "THStorage.h"
+#include "THCachingAllocator.h"
 #include "THTensor.h"
 #include "THTensorApply.h"
 #include "THTensorDimApply.h"
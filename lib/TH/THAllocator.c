@@ -1,5 +1,9 @@
 #include "THAllocator.h"
+#if defined(USE_C11_ATOMICS)
+#include <stdatomic.h> /* ATOMIC_INT_LOCK_FREE, for TH_ATOMIC_IPC_REFCOUNT */
+#endif
 #include "THAtomic.h"
+#include "THOutOfCore.h"
 
 /* stuff for mapped files */
 #ifdef _WIN32
@@ -33,6 +37,18 @@ THAllocator THDefaultAllocator = {
   &THDefaultAllocator_free
 };
 
+static THAllocator *defaultStorageAllocator = &THDefaultAllocator;
+
+void THSetDefaultStorageAllocator(THAllocator *allocator)
+{
+  defaultStorageAllocator = (allocator ? allocator : &THDefaultAllocator);
+}
+
+THAllocator* THGetDefaultStorageAllocator(void)
+{
+  return defaultStorageAllocator;
+}
+
 #if defined(_WIN32) || defined(HAVE_MMAP)
 
 struct THMapAllocatorContext_ {
@@ -125,7 +141,7 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
 
     /* open file */
     /* FILE_FLAG_RANDOM_ACCESS ? */
-    if(ctx->flags)
+    if(ctx->flags && !(ctx->flags & TH_ALLOCATOR_MAPPED_READONLY))
     {
       hfile = CreateFileA(ctx->filename, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_WRITE|FILE_SHARE_READ, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
       if (hfile == INVALID_HANDLE_VALUE)
@@ -147,7 +163,7 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     {
       if(size > hfilesz.QuadPart)
       {
-        if(ctx->flags)
+        if(ctx->flags && !(ctx->flags & TH_ALLOCATOR_MAPPED_READONLY))
         {
           hfilesz.QuadPart = size;
           if(SetFilePointerEx(hfile, hfilesz, NULL, FILE_BEGIN) == 0)
@@ -176,7 +192,12 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     hfilesz.QuadPart = ctx->size;
 
     /* get map handle */
-    if(ctx->flags)
+    if(ctx->flags & TH_ALLOCATOR_MAPPED_READONLY)
+    {
+      if( (hmfile = CreateFileMapping(hfile, NULL, PAGE_READONLY, hfilesz.HighPart, hfilesz.LowPart, NULL)) == NULL )
+        THError("could not create a map on file <%s>; error code: <%d>", ctx->filename, GetLastError());
+    }
+    else if(ctx->flags)
     {
       if( (hmfile = CreateFileMapping(hfile, NULL, PAGE_READWRITE, hfilesz.HighPart, hfilesz.LowPart, NULL)) == NULL )
         THError("could not create a map on file <%s>; error code: <%d>", ctx->filename, GetLastError());
@@ -188,7 +209,9 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     }
 
     /* map the stuff */
-    if(ctx->flags)
+    if(ctx->flags & TH_ALLOCATOR_MAPPED_READONLY)
+      data = MapViewOfFile(hmfile, FILE_MAP_READ, 0, 0, 0);
+    else if(ctx->flags)
       data = MapViewOfFile(hmfile, FILE_MAP_ALL_ACCESS, 0, 0, 0);
     else
       data = MapViewOfFile(hmfile, FILE_MAP_COPY, 0, 0, 0);
@@ -248,7 +271,7 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     {
       if(size > file_stat.st_size)
       {
-        if(ctx->flags)
+        if(ctx->flags && !(ctx->flags & TH_ALLOCATOR_MAPPED_READONLY))
         {
           if(ftruncate(fd, size) == -1)
             THError("unable to resize file <%s> to the right size", ctx->filename);
@@ -281,7 +304,9 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
     ctx->size = size; /* if we are here, it must be the right size */
 
     /* map it */
-    if (ctx->flags & (TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_SHAREDMEM))
+    if (ctx->flags & TH_ALLOCATOR_MAPPED_READONLY)
+      data = mmap(NULL, ctx->size, PROT_READ, MAP_SHARED, fd, 0);
+    else if (ctx->flags & (TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_SHAREDMEM))
       data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
     else
       data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
@@ -316,6 +341,9 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
       data = NULL; /* let's be sure it is NULL */
       THError("$ Torch: unable to mmap memory: you tried to mmap %dGB.", ctx->size/1073741824);
     }
+    /* the pages of a writable private mapping hold its changes */
+    THOutOfCore_addMapping(data, ctx->size, (ctx->flags & (TH_ALLOCATOR_MAPPED_READONLY | TH_ALLOCATOR_MAPPED_SHARED
+                                                           | TH_ALLOCATOR_MAPPED_SHAREDMEM)) != 0);
   }
 #endif
 
@@ -343,6 +371,7 @@ static void THMapAllocator_free(void* ctx_, void* data) {
       THError("could not close file descriptor %d", ctx->fd);
   }
 
+  THOutOfCore_removeMapping(data);
   if (munmap(data, ctx->size))
     THError("could not unmap the shared memory file");
 
@@ -439,6 +468,7 @@ static void THRefcountedMapAllocator_free(void* ctx_, void* data) {
     THError("could not unlink the shared memory file %s, shm_unlink not available on platform", ctx->filename);
 #endif /* HAVE_SHM_UNLINK */
   }
+  THOutOfCore_removeMapping(info);
   if (munmap(info, ctx->size))
     THError("could not unmap the shared memory file %s", ctx->filename);
 #endif /* _WIN32 */
@@ -10,6 +10,7 @@
 #define TH_ALLOCATOR_MAPPED_KEEPFD 16
 #define TH_ALLOCATOR_MAPPED_FROMFD 32
 #define TH_ALLOCATOR_MAPPED_UNLINK 64
+#define TH_ALLOCATOR_MAPPED_READONLY 128 /* PROT_READ: writes fault */
 
 /* Custom allocator
  */
@@ -24,6 +25,13 @@ typedef struct THAllocator {
  */
 extern THAllocator THDefaultAllocator;
 
+/* allocator of the storages made by THStorage_(new) and newWithSize,
+ * THDefaultAllocator unless set (NULL sets it back); process-wide.
+ * A storage keeps the allocator it was made with: it can be changed anytime.
+ */
+TH_API void THSetDefaultStorageAllocator(THAllocator *allocator);
+TH_API THAllocator* THGetDefaultStorageAllocator(void);
+
 /* file map allocator
  */
 typedef struct THMapAllocatorContext_  THMapAllocatorContext;
@@ -0,0 +1,202 @@
+#include "THArena.h"
+#include "THAtomic.h"
+
+#ifndef TH_HAVE_THREAD
+#define __thread
+#elif _MSC_VER
+#define __thread __declspec( thread )
+#endif
+
+/* header of a chunk, followed by the blocks */
+typedef struct THArenaChunk
+{
+  struct THArenaChunk *next;
+} THArenaChunk;
+
+struct THArena
+{
+  char *cur; /* free space of the last chunk */
+  char *end;
+  THArenaChunk *chunks; /* last chunk first */
+  ptrdiff_t chunkSize;
+  ptrdiff_t size;
+  ptrdiff_t refcount; /* blocks not freed, plus one until closed */
+};
+
+/* just before each block: its arena, NULL for a block of the heap (made
+   when the arena is not current) */
+typedef struct THArenaHeader
+{
+  THArena *arena;
+  ptrdiff_t size; /* room of the block */
+} THArenaHeader;
+
+#define TH_ARENA_ALIGN 64
+#define TH_ARENA_HEADER(ptr) ((THArenaHeader*)(ptr) - 1)
+
+static __thread THArena *currentArena = NULL;
+static ptrdiff_t numEscaped = 0;
+
+THArena* THArena_new(ptrdiff_t chunkSize)
+{
+  THArena *arena = THAlloc(sizeof(THArena));
+  arena->cur = NULL;
+  arena->end = NULL;
+  arena->chunks = NULL;
+  arena->chunkSize = (chunkSize > 4096 ? chunkSize : 4096);
+  arena->size = 0;
+  arena->refcount = 1;
+  return arena;
+}
+
+static void THArena_release(THArena *arena)
+{
+  if(THAtomicAddPtrdiff(&arena->refcount, -1) == 1)
+  {
+    while(arena->chunks)
+    {
+      THArenaChunk *chunk = arena->chunks;
+      arena->chunks = chunk->next;
+      THFree(chunk);
+    }
+    THFree(arena);
+  }
+}
+
+void THArena_close(THArena *arena)
+{
+  if(arena == currentArena) /* never raise: closing runs in destructors */
+    currentArena = NULL;
+  if(THAtomicGetPtrdiff(&arena->refcount) > 1)
+    THAtomicAddPtrdiff(&numEscaped, 1);
+  THArena_release(arena);
+}
+
+ptrdiff_t THArena_live(THArena *arena)
+{
+  return THAtomicGetPtrdiff(&arena->refcount) - 1;
+}
+
+ptrdiff_t THArena_size(THArena *arena)
+{
+  return arena->size;
+}
+
+ptrdiff_t THArena_numEscaped(void)
+{
+  return THAtomicGetPtrdiff(&numEscaped);
+}
+
+THArena* THArena_setCurrent(THArena *arena)
+{
+  THArena *previous = currentArena;
+  currentArena = arena;
+  return previous;
+}
+
+THArena* THArena_current(void)
+{
+  return currentArena;
+}
+
+/* first block address after cur, leaving room for the header */
+static char* THArena_align(char *cur)
+{
+  return (char*)(((size_t)cur + sizeof(THArenaHeader) + TH_ARENA_ALIGN-1) & ~(size_t)(TH_ARENA_ALIGN-1));
+}
+
+void* THArena_alloc(THArena *arena, ptrdiff_t size)
+{
+  char *ptr = (arena->cur ? THArena_align(arena->cur) : NULL);
+
+  if(!ptr || size > arena->end - ptr)
+  {
+    ptrdiff_t chunkSize = sizeof(THArenaChunk) + sizeof(THArenaHeader) + TH_ARENA_ALIGN + size;
+    THArenaChunk *chunk;
+    if(chunkSize < arena->chunkSize)
+      chunkSize = arena->chunkSize;
+    chunk = THAlloc(chunkSize);
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->end = (char*)chunk + chunkSize;
+    arena->size += chunkSize;
+    ptr = THArena_align((char*)(chunk+1));
+  }
+
+  arena->cur = ptr + size;
+  TH_ARENA_HEADER(ptr)->arena = arena;
+  TH_ARENA_HEADER(ptr)->size = size;
+  THAtomicAddPtrdiff(&arena->refcount, 1);
+  return ptr;
+}
+
+void THArena_freeBlock(void *ptr)
+{
+  if(!ptr)
+    return;
+
+  if(TH_ARENA_HEADER(ptr)->arena)
+    THArena_release(TH_ARENA_HEADER(ptr)->arena);
+  else
+    THFree((char*)ptr - TH_ARENA_ALIGN);
+}
+
+static void *THArenaAllocator_alloc(void* ctx, ptrdiff_t size)
+{
+  char *ptr;
+
+  if(size < 0)
+    THError("$ Torch: invalid memory size -- maybe an overflow?");
+  if(size == 0)
+    return NULL;
+
+  if(ctx == currentArena)
+    return THArena_alloc(ctx, size);
+
+  /* on the heap, with the same header */
+  ptr = (char*)THAlloc(TH_ARENA_ALIGN + size) + TH_ARENA_ALIGN;
+  TH_ARENA_HEADER(ptr)->arena = NULL;
+  TH_ARENA_HEADER(ptr)->size = size;
+  return ptr;
+}
+
+static void THArenaAllocator_free(void* ctx, void* ptr)
+{
+  THArena_freeBlock(ptr);
+}
+
+static void *THArenaAllocator_realloc(void* ctx, void* ptr, ptrdiff_t size)
+{
+  THArena *arena = ctx;
+  void *newptr;
+
+  if(!ptr)
+    return THArenaAllocator_alloc(ctx, size);
+  if(size == 0)
+  {
+    THArena_freeBlock(ptr);
+    return NULL;
+  }
+  if(size <= TH_ARENA_HEADER(ptr)->size)
+    return ptr;
+
+  /* the last block of the current arena grows in place */
+  if(arena == currentArena && TH_ARENA_HEADER(ptr)->arena == arena
+     && (char*)ptr + TH_ARENA_HEADER(ptr)->size == arena->cur && size <= arena->end - (char*)ptr)
+  {
+    TH_ARENA_HEADER(ptr)->size = size;
+    arena->cur = (char*)ptr + size;
+    return ptr;
+  }
+
+  newptr = THArenaAllocator_alloc(ctx, size);
+  memcpy(newptr, ptr, TH_ARENA_HEADER(ptr)->size);
+  THArena_freeBlock(ptr);
+  return newptr;
+}
+
+THAllocator THArenaAllocator = {
+  &THArenaAllocator_alloc,
+  &THArenaAllocator_realloc,
+  &THArenaAllocator_free
+};
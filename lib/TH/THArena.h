@@ -0,0 +1,65 @@
+#ifndef TH_ARENA_INC
+#define TH_ARENA_INC
+
+#include "THAllocator.h"
+
+/******************************************************************************
+ * Bump allocation arena
+ *  Blocks are cut, in order, from chunks taken with THAlloc; freeing a block
+ *  only counts it. The chunks go back to the heap at once, when the arena is
+ *  closed and all its blocks are freed (whichever comes last): blocks which
+ *  outlive the closing of their arena (escaped) stay valid.
+ *  While an arena is the current arena of a thread, the tensors and storages
+ *  made by that thread (the structures, and the data of THStorage_(new) and
+ *  newWithSize) come from it. Blocks are only cut by the thread of which the
+ *  arena is current; storages resized anywhere else move to the heap.
+ ******************************************************************************/
+
+typedef struct THArena THArena;
+
+/*
+ * arena taking chunks of at least chunkSize bytes
+*/
+TH_API THArena* THArena_new(ptrdiff_t chunkSize);
+
+/*
+ * no more blocks: the arena is freed with its last block (now if none)
+ * if it is still the current arena of the calling thread, the thread is left
+ * with none; never raises an error
+*/
+TH_API void THArena_close(THArena *arena);
+
+/*
+ * blocks not freed yet
+*/
+TH_API ptrdiff_t THArena_live(THArena *arena);
+
+/*
+ * bytes taken from the heap
+*/
+TH_API ptrdiff_t THArena_size(THArena *arena);
+
+/*
+ * number of arenas closed while some of their blocks were not freed
+*/
+TH_API ptrdiff_t THArena_numEscaped(void);
+
+/*
+ * sets the current arena of the calling thread (NULL for none)
+ * returns the previous one
+*/
+TH_API THArena* THArena_setCurrent(THArena *arena);
+TH_API THArena* THArena_current(void);
+
+/*
+ * block of size bytes from arena (aligned on 64 bytes), which must be the
+ * current arena; freed with THArena_freeBlock
+*/
+TH_API void* THArena_alloc(THArena *arena, ptrdiff_t size);
+TH_API void THArena_freeBlock(void *ptr);
+
+/* allocator on the arena given as context (see above for the other threads)
+ */
+extern THAllocator THArenaAllocator;
+
+#endif
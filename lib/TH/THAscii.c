@@ -0,0 +1,827 @@
+#if defined(HAVE_STRTOD_L) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* strtod_l, strtof_l */
+#endif
+#include "THAscii.h"
+#include "THAtomic.h"
+#include "THThreadPool.h"
+
+#include <float.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "THAsciiTables.h"
+
+/* elements formatted at a time by a thread of THAscii_write* */
+#define TH_ASCII_CHUNK 4096
+
+#define THAscii_isSpace(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+#define THAscii_isDigit(c) ((unsigned)((c) - '0') < 10)
+
+static const char THAscii_digits[200] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const double THAscii_pow10[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/******************************************************************************
+ * Shortest digits (Ryu, U. Adams, PLDI 2018)
+ *  The value is m*2^e; the reals which round to it are in an interval
+ *  [(4m-1-s)*2^(e-2), (4m+2)*2^(e-2)]. The bounds and the value are scaled to
+ *  decimal with the 125 high bits of 5^q or 2^k/5^q (the tables), digits are
+ *  removed while the bounds differ, and the last one is rounded.
+ ******************************************************************************/
+
+static inline int32_t THAscii_pow5bits(int32_t e)
+{
+  return ((e * 1217359) >> 19) + 1; /* ceil(log2(5^e)), e > 0 */
+}
+
+static inline int32_t THAscii_log10Pow2(int32_t e)
+{
+  return (e * 78913) >> 18;
+}
+
+static inline int32_t THAscii_log10Pow5(int32_t e)
+{
+  return (e * 732923) >> 20;
+}
+
+static inline uint32_t THAscii_pow5Factor(uint64_t value)
+{
+  uint32_t count = 0;
+  while(value % 5 == 0)
+  {
+    value /= 5;
+    count++;
+  }
+  return count;
+}
+
+static inline int THAscii_multipleOfPowerOf5(uint64_t value, uint32_t p)
+{
+  return THAscii_pow5Factor(value) >= p;
+}
+
+static inline int THAscii_multipleOfPowerOf2(uint64_t value, uint32_t p)
+{
+  return (value & ((1ull << p) - 1)) == 0;
+}
+
+static inline uint64_t THAscii_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 p = (unsigned __int128)a * b;
+  *high = (uint64_t)(p >> 64);
+  return (uint64_t)p;
+#else
+  uint64_t aLo = (uint32_t)a, aHi = a >> 32, bLo = (uint32_t)b, bHi = b >> 32;
+  uint64_t b00 = aLo * bLo, b01 = aLo * bHi, b10 = aHi * bLo, b11 = aHi * bHi;
+  uint64_t mid1 = b10 + (b00 >> 32);
+  uint64_t mid2 = b01 + (uint32_t)mid1;
+  *high = b11 + (mid1 >> 32) + (mid2 >> 32);
+  return (mid2 << 32) | (uint32_t)b00;
+#endif
+}
+
+/* (m * mul) >> j, mul being 128 bits (low, high), 64 < j < 128 */
+static inline uint64_t THAscii_mulShift64(uint64_t m, const uint64_t *mul, int32_t j)
+{
+  uint64_t high0, high1, low1, sum;
+  THAscii_umul128(m, mul[0], &high0);
+  low1 = THAscii_umul128(m, mul[1], &high1);
+  sum = high0 + low1;
+  if(sum < high0)
+    high1++;
+  return (high1 << (128 - j)) | (sum >> (j - 64));
+}
+
+/* (m * factor) >> shift, 32 < shift */
+static inline uint32_t THAscii_mulShift32(uint32_t m, uint64_t factor, int32_t shift)
+{
+  uint64_t bits0 = (uint64_t)m * (uint32_t)factor;
+  uint64_t bits1 = (uint64_t)m * (factor >> 32);
+  return (uint32_t)(((bits0 >> 32) + bits1) >> (shift - 32));
+}
+
+/* digits*10^exponent: the shortest decimal which rounds to the double of
+   these bits (not zero, finite) */
+static void THAscii_shortestDouble(uint64_t ieeeMantissa, uint32_t ieeeExponent, uint64_t *digits, int32_t *exponent)
+{
+  int32_t e2, e10, removed = 0;
+  uint64_t m2, mv, vr, vp, vm, output;
+  uint32_t mmShift;
+  int acceptBounds, vmIsTrailingZeros = 0, vrIsTrailingZeros = 0;
+  int lastRemovedDigit = 0;
+
+  if(ieeeExponent == 0)
+  {
+    e2 = 1 - 1023 - 52 - 2;
+    m2 = ieeeMantissa;
+  }
+  else
+  {
+    e2 = (int32_t)ieeeExponent - 1023 - 52 - 2;
+    m2 = (1ull << 52) | ieeeMantissa;
+  }
+  acceptBounds = (m2 & 1) == 0; /* ties to even: the bounds round to this value */
+  mv = 4 * m2;
+  mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1); /* the lower gap is half the upper one at powers of 2 */
+
+  if(e2 >= 0)
+  {
+    int32_t q = THAscii_log10Pow2(e2) - (e2 > 3);
+    int32_t i = -e2 + q + 125 + THAscii_pow5bits(q) - 1;
+    e10 = q;
+    vr = THAscii_mulShift64(mv, THAscii_pow5Inv[q], i);
+    vp = THAscii_mulShift64(mv + 2, THAscii_pow5Inv[q], i);
+    vm = THAscii_mulShift64(mv - 1 - mmShift, THAscii_pow5Inv[q], i);
+    if(q <= 21)
+    {
+      /* only one of mv, mv-1-mmShift and mv+2 can be a multiple of 5 */
+      if(mv % 5 == 0)
+        vrIsTrailingZeros = THAscii_multipleOfPowerOf5(mv, q);
+      else if(acceptBounds)
+        vmIsTrailingZeros = THAscii_multipleOfPowerOf5(mv - 1 - mmShift, q);
+      else
+        vp -= THAscii_multipleOfPowerOf5(mv + 2, q);
+    }
+  }
+  else
+  {
+    int32_t q = THAscii_log10Pow5(-e2) - (-e2 > 1);
+    int32_t i = -e2 - q;
+    int32_t j = q - (THAscii_pow5bits(i) - 125);
+    e10 = q + e2;
+    vr = THAscii_mulShift64(mv, THAscii_pow5[i], j);
+    vp = THAscii_mulShift64(mv + 2, THAscii_pow5[i], j);
+    vm = THAscii_mulShift64(mv - 1 - mmShift, THAscii_pow5[i], j);
+    if(q <= 1)
+    {
+      /* mv has at least q trailing zero bits, so {vr,vp,vm} are exact */
+      vrIsTrailingZeros = 1;
+      if(acceptBounds)
+        vmIsTrailingZeros = (mmShift == 1);
+      else
+        vp--;
+    }
+    else if(q < 63)
+      vrIsTrailingZeros = THAscii_multipleOfPowerOf2(mv, q);
+  }
+
+  if(vmIsTrailingZeros || vrIsTrailingZeros)
+  {
+    /* rare: the bounds or the value may be exact decimals */
+    while(vp / 10 > vm / 10)
+    {
+      vmIsTrailingZeros &= (vm % 10 == 0);
+      vrIsTrailingZeros &= (lastRemovedDigit == 0);
+      lastRemovedDigit = (int)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    if(vmIsTrailingZeros)
+    {
+      while(vm % 10 == 0)
+      {
+        vrIsTrailingZeros &= (lastRemovedDigit == 0);
+        lastRemovedDigit = (int)(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        removed++;
+      }
+    }
+    if(vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+      lastRemovedDigit = 4; /* exactly half way: round to even */
+    output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+  }
+  else
+  {
+    while(vp / 10 > vm / 10)
+    {
+      lastRemovedDigit = (int)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    output = vr + (vr == vm || lastRemovedDigit >= 5);
+  }
+
+  *digits = output;
+  *exponent = e10 + removed;
+}
+
+/* the same for floats, in 32 bits, with the high words of the tables */
+static void THAscii_shortestFloat(uint32_t ieeeMantissa, uint32_t ieeeExponent, uint64_t *digits, int32_t *exponent)
+{
+  int32_t e2, e10, removed = 0;
+  uint32_t m2, mv, mp, mm, vr, vp, vm, output;
+  uint32_t mmShift;
+  int acceptBounds, vmIsTrailingZeros = 0, vrIsTrailingZeros = 0;
+  int lastRemovedDigit = 0;
+
+  if(ieeeExponent == 0)
+  {
+    e2 = 1 - 127 - 23 - 2;
+    m2 = ieeeMantissa;
+  }
+  else
+  {
+    e2 = (int32_t)ieeeExponent - 127 - 23 - 2;
+    m2 = (1u << 23) | ieeeMantissa;
+  }
+  acceptBounds = (m2 & 1) == 0;
+  mv = 4 * m2;
+  mp = 4 * m2 + 2;
+  mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1);
+  mm = 4 * m2 - 1 - mmShift;
+
+  if(e2 >= 0)
+  {
+    int32_t q = THAscii_log10Pow2(e2);
+    int32_t i = -e2 + q + 61 + THAscii_pow5bits(q) - 1;
+    uint64_t factor = THAscii_pow5Inv[q][1] + 1;
+    e10 = q;
+    vr = THAscii_mulShift32(mv, factor, i);
+    vp = THAscii_mulShift32(mp, factor, i);
+    vm = THAscii_mulShift32(mm, factor, i);
+    if(q != 0 && (vp - 1) / 10 <= vm / 10)
+    {
+      /* no digit removed below: the last one removed by the scaling */
+      int32_t l = 61 + THAscii_pow5bits(q - 1) - 1;
+      lastRemovedDigit = (int)(THAscii_mulShift32(mv, THAscii_pow5Inv[q - 1][1] + 1, -e2 + q - 1 + l) % 10);
+    }
+    if(q <= 9)
+    {
+      if(mv % 5 == 0)
+        vrIsTrailingZeros = THAscii_multipleOfPowerOf5(mv, q);
+      else if(acceptBounds)
+        vmIsTrailingZeros = THAscii_multipleOfPowerOf5(mm, q);
+      else
+        vp -= THAscii_multipleOfPowerOf5(mp, q);
+    }
+  }
+  else
+  {
+    int32_t q = THAscii_log10Pow5(-e2);
+    int32_t i = -e2 - q;
+    int32_t j = q - (THAscii_pow5bits(i) - 61);
+    e10 = q + e2;
+    vr = THAscii_mulShift32(mv, THAscii_pow5[i][1], j);
+    vp = THAscii_mulShift32(mp, THAscii_pow5[i][1], j);
+    vm = THAscii_mulShift32(mm, THAscii_pow5[i][1], j);
+    if(q != 0 && (vp - 1) / 10 <= vm / 10)
+    {
+      j = q - 1 - (THAscii_pow5bits(i + 1) - 61);
+      lastRemovedDigit = (int)(THAscii_mulShift32(mv, THAscii_pow5[i + 1][1], j) % 10);
+    }
+    if(q <= 1)
+    {
+      vrIsTrailingZeros = 1;
+      if(acceptBounds)
+        vmIsTrailingZeros = (mmShift == 1);
+      else
+        vp--;
+    }
+    else if(q < 31)
+      vrIsTrailingZeros = THAscii_multipleOfPowerOf2(mv, q - 1);
+  }
+
+  if(vmIsTrailingZeros || vrIsTrailingZeros)
+  {
+    while(vp / 10 > vm / 10)
+    {
+      vmIsTrailingZeros &= (vm % 10 == 0);
+      vrIsTrailingZeros &= (lastRemovedDigit == 0);
+      lastRemovedDigit = (int)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    if(vmIsTrailingZeros)
+    {
+      while(vm % 10 == 0)
+      {
+        vrIsTrailingZeros &= (lastRemovedDigit == 0);
+        lastRemovedDigit = (int)(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        removed++;
+      }
+    }
+    if(vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+      lastRemovedDigit = 4;
+    output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+  }
+  else
+  {
+    while(vp / 10 > vm / 10)
+    {
+      lastRemovedDigit = (int)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      removed++;
+    }
+    output = vr + (vr == vm || lastRemovedDigit >= 5);
+  }
+
+  *digits = output;
+  *exponent = e10 + removed;
+}
+
+/******************************************************************************
+ * Formatting
+ ******************************************************************************/
+
+/* the decimal digits of value at the end of str[0..length) */
+static inline void THAscii_writeDigits(char *str, int length, uint64_t value)
+{
+  while(value >= 100)
+  {
+    length -= 2;
+    memcpy(str + length, THAscii_digits + 2 * (value % 100), 2);
+    value /= 100;
+  }
+  if(value >= 10)
+    memcpy(str + length - 2, THAscii_digits + 2 * value, 2);
+  else
+    str[length - 1] = (char)('0' + value);
+}
+
+static inline int THAscii_decimalLength(uint64_t value)
+{
+  int length = 1;
+  while(value >= 10000)
+  {
+    value /= 10000;
+    length += 4;
+  }
+  return length + (value >= 10) + (value >= 100) + (value >= 1000);
+}
+
+/* digits*10^exponent as %g would (without trailing zeros), scientific when
+   the exponent is below -4 or from precision on */
+static int THAscii_print(char *str, int negative, uint64_t digits, int32_t exponent, int precision)
+{
+  char d[20];
+  char *p = str;
+  int length = THAscii_decimalLength(digits);
+  int e = exponent + length - 1;
+
+  THAscii_writeDigits(d, length, digits);
+  if(negative)
+    *p++ = '-';
+  if(e < -4 || e >= precision)
+  {
+    *p++ = d[0];
+    if(length > 1)
+    {
+      *p++ = '.';
+      memcpy(p, d + 1, length - 1);
+      p += length - 1;
+    }
+    *p++ = 'e';
+    *p++ = (e < 0 ? '-' : '+');
+    if(e < 0)
+      e = -e;
+    if(e >= 100)
+    {
+      *p++ = (char)('0' + e / 100);
+      e %= 100;
+    }
+    memcpy(p, THAscii_digits + 2 * e, 2);
+    p += 2;
+  }
+  else if(e < 0)
+  {
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -e - 1);
+    p += -e - 1;
+    memcpy(p, d, length);
+    p += length;
+  }
+  else if(length <= e + 1)
+  {
+    memcpy(p, d, length);
+    p += length;
+    memset(p, '0', e + 1 - length);
+    p += e + 1 - length;
+  }
+  else
+  {
+    memcpy(p, d, e + 1);
+    p += e + 1;
+    *p++ = '.';
+    memcpy(p, d + e + 1, length - e - 1);
+    p += length - e - 1;
+  }
+  *p = '\0';
+  return (int)(p - str);
+}
+
+/* zeros, infinities and nans, as glibc prints them */
+static int THAscii_printSpecial(char *str, int negative, int isZero, int isNan)
+{
+  char *p = str;
+  if(negative)
+    *p++ = '-';
+  if(isZero)
+    *p++ = '0';
+  else
+  {
+    memcpy(p, (isNan ? "nan" : "inf"), 3);
+    p += 3;
+  }
+  *p = '\0';
+  return (int)(p - str);
+}
+
+int THAscii_formatDouble(char *str, double x)
+{
+  uint64_t bits, mantissa, digits;
+  uint32_t exponent;
+  int32_t e10;
+  int negative;
+
+  memcpy(&bits, &x, sizeof(double));
+  negative = (int)(bits >> 63);
+  mantissa = bits & ((1ull << 52) - 1);
+  exponent = (uint32_t)((bits >> 52) & 0x7ff);
+  if(exponent == 0x7ff || (exponent == 0 && mantissa == 0))
+    return THAscii_printSpecial(str, negative, exponent == 0, mantissa != 0);
+  THAscii_shortestDouble(mantissa, exponent, &digits, &e10);
+  return THAscii_print(str, negative, digits, e10, 17);
+}
+
+int THAscii_formatFloat(char *str, float x)
+{
+  uint32_t bits, mantissa, exponent;
+  uint64_t digits;
+  int32_t e10;
+  int negative;
+
+  memcpy(&bits, &x, sizeof(float));
+  negative = (int)(bits >> 31);
+  mantissa = bits & ((1u << 23) - 1);
+  exponent = (bits >> 23) & 0xff;
+  if(exponent == 0xff || (exponent == 0 && mantissa == 0))
+    return THAscii_printSpecial(str, negative, exponent == 0, mantissa != 0);
+  THAscii_shortestFloat(mantissa, exponent, &digits, &e10);
+  return THAscii_print(str, negative, digits, e10, 9);
+}
+
+int THAscii_formatLong(char *str, long x)
+{
+  unsigned long value = (unsigned long)x;
+  int negative = (x < 0), length;
+  if(negative)
+  {
+    *str++ = '-';
+    value = 0UL - value;
+  }
+  length = THAscii_decimalLength(value);
+  THAscii_writeDigits(str, length, value);
+  str[length] = '\0';
+  return negative + length;
+}
+
+/******************************************************************************
+ * Parsing
+ ******************************************************************************/
+
+/* strtod and strtof in the C locale, whatever setlocale was given: the
+   decimal point is always '.' */
+#if defined(_MSC_VER)
+#include <locale.h>
+typedef _locale_t THAsciiLocale;
+#define THAscii_newCLocale() _create_locale(LC_ALL, "C")
+#define THAscii_freeLocale _free_locale
+#define THAscii_strtodLocale _strtod_l
+#define THAscii_strtofLocale _strtof_l
+#elif defined(HAVE_STRTOD_L)
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+typedef locale_t THAsciiLocale;
+#define THAscii_newCLocale() newlocale(LC_ALL_MASK, "C", (locale_t)0)
+#define THAscii_freeLocale freelocale
+#define THAscii_strtodLocale strtod_l
+#define THAscii_strtofLocale strtof_l
+#endif
+
+#ifdef THAscii_strtodLocale
+/* made by the first parse which needs it, never freed */
+static ptrdiff_t volatile THAscii_locale = 0;
+
+static THAsciiLocale THAscii_cLocale(void)
+{
+  ptrdiff_t locale = THAtomicGetPtrdiff(&THAscii_locale);
+  if(!locale)
+  {
+    THAsciiLocale made = THAscii_newCLocale();
+    if(made && THAtomicCompareAndSwapPtrdiff(&THAscii_locale, 0, (ptrdiff_t)made))
+      return made;
+    if(made)
+      THAscii_freeLocale(made);
+    locale = THAtomicGetPtrdiff(&THAscii_locale);
+  }
+  return (THAsciiLocale)locale;
+}
+
+static double THAscii_strtod(const char *str, char **end)
+{
+  THAsciiLocale locale = THAscii_cLocale();
+  return (locale ? THAscii_strtodLocale(str, end, locale) : strtod(str, end));
+}
+
+static float THAscii_strtof(const char *str, char **end)
+{
+  THAsciiLocale locale = THAscii_cLocale();
+  return (locale ? THAscii_strtofLocale(str, end, locale) : strtof(str, end));
+}
+#else
+#define THAscii_strtod strtod
+#define THAscii_strtof strtof
+#endif
+
+/* a decimal of at most 19 significant digits, as mantissa*10^exponent; 0 for
+   anything else (left to strtod: longer decimals, hexadecimals, infinities,
+   nans, or no number) */
+static int THAscii_parseDecimal(const char *str, const char **end, int *negative, uint64_t *mantissa, int *exponent)
+{
+  const char *p = str;
+  uint64_t m = 0;
+  int e = 0, nd = 0, any = 0;
+
+  while(THAscii_isSpace(*p))
+    p++;
+  *negative = (*p == '-');
+  if(*p == '-' || *p == '+')
+    p++;
+  if(p[0] == '0' && (p[1] | 32) == 'x')
+    return 0;
+
+  while(*p == '0')
+  {
+    p++;
+    any = 1;
+  }
+  for(; THAscii_isDigit(*p); p++, nd++, any = 1)
+  {
+    if(nd == 19)
+      return 0;
+    m = 10 * m + (*p - '0');
+  }
+  if(*p == '.')
+  {
+    p++;
+    if(nd == 0)
+    {
+      for(; *p == '0'; p++, e--)
+        any = 1;
+    }
+    for(; THAscii_isDigit(*p); p++, nd++, e--, any = 1)
+    {
+      if(nd == 19)
+        return 0;
+      m = 10 * m + (*p - '0');
+    }
+  }
+  if(!any)
+    return 0;
+
+  if((*p | 32) == 'e')
+  {
+    const char *q = p + 1;
+    int negativeExponent = (*q == '-'), value = 0;
+    if(*q == '-' || *q == '+')
+      q++;
+    if(THAscii_isDigit(*q))
+    {
+      for(; THAscii_isDigit(*q); q++)
+      {
+        if(value < 100000)
+          value = 10 * value + (*q - '0');
+      }
+      e += (negativeExponent ? -value : value);
+      p = q;
+    }
+  }
+
+  *end = p;
+  *mantissa = m;
+  *exponent = e;
+  return 1;
+}
+
+/* mantissa*10^exponent, exact or correctly rounded, 1 if the operands are
+   exact doubles (Clinger's fast path) */
+static inline int THAscii_fastPath(uint64_t mantissa, int exponent, double *x)
+{
+  if(mantissa == 0)
+  {
+    *x = 0;
+    return 1;
+  }
+  if(mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+    return 0;
+  *x = (exponent < 0 ? (double)mantissa / THAscii_pow10[-exponent] : (double)mantissa * THAscii_pow10[exponent]);
+  return 1;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+#if LDBL_MANT_DIG == 64
+#define TH_ASCII_EXTENDED
+#endif
+#endif
+
+#ifdef TH_ASCII_EXTENDED
+/* the same in the 64 bits of the x87 long doubles, for the decimals of 17 to
+   19 digits: the double is the rounding of the long double, unless this one
+   lies half way between two doubles */
+static inline int THAscii_extendedPath(uint64_t mantissa, int exponent, double *x)
+{
+  static const long double pow10[28] = {
+    1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+    1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+  };
+  long double y;
+  uint64_t bits;
+  if(exponent < -27 || exponent > 27)
+    return 0;
+  y = (exponent < 0 ? (long double)mantissa / pow10[-exponent] : (long double)mantissa * pow10[exponent]);
+  memcpy(&bits, &y, sizeof(uint64_t)); /* the significand */
+  if((bits & 0x7ff) == 0x400)
+    return 0;
+  *x = (double)y;
+  return 1;
+}
+#endif
+
+double THAscii_parseDouble(const char *str, char **end)
+{
+  const char *p;
+  uint64_t mantissa;
+  int negative, exponent;
+  double x;
+
+  if(THAscii_parseDecimal(str, &p, &negative, &mantissa, &exponent)
+     && (THAscii_fastPath(mantissa, exponent, &x)
+#ifdef TH_ASCII_EXTENDED
+         || THAscii_extendedPath(mantissa, exponent, &x)
+#endif
+       ))
+  {
+    if(end)
+      *end = (char*)p;
+    return (negative ? -x : x);
+  }
+  return THAscii_strtod(str, end);
+}
+
+float THAscii_parseFloat(const char *str, char **end)
+{
+  const char *p;
+  uint64_t mantissa, bits;
+  int negative, exponent;
+  double x;
+
+  if(THAscii_parseDecimal(str, &p, &negative, &mantissa, &exponent) && THAscii_fastPath(mantissa, exponent, &x))
+  {
+    /* the double rounds to the float of the decimal, unless it lies half
+       way between two floats (or out of the normal floats) */
+    memcpy(&bits, &x, sizeof(double));
+    if(x == 0 || (x >= FLT_MIN && x <= FLT_MAX && (bits & ((1ull << 29) - 1)) != (1ull << 28)))
+    {
+      if(end)
+        *end = (char*)p;
+      return (float)(negative ? -x : x);
+    }
+  }
+  return THAscii_strtof(str, end);
+}
+
+long THAscii_parseLong(const char *str, char **end)
+{
+  const char *p = str;
+  unsigned long value = 0, limit;
+  int negative, overflow = 0;
+
+  while(THAscii_isSpace(*p))
+    p++;
+  negative = (*p == '-');
+  if(*p == '-' || *p == '+')
+    p++;
+  if(!THAscii_isDigit(*p))
+  {
+    if(end)
+      *end = (char*)str;
+    return 0;
+  }
+  limit = (negative ? 0UL - (unsigned long)LONG_MIN : (unsigned long)LONG_MAX);
+  for(; THAscii_isDigit(*p); p++)
+  {
+    unsigned long digit = (unsigned long)(*p - '0');
+    if(value > (limit - digit) / 10)
+      overflow = 1;
+    else
+      value = 10 * value + digit;
+  }
+  if(end)
+    *end = (char*)p;
+  if(overflow)
+    return (negative ? LONG_MIN : LONG_MAX);
+  return (negative ? (long)(0UL - value) : (long)value);
+}
+
+/******************************************************************************
+ * Arrays
+ *  In chunks of TH_ASCII_CHUNK elements, each written at its own place
+ *  (TH_ASCII_SIZE bytes per element) then moved after the previous one.
+ ******************************************************************************/
+
+typedef struct THAsciiJob
+{
+  char *str;
+  const void *data;
+  size_t n;
+  int spacing;
+  size_t *lengths; /* of the chunks */
+} THAsciiJob;
+
+#define TH_ASCII_WRITE(TYPE, TYPEC, FORMAT)                             \
+  static size_t THAscii_write##TYPEC##Chunk(char *str, const TYPE *data, size_t n, int spacing) \
+  {                                                                     \
+    char *p = str;                                                      \
+    size_t i;                                                           \
+    for(i = 0; i < n; i++)                                              \
+    {                                                                   \
+      p += FORMAT(p, data[i]);                                          \
+      if(spacing)                                                       \
+        *p++ = ' ';                                                     \
+    }                                                                   \
+    return (size_t)(p - str);                                           \
+  }                                                                     \
+                                                                        \
+  static void THAscii_write##TYPEC##Job(void *data, ptrdiff_t begin, ptrdiff_t end) \
+  {                                                                     \
+    THAsciiJob *job = (THAsciiJob*)data;                                \
+    ptrdiff_t c;                                                        \
+    for(c = begin; c < end; c++)                                        \
+    {                                                                   \
+      size_t first = (size_t)c * TH_ASCII_CHUNK;                        \
+      job->lengths[c] = THAscii_write##TYPEC##Chunk(job->str + first * TH_ASCII_SIZE, (const TYPE*)job->data + first, \
+                                                    THMin(TH_ASCII_CHUNK, job->n - first), job->spacing); \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  size_t THAscii_write##TYPEC(char *str, const TYPE *data, size_t n, int spacing) \
+  {                                                                     \
+    size_t length;                                                      \
+    if(n < 2 * TH_ASCII_CHUNK || THThreadPool_getNumThreads() < 2)      \
+      length = THAscii_write##TYPEC##Chunk(str, data, n, spacing);     \
+    else                                                                \
+    {                                                                   \
+      size_t nchunks = (n + TH_ASCII_CHUNK - 1) / TH_ASCII_CHUNK, c;    \
+      THAsciiJob job;                                                   \
+      job.str = str;                                                    \
+      job.data = data;                                                  \
+      job.n = n;                                                        \
+      job.spacing = spacing;                                            \
+      job.lengths = (size_t*)THAlloc(nchunks * sizeof(size_t));         \
+      THParallelFor(0, (ptrdiff_t)nchunks, 1, THAscii_write##TYPEC##Job, &job); \
+      length = job.lengths[0];                                          \
+      for(c = 1; c < nchunks; c++)                                      \
+      {                                                                 \
+        memmove(str + length, str + c * TH_ASCII_CHUNK * TH_ASCII_SIZE, job.lengths[c]); \
+        length += job.lengths[c];                                       \
+      }                                                                 \
+      THFree(job.lengths);                                              \
+    }                                                                   \
+    if(spacing && (n > 0))                                              \
+      length--;                                                         \
+    str[length] = '\0';                                                 \
+    return length;                                                      \
+  }
+
+#define THAscii_formatHalf(str, x) THAscii_formatFloat(str, TH_half2float(x))
+
+TH_ASCII_WRITE(short, Short, THAscii_formatLong)
+TH_ASCII_WRITE(int, Int, THAscii_formatLong)
+TH_ASCII_WRITE(long, Long, THAscii_formatLong)
+TH_ASCII_WRITE(float, Float, THAscii_formatFloat)
+TH_ASCII_WRITE(double, Double, THAscii_formatDouble)
+TH_ASCII_WRITE(THHalf, Half, THAscii_formatHalf)
@@ -0,0 +1,50 @@
+#ifndef TH_ASCII_INC
+#define TH_ASCII_INC
+
+#include "THGeneral.h"
+#include "THHalf.h"
+
+/******************************************************************************
+ * Numbers as text, for the ascii mode of the files
+ *  Reals are written with the fewest digits which read back to the same
+ *  value (shortest round trip), in the notation of printf %g: 0.1f is written
+ *  0.1 (%.9g: 0.100000001). Integers are written as with %ld.
+ *  Numbers are read as strtod and strtol do in the C locale, with a fast
+ *  path for decimals of up to 19 digits (the others go to strtod_l; to
+ *  strtod, in the locale of the program, where there is no strtod_l).
+ ******************************************************************************/
+
+/* bytes of the longest number written below, with the ending null */
+#define TH_ASCII_SIZE 32
+
+/*
+ * writes x in str, with an ending null; returns its length
+*/
+TH_API int THAscii_formatDouble(char *str, double x);
+TH_API int THAscii_formatFloat(char *str, float x);
+TH_API int THAscii_formatLong(char *str, long x);
+
+/*
+ * number at str, after spaces; *end (if end is not NULL) is set past it, or
+ * to str if there is none
+ * out of range integers are clamped (as strtol), as are reals (to infinity
+ * or zero, as strtod)
+*/
+TH_API double THAscii_parseDouble(const char *str, char **end);
+TH_API float THAscii_parseFloat(const char *str, char **end);
+TH_API long THAscii_parseLong(const char *str, char **end);
+
+/*
+ * writes the n values of data in str, separated by a space if spacing (none
+ * after the last one), with an ending null; str must have room for
+ * n*TH_ASCII_SIZE bytes; returns the length
+ * large arrays are formatted in chunks, by the threads of the pool
+*/
+TH_API size_t THAscii_writeShort(char *str, const short *data, size_t n, int spacing);
+TH_API size_t THAscii_writeInt(char *str, const int *data, size_t n, int spacing);
+TH_API size_t THAscii_writeLong(char *str, const long *data, size_t n, int spacing);
+TH_API size_t THAscii_writeFloat(char *str, const float *data, size_t n, int spacing);
+TH_API size_t THAscii_writeDouble(char *str, const double *data, size_t n, int spacing);
+TH_API size_t THAscii_writeHalf(char *str, const THHalf *data, size_t n, int spacing);
+
+#endif
@@ -1,4 +1,20 @@
 #include "THBlas.h"
+#include "THVector.h"
+#include "THThreadPool.h"
+#include "THScratch.h"
+
+/* blocking of the built-in gemm (in elements)
+ * MC rows of op(a) x KC: packed block of a, multiplied by one task
+ * KC x NC: packed block of b
+ * MG rows of op(a) are packed at once, NB columns of b are handled per task */
+#define THBlas_GEMM_MC 128
+#define THBlas_GEMM_KC 256
+#define THBlas_GEMM_NC 3072
+#define THBlas_GEMM_MG 2048
+#define THBlas_GEMM_NB 48
+
+/* below this number of multiply-adds, gemm runs plain loops */
+#define THBlas_GEMM_SMALL 32768
 
 #include "generic/THBlas.c"
 #include "THGenerateAllTypes.h"
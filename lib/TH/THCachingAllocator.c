@@ -0,0 +1,378 @@
+#include "THCachingAllocator.h"
+#include "THAtomic.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(TH_HAVE_THREAD) && !defined(_WIN32)
+#define TH_CACHING_THREAD_CACHE 1
+#endif
+
+/* a block: this header, then the data of the user */
+typedef struct THCachingBlock
+{
+  struct THCachingBlock *next; /* in a free list */
+  ptrdiff_t size; /* bytes of data */
+  int sizeClass; /* -1 if not cached */
+} THCachingBlock;
+
+#define TH_CACHING_HEADER 64 /* keeps the data aligned as the block */
+#define TH_CACHING_MAX_LOG2 48 /* larger blocks are not cached */
+#define TH_CACHING_NUM_CLASSES (16 + 8*(TH_CACHING_MAX_LOG2-10))
+#define TH_CACHING_SMALL_CLASSES 96 /* up to 1MB: kept by the threads */
+#define TH_CACHING_THREAD_BYTES ((ptrdiff_t)16 << 20)
+
+static ptrdiff_t volatile allocated = 0;
+static ptrdiff_t volatile cached = 0;
+static ptrdiff_t volatile peakAllocated = 0;
+static ptrdiff_t volatile hits = 0;
+static ptrdiff_t volatile misses = 0;
+
+/* shared pool */
+static THCachingBlock *pool[TH_CACHING_NUM_CLASSES];
+
+#ifdef _WIN32
+static int volatile poolMutex = 0;
+#define THCaching_lock() while(!THAtomicCompareAndSwap(&poolMutex, 0, 1))
+#define THCaching_unlock() THAtomicSet(&poolMutex, 0)
+#else
+#include <pthread.h>
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+#define THCaching_lock() pthread_mutex_lock(&poolMutex)
+#define THCaching_unlock() pthread_mutex_unlock(&poolMutex)
+#endif
+
+/* size class of size bytes (size > 0), -1 if too large to be cached;
+   sets *rounded to the size of the class */
+static int THCaching_sizeClass(ptrdiff_t size, ptrdiff_t *rounded)
+{
+  ptrdiff_t step, k;
+  int p;
+
+  if(size <= 1024)
+  {
+    *rounded = (size+63)/64*64;
+    return (int)(*rounded/64 - 1);
+  }
+
+  /* size in (2^p, 2^(p+1)], in 8 steps of 2^(p-3) */
+#ifdef __GNUC__
+  p = 63 - __builtin_clzll((unsigned long long)(size-1));
+#else
+  p = 10;
+  while(((ptrdiff_t)1 << (p+1)) <= size-1)
+    p++;
+#endif
+  if(p >= TH_CACHING_MAX_LOG2)
+  {
+    *rounded = size;
+    return -1;
+  }
+  step = (ptrdiff_t)1 << (p-3);
+  k = (size+step-1)/step;
+  *rounded = k*step;
+  return 16 + (p-10)*8 + (int)(k-9);
+}
+
+static void THCaching_release(THCachingBlock *block)
+{
+  THHeapUpdate(-(TH_CACHING_HEADER + block->size));
+  free(block);
+}
+
+/* a block of the system (huge pages and prefault as THAlloc for large
+   blocks); NULL when out of memory */
+static THCachingBlock* THCaching_systemAlloc(ptrdiff_t size)
+{
+  void *ptr = THAllocAligned(TH_CACHING_HEADER + size);
+  if(ptr)
+    THHeapUpdate(TH_CACHING_HEADER + size);
+  return ptr;
+}
+
+static void THCaching_updatePeak(ptrdiff_t current)
+{
+  ptrdiff_t peak = THAtomicGetPtrdiff(&peakAllocated);
+  while(current > peak && !THAtomicCompareAndSwapPtrdiff(&peakAllocated, peak, current))
+    peak = THAtomicGetPtrdiff(&peakAllocated);
+}
+
+#ifdef TH_CACHING_THREAD_CACHE
+
+typedef struct THCachingThreadCache
+{
+  THCachingBlock *blocks[TH_CACHING_SMALL_CLASSES];
+  ptrdiff_t size; /* bytes of data in the blocks */
+  /* 1 while the blocks are used: by the thread (which goes to the shared
+     pool rather than wait), or by THCachingAllocator_emptyCache */
+  int volatile busy;
+  struct THCachingThreadCache *next; /* in threadCaches */
+} THCachingThreadCache;
+
+static __thread THCachingThreadCache *threadCache = NULL;
+static pthread_key_t threadCacheKey;
+static pthread_once_t threadCacheOnce = PTHREAD_ONCE_INIT;
+/* the caches of all the threads, under the lock of the pool */
+static THCachingThreadCache *threadCaches = NULL;
+
+/* the busy flag of a cache, a lock which the thread only tries */
+#ifdef __GNUC__
+#define THCaching_tryLockCache(cache) (!__atomic_exchange_n(&(cache)->busy, 1, __ATOMIC_ACQUIRE))
+#define THCaching_unlockCache(cache) __atomic_store_n(&(cache)->busy, 0, __ATOMIC_RELEASE)
+#else
+#define THCaching_tryLockCache(cache) THAtomicCompareAndSwap(&(cache)->busy, 0, 1)
+#define THCaching_unlockCache(cache) THAtomicSet(&(cache)->busy, 0)
+#endif
+
+/* at the exit of a thread, its blocks go to the shared pool */
+static void THCaching_threadExit(void *data)
+{
+  THCachingThreadCache *cache = data;
+  THCachingThreadCache **link;
+  int c;
+
+  THCaching_lock();
+  for(link = &threadCaches; *link != cache; link = &(*link)->next);
+  *link = cache->next;
+  for(c = 0; c < TH_CACHING_SMALL_CLASSES; c++)
+  {
+    while(cache->blocks[c])
+    {
+      THCachingBlock *block = cache->blocks[c];
+      cache->blocks[c] = block->next;
+      block->next = pool[c];
+      pool[c] = block;
+    }
+  }
+  THCaching_unlock();
+  threadCache = NULL;
+  free(cache);
+}
+
+static void THCaching_createKey(void)
+{
+  pthread_key_create(&threadCacheKey, THCaching_threadExit);
+}
+
+/* cache of the calling thread, NULL if it cannot have one */
+static THCachingThreadCache* THCaching_threadCache(void)
+{
+  if(!threadCache)
+  {
+    THCachingThreadCache *cache = calloc(1, sizeof(THCachingThreadCache));
+    if(!cache)
+      return NULL;
+    pthread_once(&threadCacheOnce, THCaching_createKey);
+    if(pthread_setspecific(threadCacheKey, cache) != 0)
+    {
+      free(cache);
+      return NULL;
+    }
+    threadCache = cache;
+    THCaching_lock();
+    cache->next = threadCaches;
+    threadCaches = cache;
+    THCaching_unlock();
+  }
+  return threadCache;
+}
+
+#endif
+
+static void *THCachingAllocator_alloc(void* ctx, ptrdiff_t size)
+{
+  THCachingBlock *block = NULL;
+  ptrdiff_t rounded;
+  int c;
+
+  if(size < 0)
+    THError("$ Torch: invalid memory size -- maybe an overflow?");
+  if(size == 0)
+    return NULL;
+
+  c = THCaching_sizeClass(size, &rounded);
+#ifdef TH_CACHING_THREAD_CACHE
+  if(c >= 0 && c < TH_CACHING_SMALL_CLASSES)
+  {
+    THCachingThreadCache *cache = THCaching_threadCache();
+    if(cache && THCaching_tryLockCache(cache))
+    {
+      block = cache->blocks[c];
+      if(block)
+      {
+        cache->blocks[c] = block->next;
+        cache->size -= block->size;
+      }
+      THCaching_unlockCache(cache);
+    }
+  }
+#endif
+  if(!block && c >= 0)
+  {
+    THCaching_lock();
+    block = pool[c];
+    if(block)
+      pool[c] = block->next;
+    THCaching_unlock();
+  }
+
+  if(block)
+  {
+    THAtomicAddPtrdiff(&hits, 1);
+    THAtomicAddPtrdiff(&cached, -block->size);
+  }
+  else
+  {
+    block = THCaching_systemAlloc(rounded);
+    if(!block)
+    {
+      THCachingAllocator_emptyCache();
+      block = THCaching_systemAlloc(rounded);
+    }
+    if(!block)
+      THError("$ Torch: not enough memory: you tried to allocate %dGB. Buy new RAM!", size/1073741824);
+    block->size = rounded;
+    block->sizeClass = c;
+    THAtomicAddPtrdiff(&misses, 1);
+  }
+  block->next = NULL;
+  THCaching_updatePeak(THAtomicAddPtrdiff(&allocated, block->size) + block->size);
+  return (char*)block + TH_CACHING_HEADER;
+}
+
+static void THCachingAllocator_free(void* ctx, void* ptr)
+{
+  THCachingBlock *block;
+  int c;
+
+  if(!ptr)
+    return;
+
+  block = (THCachingBlock*)((char*)ptr - TH_CACHING_HEADER);
+  c = block->sizeClass;
+  THAtomicAddPtrdiff(&allocated, -block->size);
+  if(c < 0)
+  {
+    THCaching_release(block);
+    return;
+  }
+
+  THAtomicAddPtrdiff(&cached, block->size);
+#ifdef TH_CACHING_THREAD_CACHE
+  if(c < TH_CACHING_SMALL_CLASSES)
+  {
+    THCachingThreadCache *cache = THCaching_threadCache();
+    if(cache && THCaching_tryLockCache(cache))
+    {
+      int kept = (cache->size + block->size <= TH_CACHING_THREAD_BYTES);
+      if(kept)
+      {
+        block->next = cache->blocks[c];
+        cache->blocks[c] = block;
+        cache->size += block->size;
+      }
+      THCaching_unlockCache(cache);
+      if(kept)
+        return;
+    }
+  }
+#endif
+  THCaching_lock();
+  block->next = pool[c];
+  pool[c] = block;
+  THCaching_unlock();
+}
+
+/* the block is kept when the new size is of the same class */
+static void *THCachingAllocator_realloc(void* ctx, void* ptr, ptrdiff_t size)
+{
+  THCachingBlock *block;
+  ptrdiff_t rounded;
+  void *newptr;
+
+  if(!ptr)
+    return THCachingAllocator_alloc(ctx, size);
+  if(size == 0)
+  {
+    THCachingAllocator_free(ctx, ptr);
+    return NULL;
+  }
+  if(size < 0)
+    THError("$ Torch: invalid memory size -- maybe an overflow?");
+
+  block = (THCachingBlock*)((char*)ptr - TH_CACHING_HEADER);
+  if(block->sizeClass >= 0 && THCaching_sizeClass(size, &rounded) == block->sizeClass)
+    return ptr;
+
+  newptr = THCachingAllocator_alloc(ctx, size);
+  memcpy(newptr, ptr, (size < block->size ? size : block->size));
+  THCachingAllocator_free(ctx, ptr);
+  return newptr;
+}
+
+void THCachingAllocator_emptyCache(void)
+{
+  THCachingBlock *blocks = NULL;
+  ptrdiff_t size = 0;
+  int c;
+
+  THCaching_lock();
+#ifdef TH_CACHING_THREAD_CACHE
+  {
+    /* the threads hold their caches for a few instructions at a time */
+    THCachingThreadCache *cache;
+    for(cache = threadCaches; cache; cache = cache->next)
+    {
+      while(!THCaching_tryLockCache(cache));
+      for(c = 0; c < TH_CACHING_SMALL_CLASSES; c++)
+      {
+        while(cache->blocks[c])
+        {
+          THCachingBlock *block = cache->blocks[c];
+          cache->blocks[c] = block->next;
+          block->next = blocks;
+          blocks = block;
+        }
+      }
+      cache->size = 0;
+      THCaching_unlockCache(cache);
+    }
+  }
+#endif
+  for(c = 0; c < TH_CACHING_NUM_CLASSES; c++)
+  {
+    while(pool[c])
+    {
+      THCachingBlock *block = pool[c];
+      pool[c] = block->next;
+      block->next = blocks;
+      blocks = block;
+    }
+  }
+  THCaching_unlock();
+
+  /* back to the system, out of the lock */
+  while(blocks)
+  {
+    THCachingBlock *block = blocks;
+    blocks = block->next;
+    size += block->size;
+    THCaching_release(block);
+  }
+  THAtomicAddPtrdiff(&cached, -size);
+}
+
+void THCachingAllocator_getStats(THCachingAllocatorStats *stats)
+{
+  stats->allocated = THAtomicGetPtrdiff(&allocated);
+  stats->cached = THAtomicGetPtrdiff(&cached);
+  stats->peakAllocated = THAtomicGetPtrdiff(&peakAllocated);
+  stats->hits = THAtomicGetPtrdiff(&hits);
+  stats->misses = THAtomicGetPtrdiff(&misses);
+}
+
+THAllocator THCachingAllocator = {
+  &THCachingAllocator_alloc,
+  &THCachingAllocator_realloc,
+  &THCachingAllocator_free
+};
@@ -0,0 +1,43 @@
+#ifndef TH_CACHING_ALLOCATOR_INC
+#define TH_CACHING_ALLOCATOR_INC
+
+#include "THAllocator.h"
+
+/******************************************************************************
+ * Caching allocator for host memory (the CPU counterpart of
+ * THCCachingAllocator)
+ *  Sizes are rounded up to size classes: multiples of 64 bytes up to 1KB,
+ *  then 8 classes per power of two (at most 12.5% lost). Freed blocks are
+ *  kept in free lists, one per class, and given back to the next request of
+ *  the same class instead of being returned to the system.
+ *  Blocks of up to 1MB go to a cache of the freeing thread (no lock, up to
+ *  16MB per thread, given to the shared pool when the thread exits); the
+ *  others, and the overflow, go to a pool shared by all threads.
+ *  Memory stays cached until THCachingAllocator_emptyCache; when the system
+ *  is out of memory, the cache is emptied and the allocation retried.
+ *  Data is aligned on 64 bytes, and large blocks get the huge page and
+ *  prefault options of THAlloc (THSetLargeAllocFlags).
+ *  Use THSetDefaultStorageAllocator(&THCachingAllocator) to have all new
+ *  storages use it.
+ ******************************************************************************/
+
+typedef struct THCachingAllocatorStats
+{
+  ptrdiff_t allocated; /* bytes in use (rounded to their size class) */
+  ptrdiff_t cached; /* bytes kept for reuse */
+  ptrdiff_t peakAllocated; /* highest allocated so far */
+  ptrdiff_t hits; /* allocations served from the cache */
+  ptrdiff_t misses; /* allocations served by the system */
+} THCachingAllocatorStats;
+
+extern THAllocator THCachingAllocator;
+
+/*
+ * returns to the system the blocks of the shared pool and of the caches of
+ * all the threads (those of the thread pool included)
+*/
+TH_API void THCachingAllocator_emptyCache(void);
+
+TH_API void THCachingAllocator_getStats(THCachingAllocatorStats *stats);
+
+#endif
@@ -1,12 +1,41 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* O_DIRECT, sync_file_range */
+#endif
 #include "THGeneral.h"
 #include "THDiskFile.h"
 #include "THFilePrivate.h"
+#include "THAscii.h"
+#include "THScratch.h"
+#include "THThreadPool.h"
+#include "THVector.h"
 
 #include <stdint.h>
 #ifndef LLONG_MAX
 #define LLONG_MAX 9223372036854775807LL
 #endif
 
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TH_DISKFILE_BULK
+#endif
+
+/* binary reads and writes of at least TH_DISKFILE_BULK_SIZE bytes (by
+   default) go to the file in chunks of TH_DISKFILE_BULK_CHUNK bytes, shared by
+   the threads of the pool; the bytes of the other non native writes are
+   swapped in pieces of TH_DISKFILE_SWAP_SIZE bytes */
+#define TH_DISKFILE_BULK_SIZE (1 << 20)
+#define TH_DISKFILE_BULK_CHUNK (4 << 20)
+#define TH_DISKFILE_SWAP_SIZE (64 << 10)
+#define TH_DISKFILE_DIRECT_ALIGN 4096
+
+/* ascii numbers are written by batches of TH_DISKFILE_ASCII_BATCH, and read
+   from tokens of less than TH_DISKFILE_TOKEN_SIZE characters */
+#define TH_DISKFILE_ASCII_BATCH (64 << 10)
+#define TH_DISKFILE_TOKEN_SIZE 512
+
 typedef struct THDiskFile__
 {
     THFile file;
@@ -15,6 +44,9 @@ typedef struct THDiskFile__
     char *name;
     int isNativeEncoding;
     int longSize;
+    size_t bulkSize; /* 0: no bulk path */
+    int noCache;
+    int directFd; /* O_DIRECT, for the bulk reads of noCache (-1: none) */
 
 } THDiskFile;
 
@@ -43,7 +75,7 @@ size_t fread__(void *ptr, size_t size, size_t nitems, FILE *stream)
 #define fread__ fread
 #endif
 
-#define READ_WRITE_METHODS(TYPE, TYPEC, ASCII_READ_ELEM, ASCII_WRITE_ELEM) \
+#define READ_WRITE_METHODS(TYPE, TYPEC, ASCII_READ, ASCII_WRITE)  \
   static size_t THDiskFile_read##TYPEC(THFile *self, TYPE *data, size_t n)  \
   {                                                                     \
     THDiskFile *dfself = (THDiskFile*)(self);                           \
@@ -54,17 +86,11 @@ size_t fread__(void *ptr, size_t size, size_t nitems, FILE *stream)
                                                                         \
     if(dfself->file.isBinary)                                           \
     {                                                                   \
-      nread = fread__(data, sizeof(TYPE), n, dfself->handle);           \
-      if(!dfself->isNativeEncoding && (sizeof(TYPE) > 1) && (nread > 0)) \
-        THDiskFile_reverseMemory(data, data, sizeof(TYPE), nread);      \
+      nread = THDiskFile_readBinary(dfself, data, sizeof(TYPE), n);     \
     }                                                                   \
     else                                                                \
     {                                                                   \
-      size_t i;                                                           \
-      for(i = 0; i < n; i++)                                            \
-      {                                                                 \
-        ASCII_READ_ELEM; /* increment here result and break if wrong */ \
-      }                                                                 \
+      ASCII_READ;                                                       \
       if(dfself->file.isAutoSpacing && (n > 0))                         \
       {                                                                 \
         int c = fgetc(dfself->handle);                                  \
@@ -93,32 +119,11 @@ size_t fread__(void *ptr, size_t size, size_t nitems, FILE *stream)
                                                                         \
     if(dfself->file.isBinary)                                           \
     {                                                                   \
-      if(dfself->isNativeEncoding)                                      \
-      {                                                                 \
-        nwrite = fwrite(data, sizeof(TYPE), n, dfself->handle);         \
-      }                                                                 \
-      else                                                              \
-      {                                                                 \
-        if(sizeof(TYPE) > 1)                                            \
-        {                                                               \
-          char *buffer = THAlloc(sizeof(TYPE)*n);                       \
-          THDiskFile_reverseMemory(buffer, data, sizeof(TYPE), n);      \
-          nwrite = fwrite(buffer, sizeof(TYPE), n, dfself->handle);     \
-          THFree(buffer);                                               \
-        }                                                               \
-        else                                                            \
-          nwrite = fwrite(data, sizeof(TYPE), n, dfself->handle);       \
-      }                                                                 \
+      nwrite = THDiskFile_writeBinary(dfself, data, sizeof(TYPE), n);   \
     }                                                                   \
     else                                                                \
     {                                                                   \
-      size_t i;                                                           \
-      for(i = 0; i < n; i++)                                            \
-      {                                                                 \
-        ASCII_WRITE_ELEM;                                               \
-        if( dfself->file.isAutoSpacing && (i < n-1) )                   \
-          fprintf(dfself->handle, " ");                                 \
-      }                                                                 \
+      ASCII_WRITE;                                                      \
       if(dfself->file.isAutoSpacing && (n > 0))                         \
         fprintf(dfself->handle, "\n");                                  \
     }                                                                   \
@@ -232,19 +237,35 @@ static size_t THDiskFile_position(THFile *self)
   return 0;
 }
 
+static void THDiskFile_closeDirect(THDiskFile *self)
+{
+#ifdef TH_DISKFILE_BULK
+  if(self->directFd >= 0)
+    close(self->directFd);
+#endif
+  self->directFd = -1;
+}
+
 static void THDiskFile_close(THFile *self)
 {
   THDiskFile *dfself = (THDiskFile*)(self);
   THArgCheck(dfself->handle != NULL, 1, "attempt to use a closed file");
   fclose(dfself->handle);
   dfself->handle = NULL;
+  THDiskFile_closeDirect(dfself);
 }
 
 /* Little and Big Endian */
 
 static void THDiskFile_reverseMemory(void *dst, const void *src, size_t blockSize, size_t numBlocks)
 {
-  if(blockSize > 1)
+  if(blockSize == 2)
+    THShortVector_swapBytes(dst, src, numBlocks);
+  else if(blockSize == 4)
+    THIntVector_swapBytes(dst, src, numBlocks);
+  else if(blockSize == 8)
+    THDoubleVector_swapBytes(dst, src, numBlocks);
+  else if(blockSize > 1)
   {
     size_t halfBlockSize = blockSize/2;
     char *charSrc = (char*)src;
@@ -303,6 +324,289 @@ void THDiskFile_bigEndianEncoding(THFile *self)
 
 /* End of Little and Big Endian Stuff */
 
+/* Bulk binary path: pread/pwrite of chunks by the threads of the pool, the
+   stream positioned around them (its buffer flushed before, moved after) */
+
+#ifdef TH_DISKFILE_BULK
+
+typedef struct THDiskFileBulk__
+{
+  THDiskFile *self;
+  char *data;
+  size_t elementSize;
+  size_t size; /* bytes */
+  off_t position;
+  int swap;
+  size_t *done; /* bytes of each chunk */
+} THDiskFileBulk;
+
+static size_t THDiskFile_preadAll(int fd, char *data, size_t size, off_t position)
+{
+  size_t done = 0;
+  while(done < size)
+  {
+    ssize_t n = pread(fd, data+done, size-done, position+done);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      break;
+    done += n;
+  }
+  return done;
+}
+
+static size_t THDiskFile_pwriteAll(int fd, const char *data, size_t size, off_t position)
+{
+  size_t done = 0;
+  while(done < size)
+  {
+    ssize_t n = pwrite(fd, data+done, size-done, position+done);
+    if(n < 0 && errno == EINTR)
+      continue;
+    if(n <= 0)
+      break;
+    done += n;
+  }
+  return done;
+}
+
+/* the aligned blocks around the chunk, read into the workspace, then
+   copied (and swapped) to the data */
+static size_t THDiskFile_readDirect(THDiskFileBulk *job, char *data, size_t size, off_t position)
+{
+  off_t first = position/TH_DISKFILE_DIRECT_ALIGN*TH_DISKFILE_DIRECT_ALIGN;
+  off_t last = (position+size+TH_DISKFILE_DIRECT_ALIGN-1)/TH_DISKFILE_DIRECT_ALIGN*TH_DISKFILE_DIRECT_ALIGN;
+  char *block = THScratch_alloc(last-first+TH_DISKFILE_DIRECT_ALIGN);
+  char *buffer = (char*)(((uintptr_t)block+TH_DISKFILE_DIRECT_ALIGN-1)/TH_DISKFILE_DIRECT_ALIGN*TH_DISKFILE_DIRECT_ALIGN);
+  size_t got = THDiskFile_preadAll(job->self->directFd, buffer, last-first, first);
+  size_t skip = position-first;
+  size_t done = (got > skip ? THMin(size, got-skip) : 0);
+  size_t swapped = (job->swap ? done/job->elementSize*job->elementSize : 0);
+  if(swapped > 0)
+    THDiskFile_reverseMemory(data, buffer+skip, job->elementSize, swapped/job->elementSize);
+  memcpy(data+swapped, buffer+skip+swapped, done-swapped);
+  THScratch_free(block);
+  return done;
+}
+
+static void THDiskFile_readChunks(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THDiskFileBulk *job = data;
+  int fd = fileno(job->self->handle);
+  ptrdiff_t c;
+  for(c = begin; c < end; c++)
+  {
+    size_t offset = (size_t)c*TH_DISKFILE_BULK_CHUNK;
+    size_t size = THMin((size_t)TH_DISKFILE_BULK_CHUNK, job->size-offset);
+    char *chunk = job->data+offset;
+    off_t position = job->position+offset;
+    size_t done;
+    if(job->self->directFd >= 0)
+    {
+      job->done[c] = THDiskFile_readDirect(job, chunk, size, position);
+      continue;
+    }
+    done = THDiskFile_preadAll(fd, chunk, size, position);
+#ifdef POSIX_FADV_DONTNEED
+    if(job->self->noCache)
+      posix_fadvise(fd, position, done, POSIX_FADV_DONTNEED);
+#endif
+    if(job->swap)
+      THDiskFile_reverseMemory(chunk, chunk, job->elementSize, done/job->elementSize);
+    job->done[c] = done;
+  }
+}
+
+static void THDiskFile_writeChunks(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THDiskFileBulk *job = data;
+  int fd = fileno(job->self->handle);
+  ptrdiff_t c;
+  for(c = begin; c < end; c++)
+  {
+    size_t offset = (size_t)c*TH_DISKFILE_BULK_CHUNK;
+    size_t size = THMin((size_t)TH_DISKFILE_BULK_CHUNK, job->size-offset);
+    char *chunk = job->data+offset;
+    off_t position = job->position+offset;
+    char *buffer = NULL;
+    if(job->swap)
+    {
+      buffer = THScratch_alloc(size);
+      THDiskFile_reverseMemory(buffer, chunk, job->elementSize, size/job->elementSize);
+      chunk = buffer;
+    }
+    job->done[c] = THDiskFile_pwriteAll(fd, chunk, size, position);
+    if(buffer)
+      THScratch_free(buffer);
+    if(job->self->noCache)
+    {
+      /* dirty pages stay in the cache: written back first */
+#ifdef SYNC_FILE_RANGE_WRITE
+      sync_file_range(fd, position, job->done[c],
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+#ifdef POSIX_FADV_DONTNEED
+      posix_fadvise(fd, position, job->done[c], POSIX_FADV_DONTNEED);
+#endif
+    }
+  }
+}
+
+/* bytes read or written, the ones of the first chunks which all went through */
+static size_t THDiskFile_bulk(THDiskFile *self, void *data, size_t elementSize, size_t n, int write)
+{
+  THDiskFileBulk job;
+  ptrdiff_t numChunks, c;
+  size_t done = 0;
+  off_t position = ftello(self->handle);
+
+  if(position < 0 || fseeko(self->handle, position, SEEK_SET) < 0) /* flushes the buffer of the stream */
+    return 0;
+
+  job.self = self;
+  job.data = data;
+  job.elementSize = elementSize;
+  job.size = elementSize*n;
+  job.position = position;
+  job.swap = !self->isNativeEncoding && (elementSize > 1);
+  numChunks = (job.size+TH_DISKFILE_BULK_CHUNK-1)/TH_DISKFILE_BULK_CHUNK;
+  job.done = THAlloc(numChunks*sizeof(size_t));
+#ifdef POSIX_FADV_SEQUENTIAL
+  if(!write && !self->noCache)
+    posix_fadvise(fileno(self->handle), position, job.size, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  THParallelFor(0, numChunks, 1, (write ? THDiskFile_writeChunks : THDiskFile_readChunks), &job);
+
+  for(c = 0; c < numChunks; c++)
+  {
+    done += job.done[c];
+    if(job.done[c] < THMin((size_t)TH_DISKFILE_BULK_CHUNK, job.size-(size_t)c*TH_DISKFILE_BULK_CHUNK))
+      break;
+  }
+  THFree(job.done);
+  fseeko(self->handle, position+done, SEEK_SET);
+  return done;
+}
+
+#endif
+
+static size_t THDiskFile_readBinary(THDiskFile *self, void *data, size_t elementSize, size_t n)
+{
+  size_t nread;
+#ifdef TH_DISKFILE_BULK
+  if(self->bulkSize > 0 && elementSize*n >= self->bulkSize)
+    return THDiskFile_bulk(self, data, elementSize, n, 0)/elementSize;
+#endif
+  nread = fread__(data, elementSize, n, self->handle);
+  if(!self->isNativeEncoding && (elementSize > 1) && (nread > 0))
+    THDiskFile_reverseMemory(data, data, elementSize, nread);
+  return nread;
+}
+
+static size_t THDiskFile_writeBinary(THDiskFile *self, void *data, size_t elementSize, size_t n)
+{
+  size_t nwrite = 0, block, i;
+  char *buffer;
+#ifdef TH_DISKFILE_BULK
+  if(self->bulkSize > 0 && elementSize*n >= self->bulkSize)
+    return THDiskFile_bulk(self, data, elementSize, n, 1)/elementSize;
+#endif
+  if(self->isNativeEncoding || elementSize == 1)
+    return fwrite(data, elementSize, n, self->handle);
+
+  /* swapped by pieces, in the workspace */
+  block = THMin(n, THMax(TH_DISKFILE_SWAP_SIZE/elementSize, 1));
+  buffer = THScratch_alloc(block*elementSize);
+  for(i = 0; i < n; i += block)
+  {
+    size_t m = THMin(block, n-i), written;
+    THDiskFile_reverseMemory(buffer, (char*)data+i*elementSize, elementSize, m);
+    written = fwrite(buffer, elementSize, m, self->handle);
+    nwrite += written;
+    if(written != m)
+      break;
+  }
+  THScratch_free(buffer);
+  return nwrite;
+}
+
+/* Ascii numbers: read token by token (the characters up to a space, which
+   must all make the number), written by batches formatted in the workspace */
+
+#ifdef _WIN32
+#define flockfile _lock_file
+#define funlockfile _unlock_file
+#define getc_unlocked _getc_nolock
+#endif
+
+/* length of the next token, 0 at the end of the file or if it is too long */
+static size_t THDiskFile_token(FILE *handle, char *token)
+{
+  size_t length = 0;
+  int c;
+  do
+    c = getc_unlocked(handle);
+  while(c == ' ' || (c >= '\t' && c <= '\r'));
+  while(c != EOF && c != ' ' && (c < '\t' || c > '\r'))
+  {
+    if(length == TH_DISKFILE_TOKEN_SIZE-1)
+      return 0;
+    token[length++] = (char)c;
+    c = getc_unlocked(handle);
+  }
+  if(c != EOF)
+    ungetc(c, handle);
+  token[length] = '\0';
+  return length;
+}
+
+#define ASCII_METHODS(TYPE, TYPEC, PARSE)                               \
+  static size_t THDiskFile_readAscii##TYPEC(THDiskFile *self, TYPE *data, size_t n) \
+  {                                                                     \
+    char token[TH_DISKFILE_TOKEN_SIZE], *end;                           \
+    size_t i, length;                                                   \
+    flockfile(self->handle);                                            \
+    for(i = 0; i < n; i++)                                              \
+    {                                                                   \
+      if((length = THDiskFile_token(self->handle, token)) == 0)         \
+        break;                                                          \
+      data[i] = PARSE(token, &end);                                     \
+      if(end != token+length)                                           \
+        break;                                                          \
+    }                                                                   \
+    funlockfile(self->handle);                                          \
+    return i;                                                           \
+  }                                                                     \
+                                                                        \
+  static size_t THDiskFile_writeAscii##TYPEC(THDiskFile *self, TYPE *data, size_t n) \
+  {                                                                     \
+    size_t batch = THMin(n, TH_DISKFILE_ASCII_BATCH), i;                \
+    char *buffer = THScratch_alloc(batch*TH_ASCII_SIZE+1);              \
+    for(i = 0; i < n; i += batch)                                       \
+    {                                                                   \
+      size_t m = THMin(batch, n-i);                                     \
+      size_t length = THAscii_write##TYPEC(buffer, data+i, m, self->file.isAutoSpacing); \
+      if(self->file.isAutoSpacing && (i+m < n))                         \
+        buffer[length++] = ' ';                                         \
+      if(fwrite(buffer, 1, length, self->handle) != length)             \
+        break;                                                          \
+    }                                                                   \
+    THScratch_free(buffer);                                             \
+    return THMin(i, n);                                                 \
+  }
+
+#define THDiskFile_parseShort(str, end) ((short)THAscii_parseLong(str, end))
+#define THDiskFile_parseInt(str, end) ((int)THAscii_parseLong(str, end))
+#define THDiskFile_parseHalf(str, end) TH_float2half(THAscii_parseFloat(str, end))
+
+ASCII_METHODS(short, Short, THDiskFile_parseShort)
+ASCII_METHODS(int, Int, THDiskFile_parseInt)
+ASCII_METHODS(long, Long, THAscii_parseLong)
+ASCII_METHODS(float, Float, THAscii_parseFloat)
+ASCII_METHODS(double, Double, THAscii_parseDouble)
+ASCII_METHODS(THHalf, Half, THDiskFile_parseHalf)
+
 void THDiskFile_longSize(THFile *self, int size)
 {
   THDiskFile *dfself = (THDiskFile*)(self);
@@ -320,11 +624,46 @@ void THDiskFile_noBuffer(THFile *self)
   }
 }
 
+void THDiskFile_bulkSize(THFile *self, size_t size)
+{
+  THDiskFile *dfself = (THDiskFile*)(self);
+  THArgCheck(dfself->handle != NULL, 1, "attempt to use a closed file");
+#ifdef TH_DISKFILE_BULK
+  {
+    struct stat st;
+    if(fstat(fileno(dfself->handle), &st) == 0 && S_ISREG(st.st_mode))
+      dfself->bulkSize = size;
+  }
+#endif
+}
+
+void THDiskFile_noCache(THFile *self, int noCache)
+{
+  THDiskFile *dfself = (THDiskFile*)(self);
+  THArgCheck(dfself->handle != NULL, 1, "attempt to use a closed file");
+  dfself->noCache = noCache;
+  if(!noCache)
+    THDiskFile_closeDirect(dfself);
+#if defined(TH_DISKFILE_BULK) && defined(O_DIRECT)
+  if(noCache && dfself->directFd < 0 && dfself->file.isReadable && dfself->bulkSize > 0)
+  {
+    /* a first block read tells whether the file system takes direct reads */
+    char *block = THAlloc(2*TH_DISKFILE_DIRECT_ALIGN);
+    char *buffer = (char*)(((uintptr_t)block+TH_DISKFILE_DIRECT_ALIGN-1)/TH_DISKFILE_DIRECT_ALIGN*TH_DISKFILE_DIRECT_ALIGN);
+    dfself->directFd = open(dfself->name, O_RDONLY | O_DIRECT);
+    if(dfself->directFd >= 0 && pread(dfself->directFd, buffer, TH_DISKFILE_DIRECT_ALIGN, 0) < 0)
+      THDiskFile_closeDirect(dfself);
+    THFree(block);
+  }
+#endif
+}
+
 static void THDiskFile_free(THFile *self)
 {
   THDiskFile *dfself = (THDiskFile*)(self);
   if(dfself->handle)
     fclose(dfself->handle);
+  THDiskFile_closeDirect(dfself);
   THFree(dfself->name);
   THFree(dfself);
 }
@@ -336,32 +675,32 @@ static void THDiskFile_free(THFile *self)
 
 /* Note that we do a trick */
 READ_WRITE_METHODS(unsigned char, Byte,
-                   nread = fread(data, 1, n, dfself->handle); break,
-                   nwrite = fwrite(data, 1, n, dfself->handle); break)
+                   nread = fread(data, 1, n, dfself->handle),
+                   nwrite = fwrite(data, 1, n, dfself->handle))
 
 READ_WRITE_METHODS(char, Char,
-                   nread = fread(data, 1, n, dfself->handle); break,
-                   nwrite = fwrite(data, 1, n, dfself->handle); break)
+                   nread = fread(data, 1, n, dfself->handle),
+                   nwrite = fwrite(data, 1, n, dfself->handle))
 
 READ_WRITE_METHODS(short, Short,
-                   int ret = fscanf(dfself->handle, "%hd", &data[i]); if(ret <= 0) break; else nread++,
-                   int ret = fprintf(dfself->handle, "%hd", data[i]); if(ret <= 0) break; else nwrite++)
+                   nread = THDiskFile_readAsciiShort(dfself, data, n),
+                   nwrite = THDiskFile_writeAsciiShort(dfself, data, n))
 
 READ_WRITE_METHODS(int, Int,
-                   int ret = fscanf(dfself->handle, "%d", &data[i]); if(ret <= 0) break; else nread++,
-                   int ret = fprintf(dfself->handle, "%d", data[i]); if(ret <= 0) break; else nwrite++)
+                   nread = THDiskFile_readAsciiInt(dfself, data, n),
+                   nwrite = THDiskFile_writeAsciiInt(dfself, data, n))
 
 READ_WRITE_METHODS(float, Float,
-                   int ret = fscanf(dfself->handle, "%g", &data[i]); if(ret <= 0) break; else nread++,
-                   int ret = fprintf(dfself->handle, "%.9g", data[i]); if(ret <= 0) break; else nwrite++)
+                   nread = THDiskFile_readAsciiFloat(dfself, data, n),
+                   nwrite = THDiskFile_writeAsciiFloat(dfself, data, n))
 
 READ_WRITE_METHODS(THHalf, Half,
-                   float buf; int ret = fscanf(dfself->handle, "%g", &buf); if(ret <= 0) break; else { data[i]= TH_float2half(buf); nread++; },
-                   int ret = fprintf(dfself->handle, "%.9g", TH_half2float(data[i])); if(ret <= 0) break; else nwrite++)
+                   nread = THDiskFile_readAsciiHalf(dfself, data, n),
+                   nwrite = THDiskFile_writeAsciiHalf(dfself, data, n))
 
 READ_WRITE_METHODS(double, Double,
-                   int ret = fscanf(dfself->handle, "%lg", &data[i]); if(ret <= 0) break; else nread++,
-                   int ret = fprintf(dfself->handle, "%.17g", data[i]); if(ret <= 0) break; else nwrite++)
+                   nread = THDiskFile_readAsciiDouble(dfself, data, n),
+                   nwrite = THDiskFile_writeAsciiDouble(dfself, data, n))
 
 
 /* For Long we need to rewrite everything, because of the special management of longSize */
@@ -377,9 +716,7 @@ static size_t THDiskFile_readLong(THFile *self, long *data, size_t n)
   {
     if(dfself->longSize == 0 || dfself->longSize == sizeof(long))
     {
-      nread = fread__(data, sizeof(long), n, dfself->handle);
-      if(!dfself->isNativeEncoding && (sizeof(long) > 1) && (nread > 0))
-        THDiskFile_reverseMemory(data, data, sizeof(long), nread);
+      nread = THDiskFile_readBinary(dfself, data, sizeof(long), n);
     } else if(dfself->longSize == 4)
     {
       nread = fread__(data, 4, n, dfself->handle);
@@ -404,11 +741,7 @@ static size_t THDiskFile_readLong(THFile *self, long *data, size_t n)
   }
   else
   {
-    size_t i;
-    for(i = 0; i < n; i++)
-    {
-      int ret = fscanf(dfself->handle, "%ld", &data[i]); if(ret <= 0) break; else nread++;
-    }
+    nread = THDiskFile_readAsciiLong(dfself, data, n);
     if(dfself->file.isAutoSpacing && (n > 0))
     {
       int c = fgetc(dfself->handle);
@@ -439,17 +772,7 @@ static size_t THDiskFile_writeLong(THFile *self, long *data, size_t n)
   {
     if(dfself->longSize == 0 || dfself->longSize == sizeof(long))
     {
-      if(dfself->isNativeEncoding)
-      {
-        nwrite = fwrite(data, sizeof(long), n, dfself->handle);
-      }
-      else
-      {
-        char *buffer = THAlloc(sizeof(long)*n);
-        THDiskFile_reverseMemory(buffer, data, sizeof(long), n);
-        nwrite = fwrite(buffer, sizeof(long), n, dfself->handle);
-        THFree(buffer);
-      }
+      nwrite = THDiskFile_writeBinary(dfself, data, sizeof(long), n);
     } else if(dfself->longSize == 4)
     {
       int32_t *buffer = THAlloc(4*n);
@@ -479,13 +802,7 @@ static size_t THDiskFile_writeLong(THFile *self, long *data, size_t n)
   }
   else
   {
-    size_t i;
-    for(i = 0; i < n; i++)
-    {
-      int ret = fprintf(dfself->handle, "%ld", data[i]); if(ret <= 0) break; else nwrite++;
-      if( dfself->file.isAutoSpacing && (i < n-1) )
-        fprintf(dfself->handle, " ");
-    }
+    nwrite = THDiskFile_writeAsciiLong(dfself, data, n);
     if(dfself->file.isAutoSpacing && (n > 0))
       fprintf(dfself->handle, "\n");
   }
@@ -680,6 +997,9 @@ THFile *THDiskFile_new(const char *name, const char *mode, int isQuiet)
   strcpy(self->name, name);
   self->isNativeEncoding = 1;
   self->longSize = 0;
+  self->bulkSize = 0;
+  self->noCache = 0;
+  self->directFd = -1;
 
   self->file.vtable = &vtable;
   self->file.isQuiet = isQuiet;
@@ -689,6 +1009,8 @@ THFile *THDiskFile_new(const char *name, const char *mode, int isQuiet)
   self->file.isAutoSpacing = 1;
   self->file.hasError = 0;
 
+  THDiskFile_bulkSize((THFile*)self, TH_DISKFILE_BULK_SIZE);
+
   return (THFile*)self;
 }
 
@@ -784,6 +1106,9 @@ THFile *THPipeFile_new(const char *name, const char *mode, int isQuiet)
   strcpy(self->name, name);
   self->isNativeEncoding = 1;
   self->longSize = 0;
+  self->bulkSize = 0; /* a pipe has no positions */
+  self->noCache = 0;
+  self->directFd = -1;
 
   self->file.vtable = &vtable;
   self->file.isQuiet = isQuiet;
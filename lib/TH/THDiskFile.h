@@ -16,4 +16,14 @@ TH_API void THDiskFile_bigEndianEncoding(THFile *self);
 TH_API void THDiskFile_longSize(THFile *self, int size);
 TH_API void THDiskFile_noBuffer(THFile *self);
 
+/* binary reads and writes of at least size bytes (1MB by default, 0: none)
+   go to a regular file with pread/pwrite, in chunks shared by the threads of
+   the TH pool, rather than through the buffer of the stream */
+TH_API void THDiskFile_bulkSize(THFile *self, size_t size);
+/* the bulk reads and writes leave the page cache as it was, for files read
+   or written once (larger than memory): reads with O_DIRECT where the file
+   system takes it, else dropped from the cache after use; writes written
+   back, then dropped */
+TH_API void THDiskFile_noCache(THFile *self, int noCache);
+
 #endif
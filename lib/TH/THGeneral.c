@@ -1,5 +1,8 @@
 #include "THGeneral.h"
 #include "THAtomic.h"
+#include "THThreadPool.h"
+
+#include <stdint.h>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -11,14 +14,12 @@
 #define __thread __declspec( thread )
 #endif
 
-#if (defined(__unix) || defined(_WIN32))
-  #if defined(__FreeBSD__)
-    #include <malloc_np.h>
-  #else
-    #include <malloc.h>
-  #endif
-#elif defined(__APPLE__)
-#include <malloc/malloc.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
 #endif
 
 /* Torch Error Handling */
@@ -134,7 +135,7 @@ void THSetDefaultArgErrorHandler(THArgErrorHandlerFunction new_handler, void *da
 static __thread void (*torchGCFunction)(void *data) = NULL;
 static __thread void *torchGCData;
 static ptrdiff_t heapSize = 0;
-static __thread ptrdiff_t heapDelta = 0;
+static ptrdiff_t heapPeak = 0;
 static const ptrdiff_t heapMaxDelta = (ptrdiff_t)1e6; // limit to +/- 1MB before updating heapSize
 static const ptrdiff_t heapMinDelta = (ptrdiff_t)-1e6;
 static __thread ptrdiff_t heapSoftmax = (ptrdiff_t)3e8; // 300MB, adjusted upward dynamically
@@ -157,20 +158,158 @@ void THSetGCHandler( void (*torchGCFunction_)(void *data), void *data )
   torchGCData = data;
 }
 
-/* it is guaranteed the allocated size is not bigger than PTRDIFF_MAX */
-static ptrdiff_t getAllocSize(void *ptr) {
-#if defined(__unix) && defined(HAVE_MALLOC_USABLE_SIZE)
-  return malloc_usable_size(ptr);
-#elif defined(__APPLE__)
-  return malloc_size(ptr);
-#elif defined(_WIN32)
-  if(ptr) { return _msize(ptr); } else { return 0; }
+/* Memory statistics
+ *
+ * Each thread counts in its own shard, with plain additions: no atomic
+ * operation, no shared cache line. THHeapGetStats sums the shards; the
+ * counts of the threads which exited are kept in heapRetired (which also
+ * counts, atomically, when a thread cannot have a shard).
+ */
+typedef struct THHeapShard
+{
+  ptrdiff_t volatile delta; /* not yet in heapSize */
+  ptrdiff_t volatile allocated;
+  ptrdiff_t volatile numAllocs;
+  ptrdiff_t volatile numFrees;
+  ptrdiff_t volatile histogram[TH_HEAP_HISTOGRAM_SIZE];
+  struct THHeapShard *prev, *next;
+} THHeapShard;
+
+static THHeapShard heapRetired; /* head of the list of the shards */
+
+#if defined(TH_HAVE_THREAD) && !defined(_WIN32)
+
+#include <pthread.h>
+
+static __thread THHeapShard *heapShard = NULL;
+static pthread_mutex_t heapShardMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t heapShardKey;
+static pthread_once_t heapShardOnce = PTHREAD_ONCE_INIT;
+
+static ptrdiff_t applyHeapDelta(THHeapShard *shard);
+
+static void heapShardExit(void *data)
+{
+  THHeapShard *shard = data;
+  int i;
+
+  applyHeapDelta(shard);
+  pthread_mutex_lock(&heapShardMutex);
+  THAtomicAddPtrdiff(&heapRetired.allocated, shard->allocated);
+  THAtomicAddPtrdiff(&heapRetired.numAllocs, shard->numAllocs);
+  THAtomicAddPtrdiff(&heapRetired.numFrees, shard->numFrees);
+  for(i = 0; i < TH_HEAP_HISTOGRAM_SIZE; i++)
+    THAtomicAddPtrdiff(&heapRetired.histogram[i], shard->histogram[i]);
+  shard->prev->next = shard->next;
+  if(shard->next)
+    shard->next->prev = shard->prev;
+  pthread_mutex_unlock(&heapShardMutex);
+  heapShard = NULL;
+  free(shard);
+}
+
+static void heapShardCreateKey(void)
+{
+  pthread_key_create(&heapShardKey, heapShardExit);
+}
+
+static THHeapShard* getHeapShard(void)
+{
+  if(!heapShard)
+  {
+    THHeapShard *shard = calloc(1, sizeof(THHeapShard));
+    if(!shard)
+      return &heapRetired;
+    pthread_once(&heapShardOnce, heapShardCreateKey);
+    if(pthread_setspecific(heapShardKey, shard) != 0)
+    {
+      free(shard);
+      return &heapRetired;
+    }
+    pthread_mutex_lock(&heapShardMutex);
+    shard->prev = &heapRetired;
+    shard->next = heapRetired.next;
+    if(heapRetired.next)
+      heapRetired.next->prev = shard;
+    heapRetired.next = shard;
+    pthread_mutex_unlock(&heapShardMutex);
+    heapShard = shard;
+  }
+  return heapShard;
+}
+
+#define lockHeapShards() pthread_mutex_lock(&heapShardMutex)
+#define unlockHeapShards() pthread_mutex_unlock(&heapShardMutex)
+
 #else
-  return 0;
+
+static THHeapShard* getHeapShard(void)
+{
+  return &heapRetired;
+}
+
+#define lockHeapShards()
+#define unlockHeapShards()
+
+#endif
+
+static void heapShardAdd(THHeapShard *shard, ptrdiff_t volatile *counter, ptrdiff_t value)
+{
+  if(shard == &heapRetired)
+    THAtomicAddPtrdiff(counter, value);
+  else
+    *counter += value;
+}
+
+static int heapHistogramBin(ptrdiff_t size)
+{
+  int bin;
+#ifdef __GNUC__
+  bin = 63 - __builtin_clzll((unsigned long long)size);
+#else
+  bin = 0;
+  while(bin < 62 && ((ptrdiff_t)1 << (bin+1)) <= size)
+    bin++;
 #endif
+  return (bin < TH_HEAP_HISTOGRAM_SIZE ? bin : TH_HEAP_HISTOGRAM_SIZE-1);
 }
 
-static ptrdiff_t applyHeapDelta() {
+void THHeapGetStats(THHeapStats *stats)
+{
+  THHeapShard *shard;
+  int i;
+
+  memset(stats, 0, sizeof(THHeapStats));
+  lockHeapShards();
+  for(shard = &heapRetired; shard; shard = shard->next)
+  {
+    stats->allocated += shard->allocated;
+    stats->numAllocs += shard->numAllocs;
+    stats->numFrees += shard->numFrees;
+    for(i = 0; i < TH_HEAP_HISTOGRAM_SIZE; i++)
+      stats->histogram[i] += shard->histogram[i];
+  }
+  unlockHeapShards();
+  stats->peakAllocated = THAtomicGetPtrdiff(&heapPeak);
+  if(stats->peakAllocated < stats->allocated)
+    stats->peakAllocated = stats->allocated;
+}
+
+void THHeapResetPeak(void)
+{
+  THHeapStats stats;
+  THHeapGetStats(&stats);
+  THAtomicSetPtrdiff(&heapPeak, stats.allocated);
+}
+
+static ptrdiff_t applyHeapDelta(THHeapShard *shard) {
+  ptrdiff_t heapDelta = shard->delta;
+  if (shard == &heapRetired) {
+    while (!THAtomicCompareAndSwapPtrdiff(&shard->delta, heapDelta, 0))
+      heapDelta = THAtomicGetPtrdiff(&shard->delta);
+  } else {
+    shard->delta = 0;
+  }
   ptrdiff_t oldHeapSize = THAtomicAddPtrdiff(&heapSize, heapDelta);
 #ifdef DEBUG
   if (heapDelta > 0 && oldHeapSize > PTRDIFF_MAX - heapDelta)
@@ -179,7 +318,12 @@ static ptrdiff_t applyHeapDelta() {
     THError("applyHeapDelta: heapSize(%td) + decreased(%td) < PTRDIFF_MIN, heapSize underflow!", oldHeapSize, heapDelta);
 #endif
   ptrdiff_t newHeapSize = oldHeapSize + heapDelta;
-  heapDelta = 0;
+
+  // the peak is seen here, to within heapMaxDelta per thread
+  ptrdiff_t peak = THAtomicGetPtrdiff(&heapPeak);
+  while (newHeapSize > peak && !THAtomicCompareAndSwapPtrdiff(&heapPeak, peak, newHeapSize))
+    peak = THAtomicGetPtrdiff(&heapPeak);
+
   return newHeapSize;
 }
 
@@ -187,12 +331,12 @@ static ptrdiff_t applyHeapDelta() {
  * (2) if post-GC heap size exceeds 80% of the soft max, increase the
  *     soft max by 40%
  */
-static void maybeTriggerGC(ptrdiff_t curHeapSize) {
+static void maybeTriggerGC(THHeapShard *shard, ptrdiff_t curHeapSize) {
   if (torchGCFunction && curHeapSize > heapSoftmax) {
     torchGCFunction(torchGCData);
 
     // ensure heapSize is accurate before updating heapSoftmax
-    ptrdiff_t newHeapSize = applyHeapDelta();
+    ptrdiff_t newHeapSize = applyHeapDelta(shard);
 
     if (newHeapSize > heapSoftmax * heapSoftmaxGrowthThresh) {
       heapSoftmax = (ptrdiff_t)(heapSoftmax * heapSoftmaxGrowthFactor);
@@ -200,60 +344,154 @@ static void maybeTriggerGC(ptrdiff_t curHeapSize) {
   }
 }
 
-// hooks into the TH heap tracking
-void THHeapUpdate(ptrdiff_t size) {
+static void heapUpdate(THHeapShard *shard, ptrdiff_t size) {
 #ifdef DEBUG
-  if (size > 0 && heapDelta > PTRDIFF_MAX - size)
-    THError("THHeapUpdate: heapDelta(%td) + increased(%td) > PTRDIFF_MAX, heapDelta overflow!", heapDelta, size);
-  if (size < 0 && heapDelta < PTRDIFF_MIN - size)
-    THError("THHeapUpdate: heapDelta(%td) + decreased(%td) < PTRDIFF_MIN, heapDelta underflow!", heapDelta, size);
+  if (size > 0 && shard->delta > PTRDIFF_MAX - size)
+    THError("THHeapUpdate: heapDelta(%td) + increased(%td) > PTRDIFF_MAX, heapDelta overflow!", shard->delta, size);
+  if (size < 0 && shard->delta < PTRDIFF_MIN - size)
+    THError("THHeapUpdate: heapDelta(%td) + decreased(%td) < PTRDIFF_MIN, heapDelta underflow!", shard->delta, size);
 #endif
 
-  heapDelta += size;
+  heapShardAdd(shard, &shard->allocated, size);
+  heapShardAdd(shard, &shard->delta, size);
+  ptrdiff_t heapDelta = shard->delta;
 
   // batch updates to global heapSize to minimize thread contention
   if (heapDelta < heapMaxDelta && heapDelta > heapMinDelta) {
     return;
   }
 
-  ptrdiff_t newHeapSize = applyHeapDelta();
+  ptrdiff_t newHeapSize = applyHeapDelta(shard);
 
   if (size > 0) {
-    maybeTriggerGC(newHeapSize);
+    maybeTriggerGC(shard, newHeapSize);
+  }
+}
+
+// hooks into the TH heap tracking
+void THHeapUpdate(ptrdiff_t size) {
+  heapUpdate(getHeapShard(), size);
+}
+
+/* Large allocations
+ *
+ * From TH_LARGE_ALLOC_SIZE bytes, THAlloc can align the block on huge pages
+ * and ask for transparent huge pages (fewer TLB misses in the kernels), and
+ * touch its pages on the TH threads (the page faults are then taken once,
+ * in parallel, rather than by the first kernel writing the data).
+ * The flags come from the environment variable TH_LARGE_ALLOC (e.g.
+ * TH_LARGE_ALLOC=hugepages,prefault) until THSetLargeAllocFlags.
+ */
+static int largeAllocFlags = -1;
+
+void THSetLargeAllocFlags(int flags)
+{
+  largeAllocFlags = flags & (TH_LARGE_ALLOC_HUGEPAGES | TH_LARGE_ALLOC_PREFAULT);
+}
+
+int THGetLargeAllocFlags(void)
+{
+  int flags = largeAllocFlags;
+  if (flags < 0) {
+    const char *env = getenv("TH_LARGE_ALLOC");
+    flags = 0;
+    if (env && strstr(env, "hugepages"))
+      flags |= TH_LARGE_ALLOC_HUGEPAGES;
+    if (env && strstr(env, "prefault"))
+      flags |= TH_LARGE_ALLOC_PREFAULT;
+    largeAllocFlags = flags;
   }
+  return flags;
+}
+
+#define TH_PAGE_SIZE 4096
+
+static void prefaultPages(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  volatile char *pages = data;
+  ptrdiff_t i;
+  for (i = begin; i < end; i++)
+    pages[i*TH_PAGE_SIZE] = 0; /* a write: a read would map the zero page */
+}
+
+/* block of size bytes from posix_memalign */
+static void adviseLargeAlloc(char *base, ptrdiff_t size, int flags)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (flags & TH_LARGE_ALLOC_HUGEPAGES)
+    madvise(base, size, MADV_HUGEPAGE);
+#endif
+  if (flags & TH_LARGE_ALLOC_PREFAULT)
+    THParallelFor(0, (size + TH_PAGE_SIZE-1)/TH_PAGE_SIZE, 16, prefaultPages, base);
+}
+
+void* THAllocAligned(ptrdiff_t size)
+{
+  void *base;
+#if (defined(__unix) || defined(__APPLE__)) && (!defined(DISABLE_POSIX_MEMALIGN))
+  int flags = (size >= TH_LARGE_ALLOC_SIZE ? THGetLargeAllocFlags() : 0);
+  if (posix_memalign(&base, (flags & TH_LARGE_ALLOC_HUGEPAGES ? TH_LARGE_ALLOC_SIZE : 64), size) != 0)
+    return NULL;
+  if (flags)
+    adviseLargeAlloc(base, size, flags);
+#else
+  base = malloc(size);
+#endif
+  return base;
 }
 
+/* a block of THAlloc: padding (up to 64 bytes above 5120 bytes, which keeps
+   the data aligned), this header, then the data; the size is thus known
+   without asking the system */
+typedef struct THHeapHeader
+{
+  ptrdiff_t size; /* bytes of data */
+  ptrdiff_t offset; /* from the start of the block to the data */
+} THHeapHeader;
+
+#define TH_HEAP_HEADER(ptr) ((THHeapHeader*)(ptr) - 1)
+
 static void* THAllocInternal(ptrdiff_t size)
 {
-  void *ptr;
+  char *base;
+  ptrdiff_t offset = sizeof(THHeapHeader);
 
   if (size > 5120)
   {
 #if (defined(__unix) || defined(__APPLE__)) && (!defined(DISABLE_POSIX_MEMALIGN))
-    if (posix_memalign(&ptr, 64, size) != 0)
-      ptr = NULL;
+    offset = 64;
+    base = THAllocAligned(offset + size);
 /*
 #elif defined(_WIN32)
     ptr = _aligned_malloc(size, 64);
 */
 #else
-    ptr = malloc(size);
+    base = malloc(offset + size);
 #endif
   }
   else
   {
-    ptr = malloc(size);
+    base = malloc(offset + size);
   }
 
-  THHeapUpdate(getAllocSize(ptr));
-  return ptr;
+  if (!base)
+    return NULL;
+
+  TH_HEAP_HEADER(base + offset)->size = size;
+  TH_HEAP_HEADER(base + offset)->offset = offset;
+
+  THHeapShard *shard = getHeapShard();
+  heapShardAdd(shard, &shard->numAllocs, 1);
+  heapShardAdd(shard, &shard->histogram[heapHistogramBin(size)], 1);
+  heapUpdate(shard, size);
+  return base + offset;
 }
 
 void* THAlloc(ptrdiff_t size)
 {
   void *ptr;
 
-  if(size < 0)
+  if(size < 0 || size > PTRDIFF_MAX - 64)
     THError("$ Torch: invalid memory size -- maybe an overflow?");
 
   if(size == 0)
@@ -283,30 +521,53 @@ void* THRealloc(void *ptr, ptrdiff_t size)
     return NULL;
   }
 
-  if(size < 0)
+  if(size < 0 || size > PTRDIFF_MAX - 64)
     THError("$ Torch: invalid memory size -- maybe an overflow?");
 
-  ptrdiff_t oldSize = -getAllocSize(ptr);
-  void *newptr = realloc(ptr, size);
+  ptrdiff_t oldSize = TH_HEAP_HEADER(ptr)->size;
+  ptrdiff_t offset = TH_HEAP_HEADER(ptr)->offset;
 
-  if(!newptr && torchGCFunction) {
+  /* realloc would give a large block without the options of THAlloc: it
+     is made by THAlloc instead (a smaller block keeps its place) */
+  if(size >= TH_LARGE_ALLOC_SIZE && size > oldSize && THGetLargeAllocFlags())
+  {
+    void *newptr = THAlloc(size);
+    memcpy(newptr, ptr, oldSize);
+    THFree(ptr);
+    return newptr;
+  }
+
+  char *newbase = realloc((char*)ptr - offset, offset + size);
+
+  if(!newbase && torchGCFunction) {
     torchGCFunction(torchGCData);
-    newptr = realloc(ptr, size);
+    newbase = realloc((char*)ptr - offset, offset + size);
   }
 
-  if(!newptr)
+  if(!newbase)
     THError("$ Torch: not enough memory: you tried to reallocate %dGB. Buy new RAM!", size/1073741824);
 
+  TH_HEAP_HEADER(newbase + offset)->size = size;
+
   // update heapSize only after successfully reallocated
-  THHeapUpdate(oldSize + getAllocSize(newptr));
+  THHeapShard *shard = getHeapShard();
+  heapShardAdd(shard, &shard->numAllocs, 1);
+  heapShardAdd(shard, &shard->numFrees, 1);
+  heapShardAdd(shard, &shard->histogram[heapHistogramBin(size)], 1);
+  heapUpdate(shard, size - oldSize);
 
-  return newptr;
+  return newbase + offset;
 }
 
 void THFree(void *ptr)
 {
-  THHeapUpdate(-getAllocSize(ptr));
-  free(ptr);
+  if(!ptr)
+    return;
+
+  THHeapShard *shard = getHeapShard();
+  heapShardAdd(shard, &shard->numFrees, 1);
+  heapUpdate(shard, -TH_HEAP_HEADER(ptr)->size);
+  free((char*)ptr - TH_HEAP_HEADER(ptr)->offset);
 }
 
 double THLog1p(const double x)
@@ -321,24 +582,25 @@ double THLog1p(const double x)
 
 void THSetNumThreads(int num_threads)
 {
+  THThreadPool_setNumThreads(num_threads);
 #ifdef _OPENMP
+  /* the BLAS might still use OpenMP */
   omp_set_num_threads(num_threads);
 #endif
 }
 
 int THGetNumThreads(void)
 {
-#ifdef _OPENMP
-  return omp_get_max_threads();
-#else
-  return 1;
-#endif
+  return THThreadPool_getNumThreads();
 }
 
 int THGetNumCores(void)
 {
 #ifdef _OPENMP
   return omp_get_num_procs();
+#elif !defined(_WIN32)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0 ? (int)n : 1);
 #else
   return 1;
 #endif
@@ -358,3 +620,15 @@ TH_API void THInferNumThreads(void)
   omp_set_num_threads(mkl_get_max_threads());
 #endif
 }
+
+static int compensatedSum = 0;
+
+void THSetCompensatedSum(int enabled)
+{
+  compensatedSum = (enabled != 0);
+}
+
+int THGetCompensatedSum(void)
+{
+  return compensatedSum;
+}
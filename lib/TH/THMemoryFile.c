@@ -1,5 +1,6 @@
 #include "THMemoryFile.h"
 #include "THFilePrivate.h"
+#include "THAscii.h"
 #include "stdint.h"
 
 typedef struct THMemoryFile__
@@ -18,30 +19,6 @@ static int THMemoryFile_isOpened(THFile *self)
   return (mfself->storage != NULL);
 }
 
-static char *THMemoryFile_strnextspace(char *str_, char *c_)
-{
-  char c;
-
-  while( (c = *str_) )
-  {
-    if( (c != ' ') && (c != '\n') && (c != ':') && (c != ';') )
-      break;
-    str_++;
-  }
-
-  while( (c = *str_) )
-  {
-    if( (c == ' ') || (c == '\n') || (c == ':') || (c == ';') )
-    {
-      *c_ = c;
-      *str_ = '\0';
-      return(str_);
-    }
-    str_++;
-  }
-  return NULL;
-}
-
 static void THMemoryFile_grow(THMemoryFile *self, size_t size)
 {
   size_t missingSpace;
@@ -64,6 +41,14 @@ static void THMemoryFile_grow(THMemoryFile *self, size_t size)
                                        : self->storage->size + missingSpace));
 }
 
+/* room for size bytes and the ending null, the size of the file left as it is */
+static void THMemoryFile_reserve(THMemoryFile *self, size_t size)
+{
+  if(size < self->storage->size)
+    return;
+  THCharStorage_resize(self->storage, THMax(self->storage->size + self->storage->size/2, size+1));
+}
+
 static int THMemoryFile_mode(const char *mode, int *isReadable, int *isWritable)
 {
   *isReadable = 0;
@@ -95,7 +80,7 @@ static int THMemoryFile_mode(const char *mode, int *isReadable, int *isWritable)
 
 /********************************************************/
 
-#define READ_WRITE_METHODS(TYPE, TYPEC, ASCII_READ_ELEM, ASCII_WRITE_ELEM, INSIDE_SPACING) \
+#define READ_WRITE_METHODS(TYPE, TYPEC, ASCII_READ, ASCII_WRITE)  \
   static size_t THMemoryFile_read##TYPEC(THFile *self, TYPE *data, size_t n) \
   {                                                                     \
     THMemoryFile *mfself = (THMemoryFile*)self;                         \
@@ -117,23 +102,7 @@ static int THMemoryFile_mode(const char *mode, int *isReadable, int *isWritable)
     }                                                                   \
     else                                                                \
     {                                                                   \
-      size_t i;                                                           \
-      for(i = 0; i < n; i++)                                            \
-      {                                                                 \
-        size_t nByteRead = 0;                                             \
-        char spaceChar = 0;                                             \
-        char *spacePtr = THMemoryFile_strnextspace(mfself->storage->data+mfself->position, &spaceChar); \
-        ASCII_READ_ELEM;                                                \
-        if(ret == EOF)                                                  \
-        {                                                               \
-          while(mfself->storage->data[mfself->position])                \
-            mfself->position++;                                         \
-        }                                                               \
-        else                                                            \
-          mfself->position += nByteRead;                                \
-        if(spacePtr)                                                    \
-          *spacePtr = spaceChar;                                        \
-      }                                                                 \
+      nread = ASCII_READ;                                               \
       if(mfself->file.isAutoSpacing && (n > 0))                         \
       {                                                                 \
         if( (mfself->position < mfself->size) && (mfself->storage->data[mfself->position] == '\n') ) \
@@ -175,35 +144,11 @@ static int THMemoryFile_mode(const char *mode, int *isReadable, int *isWritable)
     }                                                                   \
     else                                                                \
     {                                                                   \
-      size_t i;                                                           \
-      for(i = 0; i < n; i++)                                            \
+      ASCII_WRITE;                                                      \
+      if(mfself->file.isAutoSpacing)                                    \
       {                                                                 \
-        ssize_t nByteWritten;                                           \
-        while (1)                                                       \
-        {                                                               \
-          ASCII_WRITE_ELEM;                                             \
-          if( (nByteWritten > -1) && (nByteWritten < mfself->storage->size-mfself->position) ) \
-          {                                                             \
-            mfself->position += nByteWritten;                           \
-            break;                                                      \
-          }                                                             \
-          THMemoryFile_grow(mfself, mfself->storage->size + (mfself->storage->size/2) + 2); \
-        }                                                               \
-        if(mfself->file.isAutoSpacing)                                  \
-        {                                                               \
-          if(i < n-1)                                                   \
-          {                                                             \
-            THMemoryFile_grow(mfself, mfself->position+1);              \
-            sprintf(mfself->storage->data+mfself->position, " ");       \
-            mfself->position++;                                         \
-          }                                                             \
-          if(i == n-1)                                                  \
-          {                                                             \
-            THMemoryFile_grow(mfself, mfself->position+1);              \
-            sprintf(mfself->storage->data+mfself->position, "\n");      \
-            mfself->position++;                                         \
-          }                                                             \
-        }                                                               \
+        THMemoryFile_reserve(mfself, mfself->position+1);               \
+        mfself->storage->data[mfself->position++] = '\n';               \
       }                                                                 \
       if(mfself->position > mfself->size)                               \
       {                                                                 \
@@ -289,65 +234,107 @@ static void THMemoryFile_free(THFile *self)
   THFree(mfself);
 }
 
+/* Ascii numbers: each read after the spaces, ':' and ';' before it (up to the
+   end of the text), written by batches formatted in place */
+
+#define TH_MEMORYFILE_ASCII_BATCH (64 << 10)
+
+#define ASCII_METHODS(TYPE, TYPEC, PARSE)                               \
+  static size_t THMemoryFile_readAscii##TYPEC(THMemoryFile *self, TYPE *data, size_t n) \
+  {                                                                     \
+    size_t i;                                                           \
+    for(i = 0; i < n; i++)                                              \
+    {                                                                   \
+      char *str = self->storage->data+self->position, *end;             \
+      TYPE value;                                                       \
+      while(*str == ' ' || (*str >= '\t' && *str <= '\r') || *str == ':' || *str == ';') \
+        str++;                                                          \
+      value = PARSE(str, &end);                                         \
+      if(end == str)                                                    \
+      {                                                                 \
+        if(*str == '\0')                                                \
+          self->position = str - self->storage->data;                   \
+        break;                                                          \
+      }                                                                 \
+      data[i] = value;                                                  \
+      self->position = end - self->storage->data;                       \
+    }                                                                   \
+    return i;                                                           \
+  }                                                                     \
+                                                                        \
+  static void THMemoryFile_writeAscii##TYPEC(THMemoryFile *self, TYPE *data, size_t n) \
+  {                                                                     \
+    size_t i;                                                           \
+    for(i = 0; i < n; i += TH_MEMORYFILE_ASCII_BATCH)                   \
+    {                                                                   \
+      size_t m = THMin(TH_MEMORYFILE_ASCII_BATCH, n-i);                 \
+      THMemoryFile_reserve(self, self->position + m*TH_ASCII_SIZE + 1); \
+      self->position += THAscii_write##TYPEC(self->storage->data+self->position, data+i, m, self->file.isAutoSpacing); \
+      if(self->file.isAutoSpacing && (i+m < n))                         \
+        self->storage->data[self->position++] = ' ';                    \
+    }                                                                   \
+  }
+
+#define THMemoryFile_parseShort(str, end) ((short)THAscii_parseLong(str, end))
+#define THMemoryFile_parseInt(str, end) ((int)THAscii_parseLong(str, end))
+#define THMemoryFile_parseHalf(str, end) TH_float2half(THAscii_parseFloat(str, end))
+
+ASCII_METHODS(short, Short, THMemoryFile_parseShort)
+ASCII_METHODS(int, Int, THMemoryFile_parseInt)
+ASCII_METHODS(long, Long, THAscii_parseLong)
+ASCII_METHODS(float, Float, THAscii_parseFloat)
+ASCII_METHODS(double, Double, THAscii_parseDouble)
+ASCII_METHODS(THHalf, Half, THMemoryFile_parseHalf)
+
+/* raw characters */
+static size_t THMemoryFile_readAsciiChars(THMemoryFile *self, void *data, size_t n)
+{
+  size_t nread = (self->position + n <= self->size ? n : self->size-self->position);
+  memmove(data, self->storage->data+self->position, nread);
+  self->position += nread;
+  return nread;
+}
+
+static void THMemoryFile_writeAsciiChars(THMemoryFile *self, void *data, size_t n)
+{
+  THMemoryFile_reserve(self, self->position+n);
+  memmove(self->storage->data+self->position, data, n);
+  self->position += n;
+}
+
 /* READ_WRITE_METHODS(bool, Bool, */
 /*                    int value = 0; int ret = sscanf(mfself->storage->data+mfself->position, "%d%n", &value, &nByteRead); data[i] = (value ? 1 : 0), */
 /*                    int value = (data[i] ? 1 : 0); nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%d", value), */
 /*                    1) */
 
 READ_WRITE_METHODS(unsigned char, Byte,
-                   size_t ret = (mfself->position + n <= mfself->size ? n : mfself->size-mfself->position);  \
-                   if(spacePtr) *spacePtr = spaceChar; \
-                   nByteRead = ret; \
-                   nread = ret; \
-                   i = n-1; \
-                   memmove(data, mfself->storage->data+mfself->position, nByteRead),
-                   nByteWritten = (n < mfself->storage->size-mfself->position ? n : -1); \
-                   i = n-1; \
-                   if(nByteWritten > -1)
-                     memmove(mfself->storage->data+mfself->position, data, nByteWritten),
-                   0)
-
-/* DEBUG: we should check if %n is count or not as a element (so ret might need to be ret-- on some systems) */
+                   THMemoryFile_readAsciiChars(mfself, data, n),
+                   THMemoryFile_writeAsciiChars(mfself, data, n))
+
 /* Note that we do a trick for char */
 READ_WRITE_METHODS(char, Char,
-                   size_t ret = (mfself->position + n <= mfself->size ? n : mfself->size-mfself->position);  \
-                   if(spacePtr) *spacePtr = spaceChar; \
-                   nByteRead = ret; \
-                   nread = ret; \
-                   i = n-1; \
-                   memmove(data, mfself->storage->data+mfself->position, nByteRead),
-                   nByteWritten = (n < mfself->storage->size-mfself->position ? n : -1); \
-                   i = n-1; \
-                   if(nByteWritten > -1)
-                     memmove(mfself->storage->data+mfself->position, data, nByteWritten),
-                   0)
+                   THMemoryFile_readAsciiChars(mfself, data, n),
+                   THMemoryFile_writeAsciiChars(mfself, data, n))
 
 READ_WRITE_METHODS(short, Short,
-                   int nByteRead_; int ret = sscanf(mfself->storage->data+mfself->position, "%hd%n", &data[i], &nByteRead_); nByteRead = nByteRead_; if(ret <= 0) break; else nread++,
-                   nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%hd", data[i]),
-                   1)
+                   THMemoryFile_readAsciiShort(mfself, data, n),
+                   THMemoryFile_writeAsciiShort(mfself, data, n))
 
 READ_WRITE_METHODS(int, Int,
-                   int nByteRead_; int ret = sscanf(mfself->storage->data+mfself->position, "%d%n", &data[i], &nByteRead_); nByteRead = nByteRead_; if(ret <= 0) break; else nread++,
-                   nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%d", data[i]),
-                   1)
+                   THMemoryFile_readAsciiInt(mfself, data, n),
+                   THMemoryFile_writeAsciiInt(mfself, data, n))
 
 READ_WRITE_METHODS(float, Float,
-                   int nByteRead_; int ret = sscanf(mfself->storage->data+mfself->position, "%g%n", &data[i], &nByteRead_); nByteRead = nByteRead_; if(ret <= 0) break; else nread++,
-                   nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%.9g", data[i]),
-                   1)
+                   THMemoryFile_readAsciiFloat(mfself, data, n),
+                   THMemoryFile_writeAsciiFloat(mfself, data, n))
 
 READ_WRITE_METHODS(THHalf, Half,
-                   int nByteRead_; float buf; \
-                   int ret = sscanf(mfself->storage->data+mfself->position, "%g%n", &buf, &nByteRead_); \
-                   data[i] = TH_float2half(buf); nByteRead = nByteRead_; if(ret <= 0) break; else nread++,
-                   nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%.9g", TH_half2float(data[i])),
-                   1)
+                   THMemoryFile_readAsciiHalf(mfself, data, n),
+                   THMemoryFile_writeAsciiHalf(mfself, data, n))
 
 READ_WRITE_METHODS(double, Double,
-                   int nByteRead_; int ret = sscanf(mfself->storage->data+mfself->position, "%lg%n", &data[i], &nByteRead_); nByteRead = nByteRead_; if(ret <= 0) break; else nread++,
-                   nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%.17g", data[i]),
-                   1)
+                   THMemoryFile_readAsciiDouble(mfself, data, n),
+                   THMemoryFile_writeAsciiDouble(mfself, data, n))
 
 int THDiskFile_isLittleEndianCPU(void);
 
@@ -397,23 +384,7 @@ static size_t THMemoryFile_readLong(THFile *self, long *data, size_t n)
   }
   else
   {
-    size_t i;
-    for(i = 0; i < n; i++)
-    {
-      size_t nByteRead = 0;
-      char spaceChar = 0;
-      char *spacePtr = THMemoryFile_strnextspace(mfself->storage->data+mfself->position, &spaceChar);
-      int nByteRead_; int ret = sscanf(mfself->storage->data+mfself->position, "%ld%n", &data[i], &nByteRead_); nByteRead = nByteRead_; if(ret <= 0) break; else nread++;
-      if(ret == EOF)
-      {
-        while(mfself->storage->data[mfself->position])
-          mfself->position++;
-      }
-      else
-        mfself->position += nByteRead;
-      if(spacePtr)
-        *spacePtr = spaceChar;
-    }
+    nread = THMemoryFile_readAsciiLong(mfself, data, n);
     if(mfself->file.isAutoSpacing && (n > 0))
     {
       if( (mfself->position < mfself->size) && (mfself->storage->data[mfself->position] == '\n') )
@@ -481,35 +452,11 @@ static size_t THMemoryFile_writeLong(THFile *self, long *data, size_t n)
   }
   else
   {
-    size_t i;
-    for(i = 0; i < n; i++)
+    THMemoryFile_writeAsciiLong(mfself, data, n);
+    if(mfself->file.isAutoSpacing)
     {
-      ssize_t nByteWritten;
-      while (1)
-      {
-        nByteWritten = snprintf(mfself->storage->data+mfself->position, mfself->storage->size-mfself->position, "%ld", data[i]);
-        if( (nByteWritten > -1) && (nByteWritten < mfself->storage->size-mfself->position) )
-        {
-          mfself->position += nByteWritten;
-          break;
-        }
-        THMemoryFile_grow(mfself, mfself->storage->size + (mfself->storage->size/2) + 2);
-      }
-      if(mfself->file.isAutoSpacing)
-      {
-        if(i < n-1)
-        {
-          THMemoryFile_grow(mfself, mfself->position+1);
-          sprintf(mfself->storage->data+mfself->position, " ");
-          mfself->position++;
-        }
-        if(i == n-1)
-        {
-          THMemoryFile_grow(mfself, mfself->position+1);
-          sprintf(mfself->storage->data+mfself->position, "\n");
-          mfself->position++;
-        }
-      }
+      THMemoryFile_reserve(mfself, mfself->position+1);
+      mfself->storage->data[mfself->position++] = '\n';
     }
     if(mfself->position > mfself->size)
     {
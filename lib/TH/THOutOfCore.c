@@ -0,0 +1,203 @@
+#include "THOutOfCore.h"
+
+#if HAVE_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+#define TH_OUT_OF_CORE 1
+#endif
+
+/* a chunk is not smaller (per array), whatever the budget */
+#define TH_OUT_OF_CORE_MIN_CHUNK ((ptrdiff_t)256 << 10)
+
+static ptrdiff_t budget = 0;
+
+void THOutOfCore_setBudget(ptrdiff_t size)
+{
+  THArgCheck(size >= 0, 1, "budget must be positive or 0");
+  budget = size;
+}
+
+ptrdiff_t THOutOfCore_getBudget(void)
+{
+  return budget;
+}
+
+#ifdef TH_OUT_OF_CORE
+
+typedef struct THOutOfCoreMapping
+{
+  char *data;
+  ptrdiff_t size;
+  int release;
+} THOutOfCoreMapping;
+
+/* the mappings alive, unordered: a process has a few */
+static THOutOfCoreMapping *mappings = NULL;
+static int numMappings = 0;
+static int maxMappings = 0;
+static pthread_mutex_t mappingsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void THOutOfCore_addMapping(void *data, ptrdiff_t size, int release)
+{
+  pthread_mutex_lock(&mappingsMutex);
+  if(numMappings == maxMappings)
+  {
+    int n = (maxMappings ? 2*maxMappings : 16);
+    THOutOfCoreMapping *m = realloc(mappings, n*sizeof(THOutOfCoreMapping));
+    if(!m)
+    {
+      pthread_mutex_unlock(&mappingsMutex);
+      return; /* not chunked, which is only slower */
+    }
+    mappings = m;
+    maxMappings = n;
+  }
+  mappings[numMappings].data = data;
+  mappings[numMappings].size = size;
+  mappings[numMappings].release = release;
+  numMappings++;
+  pthread_mutex_unlock(&mappingsMutex);
+}
+
+void THOutOfCore_removeMapping(void *data)
+{
+  int i;
+  pthread_mutex_lock(&mappingsMutex);
+  for(i = 0; i < numMappings; i++)
+  {
+    if(mappings[i].data == data)
+    {
+      mappings[i] = mappings[--numMappings];
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mappingsMutex);
+}
+
+static ptrdiff_t THOutOfCore_pageSize(void)
+{
+  static ptrdiff_t size = 0;
+  if(size == 0)
+    size = sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+static char* THOutOfCore_pageOf(const char *ptr)
+{
+  return (char*)((size_t)ptr & ~(size_t)(THOutOfCore_pageSize()-1));
+}
+
+ptrdiff_t THOutOfCore_begin(THOutOfCoreLoop *loop, ptrdiff_t size, ptrdiff_t granularity,
+                            const void *a, ptrdiff_t aSize, const void *b, ptrdiff_t bSize,
+                            const void *c, ptrdiff_t cSize)
+{
+  const char *arrays[TH_OUT_OF_CORE_ARRAYS];
+  ptrdiff_t elemSizes[TH_OUT_OF_CORE_ARRAYS];
+  ptrdiff_t bytes = 0, chunk;
+  int i, j;
+
+  loop->n = 0;
+  loop->size = size;
+  loop->chunk = size;
+  if(budget == 0 || numMappings == 0)
+    return size;
+
+  arrays[0] = a;
+  arrays[1] = b;
+  arrays[2] = c;
+  elemSizes[0] = aSize;
+  elemSizes[1] = bSize;
+  elemSizes[2] = cSize;
+  pthread_mutex_lock(&mappingsMutex);
+  for(i = 0; i < TH_OUT_OF_CORE_ARRAYS; i++)
+  {
+    for(j = 0; arrays[i] && j < numMappings; j++)
+    {
+      const THOutOfCoreMapping *m = &mappings[j];
+      if(arrays[i] >= m->data && arrays[i] + size*elemSizes[i] <= m->data + m->size)
+      {
+        loop->data[loop->n] = (char*)arrays[i];
+        loop->elemSize[loop->n] = elemSizes[i];
+        loop->release[loop->n] = m->release;
+        loop->n++;
+        bytes += elemSizes[i];
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&mappingsMutex);
+  if(loop->n == 0 || size*bytes <= budget)
+    return size;
+
+  /* the chunk which runs and the next one, of each array */
+  chunk = (budget/2 > loop->n*TH_OUT_OF_CORE_MIN_CHUNK ? budget/2 : loop->n*TH_OUT_OF_CORE_MIN_CHUNK)/bytes;
+  chunk = chunk/granularity*granularity;
+  if(chunk < granularity)
+    chunk = granularity;
+  if(chunk >= size)
+    return size;
+  loop->chunk = chunk;
+  THOutOfCore_prefetch(loop, 0);
+  return chunk;
+}
+
+void THOutOfCore_prefetch(THOutOfCoreLoop *loop, ptrdiff_t begin)
+{
+  ptrdiff_t end = (loop->size - begin < loop->chunk ? loop->size : begin + loop->chunk);
+  int i;
+  if(begin >= loop->size)
+    return;
+  for(i = 0; i < loop->n; i++)
+  {
+    char *first = THOutOfCore_pageOf(loop->data[i] + begin*loop->elemSize[i]);
+    madvise(first, loop->data[i] + end*loop->elemSize[i] - first, MADV_WILLNEED);
+  }
+}
+
+void THOutOfCore_release(THOutOfCoreLoop *loop, ptrdiff_t begin, ptrdiff_t end)
+{
+  int i;
+  for(i = 0; i < loop->n; i++)
+  {
+    char *first, *last;
+    if(!loop->release[i])
+      continue;
+    first = THOutOfCore_pageOf(loop->data[i] + begin*loop->elemSize[i]);
+    last = loop->data[i] + end*loop->elemSize[i];
+    if(end < loop->size)
+      last = THOutOfCore_pageOf(last);
+    if(last > first)
+      madvise(first, last - first, MADV_DONTNEED);
+  }
+}
+
+#else
+
+void THOutOfCore_addMapping(void *data, ptrdiff_t size, int release)
+{
+}
+
+void THOutOfCore_removeMapping(void *data)
+{
+}
+
+ptrdiff_t THOutOfCore_begin(THOutOfCoreLoop *loop, ptrdiff_t size, ptrdiff_t granularity,
+                            const void *a, ptrdiff_t aSize, const void *b, ptrdiff_t bSize,
+                            const void *c, ptrdiff_t cSize)
+{
+  loop->n = 0;
+  loop->size = size;
+  loop->chunk = size;
+  return size;
+}
+
+void THOutOfCore_prefetch(THOutOfCoreLoop *loop, ptrdiff_t begin)
+{
+}
+
+void THOutOfCore_release(THOutOfCoreLoop *loop, ptrdiff_t begin, ptrdiff_t end)
+{
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef TH_OUT_OF_CORE_INC
+#define TH_OUT_OF_CORE_INC
+
+#include "THGeneral.h"
+
+/******************************************************************************
+ * Out-of-core execution, for tensors on file mappings larger than memory
+ *  The contiguous element-wise ops, copies and reductions over more bytes of
+ *  mapped storages (THMapAllocator, THRefcountedMapAllocator) than the
+ *  budget run in chunks: the pages of the next chunk are asked for while the
+ *  current one runs (madvise WILLNEED), and those of a chunk done are given
+ *  back (DONTNEED), so that the resident pages of the mappings stay within
+ *  the budget rather than all the file going through the process.
+ *  The pages of writable private mappings (copy-on-write) are not given
+ *  back: it would drop the changes made to them.
+ *  Off (budget 0) by default; process-wide.
+ ******************************************************************************/
+
+/*
+ * bytes of mapped storages resident for one op (0: no chunking)
+*/
+TH_API void THOutOfCore_setBudget(ptrdiff_t size);
+TH_API ptrdiff_t THOutOfCore_getBudget(void);
+
+/*
+ * mappings of the map allocators, made and unmapped; release: whether their
+ * pages can be given back
+*/
+TH_API void THOutOfCore_addMapping(void *data, ptrdiff_t size, int release);
+TH_API void THOutOfCore_removeMapping(void *data);
+
+#define TH_OUT_OF_CORE_ARRAYS 3
+
+/* the mapped arrays of a chunked loop */
+typedef struct THOutOfCoreLoop
+{
+  int n;
+  char *data[TH_OUT_OF_CORE_ARRAYS];
+  ptrdiff_t elemSize[TH_OUT_OF_CORE_ARRAYS];
+  int release[TH_OUT_OF_CORE_ARRAYS];
+  ptrdiff_t size;  /* elements */
+  ptrdiff_t chunk;
+} THOutOfCoreLoop;
+
+/*
+ * a loop over size elements of the arrays a, b and c, of elements of aSize,
+ * bSize and cSize bytes (NULL arrays are ignored): returns the elements of a
+ * chunk, a multiple of granularity, or size if the loop is not to be chunked
+ * (no array on a mapping, budget 0 or not exceeded); a chunked loop asks for
+ * its first chunk, then runs:
+ *   for(begin = 0; begin < size; begin += chunk) {
+ *     end = min(begin+chunk, size);
+ *     THOutOfCore_prefetch(&loop, end);
+ *     ... [begin, end) ...
+ *     THOutOfCore_release(&loop, begin, end);
+ *   }
+*/
+TH_API ptrdiff_t THOutOfCore_begin(THOutOfCoreLoop *loop, ptrdiff_t size, ptrdiff_t granularity,
+                                   const void *a, ptrdiff_t aSize, const void *b, ptrdiff_t bSize,
+                                   const void *c, ptrdiff_t cSize);
+
+/*
+ * asks for the chunk starting at element begin (nothing past the end)
+*/
+TH_API void THOutOfCore_prefetch(THOutOfCoreLoop *loop, ptrdiff_t begin);
+
+/*
+ * gives back the pages of the elements [begin, end) done (the page of end is
+ * kept for the next chunk, unless end is the last element)
+*/
+TH_API void THOutOfCore_release(THOutOfCoreLoop *loop, ptrdiff_t begin, ptrdiff_t end);
+
+#endif
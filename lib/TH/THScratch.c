@@ -0,0 +1,181 @@
+#include "THScratch.h"
+
+#ifndef TH_HAVE_THREAD
+#define __thread
+#elif _MSC_VER
+#define __thread __declspec( thread )
+#endif
+
+#if defined(TH_HAVE_THREAD) && !defined(_WIN32)
+#define TH_SCRATCH_THREAD_EXIT 1
+#include <pthread.h>
+#endif
+
+#define TH_SCRATCH_ALIGN 64
+
+/* just before each block of the workspace */
+typedef struct THScratchHeader
+{
+  char *previous; /* block below, NULL for the first one; for a block of
+                    the heap, what THAlloc gave */
+  ptrdiff_t size;
+  int freed;
+} THScratchHeader;
+
+#define TH_SCRATCH_HEADER(ptr) ((THScratchHeader*)(ptr) - 1)
+
+typedef struct THScratch
+{
+  char *data; /* THAlloc'ed, aligned on 64 bytes */
+  ptrdiff_t size;
+  char *last; /* block on top, NULL if empty */
+  ptrdiff_t wanted; /* largest room asked, for the next growth */
+} THScratch;
+
+static __thread THScratch scratch = {NULL, 0, NULL, 0};
+static ptrdiff_t scratchLimit = (ptrdiff_t)64 << 20;
+
+#ifdef TH_SCRATCH_THREAD_EXIT
+
+static pthread_key_t scratchKey;
+static pthread_once_t scratchOnce = PTHREAD_ONCE_INIT;
+
+static void THScratch_threadExit(void *data)
+{
+  THFree(data);
+  scratch.data = NULL;
+  scratch.size = 0;
+  scratch.last = NULL;
+}
+
+static void THScratch_createKey(void)
+{
+  pthread_key_create(&scratchKey, THScratch_threadExit);
+}
+
+#endif
+
+/* first block address after ptr, leaving room for the header */
+static char* THScratch_align(char *ptr)
+{
+  return (char*)(((size_t)ptr + sizeof(THScratchHeader) + TH_SCRATCH_ALIGN-1) & ~(size_t)(TH_SCRATCH_ALIGN-1));
+}
+
+/* the workspace is empty */
+static void THScratch_grow(ptrdiff_t size)
+{
+  /* nothing points to the old workspace if THAlloc raises an error */
+  THFree(scratch.data);
+  scratch.data = NULL;
+  scratch.size = 0;
+#ifdef TH_SCRATCH_THREAD_EXIT
+  pthread_once(&scratchOnce, THScratch_createKey);
+  pthread_setspecific(scratchKey, NULL);
+#endif
+  scratch.data = THAlloc(size);
+  scratch.size = size;
+#ifdef TH_SCRATCH_THREAD_EXIT
+  pthread_setspecific(scratchKey, scratch.data);
+#endif
+}
+
+void* THScratch_alloc(ptrdiff_t size)
+{
+  char *top, *ptr;
+  ptrdiff_t room;
+
+  if(size < 0)
+    THError("$ Torch: invalid memory size -- maybe an overflow?");
+
+  top = (scratch.last ? scratch.last + TH_SCRATCH_HEADER(scratch.last)->size : scratch.data);
+  room = (scratch.last ? top - scratch.data : 0) + sizeof(THScratchHeader) + TH_SCRATCH_ALIGN + size;
+  if(room > scratch.wanted)
+    scratch.wanted = room;
+
+  if(!scratch.last)
+  {
+    room = (scratch.wanted < scratchLimit ? scratch.wanted : scratchLimit);
+    if(room > scratch.size)
+    {
+      THScratch_grow(room);
+      top = scratch.data;
+    }
+  }
+
+  /* a block ends before the end of the workspace, which is not in it */
+  ptr = (top ? THScratch_align(top) : NULL);
+  if(!ptr || size >= scratch.data + scratch.size - ptr)
+  {
+    char *data = THAlloc(2*TH_SCRATCH_ALIGN + size);
+    ptr = THScratch_align(data);
+    TH_SCRATCH_HEADER(ptr)->previous = data;
+    return ptr;
+  }
+
+  TH_SCRATCH_HEADER(ptr)->previous = scratch.last;
+  TH_SCRATCH_HEADER(ptr)->size = size;
+  TH_SCRATCH_HEADER(ptr)->freed = 0;
+  scratch.last = ptr;
+  return ptr;
+}
+
+void THScratch_free(void *ptr)
+{
+  if(!ptr)
+    return;
+
+  if((char*)ptr < scratch.data || (char*)ptr >= scratch.data + scratch.size)
+  {
+    THFree(TH_SCRATCH_HEADER(ptr)->previous);
+    return;
+  }
+
+  TH_SCRATCH_HEADER(ptr)->freed = 1;
+  while(scratch.last && TH_SCRATCH_HEADER(scratch.last)->freed)
+    scratch.last = TH_SCRATCH_HEADER(scratch.last)->previous;
+}
+
+void THScratch_release(void)
+{
+  if(scratch.last)
+    return;
+  THFree(scratch.data);
+  scratch.data = NULL;
+  scratch.size = 0;
+  scratch.wanted = 0;
+#ifdef TH_SCRATCH_THREAD_EXIT
+  pthread_once(&scratchOnce, THScratch_createKey);
+  pthread_setspecific(scratchKey, NULL);
+#endif
+}
+
+ptrdiff_t THScratch_size(void)
+{
+  return scratch.size;
+}
+
+void THScratch_setLimit(ptrdiff_t size)
+{
+  scratchLimit = size;
+}
+
+ptrdiff_t THScratch_getLimit(void)
+{
+  return scratchLimit;
+}
+
+static void *THScratchAllocator_alloc(void* ctx, ptrdiff_t size)
+{
+  return (size > 0 ? THScratch_alloc(size) : NULL);
+}
+
+static void THScratchAllocator_free(void* ctx, void* ptr)
+{
+  THScratch_free(ptr);
+}
+
+THAllocator THScratchAllocator = {
+  &THScratchAllocator_alloc,
+  NULL, /* resized by malloc and free (see THStorage_(resize)) */
+  &THScratchAllocator_free
+};
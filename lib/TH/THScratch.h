@@ -0,0 +1,45 @@
+#ifndef TH_SCRATCH_INC
+#define TH_SCRATCH_INC
+
+#include "THAllocator.h"
+
+/******************************************************************************
+ * Scratch workspaces for the temporaries of the TH kernels
+ *  Each thread has a workspace, taken with THAlloc, from which blocks are
+ *  cut as on a stack (freeing the last block, or a block below freed ones,
+ *  gives their room back). The workspace only grows, when it is empty, to
+ *  the largest room asked since (up to the limit): in the steady state of a
+ *  loop, the temporaries are not allocated anymore.
+ *  Blocks which do not fit come from THAlloc, as do those larger than the
+ *  limit. A block must be freed by the thread which made it, before any
+ *  THError (a block left in use keeps the workspace from growing).
+ ******************************************************************************/
+
+/*
+ * block of size bytes, aligned on 64 bytes
+*/
+TH_API void* THScratch_alloc(ptrdiff_t size);
+TH_API void THScratch_free(void *ptr);
+
+/*
+ * gives the workspace of the calling thread back to the heap, if no block
+ * of it is in use
+*/
+TH_API void THScratch_release(void);
+
+/*
+ * bytes of the workspace of the calling thread
+*/
+TH_API ptrdiff_t THScratch_size(void);
+
+/*
+ * largest workspace of a thread, in bytes (64MB by default)
+*/
+TH_API void THScratch_setLimit(ptrdiff_t size);
+TH_API ptrdiff_t THScratch_getLimit(void);
+
+/* storages on blocks of the workspace: tensors for temporaries
+ */
+extern THAllocator THScratchAllocator;
+
+#endif
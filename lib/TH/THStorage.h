@@ -3,6 +3,9 @@
 
 #include "THGeneral.h"
 #include "THAllocator.h"
+#include "THArena.h"
+#include "THScratch.h"
+#include "THOutOfCore.h"
 
 #define THStorage        TH_CONCAT_3(TH,Real,Storage)
 #define THStorage_(NAME) TH_CONCAT_4(TH,Real,Storage_,NAME)
@@ -0,0 +1,289 @@
+#include "THThreadPool.h"
+#include "THAtomic.h"
+
+#include <stdlib.h>
+
+#ifndef TH_HAVE_THREAD
+#define __thread
+#elif _MSC_VER
+#define __thread __declspec( thread )
+#endif
+
+/* smallest amount of work (in simple element-wise operations) worth waking
+   up a worker for: below that, the wake-up costs more than it saves */
+#define TH_PARALLEL_MIN_WORK 32768
+#define TH_PARALLEL_MAX_THREADS 256
+
+ptrdiff_t THParallelGrain(ptrdiff_t cost)
+{
+  ptrdiff_t grain;
+  if(cost < 1)
+    cost = 1;
+  grain = TH_PARALLEL_MIN_WORK / cost;
+  return (grain > 0 ? grain : 1);
+}
+
+#ifdef _WIN32
+
+/* no pool: everything runs on the calling thread */
+
+void THParallelFor(ptrdiff_t begin, ptrdiff_t end, ptrdiff_t grain, THParallelFunction f, void *data)
+{
+  if(begin < end)
+    f(data, begin, end);
+}
+
+void THThreadPool_setNumThreads(int num_threads)
+{
+}
+
+int THThreadPool_getNumThreads(void)
+{
+  return 1;
+}
+
+#else
+
+#include <pthread.h>
+#include <unistd.h>
+
+/* share of a job: chunks are taken from next, up to end */
+typedef struct THThreadPoolShare
+{
+  ptrdiff_t volatile next;
+  ptrdiff_t end;
+  char padding[64-2*sizeof(ptrdiff_t)]; /* one cache line per share */
+} THThreadPoolShare;
+
+static struct
+{
+  pthread_mutex_t owner;  /* held by the thread running a job */
+  pthread_mutex_t mutex;  /* protects generation, pending and stop */
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  pthread_t *workers;
+  int nworkers;
+  int nthreads;           /* 0 until set or inferred */
+  int forkhandler;
+  int stop;
+  unsigned long generation;
+  int pending;
+
+  /* current job */
+  THParallelFunction f;
+  void *data;
+  ptrdiff_t grain;
+  int nshares;
+  int volatile joined;
+  THThreadPoolShare shares[TH_PARALLEL_MAX_THREADS];
+} pool = {
+  PTHREAD_MUTEX_INITIALIZER,
+  PTHREAD_MUTEX_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  PTHREAD_COND_INITIALIZER
+};
+
+/* set while running chunks: nested jobs run serially */
+static __thread int inParallel = 0;
+
+static int THThreadPool_defaultNumThreads(void)
+{
+  const char *env = getenv("OMP_NUM_THREADS");
+  long n = (env ? atol(env) : 0);
+  if(n <= 0)
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+  if(n < 1)
+    n = 1;
+  if(n > TH_PARALLEL_MAX_THREADS)
+    n = TH_PARALLEL_MAX_THREADS;
+  return (int)n;
+}
+
+static void THThreadPool_participate(int id)
+{
+  int nshares = pool.nshares;
+  ptrdiff_t grain = pool.grain;
+  int k;
+
+  inParallel = 1;
+  for(k = 0; k < nshares; k++)
+  {
+    /* own share first, then steal from the next ones */
+    THThreadPoolShare *share = &pool.shares[(id+k) % nshares];
+    while(1)
+    {
+      ptrdiff_t begin = THAtomicAddPtrdiff(&share->next, grain);
+      if(begin >= share->end)
+        break;
+      pool.f(pool.data, begin, (share->end - begin > grain ? begin + grain : share->end));
+    }
+  }
+  inParallel = 0;
+}
+
+static void* THThreadPool_worker(void *arg)
+{
+  unsigned long seen = (unsigned long)(size_t)arg;
+
+  pthread_mutex_lock(&pool.mutex);
+  while(1)
+  {
+    while(!pool.stop && pool.generation == seen)
+      pthread_cond_wait(&pool.wake, &pool.mutex);
+    if(pool.stop)
+      break;
+    seen = pool.generation;
+    pthread_mutex_unlock(&pool.mutex);
+
+    THThreadPool_participate(THAtomicAdd(&pool.joined, 1) + 1);
+
+    pthread_mutex_lock(&pool.mutex);
+    if(--pool.pending == 0)
+      pthread_cond_signal(&pool.done);
+  }
+  pthread_mutex_unlock(&pool.mutex);
+  return NULL;
+}
+
+/* the child of a fork has no workers: start afresh */
+static void THThreadPool_atforkChild(void)
+{
+  pthread_mutex_init(&pool.owner, NULL);
+  pthread_mutex_init(&pool.mutex, NULL);
+  pthread_cond_init(&pool.wake, NULL);
+  pthread_cond_init(&pool.done, NULL);
+  free(pool.workers);
+  pool.workers = NULL;
+  pool.nworkers = 0;
+  pool.stop = 0;
+  pool.pending = 0;
+  inParallel = 0;
+}
+
+/* owner must be held */
+static void THThreadPool_stopWorkers(void)
+{
+  int i;
+  if(pool.nworkers == 0)
+    return;
+  pthread_mutex_lock(&pool.mutex);
+  pool.stop = 1;
+  pthread_cond_broadcast(&pool.wake);
+  pthread_mutex_unlock(&pool.mutex);
+  for(i = 0; i < pool.nworkers; i++)
+    pthread_join(pool.workers[i], NULL);
+  free(pool.workers);
+  pool.workers = NULL;
+  pool.nworkers = 0;
+  pool.stop = 0;
+}
+
+/* owner must be held */
+static void THThreadPool_startWorkers(void)
+{
+  int n;
+  if(pool.nthreads == 0)
+    pool.nthreads = THThreadPool_defaultNumThreads();
+  n = pool.nthreads - 1;
+  if(pool.workers || n == 0)
+    return;
+  if(!pool.forkhandler)
+  {
+    pthread_atfork(NULL, NULL, THThreadPool_atforkChild);
+    pool.forkhandler = 1;
+  }
+  pool.workers = malloc(sizeof(pthread_t)*n);
+  if(!pool.workers)
+    return;
+  while(pool.nworkers < n)
+  {
+    if(pthread_create(&pool.workers[pool.nworkers], NULL, THThreadPool_worker, (void*)(size_t)pool.generation) != 0)
+      break;
+    pool.nworkers++;
+  }
+}
+
+void THParallelFor(ptrdiff_t begin, ptrdiff_t end, ptrdiff_t grain, THParallelFunction f, void *data)
+{
+  ptrdiff_t n = end - begin;
+  ptrdiff_t size, rem, offset;
+  int nshares, k;
+
+  if(n <= 0)
+    return;
+  if(grain < 1)
+    grain = 1;
+
+  /* too small, nested, or the pool is busy with another thread's job */
+  if(n < 2*grain || inParallel || pthread_mutex_trylock(&pool.owner) != 0)
+  {
+    f(data, begin, end);
+    return;
+  }
+
+  THThreadPool_startWorkers();
+  nshares = pool.nworkers + 1;
+  if(n / grain < nshares)
+    nshares = (int)(n / grain);
+  if(nshares < 2)
+  {
+    pthread_mutex_unlock(&pool.owner);
+    f(data, begin, end);
+    return;
+  }
+
+  size = n / nshares;
+  rem = n % nshares;
+  offset = begin;
+  for(k = 0; k < nshares; k++)
+  {
+    pool.shares[k].next = offset;
+    offset += size + (k < rem ? 1 : 0);
+    pool.shares[k].end = offset;
+  }
+  pool.f = f;
+  pool.data = data;
+  pool.grain = grain;
+  pool.nshares = nshares;
+  pool.joined = 0;
+
+  pthread_mutex_lock(&pool.mutex);
+  pool.pending = pool.nworkers;
+  pool.generation++;
+  pthread_cond_broadcast(&pool.wake);
+  pthread_mutex_unlock(&pool.mutex);
+
+  THThreadPool_participate(0);
+
+  pthread_mutex_lock(&pool.mutex);
+  while(pool.pending > 0)
+    pthread_cond_wait(&pool.done, &pool.mutex);
+  pthread_mutex_unlock(&pool.mutex);
+
+  pthread_mutex_unlock(&pool.owner);
+}
+
+void THThreadPool_setNumThreads(int num_threads)
+{
+  if(inParallel)
+    return;
+  if(num_threads < 1)
+    num_threads = 1;
+  if(num_threads > TH_PARALLEL_MAX_THREADS)
+    num_threads = TH_PARALLEL_MAX_THREADS;
+  pthread_mutex_lock(&pool.owner);
+  if(num_threads != pool.nthreads)
+  {
+    THThreadPool_stopWorkers();
+    pool.nthreads = num_threads;
+  }
+  pthread_mutex_unlock(&pool.owner);
+}
+
+int THThreadPool_getNumThreads(void)
+{
+  int n = pool.nthreads;
+  return (n > 0 ? n : THThreadPool_defaultNumThreads());
+}
+
+#endif
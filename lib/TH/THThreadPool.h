@@ -0,0 +1,39 @@
+#ifndef TH_THREAD_POOL_INC
+#define TH_THREAD_POOL_INC
+
+#include "THGeneral.h"
+
+/******************************************************************************
+ * Persistent thread pool for TH
+ *  Workers are created on first use and sleep between jobs. A job is a range
+ *  [begin, end) split into one contiguous share per participant (the calling
+ *  thread included); participants take chunks of grain elements from their
+ *  own share first, then steal chunks from the others.
+ *  Calls made from inside a job, or while another thread owns the pool, run
+ *  serially on the calling thread: the pool never oversubscribes the cores.
+ ******************************************************************************/
+
+/*
+ * processes [begin, end)
+*/
+typedef void (*THParallelFunction)(void *data, ptrdiff_t begin, ptrdiff_t end);
+
+/*
+ * runs f over [begin, end), in chunks of at least grain elements
+ * returns when all chunks are done; f must not raise errors
+*/
+TH_API void THParallelFor(ptrdiff_t begin, ptrdiff_t end, ptrdiff_t grain, THParallelFunction f, void *data);
+
+/*
+ * grain size for elements costing roughly cost times a simple
+ * element-wise operation (cost >= 1)
+*/
+TH_API ptrdiff_t THParallelGrain(ptrdiff_t cost);
+
+/*
+ * number of threads participating to a job (the calling thread included)
+*/
+TH_API void THThreadPool_setNumThreads(int num_threads);
+TH_API int THThreadPool_getNumThreads(void);
+
+#endif
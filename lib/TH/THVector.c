@@ -1,4 +1,5 @@
 #include "THVector.h"
+#include "THMath.h"
 
 #include "generic/simd/simd.h"
 
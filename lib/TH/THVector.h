@@ -5,6 +5,10 @@
 
 #define THVector_(NAME) TH_CONCAT_4(TH,Real,Vector_,NAME)
 
+/* register tile of THVector_(gemmTile): 64 bytes of rows x 6 columns */
+#define THVector_GEMM_MR (64/sizeof(real))
+#define THVector_GEMM_NR 6
+
 /* We are going to use dynamic dispatch, and want only to generate declarations
  * of the vector functions */
 #include "generic/THVector.h"
@@ -276,6 +276,195 @@ void THBlas_(ger)(long m, long n, real alpha, real *x, long incx, real *y, long
   }
 }
 
+/* built-in blocked gemm, for BLAS-less builds: op(a) and op(b) are packed
+   into panels of THVector_GEMM_MR rows and THVector_GEMM_NR columns, which
+   are multiplied by THVector_(gemmTile), on the TH thread pool */
+typedef struct THBlas_(GemmJob)
+{
+  int transa, transb;
+  long m, n;
+  real alpha, beta;
+  real *a, *b, *c;
+  long lda, ldb, ldc;
+  /* current blocks: rows ic..ic+mg of op(a), columns jc..jc+nc of op(b),
+     depth pc..pc+kc */
+  long ic, mg, jc, nc, pc, kc;
+  real *apack, *bpack;
+} THBlas_(GemmJob);
+
+static void THBlas_(gemmScale_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THBlas_(GemmJob) *job = data;
+  ptrdiff_t i, j;
+  for(j = begin; j < end; j++)
+  {
+    real *c_ = job->c + j*job->ldc;
+    if(job->beta == 0)
+      for(i = 0; i < job->m; i++)
+        c_[i] = 0;
+    else
+      for(i = 0; i < job->m; i++)
+        c_[i] *= job->beta;
+  }
+}
+
+/* slivers of MR rows of op(a), zero-padded */
+static void THBlas_(gemmPackA_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THBlas_(GemmJob) *job = data;
+  const long mr = THVector_GEMM_MR;
+  ptrdiff_t s;
+  long i, l;
+  for(s = begin; s < end; s++)
+  {
+    real *p = job->apack + s*mr*job->kc;
+    long i0 = job->ic + s*mr;
+    long ni = job->ic + job->mg - i0;
+    if(ni > mr)
+      ni = mr;
+    for(l = 0; l < job->kc; l++)
+    {
+      long l_ = job->pc + l;
+      if(job->transa)
+        for(i = 0; i < ni; i++)
+          p[i] = job->a[l_ + (i0+i)*job->lda];
+      else
+        for(i = 0; i < ni; i++)
+          p[i] = job->a[i0+i + l_*job->lda];
+      for(; i < mr; i++)
+        p[i] = 0;
+      p += mr;
+    }
+  }
+}
+
+/* slivers of NR columns of op(b), zero-padded */
+static void THBlas_(gemmPackB_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THBlas_(GemmJob) *job = data;
+  const long nr = THVector_GEMM_NR;
+  ptrdiff_t s;
+  long j, l;
+  for(s = begin; s < end; s++)
+  {
+    real *p = job->bpack + s*nr*job->kc;
+    long j0 = job->jc + s*nr;
+    long nj = job->jc + job->nc - j0;
+    if(nj > nr)
+      nj = nr;
+    for(l = 0; l < job->kc; l++)
+    {
+      long l_ = job->pc + l;
+      if(job->transb)
+        for(j = 0; j < nj; j++)
+          p[j] = job->b[j0+j + l_*job->ldb];
+      else
+        for(j = 0; j < nj; j++)
+          p[j] = job->b[l_ + (j0+j)*job->ldb];
+      for(; j < nr; j++)
+        p[j] = 0;
+      p += nr;
+    }
+  }
+}
+
+/* tasks of MC rows x NB columns of the current blocks; tasks sharing the
+   same rows (hence the same packed a) are consecutive */
+static void THBlas_(gemmTile_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THBlas_(GemmJob) *job = data;
+  const long mr = THVector_GEMM_MR;
+  const long nr = THVector_GEMM_NR;
+  long nbn = (job->nc + THBlas_GEMM_NB - 1) / THBlas_GEMM_NB;
+  real tile[THVector_GEMM_MR*THVector_GEMM_NR];
+  ptrdiff_t t;
+  for(t = begin; t < end; t++)
+  {
+    long i0 = (t / nbn) * THBlas_GEMM_MC;
+    long j0 = (t % nbn) * THBlas_GEMM_NB;
+    long i1 = (i0 + THBlas_GEMM_MC < job->mg ? i0 + THBlas_GEMM_MC : job->mg);
+    long j1 = (j0 + THBlas_GEMM_NB < job->nc ? j0 + THBlas_GEMM_NB : job->nc);
+    long i, j, ii, jj;
+    for(j = j0; j < j1; j += nr)
+    {
+      real *b_ = job->bpack + (j/nr)*nr*job->kc;
+      for(i = i0; i < i1; i += mr)
+      {
+        real *a_ = job->apack + (i/mr)*mr*job->kc;
+        real *c_ = job->c + (job->ic+i) + (job->jc+j)*job->ldc;
+        if(i + mr <= i1 && j + nr <= j1)
+          THVector_(gemmTile)(c_, job->ldc, a_, b_, job->alpha, job->kc);
+        else
+        {
+          /* edge: compute the full tile aside, keep the valid part */
+          for(ii = 0; ii < mr*nr; ii++)
+            tile[ii] = 0;
+          THVector_(gemmTile)(tile, mr, a_, b_, job->alpha, job->kc);
+          for(jj = 0; jj < nr && j+jj < j1; jj++)
+            for(ii = 0; ii < mr && i+ii < i1; ii++)
+              c_[ii + jj*job->ldc] += tile[ii + jj*mr];
+        }
+      }
+    }
+  }
+}
+
+static void THBlas_(gemmBlocked)(int transa, int transb, long m, long n, long k, real alpha, real *a, long lda, real *b, long ldb, real beta, real *c, long ldc)
+{
+  const long mr = THVector_GEMM_MR;
+  const long nr = THVector_GEMM_NR;
+  long kc, mg, nc;
+  THBlas_(GemmJob) job;
+
+  job.transa = transa;
+  job.transb = transb;
+  job.m = m;
+  job.n = n;
+  job.alpha = alpha;
+  job.beta = beta;
+  job.a = a;
+  job.b = b;
+  job.c = c;
+  job.lda = lda;
+  job.ldb = ldb;
+  job.ldc = ldc;
+
+  if(beta != 1)
+    THParallelFor(0, n, THParallelGrain(m), THBlas_(gemmScale_kernel), &job);
+  if(alpha == 0 || k == 0)
+    return;
+
+  /* packed blocks in the scratch workspace, as large as the blocks of this
+     product (which are often smaller than the full ones) */
+  kc = (k < THBlas_GEMM_KC ? k : THBlas_GEMM_KC);
+  mg = (m < THBlas_GEMM_MG ? m : THBlas_GEMM_MG);
+  nc = (n < THBlas_GEMM_NC ? n : THBlas_GEMM_NC);
+  job.apack = THScratch_alloc(sizeof(real)*((mg + mr - 1) / mr)*mr*kc);
+  job.bpack = THScratch_alloc(sizeof(real)*((nc + nr - 1) / nr)*nr*kc);
+
+  for(job.jc = 0; job.jc < n; job.jc += THBlas_GEMM_NC)
+  {
+    job.nc = (n - job.jc < THBlas_GEMM_NC ? n - job.jc : THBlas_GEMM_NC);
+    for(job.pc = 0; job.pc < k; job.pc += THBlas_GEMM_KC)
+    {
+      long nbn = (job.nc + THBlas_GEMM_NB - 1) / THBlas_GEMM_NB;
+      job.kc = (k - job.pc < THBlas_GEMM_KC ? k - job.pc : THBlas_GEMM_KC);
+      THParallelFor(0, (job.nc + nr - 1) / nr, THParallelGrain(nr*job.kc), THBlas_(gemmPackB_kernel), &job);
+      for(job.ic = 0; job.ic < m; job.ic += THBlas_GEMM_MG)
+      {
+        long nbm;
+        job.mg = (m - job.ic < THBlas_GEMM_MG ? m - job.ic : THBlas_GEMM_MG);
+        nbm = (job.mg + THBlas_GEMM_MC - 1) / THBlas_GEMM_MC;
+        THParallelFor(0, (job.mg + mr - 1) / mr, THParallelGrain(mr*job.kc), THBlas_(gemmPackA_kernel), &job);
+        THParallelFor(0, nbm*nbn, 1, THBlas_(gemmTile_kernel), &job);
+      }
+    }
+  }
+
+  THScratch_free(job.bpack);
+  THScratch_free(job.apack);
+}
+
 void THBlas_(gemm)(char transa, char transb, long m, long n, long k, real alpha, real *a, long lda, real *b, long ldb, real beta, real *c, long ldc)
 {
   int transa_ = ((transa == 't') || (transa == 'T'));
@@ -324,6 +513,11 @@ void THBlas_(gemm)(char transa, char transb, long m, long n, long k, real alpha,
     return;
   }
 #endif
+  if(m*n*k > THBlas_GEMM_SMALL)
+  {
+    THBlas_(gemmBlocked)(transa_, transb_, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    return;
+  }
   {
     long i, j, l;
     if(!transa_ && !transb_)
@@ -17,6 +17,15 @@ size_t THStorage_(elementSize)()
   return sizeof(real);
 }
 
+/* structure from the current arena, if any; flag set */
+static THStorage* THStorage_(rawNew)(void)
+{
+  THArena *arena = THArena_current();
+  THStorage *storage = (arena ? THArena_alloc(arena, sizeof(THStorage)) : THAlloc(sizeof(THStorage)));
+  storage->flag = (arena ? TH_STORAGE_ARENA : 0);
+  return storage;
+}
+
 THStorage* THStorage_(new)(void)
 {
   return THStorage_(newWithSize)(0);
@@ -24,18 +33,21 @@ THStorage* THStorage_(new)(void)
 
 THStorage* THStorage_(newWithSize)(ptrdiff_t size)
 {
-  return THStorage_(newWithAllocator)(size, &THDefaultAllocator, NULL);
+  THArena *arena = THArena_current();
+  if(arena)
+    return THStorage_(newWithAllocator)(size, &THArenaAllocator, arena);
+  return THStorage_(newWithAllocator)(size, THGetDefaultStorageAllocator(), NULL);
 }
 
 THStorage* THStorage_(newWithAllocator)(ptrdiff_t size,
                                         THAllocator *allocator,
                                         void *allocatorContext)
 {
-  THStorage *storage = THAlloc(sizeof(THStorage));
+  THStorage *storage = THStorage_(rawNew)();
   storage->data = allocator->malloc(allocatorContext, sizeof(real)*size);
   storage->size = size;
   storage->refcount = 1;
-  storage->flag = TH_STORAGE_REFCOUNTED | TH_STORAGE_RESIZABLE | TH_STORAGE_FREEMEM;
+  storage->flag |= TH_STORAGE_REFCOUNTED | TH_STORAGE_RESIZABLE | TH_STORAGE_FREEMEM;
   storage->allocator = allocator;
   storage->allocatorContext = allocatorContext;
   return storage;
@@ -122,7 +134,10 @@ void THStorage_(free)(THStorage *storage)
       if(storage->flag & TH_STORAGE_VIEW) {
         THStorage_(free)(storage->view);
       }
-      THFree(storage);
+      if(storage->flag & TH_STORAGE_ARENA)
+        THArena_freeBlock(storage);
+      else
+        THFree(storage);
     }
   }
 }
@@ -136,11 +151,11 @@ THStorage* THStorage_(newWithData)(real *data, ptrdiff_t size)
 THStorage* THStorage_(newWithDataAndAllocator)(real* data, ptrdiff_t size,
                                                THAllocator* allocator,
                                                void* allocatorContext) {
-  THStorage *storage = THAlloc(sizeof(THStorage));
+  THStorage *storage = THStorage_(rawNew)();
   storage->data = data;
   storage->size = size;
   storage->refcount = 1;
-  storage->flag = TH_STORAGE_REFCOUNTED | TH_STORAGE_RESIZABLE | TH_STORAGE_FREEMEM;
+  storage->flag |= TH_STORAGE_REFCOUNTED | TH_STORAGE_RESIZABLE | TH_STORAGE_FREEMEM;
   storage->allocator = allocator;
   storage->allocatorContext = allocatorContext;
   return storage;
@@ -20,6 +20,7 @@
 #define TH_STORAGE_RESIZABLE  2
 #define TH_STORAGE_FREEMEM    4
 #define TH_STORAGE_VIEW       8
+#define TH_STORAGE_ARENA     16 /* the structure comes from an arena */
 
 typedef struct THStorage
 {
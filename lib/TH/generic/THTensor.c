@@ -67,21 +67,21 @@ void THTensor_(clearFlag)(THTensor *self, const char flag)
 /**** creation methods ****/
 
 static void THTensor_(rawInit)(THTensor *self);
+static THTensor *THTensor_(rawNew)(void);
+static void THTensor_(reserveDim)(THTensor *self, int nDimension);
 
 
 /* Empty init */
 THTensor *THTensor_(new)(void)
 {
-  THTensor *self = THAlloc(sizeof(THTensor));
-  THTensor_(rawInit)(self);
+  THTensor *self = THTensor_(rawNew)();
   return self;
 }
 
 /* Pointer-copy init */
 THTensor *THTensor_(newWithTensor)(THTensor *tensor)
 {
-  THTensor *self = THAlloc(sizeof(THTensor));
-  THTensor_(rawInit)(self);
+  THTensor *self = THTensor_(rawNew)();
   THTensor_(setStorageNd)(self,
                           tensor->storage,
                           tensor->storageOffset,
@@ -94,11 +94,10 @@ THTensor *THTensor_(newWithTensor)(THTensor *tensor)
 /* Storage init */
 THTensor *THTensor_(newWithStorage)(THStorage *storage, ptrdiff_t storageOffset, THLongStorage *size, THLongStorage *stride)
 {
-  THTensor *self = THAlloc(sizeof(THTensor));
+  THTensor *self = THTensor_(rawNew)();
   if(size && stride)
     THArgCheck(size->size == stride->size, 4, "inconsistent size");
 
-  THTensor_(rawInit)(self);
 #ifdef DEBUG
   THAssert((size ? size->size : (stride ? stride->size : 0)) <= INT_MAX);
 #endif
@@ -141,8 +140,7 @@ THTensor *THTensor_(newWithStorage4d)(THStorage *storage, ptrdiff_t storageOffse
   long size[4] = {size0, size1, size2, size3};
   long stride[4] = {stride0, stride1, stride2, stride3};
 
-  THTensor *self = THAlloc(sizeof(THTensor));
-  THTensor_(rawInit)(self);
+  THTensor *self = THTensor_(rawNew)();
   THTensor_(setStorageNd)(self, storage, storageOffset, 4, size, stride);
 
   return self;
@@ -172,8 +170,7 @@ THTensor *THTensor_(newWithSize4d)(long size0, long size1, long size2, long size
 {
   long size[4] = {size0, size1, size2, size3};
 
-  THTensor *self = THAlloc(sizeof(THTensor));
-  THTensor_(rawInit)(self);
+  THTensor *self = THTensor_(rawNew)();
   THTensor_(resizeNd)(self, 4, size, NULL);
 
   return self;
@@ -198,6 +195,25 @@ THTensor *THTensor_(newContiguous)(THTensor *self)
   }
 }
 
+THTensor *THTensor_(newContiguousScratch)(THTensor *self)
+{
+  THTensor *tensor;
+  THStorage *storage;
+
+  if(THTensor_(isContiguous)(self))
+  {
+    THTensor_(retain)(self);
+    return self;
+  }
+
+  storage = THStorage_(newWithAllocator)(THTensor_(nElement)(self), &THScratchAllocator, NULL);
+  tensor = THTensor_(new)();
+  THTensor_(setStorageNd)(tensor, storage, 0, self->nDimension, self->size, NULL);
+  THStorage_(free)(storage);
+  THTensor_(copy)(tensor, self);
+  return tensor;
+}
+
 THTensor *THTensor_(newSelect)(THTensor *tensor, int dimension_, long sliceIndex_)
 {
   THTensor *self = THTensor_(newWithTensor)(tensor);
@@ -439,10 +455,6 @@ void THTensor_(transpose)(THTensor *self, THTensor *src, int dimension1, int dim
 
 void THTensor_(unfold)(THTensor *self, THTensor *src, int dimension, long size, long step)
 {
-  long *newSize;
-  long *newStride;
-  int d;
-
   if(!src)
     src = self;
 
@@ -453,30 +465,11 @@ void THTensor_(unfold)(THTensor *self, THTensor *src, int dimension, long size,
 
   THTensor_(set)(self, src);
 
-  newSize = THAlloc(sizeof(long)*(self->nDimension+1));
-  newStride = THAlloc(sizeof(long)*(self->nDimension+1));
-
-  newSize[self->nDimension] = size;
-  newStride[self->nDimension] = self->stride[dimension];
-  for(d = 0; d < self->nDimension; d++)
-  {
-    if(d == dimension)
-    {
-      newSize[d] = (self->size[d] - size) / step + 1;
-      newStride[d] = step*self->stride[d];
-    }
-    else
-    {
-      newSize[d] = self->size[d];
-      newStride[d] = self->stride[d];
-    }
-  }
-
-  THFree(self->size);
-  THFree(self->stride);
-
-  self->size = newSize;
-  self->stride = newStride;
+  THTensor_(reserveDim)(self, self->nDimension+1);
+  self->size[self->nDimension] = size;
+  self->stride[self->nDimension] = self->stride[dimension];
+  self->size[dimension] = (self->size[dimension] - size) / step + 1;
+  self->stride[dimension] = step*self->stride[dimension];
   self->nDimension++;
 }
 
@@ -548,8 +541,7 @@ void THTensor_(unsqueeze1d)(THTensor *self, THTensor *src, int dimension)
 
   THTensor_(set)(self, src);
 
-  self->size = (long*)THRealloc(self->size, sizeof(long)*(self->nDimension+1));
-  self->stride = (long*)THRealloc(self->stride, sizeof(long)*(self->nDimension+1));
+  THTensor_(reserveDim)(self, self->nDimension+1);
   self->nDimension++;
   for (d = self->nDimension-1; d > dimension; d--) {
     self->size[d] = self->size[d-1];
@@ -679,11 +671,17 @@ void THTensor_(free)(THTensor *self)
   {
     if(THAtomicDecrementRef(&self->refcount))
     {
-      THFree(self->size);
-      THFree(self->stride);
+      if(self->size != self->sizeInline)
+      {
+        THFree(self->size);
+        THFree(self->stride);
+      }
       if(self->storage)
         THStorage_(free)(self->storage);
-      THFree(self);
+      if(self->flag & TH_TENSOR_ARENA)
+        THArena_freeBlock(self);
+      else
+        THFree(self);
     }
   }
 }
@@ -703,12 +701,54 @@ static void THTensor_(rawInit)(THTensor *self)
   self->refcount = 1;
   self->storage = NULL;
   self->storageOffset = 0;
-  self->size = NULL;
-  self->stride = NULL;
+  self->size = self->sizeInline;
+  self->stride = self->strideInline;
   self->nDimension = 0;
   self->flag = TH_TENSOR_REFCOUNTED;
 }
 
+/* from the current arena, if any */
+static THTensor *THTensor_(rawNew)(void)
+{
+  THArena *arena = THArena_current();
+  THTensor *self = (arena ? THArena_alloc(arena, sizeof(THTensor)) : THAlloc(sizeof(THTensor)));
+  THTensor_(rawInit)(self);
+  if(arena)
+    self->flag |= TH_TENSOR_ARENA;
+  return self;
+}
+
+/* room for nDimension sizes and strides, keeping the current ones: inline up
+   to TH_TENSOR_INLINE_DIMS, on the heap above (back inline when it shrinks) */
+static void THTensor_(reserveDim)(THTensor *self, int nDimension)
+{
+  int nKept = THMin(nDimension, self->nDimension);
+  if(nDimension <= TH_TENSOR_INLINE_DIMS)
+  {
+    if(self->size != self->sizeInline)
+    {
+      memcpy(self->sizeInline, self->size, sizeof(long)*nKept);
+      memcpy(self->strideInline, self->stride, sizeof(long)*nKept);
+      THFree(self->size);
+      THFree(self->stride);
+      self->size = self->sizeInline;
+      self->stride = self->strideInline;
+    }
+  }
+  else if(self->size == self->sizeInline)
+  {
+    self->size = THAlloc(sizeof(long)*nDimension);
+    self->stride = THAlloc(sizeof(long)*nDimension);
+    memcpy(self->size, self->sizeInline, sizeof(long)*nKept);
+    memcpy(self->stride, self->strideInline, sizeof(long)*nKept);
+  }
+  else
+  {
+    self->size = THRealloc(self->size, sizeof(long)*nDimension);
+    self->stride = THRealloc(self->stride, sizeof(long)*nDimension);
+  }
+}
+
 void THTensor_(setStorageNd)(THTensor *self, THStorage *storage, ptrdiff_t storageOffset, int nDimension, long *size, long *stride)
 {
   /* storage */
@@ -769,8 +809,7 @@ void THTensor_(resizeNd)(THTensor *self, int nDimension, long *size, long *strid
   {
     if(nDimension != self->nDimension)
     {
-      self->size = THRealloc(self->size, sizeof(long)*nDimension);
-      self->stride = THRealloc(self->stride, sizeof(long)*nDimension);
+      THTensor_(reserveDim)(self, nDimension);
       self->nDimension = nDimension;
     }
 
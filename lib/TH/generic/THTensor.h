@@ -5,12 +5,19 @@
 /* a la lua? dim, storageoffset, ...  et les methodes ? */
 
 #define TH_TENSOR_REFCOUNTED 1
+#define TH_TENSOR_ARENA      2 /* the structure comes from an arena */
+
+/* sizes and strides of tensors up to this dimension are kept in the tensor
+   (size points to sizeInline): views are a single allocation */
+#define TH_TENSOR_INLINE_DIMS 5
 
 typedef struct THTensor
 {
     long *size;
     long *stride;
     int nDimension;
+    long sizeInline[TH_TENSOR_INLINE_DIMS];
+    long strideInline[TH_TENSOR_INLINE_DIMS];
 
     THStorage *storage;
     ptrdiff_t storageOffset;
@@ -64,6 +71,9 @@ TH_API THTensor *THTensor_(newWithSize4d)(long size0_, long size1_, long size2_,
 
 TH_API THTensor *THTensor_(newClone)(THTensor *self);
 TH_API THTensor *THTensor_(newContiguous)(THTensor *tensor);
+/* as newContiguous, a copy having its data in the scratch workspace (see
+   THScratch.h): for a temporary, freed by the calling thread */
+TH_API THTensor *THTensor_(newContiguousScratch)(THTensor *tensor);
 TH_API THTensor *THTensor_(newSelect)(THTensor *tensor, int dimension_, long sliceIndex_);
 TH_API THTensor *THTensor_(newNarrow)(THTensor *tensor, int dimension_, long firstIndex_, long size_);
 TH_API THTensor *THTensor_(newTranspose)(THTensor *tensor, int dimension1_, int dimension2_);
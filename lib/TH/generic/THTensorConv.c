@@ -571,6 +571,82 @@ long THTensor_(convsize)(long x, long k, long s, const char* vf)
 }
 
 
+/* conv2D* loops run on the TH thread pool (see THThreadPool.h) */
+typedef struct THTensor_(Conv2DJob)
+{
+  real *output_data;
+  real *input_data;
+  real *weight_data;
+  real alpha;
+  real beta;
+  long nbatch;
+  long nInputPlane, nInputRows, nInputCols;
+  long nKernelRows, nKernelCols;
+  long nOutputPlane, nOutputRows, nOutputCols;
+  long istride0, istride1, kstride0, kstride1;
+  long srow, scol;
+  const char *vf, *xc;
+} THTensor_(Conv2DJob);
+
+static void THTensor_(conv2DScale_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(Conv2DJob) *job = data;
+  real *ptr_output = job->output_data;
+  real beta = job->beta;
+  ptrdiff_t l;
+  if (beta == 0)
+    for (l = begin; l < end; l++)
+      ptr_output[l] = 0.0;
+  else
+    for (l = begin; l < end; l++)
+      ptr_output[l] *= beta;
+}
+
+/* output <- beta*output (zeroed if beta is 0) */
+static void THTensor_(conv2DScale)(real *output_data, ptrdiff_t size, real beta)
+{
+  THTensor_(Conv2DJob) job;
+  job.output_data = output_data;
+  job.beta = beta;
+  THParallelFor(0, size, THParallelGrain(1), THTensor_(conv2DScale_kernel), &job);
+}
+
+/* cost of one output plane, for a given number of input planes */
+static ptrdiff_t THTensor_(conv2DCost)(THTensor_(Conv2DJob) *job, long nplane)
+{
+  return (ptrdiff_t)nplane*job->nOutputRows*job->nOutputCols*job->nKernelRows*job->nKernelCols;
+}
+
+static void THTensor_(conv2DRevger_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(Conv2DJob) *job = data;
+  long nInputPlane = job->nInputPlane;
+  long nOutputRows = job->nOutputRows;
+  long nOutputCols = job->nOutputCols;
+  long k;
+  for(k = begin; k < end; k++)
+  {
+    long i;
+    /* get kernel */
+    real *ptr_weight = job->weight_data+k*job->kstride0;
+
+    for(i = 0; i < nInputPlane; i++)
+    {
+      /* get output */
+      real *ptr_output = job->output_data + k*nInputPlane*nOutputCols*nOutputRows + i*nOutputCols*nOutputRows;
+      /* get input */
+      real *ptr_input = job->input_data+i*job->istride0;
+
+      /* do image, kernel convolution */
+      THTensor_(validXCorr2DRevptr)(ptr_output,
+                                    job->alpha,
+                                    ptr_input,  job->nInputRows,  job->nInputCols,
+                                    ptr_weight, job->nKernelRows, job->nKernelCols,
+                                    job->srow, job->scol);
+    }
+  }
+}
+
 /*
   3D input, 3D kernel, 4D output
   like rank1 update
@@ -590,7 +666,7 @@ void THTensor_(conv2DRevger)(THTensor *r_, real beta, real alpha, THTensor *t_,
   real *weight_data;
   real *output_data;
   ptrdiff_t nelem;
-  long k;
+  THTensor_(Conv2DJob) job;
 
   THArgCheck(t_->nDimension == 3 , 3, "input: 3D Tensor expected");
   THArgCheck(k_->nDimension == 3 , 4, "kernel: 3D Tensor expected");
@@ -624,60 +700,65 @@ void THTensor_(conv2DRevger)(THTensor *r_, real beta, real alpha, THTensor *t_,
   output_data = THTensor_(data)(r_);
 
   if (nelem == 0 || beta == 0 || nelem != THTensor_(nElement)(r_))
-  {
-    /*THTensor_(zero)(r_);*/
-
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]*r_->size[1]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] = 0.0;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), 0);
   else if (beta != 1)
-  {
-    /*THTensor_(mul)(r_, beta);*/
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]*r_->size[1]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] *= beta;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), beta);
+
+  job.output_data = output_data;
+  job.input_data = input_data;
+  job.weight_data = weight_data;
+  job.alpha = alpha;
+  job.nInputPlane = nInputPlane;
+  job.nInputRows = nInputRows;
+  job.nInputCols = nInputCols;
+  job.nKernelRows = nKernelRows;
+  job.nKernelCols = nKernelCols;
+  job.nOutputRows = nOutputRows;
+  job.nOutputCols = nOutputCols;
+  job.istride0 = istride0;
+  job.kstride0 = kstride0;
+  job.srow = srow;
+  job.scol = scol;
+  THParallelFor(0, nKernelPlane, THParallelGrain(THTensor_(conv2DCost)(&job, nInputPlane)), THTensor_(conv2DRevger_kernel), &job);
 
-#pragma omp parallel for private(k)
-  for(k = 0; k < nKernelPlane; k++)
+  THTensor_(free)(input);
+  THTensor_(free)(kernel);
+}
+
+
+static void THTensor_(conv2DRevgerm_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(Conv2DJob) *job = data;
+  long nInputPlane = job->nInputPlane;
+  long nOutputRows = job->nOutputRows;
+  long nOutputCols = job->nOutputCols;
+  long k;
+  for(k = begin; k < end; k++)
   {
     long i;
-    /* get kernel */
-    real *ptr_weight = weight_data+k*kstride0;
-
     for(i = 0; i < nInputPlane; i++)
     {
-      /* get output */
-      real *ptr_output = output_data + k*nInputPlane*nOutputCols*nOutputRows + i*nOutputCols*nOutputRows;
-      /* get input */
-      real *ptr_input = input_data+i*istride0;
+      long p;
+      for(p = 0; p < job->nbatch; p++)
+      {
+        /* get kernel */
+        real *ptr_weight = job->weight_data + p*job->kstride0 + k*job->kstride1;
+        /* get output */
+        real *ptr_output = job->output_data + k*nInputPlane*nOutputCols*nOutputRows + i*nOutputCols*nOutputRows;
+        /* get input */
+        real *ptr_input = job->input_data + p*job->istride0 + i*job->istride1;
 
-      /* do image, kernel convolution */
-      THTensor_(validXCorr2DRevptr)(ptr_output,
-                                    alpha,
-                                    ptr_input,  nInputRows,  nInputCols,
-                                    ptr_weight, nKernelRows, nKernelCols,
-                                    srow, scol);
-      /* Next output plane */
-      /* output_data += nOutputCols*nOutputRows; */
+        /* do image, kernel convolution */
+        THTensor_(validXCorr2DRevptr)(ptr_output,
+                                      job->alpha,
+                                      ptr_input,  job->nInputRows,  job->nInputCols,
+                                      ptr_weight, job->nKernelRows, job->nKernelCols,
+                                      job->srow, job->scol);
+      }
     }
   }
-  THTensor_(free)(input);
-  THTensor_(free)(kernel);
 }
 
-
 /*
   3D input, 3D kernel, 4D output
   like rank1 update
@@ -697,7 +778,7 @@ void THTensor_(conv2DRevgerm)(THTensor *r_, real beta, real alpha, THTensor *t_,
   real *weight_data;
   real *output_data;
   ptrdiff_t nelem;
-  long k;
+  THTensor_(Conv2DJob) job;
 
   THArgCheck(t_->nDimension == 4 , 3, "input: 4D Tensor expected");
   THArgCheck(k_->nDimension == 4 , 4, "kernel: 4D Tensor expected");
@@ -734,63 +815,66 @@ void THTensor_(conv2DRevgerm)(THTensor *r_, real beta, real alpha, THTensor *t_,
   output_data = THTensor_(data)(r_);
 
   if (nelem == 0 || beta == 0 || nelem != THTensor_(nElement)(r_))
-  {
-    /*THTensor_(zero)(r_);*/
-
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]*r_->size[1]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] = 0.0;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), 0);
   else if (beta != 1)
-  {
-    /*THTensor_(mul)(r_, beta);*/
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]*r_->size[1]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] *= beta;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), beta);
+
+  job.output_data = output_data;
+  job.input_data = input_data;
+  job.weight_data = weight_data;
+  job.alpha = alpha;
+  job.nbatch = nbatch;
+  job.nInputPlane = nInputPlane;
+  job.nInputRows = nInputRows;
+  job.nInputCols = nInputCols;
+  job.nKernelRows = nKernelRows;
+  job.nKernelCols = nKernelCols;
+  job.nOutputRows = nOutputRows;
+  job.nOutputCols = nOutputCols;
+  job.istride0 = istride0;
+  job.istride1 = istride1;
+  job.kstride0 = kstride0;
+  job.kstride1 = kstride1;
+  job.srow = srow;
+  job.scol = scol;
+  THParallelFor(0, nKernelPlane, THParallelGrain(THTensor_(conv2DCost)(&job, nInputPlane*nbatch)), THTensor_(conv2DRevgerm_kernel), &job);
 
-#pragma omp parallel for private(k)
-  for(k = 0; k < nKernelPlane; k++)
+  THTensor_(free)(input);
+  THTensor_(free)(kernel);
+}
+
+
+static void THTensor_(conv2Dger_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(Conv2DJob) *job = data;
+  long nInputPlane = job->nInputPlane;
+  long nOutputRows = job->nOutputRows;
+  long nOutputCols = job->nOutputCols;
+  long k;
+  for(k = begin; k < end; k++)
   {
     long i;
+    /* get kernel */
+    real *ptr_weight = job->weight_data+k*job->kstride0;
+
     for(i = 0; i < nInputPlane; i++)
     {
-      long p;
-      for(p = 0; p < nbatch; p++)
-      {
-        /* get kernel */
-        real *ptr_weight = weight_data + p*kstride0 + k*kstride1;
-        /* get output */
-        real *ptr_output = output_data + k*nInputPlane*nOutputCols*nOutputRows + i*nOutputCols*nOutputRows;
-        /* get input */
-        real *ptr_input = input_data + p*istride0 + i*istride1;
+      /* get output */
+      real *ptr_output = job->output_data + k*nInputPlane*nOutputCols*nOutputRows + i*nOutputCols*nOutputRows;
+      /* get input */
+      real *ptr_input = job->input_data+i*job->istride0;
 
-        /* do image, kernel convolution */
-        THTensor_(validXCorr2DRevptr)(ptr_output,
-                                      alpha,
-                                      ptr_input,  nInputRows,  nInputCols,
-                                      ptr_weight, nKernelRows, nKernelCols,
-                                      srow, scol);
-        /* Next output plane */
-        /* output_data += nOutputCols*nOutputRows; */
-      }
+      /* do image, kernel convolution */
+      THTensor_(conv2d)(ptr_output,
+                        job->alpha,
+                        ptr_input,  job->nInputRows,  job->nInputCols,
+                        ptr_weight, job->nKernelRows, job->nKernelCols,
+                        job->srow, job->scol,
+                        job->vf, job->xc);
     }
   }
-  THTensor_(free)(input);
-  THTensor_(free)(kernel);
 }
 
-
 /*
   3D input, 3D kernel, 4D output
   like rank1 update
@@ -809,7 +893,7 @@ void THTensor_(conv2Dger)(THTensor *r_, real beta, real alpha, THTensor *t_, THT
   real *weight_data;
   real *output_data;
   ptrdiff_t nelem;
-  long k;
+  THTensor_(Conv2DJob) job;
 
   THArgCheck(t_->nDimension == 3 , 3, "input: 3D Tensor expected");
   THArgCheck(k_->nDimension == 3 , 4, "kernel: 3D Tensor expected");
@@ -850,80 +934,61 @@ void THTensor_(conv2Dger)(THTensor *r_, real beta, real alpha, THTensor *t_, THT
   output_data = THTensor_(data)(r_);
 
   if (nelem == 0 || beta == 0 || nelem != THTensor_(nElement)(r_))
-  {
-    /*THTensor_(zero)(r_);*/
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]*r_->size[1]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] = 0.0;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), 0);
   else if (beta != 1)
-  {
-    /*THTensor_(mul)(r_, beta);*/
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]*r_->size[1]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] *= beta;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), beta);
+
+  job.output_data = output_data;
+  job.input_data = input_data;
+  job.weight_data = weight_data;
+  job.alpha = alpha;
+  job.nInputPlane = nInputPlane;
+  job.nInputRows = nInputRows;
+  job.nInputCols = nInputCols;
+  job.nKernelRows = nKernelRows;
+  job.nKernelCols = nKernelCols;
+  job.nOutputRows = nOutputRows;
+  job.nOutputCols = nOutputCols;
+  job.istride0 = istride0;
+  job.kstride0 = kstride0;
+  job.vf = vf;
+  job.xc = xc;
+  job.srow = srow;
+  job.scol = scol;
+  THParallelFor(0, nKernelPlane, THParallelGrain(THTensor_(conv2DCost)(&job, nInputPlane)), THTensor_(conv2Dger_kernel), &job);
 
-#pragma omp parallel for private(k)
-  for(k = 0; k < nKernelPlane; k++)
+  THTensor_(free)(input);
+  THTensor_(free)(kernel);
+}
+
+
+static void THTensor_(conv2Dmv_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(Conv2DJob) *job = data;
+  long k;
+  for(k = begin; k < end; k++)
   {
     long i;
-    /* get kernel */
-    real *ptr_weight = weight_data+k*kstride0;
-
-    for(i = 0; i < nInputPlane; i++)
+    /* get output */
+    real *ptr_output = job->output_data + k*job->nOutputCols*job->nOutputRows;
+    for(i = 0; i < job->nInputPlane; i++)
     {
-      /* get output */
-      real *ptr_output = output_data + k*nInputPlane*nOutputCols*nOutputRows + i*nOutputCols*nOutputRows;
+      /* get kernel */
+      real *ptr_weight = job->weight_data + k*job->kstride0 + i*job->kstride1;
       /* get input */
-      real *ptr_input = input_data+i*istride0;
+      real *ptr_input = job->input_data + i*job->istride0;
 
       /* do image, kernel convolution */
-      if (*vf == 'F')
-        if (*xc == 'X')
-          THTensor_(fullXCorr2Dptr)(ptr_output,
-                                    alpha,
-                                    ptr_input,  nInputRows,  nInputCols,
-                                    ptr_weight, nKernelRows, nKernelCols,
-                                    srow, scol);
-        else
-          THTensor_(fullConv2Dptr)(ptr_output,
-                                   alpha,
-                                   ptr_input,  nInputRows,  nInputCols,
-                                   ptr_weight, nKernelRows, nKernelCols,
-                                   srow, scol);
-      else
-        if (*xc == 'X')
-          THTensor_(validXCorr2Dptr)(ptr_output,
-                                     alpha,
-                                     ptr_input,  nInputRows,  nInputCols,
-                                     ptr_weight, nKernelRows, nKernelCols,
-                                     srow, scol);
-        else
-          THTensor_(validConv2Dptr)(ptr_output,
-                                    alpha,
-                                    ptr_input,  nInputRows,  nInputCols,
-                                    ptr_weight, nKernelRows, nKernelCols,
-                                    srow, scol);
-      /* Next output plane */
-      /* output_data += nOutputCols*nOutputRows; */
+      THTensor_(conv2d)(ptr_output,
+                        job->alpha,
+                        ptr_input,  job->nInputRows,  job->nInputCols,
+                        ptr_weight, job->nKernelRows, job->nKernelCols,
+                        job->srow, job->scol,
+                        job->vf, job->xc);
     }
   }
-  THTensor_(free)(input);
-  THTensor_(free)(kernel);
 }
 
-
 /*
   3D input, 4D kernel, 3D output
   matrix vector product like
@@ -941,7 +1006,7 @@ void THTensor_(conv2Dmv)(THTensor *r_, real beta, real alpha, THTensor *t_, THTe
   real *weight_data;
   real *output_data;
   ptrdiff_t nelem;
-  long k;
+  THTensor_(Conv2DJob) job;
 
   THArgCheck(t_->nDimension == 3 , 3, "input: 3D Tensor expected");
   THArgCheck(k_->nDimension == 4 , 4, "kernel: 4D Tensor expected");
@@ -988,79 +1053,72 @@ void THTensor_(conv2Dmv)(THTensor *r_, real beta, real alpha, THTensor *t_, THTe
   output_data = THTensor_(data)(r_);
 
   if (nelem == 0 || beta == 0 || nelem != THTensor_(nElement)(r_))
-  {
-    /*THTensor_(zero)(r_);*/
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] = 0.0;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), 0);
   else if (beta != 1)
-  {
-    /*THTensor_(mul)(r_, beta);*/
-#pragma omp parallel for private(k)
-    for (k = 0; k < r_->size[0]; k++)
-    {
-      real* ptr_output = output_data + k*nOutputCols*nOutputRows;
-      long l;
-      for (l = 0; l < nOutputRows*nOutputCols; l++)
-        ptr_output[l] *= beta;
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), beta);
+
+  job.output_data = output_data;
+  job.input_data = input_data;
+  job.weight_data = weight_data;
+  job.alpha = alpha;
+  job.nInputPlane = nInputPlane;
+  job.nInputRows = nInputRows;
+  job.nInputCols = nInputCols;
+  job.nKernelRows = nKernelRows;
+  job.nKernelCols = nKernelCols;
+  job.nOutputRows = nOutputRows;
+  job.nOutputCols = nOutputCols;
+  job.istride0 = istride0;
+  job.kstride0 = kstride0;
+  job.kstride1 = kstride1;
+  job.vf = vf;
+  job.xc = xc;
+  job.srow = srow;
+  job.scol = scol;
+  THParallelFor(0, nOutputPlane, THParallelGrain(THTensor_(conv2DCost)(&job, nInputPlane)), THTensor_(conv2Dmv_kernel), &job);
 
-#pragma omp parallel for private(k)
-  for(k = 0; k < nOutputPlane; k++)
+  THTensor_(free)(input);
+  THTensor_(free)(kernel);
+}
+
+
+static void THTensor_(conv2Dmm_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(Conv2DJob) *job = data;
+  long nInputPlane = job->nInputPlane;
+  long nInputRows = job->nInputRows;
+  long nInputCols = job->nInputCols;
+  long nOutputPlane = job->nOutputPlane;
+  long nOutputRows = job->nOutputRows;
+  long nOutputCols = job->nOutputCols;
+  long p;
+  for(p = begin; p < end; p++)
   {
-    long i;
-    /* get output */
-    real *ptr_output = output_data + k*nOutputCols*nOutputRows;
-    for(i = 0; i < nInputPlane; i++)
+    long k;
+    for(k = 0; k < nOutputPlane; k++)
     {
-      /* get kernel */
-      real *ptr_weight = weight_data + k*kstride0 + i*kstride1;
-      /* get input */
-      real *ptr_input = input_data + i*istride0;
+      long i;
+      /* get output */
+      real *ptr_output = job->output_data + p*nOutputPlane*nOutputCols*nOutputRows + k*nOutputCols*nOutputRows;
+      for(i = 0; i < nInputPlane; i++)
+      {
+        /* get kernel */
+        real *ptr_weight = job->weight_data + k*job->kstride0 + i*job->kstride1;
+        /* get input */
+        real *ptr_input = job->input_data + p*nInputPlane*nInputRows*nInputCols + i*nInputRows*nInputCols;
 
-      /* do image, kernel convolution */
-      if (*vf == 'F')
-        if (*xc == 'X')
-          THTensor_(fullXCorr2Dptr)(ptr_output,
-                                    alpha,
-                                    ptr_input,  nInputRows,  nInputCols,
-                                    ptr_weight, nKernelRows, nKernelCols,
-                                    srow, scol);
-        else
-          THTensor_(fullConv2Dptr)(ptr_output,
-                                   alpha,
-                                   ptr_input,  nInputRows,  nInputCols,
-                                   ptr_weight, nKernelRows, nKernelCols,
-                                   srow, scol);
-      else
-        if (*xc == 'X')
-          THTensor_(validXCorr2Dptr)(ptr_output,
-                                     alpha,
-                                     ptr_input,  nInputRows,  nInputCols,
-                                     ptr_weight, nKernelRows, nKernelCols,
-                                     srow, scol);
-        else
-          THTensor_(validConv2Dptr)(ptr_output,
-                                    alpha,
-                                    ptr_input,  nInputRows,  nInputCols,
-                                    ptr_weight, nKernelRows, nKernelCols,
-                                    srow, scol);
+        /* do image, kernel convolution */
+        THTensor_(conv2d)(ptr_output,
+                          job->alpha,
+                          ptr_input,  nInputRows,  nInputCols,
+                          ptr_weight, job->nKernelRows, job->nKernelCols,
+                          job->srow, job->scol,
+                          job->vf, job->xc);
+      }
     }
-    /* Next output plane */
-    /* output_data += nOutputCols*nOutputRows;*/
   }
-  THTensor_(free)(input);
-  THTensor_(free)(kernel);
 }
 
-
 /*
   3D input, 4D kernel, 3D output
   matrix vector product like
@@ -1079,7 +1137,7 @@ void THTensor_(conv2Dmm)(THTensor *r_, real beta, real alpha, THTensor *t_, THTe
   real *input_data;
   real *weight_data;
   real *output_data;
-  long p;
+  THTensor_(Conv2DJob) job;
 
   THArgCheck(t_->nDimension == 4 , 3, "input: 4D Tensor expected");
   THArgCheck(k_->nDimension == 4 , 4, "kernel: 4D Tensor expected");
@@ -1126,86 +1184,30 @@ void THTensor_(conv2Dmm)(THTensor *r_, real beta, real alpha, THTensor *t_, THTe
   output_data = THTensor_(data)(r_);
 
   if (nelem == 0 || beta == 0 || nelem != THTensor_(nElement)(r_))
-  {
-    /*THTensor_(zero)(r_);*/
-#pragma omp parallel for private(p)
-    for (p=0; p < r_->size[0]; p++)
-    {
-      long k;
-      for (k = 0; k < r_->size[1]; k++)
-      {
-        real* ptr_output = output_data + p*nOutputPlane*nOutputRows*nOutputCols + k*nOutputCols*nOutputRows;
-        long l;
-        for (l = 0; l < nOutputRows*nOutputCols; l++)
-          ptr_output[l] = 0.0;
-      }
-    }
-  }
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), 0);
   else if (beta != 1)
-  {
-    /*THTensor_(mul)(r_, beta);*/
-#pragma omp parallel for private(p)
-    for(p=0; p < r_->size[0]; p++)
-    {
-      long k;
-      for (k = 0; k < r_->size[1]; k++)
-      {
-        real* ptr_output = output_data + p*nOutputPlane*nOutputRows*nOutputCols + k*nOutputCols*nOutputRows;
-        long l;
-        for (l = 0; l < nOutputRows*nOutputCols; l++)
-          ptr_output[l] *= beta;
-      }
-    }
-  }
-
-#pragma omp parallel for private(p)
-  for(p=0; p < nbatch; p++)
-  {
-    long k;
-    for(k = 0; k < nOutputPlane; k++)
-    {
-      long i;
-      /* get output */
-      real *ptr_output = output_data + p*nOutputPlane*nOutputCols*nOutputRows + k*nOutputCols*nOutputRows;
-      for(i = 0; i < nInputPlane; i++)
-      {
-        /* get kernel */
-        real *ptr_weight = weight_data + k*kstride0 + i*kstride1;
-        /* get input */
-        real *ptr_input = input_data + p*nInputPlane*nInputRows*nInputCols + i*nInputRows*nInputCols;
+    THTensor_(conv2DScale)(output_data, THTensor_(nElement)(r_), beta);
+
+  job.output_data = output_data;
+  job.input_data = input_data;
+  job.weight_data = weight_data;
+  job.alpha = alpha;
+  job.nInputPlane = nInputPlane;
+  job.nInputRows = nInputRows;
+  job.nInputCols = nInputCols;
+  job.nKernelRows = nKernelRows;
+  job.nKernelCols = nKernelCols;
+  job.nOutputPlane = nOutputPlane;
+  job.nOutputRows = nOutputRows;
+  job.nOutputCols = nOutputCols;
+  job.kstride0 = kstride0;
+  job.kstride1 = kstride1;
+  job.vf = vf;
+  job.xc = xc;
+  job.srow = srow;
+  job.scol = scol;
+  THParallelFor(0, nbatch, THParallelGrain(THTensor_(conv2DCost)(&job, nInputPlane*nOutputPlane)), THTensor_(conv2Dmm_kernel), &job);
 
-        /* do image, kernel convolution */
-        if (*vf == 'F')
-          if (*xc == 'X')
-            THTensor_(fullXCorr2Dptr)(ptr_output,
-                                      alpha,
-                                      ptr_input,  nInputRows,  nInputCols,
-                                      ptr_weight, nKernelRows, nKernelCols,
-                                      srow, scol);
-          else
-            THTensor_(fullConv2Dptr)(ptr_output,
-                                     alpha,
-                                     ptr_input,  nInputRows,  nInputCols,
-                                     ptr_weight, nKernelRows, nKernelCols,
-                                     srow, scol);
-        else
-          if (*xc == 'X')
-            THTensor_(validXCorr2Dptr)(ptr_output,
-                                       alpha,
-                                       ptr_input,  nInputRows,  nInputCols,
-                                       ptr_weight, nKernelRows, nKernelCols,
-                                       srow, scol);
-          else
-            THTensor_(validConv2Dptr)(ptr_output,
-                                      alpha,
-                                      ptr_input,  nInputRows,  nInputCols,
-                                      ptr_weight, nKernelRows, nKernelCols,
-                                      srow, scol);
-      }
-      /* Next output plane */
-      /* output_data += nOutputCols*nOutputRows;*/
-    }
-  }
   THTensor_(free)(input);
   THTensor_(free)(kernel);
 }
@@ -23,10 +23,9 @@ void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
   const int BLOCK_SZ = 60;
 #endif
 
-  THTensor *buf = THTensor_(newWithSize2d)(BLOCK_SZ, BLOCK_SZ);
   real *sp = THTensor_(data)(src);
   real *rp = THTensor_(data)(tensor);
-  real *bp = THTensor_(data)(buf);
+  real *bp = THScratch_alloc(BLOCK_SZ * BLOCK_SZ * sizeof(real));
 
   long NR = THTensor_(size)(src, 0);
   long NC = THTensor_(size)(src, 1);
@@ -61,7 +60,7 @@ void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
       }
     }
   }
-  THTensor_(free)(buf);
+  THScratch_free(bp);
   #undef MIN
   #undef MAX
 }
@@ -72,11 +71,19 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
     real *sp = THTensor_(data)(src);
     real *rp = THTensor_(data)(tensor);
     ptrdiff_t sz = THTensor_(nElement)(tensor);
+    ptrdiff_t begin, end;
+    THOutOfCoreLoop loop;
+    ptrdiff_t chunk = THOutOfCore_begin(&loop, sz, 1, rp, sizeof(real), sp, sizeof(real), NULL, 0);
+    for (begin = 0; begin < sz; begin += chunk) {
+      end = (sz - begin < chunk ? sz : begin + chunk);
+      THOutOfCore_prefetch(&loop, end);
 #ifndef TH_REAL_IS_HALF
-    THVector_(copy)(rp, sp, sz);
+      THVector_(copy)(rp + begin, sp + begin, end - begin);
 #else
-    memcpy(rp, sp, sz * sizeof(real));
+      memcpy(rp + begin, sp + begin, (end - begin) * sizeof(real));
 #endif
+      THOutOfCore_release(&loop, begin, end);
+    }
 #ifndef TH_REAL_IS_HALF
   } else if (THTensor_(copyTransposeValid)(tensor, src)) {
     THTensor_(copyTranspose)(tensor, src);
@@ -86,27 +93,53 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
   }
 }
 
+/* contiguous tensors: a loop over the elements, in chunks on mapped storages
+   larger than the budget (see THOutOfCore.h) */
+#define THTensor_copyContiguous(TYPENAMESRC, TYPE_SRC, CODE) \
+  if (THTensor_(isContiguous)(tensor) && TH##TYPENAMESRC##Tensor_isContiguous(src) \
+      && THTensor_(nElement)(tensor) == TH##TYPENAMESRC##Tensor_nElement(src)) { \
+    real *rp = THTensor_(data)(tensor); \
+    TYPE_SRC *sp = TH##TYPENAMESRC##Tensor_data(src); \
+    ptrdiff_t sz = THTensor_(nElement)(tensor); \
+    ptrdiff_t begin, end, i; \
+    THOutOfCoreLoop loop; \
+    ptrdiff_t chunk = THOutOfCore_begin(&loop, sz, 1, rp, sizeof(real), sp, sizeof(TYPE_SRC), NULL, 0); \
+    for (begin = 0; begin < sz; begin += chunk) { \
+      end = (sz - begin < chunk ? sz : begin + chunk); \
+      THOutOfCore_prefetch(&loop, end); \
+      for (i = begin; i < end; i++) { \
+        CODE \
+      } \
+      THOutOfCore_release(&loop, begin, end); \
+    } \
+    return; \
+  }
+
 #define IMPLEMENT_THTensor_COPY(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
+  THTensor_copyContiguous(TYPENAMESRC, TYPE_SRC, rp[i] = (real)(sp[i]);) \
   TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)(*src_data);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
+ THTensor_copyContiguous(TYPENAMESRC, TYPE_SRC, rp[i] = TH_float2half((float)sp[i]);) \
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = TH_float2half((float)*src_data);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
+ THTensor_copyContiguous(TYPENAMESRC, TYPE_SRC, rp[i] = (real)TH_half2float(sp[i]);) \
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)TH_half2float(*src_data);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
+ THTensor_copyContiguous(TYPENAMESRC, TYPE_SRC, rp[i] = sp[i];) \
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = *src_data;) \
 }
 
@@ -132,4 +165,6 @@ IMPLEMENT_THTensor_COPY_TO_HALF(Double, double)
 
 #endif /* REAL_IS_HALF */
 
+#undef THTensor_copyContiguous
+
 #endif
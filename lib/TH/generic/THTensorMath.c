@@ -6,104 +6,72 @@
   #define NAN (nan(NULL))
 #endif
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
-#define TH_OMP_OVERHEAD_THRESHOLD 100000
-
-#ifdef _OPENMP
-
-#ifndef _WIN32
-#define PRAGMA(P) _Pragma(#P)
-#else
-#define PRAGMA(P) __pragma(P)
-#endif
-
-#define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, CODE) \
-{ \
-  ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
-  { \
-    size_t num_threads = omp_get_num_threads(); \
-    size_t tid = omp_get_thread_num(); \
-    ptrdiff_t TH_TENSOR_offset = tid * (TH_TENSOR_size / num_threads); \
-    ptrdiff_t TH_TENSOR_end = tid == num_threads - 1 ? TH_TENSOR_size : \
-      TH_TENSOR_offset + TH_TENSOR_size / num_threads; \
-    ptrdiff_t TENSOR##_len = TH_TENSOR_end - TH_TENSOR_offset; \
-    TYPE *TENSOR##_data = THTensor_(data)(TENSOR) + TH_TENSOR_offset; \
-    CODE \
-  } \
-}
-#else
-#define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, CODE) \
-{ \
-  TYPE *TENSOR##_data = THTensor_(data)(TENSOR); \
-  ptrdiff_t TENSOR##_len = THTensor_(nElement)(TENSOR); \
-  CODE \
+/* contiguous loops run in chunks on the TH thread pool (see THThreadPool.h)
+   cost is the price of one element, relative to a simple element-wise op */
+typedef struct THTensor_(ParallelJob)
+{
+  real *r;
+  real *t;
+  real *src;
+  real value;
+  real value2;
+  long *index;
+  ptrdiff_t rowsize;
+  ptrdiff_t dim;
+} THTensor_(ParallelJob);
+
+/* THParallelFor over size elements of the arrays r, t and src, in chunks on
+   mapped storages larger than the budget (see THOutOfCore.h): the kernel
+   runs units indices per granularity elements, and a chunk is a multiple of
+   granularity elements */
+static void THTensor_(outOfCoreFor)(ptrdiff_t size, ptrdiff_t granularity, ptrdiff_t units, ptrdiff_t grain,
+                                    THParallelFunction kernel, void *job,
+                                    const real *r, const real *t, const real *src)
+{
+  THOutOfCoreLoop loop;
+  ptrdiff_t chunk = THOutOfCore_begin(&loop, size, granularity, r, sizeof(real), t, sizeof(real),
+                                      src, sizeof(real));
+  ptrdiff_t begin, end;
+  if(chunk >= size)
+  {
+    THParallelFor(0, (size + granularity-1)/granularity*units, grain, kernel, job);
+    return;
+  }
+  for(begin = 0; begin < size; begin += chunk)
+  {
+    end = (size - begin < chunk ? size : begin + chunk);
+    THOutOfCore_prefetch(&loop, end);
+    THParallelFor(begin/granularity*units, (end + granularity-1)/granularity*units, grain, kernel, job);
+    THOutOfCore_release(&loop, begin, end);
+  }
 }
-#endif
 
-#ifdef _OPENMP
-#define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE) \
-{ \
-  ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR1); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
-  { \
-    size_t num_threads = omp_get_num_threads(); \
-    size_t tid = omp_get_thread_num(); \
-    ptrdiff_t TH_TENSOR_offset = tid * (TH_TENSOR_size / num_threads); \
-    ptrdiff_t TH_TENSOR_end = tid == num_threads - 1 ? TH_TENSOR_size : \
-      TH_TENSOR_offset + TH_TENSOR_size / num_threads; \
-    ptrdiff_t TENSOR1##_len = TH_TENSOR_end - TH_TENSOR_offset; \
-    TYPE1 *TENSOR1##_data = THTensor_(data)(TENSOR1) + TH_TENSOR_offset; \
-    TYPE2 *TENSOR2##_data = THTensor_(data)(TENSOR2) + TH_TENSOR_offset; \
-    CODE \
-  } \
-}
-#else
-#define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE) \
-{ \
-  TYPE1 *TENSOR1##_data = THTensor_(data)(TENSOR1); \
-  TYPE2 *TENSOR2##_data = THTensor_(data)(TENSOR2); \
-  ptrdiff_t TENSOR1##_len = THTensor_(nElement)(TENSOR1); \
-  CODE \
+static void THTensor_(parallelApply)(THParallelFunction kernel, ptrdiff_t cost, ptrdiff_t size,
+                                     real *r, real *t, real *src, real value, real value2)
+{
+  THTensor_(ParallelJob) job;
+  job.r = r;
+  job.t = t;
+  job.src = src;
+  job.value = value;
+  job.value2 = value2;
+  job.index = NULL;
+  job.rowsize = 0;
+  job.dim = 0;
+  THTensor_(outOfCoreFor)(size, 1, 1, THParallelGrain(cost), kernel, &job, r, t, src);
 }
-#endif
 
-#ifdef _OPENMP
-#define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE) \
-{ \
-  ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR1); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
-  { \
-    size_t num_threads = omp_get_num_threads(); \
-    size_t tid = omp_get_thread_num(); \
-    ptrdiff_t TH_TENSOR_offset = tid * (TH_TENSOR_size / num_threads); \
-    ptrdiff_t TH_TENSOR_end = tid == num_threads - 1 ? TH_TENSOR_size : \
-      TH_TENSOR_offset + TH_TENSOR_size / num_threads; \
-    ptrdiff_t TENSOR1##_len = TH_TENSOR_end - TH_TENSOR_offset; \
-    TYPE1 *TENSOR1##_data = THTensor_(data)(TENSOR1) + TH_TENSOR_offset; \
-    TYPE2 *TENSOR2##_data = THTensor_(data)(TENSOR2) + TH_TENSOR_offset; \
-    TYPE3 *TENSOR3##_data = THTensor_(data)(TENSOR3) + TH_TENSOR_offset; \
-    CODE \
-  } \
-}
-#else
-#define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE) \
-{ \
-  TYPE1 *TENSOR1##_data = THTensor_(data)(TENSOR1); \
-  TYPE2 *TENSOR2##_data = THTensor_(data)(TENSOR2); \
-  TYPE3 *TENSOR3##_data = THTensor_(data)(TENSOR3); \
-  ptrdiff_t TENSOR1##_len = THTensor_(nElement)(TENSOR1); \
-  CODE \
+static void THTensor_(fill_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(fill)(job->r + begin, job->value, end - begin);
 }
-#endif
 
 void THTensor_(fill)(THTensor *r_, real value)
 {
   if (THTensor_(isContiguous)(r_) || THTensor_(isTransposed)(r_)) {
-    TH_TENSOR_APPLY_CONTIG(real, r_, THVector_(fill)(r__data, value, r__len););
+    THTensor_(parallelApply)(THTensor_(fill_kernel), 1, THTensor_(nElement)(r_),
+                             THTensor_(data)(r_), NULL, NULL, value, 0);
   } else {
     TH_TENSOR_APPLY(real, r_,
       if (r__stride == 1) {
@@ -237,31 +205,80 @@ void THTensor_(nonzero)(THLongTensor *subscript, THTensor *tensor)
                   ++i;);
 }
 
+static void THTensor_(indexSelect_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tensor_data = job->r;
+  real *src_data = job->src;
+  long *index_data = job->index;
+  ptrdiff_t rowsize = job->rowsize;
+  ptrdiff_t i;
+  if (rowsize == 1) {
+    for (i=begin; i<end; i++)
+      tensor_data[i] = src_data[index_data[i] - TH_INDEX_BASE];
+  } else {
+    for (i=begin; i<end; i++)
+      memcpy(tensor_data + i*rowsize, src_data + (index_data[i] - TH_INDEX_BASE)*rowsize, rowsize*sizeof(real));
+  }
+}
+
+/* resizes r_, and ri_ if not NULL, as t with size at dimension (the sizes
+   are on the stack for up to TH_TENSOR_INLINE_DIMS dimensions) */
+static void THTensor_(resizeAlong)(THTensor *r_, THLongTensor *ri_, THTensor *t, int dimension, long size)
+{
+  long sizeInline[TH_TENSOR_INLINE_DIMS];
+  THLongStorage *sizeStorage = NULL;
+  long *sizes = sizeInline;
+
+  if (t->nDimension > TH_TENSOR_INLINE_DIMS) {
+    sizeStorage = THLongStorage_newWithSize(t->nDimension);
+    sizes = sizeStorage->data;
+  }
+  memcpy(sizes, t->size, t->nDimension*sizeof(long));
+  sizes[dimension] = size;
+  THTensor_(resizeNd)(r_, t->nDimension, sizes, NULL);
+  if (ri_)
+    THLongTensor_resizeNd(ri_, t->nDimension, sizes, NULL);
+  if (sizeStorage)
+    THLongStorage_free(sizeStorage);
+}
+
 void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTensor *index)
 {
   ptrdiff_t i, numel;
-  THLongStorage *newSize;
   THTensor *tSlice, *sSlice;
-  long *index_data;
+  long *index_data, *scratch = NULL;
   real *tensor_data, *src_data;
+  long max;
 
   THArgCheck(index->nDimension == 1, 3, "Index is supposed to be a vector");
   THArgCheck(dim < src->nDimension, 4,"Indexing dim %d is out of bounds of tensor", dim + TH_INDEX_BASE);
   THArgCheck(src->nDimension > 0,2,"Source tensor is empty");
 
   numel = THLongTensor_nElement(index);
-
-  newSize = THLongStorage_newWithSize(src->nDimension);
-  THLongStorage_rawCopy(newSize,src->size);
 #ifdef DEBUG
   THAssert(numel <= LONG_MAX);
 #endif
-  newSize->data[dim] = numel;
-  THTensor_(resize)(tensor,newSize,NULL);
-  THLongStorage_free(newSize);
 
-  index = THLongTensor_newContiguous(index);
+  // check that the indices are within range (before the scratch workspace
+  // is used: no error after)
+  max = src->size[dim] - 1 + TH_INDEX_BASE;
   index_data = THLongTensor_data(index);
+  for (i=0; i<numel; i++) {
+    long idx = index_data[i*index->stride[0]];
+    if (idx < TH_INDEX_BASE || idx > max)
+      THError("index out of range");
+  }
+
+  THTensor_(resizeAlong)(tensor, NULL, src, dim, numel);
+
+  // a strided index is gathered in the scratch workspace
+  if (index->stride[0] != 1 && numel > 1) {
+    scratch = THScratch_alloc(numel*sizeof(long));
+    for (i=0; i<numel; i++)
+      scratch[i] = index_data[i*index->stride[0]];
+    index_data = scratch;
+  }
 
   if (dim == 0 && THTensor_(isContiguous)(src) && THTensor_(isContiguous)(tensor))
   {
@@ -269,24 +286,12 @@ void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTens
     src_data = THTensor_(data)(src);
     ptrdiff_t rowsize = THTensor_(nElement)(src) / src->size[0];
 
-    // check that the indices are within range
-    long max = src->size[0] - 1 + TH_INDEX_BASE;
-    for (i=0; i<numel; i++) {
-      if (index_data[i] < TH_INDEX_BASE || index_data[i] > max) {
-        THLongTensor_free(index);
-        THError("index out of range");
-      }
-    }
-
-    if (src->nDimension == 1) {
-      #pragma omp parallel for if(numel > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-      for (i=0; i<numel; i++)
-        tensor_data[i] = src_data[index_data[i] - TH_INDEX_BASE];
-    } else {
-      #pragma omp parallel for if(numel*rowsize > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-      for (i=0; i<numel; i++)
-        memcpy(tensor_data + i*rowsize, src_data + (index_data[i] - TH_INDEX_BASE)*rowsize, rowsize*sizeof(real));
-    }
+    THTensor_(ParallelJob) job;
+    job.r = tensor_data;
+    job.src = src_data;
+    job.index = index_data;
+    job.rowsize = rowsize;
+    THParallelFor(0, numel, THParallelGrain(rowsize), THTensor_(indexSelect_kernel), &job);
   }
   else if (src->nDimension == 1)
   {
@@ -295,19 +300,19 @@ void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTens
   }
   else
   {
+    tSlice = THTensor_(new)();
+    sSlice = THTensor_(new)();
     for (i=0; i<numel; i++)
     {
-      tSlice = THTensor_(new)();
-      sSlice = THTensor_(new)();
       THTensor_(select)(tSlice, tensor, dim, i);
       THTensor_(select)(sSlice, src, dim, index_data[i] - TH_INDEX_BASE);
       THTensor_(copy)(tSlice, sSlice);
-      THTensor_(free)(tSlice);
-      THTensor_(free)(sSlice);
     }
+    THTensor_(free)(tSlice);
+    THTensor_(free)(sSlice);
   }
 
-  THLongTensor_free(index);
+  THScratch_free(scratch);
 }
 
 void THTensor_(indexCopy)(THTensor *tensor, int dim, THLongTensor *index, THTensor *src)
@@ -550,12 +555,366 @@ if (isnan(val)) break;
 #define th_isnan_break(val)
 #endif
 
+/* Reductions (sum, prod, max, min, norm, ...) share one engine:
+ *  - over all the elements of a contiguous tensor, blocks of TH_REDUCE_BLOCK
+ *    elements are reduced in parallel by the THVector kernels, then the
+ *    block results are combined pairwise, in an order that does not depend
+ *    on the number of threads
+ *  - along a dimension of stride 1, the rows are reduced in parallel by the
+ *    THVector kernels
+ *  - along another dimension of a contiguous tensor, seen as
+ *    (outer, size, inner), the size rows are accumulated element-wise into
+ *    inner results, which vectorizes over the inner elements; pieces of
+ *    TH_REDUCE_INNER inner elements run in parallel
+ * Other layouts use the apply macros. */
+
+#ifndef TH_REDUCE_BLOCK
+#define TH_REDUCE_BLOCK 4096
+#define TH_REDUCE_INNER 2048
+#define TH_REDUCE_ROWS 16
+#define TH_REDUCE_SUM 0
+#define TH_REDUCE_PROD 1
+#define TH_REDUCE_MAX 2
+#define TH_REDUCE_MIN 3
+#define TH_REDUCE_ASUM 4     /* sum of |x| */
+#define TH_REDUCE_SUMSQ 5    /* sum of (x-value)^2 */
+#define TH_REDUCE_POW 6      /* sum of |x|^value */
+#define TH_REDUCE_NONZERO 7  /* number of non-zero x */
+#endif
+
+typedef struct THTensor_(ReduceJob)
+{
+  int op;
+  accreal value;
+  real *t;
+  ptrdiff_t size;     /* number of elements reduced into one result */
+  ptrdiff_t inner;    /* distance between these elements */
+  ptrdiff_t npieces;  /* pieces of inner elements */
+  accreal *partial;   /* results of the blocks (all elements) */
+  real *r;            /* results (along a dimension) */
+  long *index;        /* positions of the max/min (along a dimension) */
+} THTensor_(ReduceJob);
+
+static accreal THTensor_(reduceRow)(int op, const real *x, ptrdiff_t n, accreal value)
+{
+  accreal acc;
+  ptrdiff_t i;
+  switch(op)
+  {
+    case TH_REDUCE_SUM:
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+      if(THGetCompensatedSum())
+        return THVector_(sumCompensated)(x, n);
+#endif
+      return THVector_(sum)(x, n);
+    case TH_REDUCE_MAX:
+      return THVector_(max)(x, n);
+    case TH_REDUCE_MIN:
+      return THVector_(min)(x, n);
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+    case TH_REDUCE_ASUM:
+      return THVector_(asum)(x, n);
+    case TH_REDUCE_SUMSQ:
+      return THVector_(sumsq)(x, value, n);
+    case TH_REDUCE_POW:
+      acc = 0;
+      for(i = 0; i < n; i++)
+        acc += pow(fabs(x[i]), value);
+      return acc;
+    case TH_REDUCE_NONZERO:
+      acc = 0;
+      for(i = 0; i < n; i++)
+        acc += (x[i] != 0);
+      return acc;
+#endif
+    default:
+      acc = 1;
+      for(i = 0; i < n; i++)
+        acc *= x[i];
+      return acc;
+  }
+}
+
+/* position of the first nan if m is nan, of the first m otherwise */
+static long THTensor_(reduceIndex)(const real *x, ptrdiff_t n, real m)
+{
+  ptrdiff_t i;
+  if(th_isnan(m))
+  {
+    for(i = 0; i < n; i++)
+      if(th_isnan(x[i]))
+        return i;
+  }
+  for(i = 0; i < n; i++)
+    if(x[i] == m)
+      return i;
+  return 0;
+}
+
+static accreal THTensor_(reduceCombine)(int op, accreal a, accreal b)
+{
+  switch(op)
+  {
+    case TH_REDUCE_MAX:
+      return (th_isnan(a) || b <= a ? a : b);
+    case TH_REDUCE_MIN:
+      return (th_isnan(a) || b >= a ? a : b);
+    case TH_REDUCE_PROD:
+      return a*b;
+    default:
+      return a+b;
+  }
+}
+
+static void THTensor_(reduceAll_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ReduceJob) *job = data;
+  ptrdiff_t b;
+  for(b = begin; b < end; b++)
+  {
+    ptrdiff_t offset = b*TH_REDUCE_BLOCK;
+    ptrdiff_t n = (job->size - offset < TH_REDUCE_BLOCK ? job->size - offset : TH_REDUCE_BLOCK);
+    job->partial[b] = THTensor_(reduceRow)(job->op, job->t + offset, n, job->value);
+  }
+}
+
+/* tensor must be contiguous and not empty */
+static accreal THTensor_(reduceAll)(THTensor *tensor, int op, accreal value, ptrdiff_t cost)
+{
+  THTensor_(ReduceJob) job;
+  accreal partial[64];
+  accreal result;
+  ptrdiff_t nblocks, n, i;
+
+  job.op = op;
+  job.value = value;
+  job.t = THTensor_(data)(tensor);
+  job.size = THTensor_(nElement)(tensor);
+  nblocks = (job.size + TH_REDUCE_BLOCK - 1) / TH_REDUCE_BLOCK;
+  job.partial = (nblocks <= 64 ? partial : THScratch_alloc(sizeof(accreal)*nblocks));
+  /* chunks of whole blocks: the same partials as in one pass */
+  THTensor_(outOfCoreFor)(job.size, TH_REDUCE_BLOCK, 1, THParallelGrain(cost*TH_REDUCE_BLOCK),
+                          THTensor_(reduceAll_kernel), &job, job.t, NULL, NULL);
+
+  for(n = nblocks; n > 1; n = (n+1)/2)
+  {
+    for(i = 0; i < n/2; i++)
+      job.partial[i] = THTensor_(reduceCombine)(op, job.partial[2*i], job.partial[2*i+1]);
+    if(n % 2)
+      job.partial[n/2] = job.partial[n-1];
+  }
+  result = job.partial[0];
+  if(job.partial != partial)
+    THScratch_free(job.partial);
+  return result;
+}
+
+static void THTensor_(reduceRows_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ReduceJob) *job = data;
+  ptrdiff_t i;
+  for(i = begin; i < end; i++)
+  {
+    const real *x = job->t + i*job->size;
+    job->r[i] = (real)THTensor_(reduceRow)(job->op, x, job->size, job->value);
+    if(job->index)
+      job->index[i] = THTensor_(reduceIndex)(x, job->size, job->r[i]);
+  }
+}
+
+static void THTensor_(reduceCols_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ReduceJob) *job = data;
+  accreal acc[TH_REDUCE_INNER];
+  accreal comp[TH_REDUCE_INNER];
+  ptrdiff_t p, j, k;
+  int op = job->op;
+  int compensated = 0;
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+  compensated = (op == TH_REDUCE_SUM && THGetCompensatedSum());
+#endif
+
+  for(p = begin; p < end; p++)
+  {
+    ptrdiff_t o = p / job->npieces;
+    ptrdiff_t j0 = (p % job->npieces)*TH_REDUCE_INNER;
+    ptrdiff_t m = (job->inner - j0 < TH_REDUCE_INNER ? job->inner - j0 : TH_REDUCE_INNER);
+    const real *x = job->t + o*job->size*job->inner + j0;
+    real *r = job->r + o*job->inner + j0;
+    accreal value = job->value;
+
+    if(op == TH_REDUCE_MAX || op == TH_REDUCE_MIN)
+    {
+      long *index = job->index + o*job->inner + j0;
+      for(j = 0; j < m; j++)
+      {
+        r[j] = x[j];
+        index[j] = 0;
+      }
+      /* the first nan stays */
+      for(k = 1; k < job->size; k++)
+      {
+        const real *row = x + k*job->inner;
+        if(op == TH_REDUCE_MAX)
+        {
+          for(j = 0; j < m; j++)
+          {
+            int take = !(row[j] <= r[j]) && !th_isnan(r[j]);
+            r[j] = (take ? row[j] : r[j]);
+            index[j] = (take ? k : index[j]);
+          }
+        }
+        else
+        {
+          for(j = 0; j < m; j++)
+          {
+            int take = !(row[j] >= r[j]) && !th_isnan(r[j]);
+            r[j] = (take ? row[j] : r[j]);
+            index[j] = (take ? k : index[j]);
+          }
+        }
+      }
+      continue;
+    }
+
+    for(j = 0; j < m; j++)
+    {
+      acc[j] = (op == TH_REDUCE_PROD ? 1 : 0);
+      comp[j] = 0;
+    }
+    if(op == TH_REDUCE_SUM && !compensated)
+    {
+      /* groups of TH_REDUCE_ROWS rows are summed in real, then in accreal:
+         for float, half the traffic on the accumulators */
+      real part[TH_REDUCE_INNER];
+      ptrdiff_t k0, k1;
+      for(k0 = 0; k0 < job->size; k0 += TH_REDUCE_ROWS)
+      {
+        k1 = (job->size - k0 < TH_REDUCE_ROWS ? job->size : k0 + TH_REDUCE_ROWS);
+        for(j = 0; j < m; j++)
+          part[j] = x[k0*job->inner+j];
+        for(k = k0+1; k < k1-1; k += 2)
+        {
+          const real *row0 = x + k*job->inner;
+          const real *row1 = row0 + job->inner;
+          for(j = 0; j < m; j++)
+            part[j] += row0[j] + row1[j];
+        }
+        for(; k < k1; k++)
+        {
+          const real *row = x + k*job->inner;
+          for(j = 0; j < m; j++)
+            part[j] += row[j];
+        }
+        for(j = 0; j < m; j++)
+          acc[j] += part[j];
+      }
+    }
+    else for(k = 0; k < job->size; k++)
+    {
+      const real *row = x + k*job->inner;
+      switch(op)
+      {
+        case TH_REDUCE_SUM:
+          if(compensated)
+          {
+            for(j = 0; j < m; j++)
+            {
+              accreal y = row[j] - comp[j];
+              accreal t = acc[j] + y;
+              comp[j] = (t - acc[j]) - y;
+              acc[j] = t;
+            }
+          }
+          else
+          {
+            for(j = 0; j < m; j++)
+              acc[j] += row[j];
+          }
+          break;
+        case TH_REDUCE_PROD:
+          for(j = 0; j < m; j++)
+            acc[j] *= row[j];
+          break;
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+        case TH_REDUCE_ASUM:
+          for(j = 0; j < m; j++)
+            acc[j] += fabs(row[j]);
+          break;
+        case TH_REDUCE_SUMSQ:
+          for(j = 0; j < m; j++)
+          {
+            accreal d = (accreal)row[j] - value;
+            acc[j] += d*d;
+          }
+          break;
+        case TH_REDUCE_POW:
+          for(j = 0; j < m; j++)
+            acc[j] += pow(fabs(row[j]), value);
+          break;
+        case TH_REDUCE_NONZERO:
+          for(j = 0; j < m; j++)
+            acc[j] += (row[j] != 0);
+          break;
+#endif
+      }
+    }
+    for(j = 0; j < m; j++)
+      r[j] = (real)acc[j];
+  }
+}
+
+/* reduces t along dimension into r_ (and index_ for max and min), already
+ * resized to the size of t with 1 at dimension
+ * returns 0 if the layout of the tensors is not handled */
+static int THTensor_(reduceDim)(THTensor *r_, THLongTensor *index_, THTensor *t, int dimension,
+                                int op, real value, ptrdiff_t cost)
+{
+  THTensor_(ReduceJob) job;
+  ptrdiff_t outer;
+  int d;
+
+  if(!THTensor_(isContiguous)(t) || !THTensor_(isContiguous)(r_)
+     || (index_ && !THLongTensor_isContiguous(index_)))
+    return 0;
+
+  job.op = op;
+  job.value = value;
+  job.t = THTensor_(data)(t);
+  job.size = t->size[dimension];
+  job.inner = 1;
+  for(d = dimension+1; d < t->nDimension; d++)
+    job.inner *= t->size[d];
+  outer = THTensor_(nElement)(t) / (job.size*job.inner);
+  job.partial = NULL;
+  job.r = THTensor_(data)(r_);
+  job.index = (index_ ? THLongTensor_data(index_) : NULL);
+
+  /* out of core, in chunks of whole slices (size*inner elements) */
+  if(job.inner == 1)
+  {
+    job.npieces = 1;
+    THTensor_(outOfCoreFor)(outer*job.size, job.size, 1, THParallelGrain(cost*job.size),
+                            THTensor_(reduceRows_kernel), &job, job.t, NULL, NULL);
+  }
+  else
+  {
+    job.npieces = (job.inner + TH_REDUCE_INNER - 1) / TH_REDUCE_INNER;
+    THTensor_(outOfCoreFor)(outer*job.size*job.inner, job.size*job.inner, job.npieces,
+                            THParallelGrain(cost*job.size*TH_REDUCE_INNER),
+                            THTensor_(reduceCols_kernel), &job, job.t, NULL, NULL);
+  }
+  return 1;
+}
+
 real THTensor_(minall)(THTensor *tensor)
 {
   real theMin;
   real value;
 
   THArgCheck(tensor->nDimension > 0, 1, "tensor must have one dimension");
+  if(THTensor_(isContiguous)(tensor))
+    return (real)THTensor_(reduceAll)(tensor, TH_REDUCE_MIN, 0, 1);
   theMin = THTensor_(data)(tensor)[0];
   TH_TENSOR_APPLY(real, tensor,
                   value = *tensor_data;
@@ -574,6 +933,8 @@ real THTensor_(maxall)(THTensor *tensor)
   real value;
 
   THArgCheck(tensor->nDimension > 0, 1, "tensor must have one dimension");
+  if(THTensor_(isContiguous)(tensor))
+    return (real)THTensor_(reduceAll)(tensor, TH_REDUCE_MAX, 0, 1);
   theMax = THTensor_(data)(tensor)[0];
   TH_TENSOR_APPLY(real, tensor,
                   value = *tensor_data;
@@ -589,22 +950,44 @@ real THTensor_(maxall)(THTensor *tensor)
 accreal THTensor_(sumall)(THTensor *tensor)
 {
   accreal sum = 0;
-  TH_TENSOR_APPLY(real, tensor, sum += *tensor_data;);
+  if(THTensor_(nElement)(tensor) == 0)
+    return 0;
+  if(THTensor_(isContiguous)(tensor))
+    return THTensor_(reduceAll)(tensor, TH_REDUCE_SUM, 0, 1);
+  /* the innermost runs of stride 1 still go through the vector kernels */
+  TH_TENSOR_APPLY(real, tensor,
+                  if(tensor_stride == 1) {
+                    sum += THTensor_(reduceRow)(TH_REDUCE_SUM, tensor_data, tensor_size, 0);
+                    tensor_i = tensor_size;
+                    tensor_data += tensor_size;
+                    break;
+                  } else {
+                    sum += *tensor_data;
+                  });
   return sum;
 }
 
 accreal THTensor_(prodall)(THTensor *tensor)
 {
   accreal prod = 1;
+  if(THTensor_(nElement)(tensor) > 0 && THTensor_(isContiguous)(tensor))
+    return THTensor_(reduceAll)(tensor, TH_REDUCE_PROD, 0, 1);
   TH_TENSOR_APPLY(real, tensor, prod *= *tensor_data;);
   return prod;
 }
 
+static void THTensor_(add_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(adds)(job->r + begin, job->t + begin, job->value, end - begin);
+}
+
 void THTensor_(add)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) {
-    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(adds)(r__data, t_data, value, r__len););
+    THTensor_(parallelApply)(THTensor_(add_kernel), 1, THTensor_(nElement)(r_),
+                             THTensor_(data)(r_), THTensor_(data)(t), NULL, value, 0);
   } else {
     TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data + value;);
   }
@@ -615,26 +998,58 @@ void THTensor_(sub)(THTensor *r_, THTensor *t, real value)
   THTensor_(add)(r_, t, -value);
 }
 
+static void THTensor_(mul_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(muls)(job->r + begin, job->t + begin, job->value, end - begin);
+}
+
 void THTensor_(mul)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) {
-    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(muls)(r__data, t_data, value, r__len););
+    THTensor_(parallelApply)(THTensor_(mul_kernel), 1, THTensor_(nElement)(r_),
+                             THTensor_(data)(r_), THTensor_(data)(t), NULL, value, 0);
   } else {
     TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data * value;);
   }
 }
 
+static void THTensor_(div_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(divs)(job->r + begin, job->t + begin, job->value, end - begin);
+}
+
 void THTensor_(div)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) {
-    TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(divs)(r__data, t_data, value, r__len););
+    THTensor_(parallelApply)(THTensor_(div_kernel), 1, THTensor_(nElement)(r_),
+                             THTensor_(data)(r_), THTensor_(data)(t), NULL, value, 0);
   } else {
     TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data / value;);
   }
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(lshift_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_BYTE)
+    rp[i] = ((real) tp[i]) << value;
+#else
+    rp[i] = ((unsigned real) tp[i]) << value;
+#endif
+  }
+}
+#endif
+
 void THTensor_(lshift)(THTensor *r_, THTensor *t, real value)
 {
 #if defined(TH_REAL_IS_FLOAT)
@@ -651,15 +1066,7 @@ void THTensor_(lshift)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       long sz = THTensor_(nElement)(t);
-      long i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
-      for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_BYTE)
-          rp[i] = ((real) tp[i]) << value;
-#else
-          rp[i] = ((unsigned real) tp[i]) << value;
-#endif
-      }
+      THTensor_(parallelApply)(THTensor_(lshift_kernel), 1, sz, rp, tp, NULL, value, 0);
   } else {
 #if defined(TH_REAL_IS_BYTE)
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (((real) *t_data) << value););
@@ -670,6 +1077,24 @@ void THTensor_(lshift)(THTensor *r_, THTensor *t, real value)
 #endif
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(rshift_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_BYTE)
+    rp[i] = ((real) tp[i]) >> value;
+#else
+    rp[i] = ((unsigned real) tp[i]) >> value;
+#endif
+  }
+}
+#endif
+
 void THTensor_(rshift)(THTensor *r_, THTensor *t, real value)
 {
 #if defined(TH_REAL_IS_FLOAT)
@@ -686,15 +1111,7 @@ void THTensor_(rshift)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       long sz = THTensor_(nElement)(t);
-      long i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
-      for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_BYTE)
-          rp[i] = ((real) tp[i]) >> value;
-#else
-          rp[i] = ((unsigned real) tp[i]) >> value;
-#endif
-      }
+      THTensor_(parallelApply)(THTensor_(rshift_kernel), 1, sz, rp, tp, NULL, value, 0);
   } else {
 #if defined(TH_REAL_IS_BYTE)
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (((real) *t_data) >> value););
@@ -705,6 +1122,22 @@ void THTensor_(rshift)(THTensor *r_, THTensor *t, real value)
 #endif
 }
 
+static void THTensor_(fmod_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+    rp[i] = fmod(tp[i], value);
+#else
+    rp[i] = tp[i] % value;
+#endif
+  }
+}
+
 void THTensor_(fmod)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
@@ -713,15 +1146,7 @@ void THTensor_(fmod)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-      for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-          rp[i] = fmod(tp[i], value);
-#else
-          rp[i] = tp[i] % value;
-#endif
-      }
+      THTensor_(parallelApply)(THTensor_(fmod_kernel), 8, sz, rp, tp, NULL, value, 0);
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = fmod(*t_data, value););
@@ -731,6 +1156,25 @@ void THTensor_(fmod)(THTensor *r_, THTensor *t, real value)
   }
 }
 
+static void THTensor_(remainder_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+    rp[i] = (value == 0)? NAN : tp[i] - value * floor(tp[i] / value);
+#else
+    // There is no NAN for integers
+    rp[i] = tp[i] % value;
+    if (rp[i] * value < 0)
+      rp[i] += value;
+#endif
+  }
+}
+
 void THTensor_(remainder)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
@@ -738,18 +1182,7 @@ void THTensor_(remainder)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-      for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-          rp[i] = (value == 0)? NAN : tp[i] - value * floor(tp[i] / value);
-#else
-          // There is no NAN for integers
-          rp[i] = tp[i] % value;
-          if (rp[i] * value < 0)
-            rp[i] += value;
-#endif
-      }
+      THTensor_(parallelApply)(THTensor_(remainder_kernel), 8, sz, rp, tp, NULL, value, 0);
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (value == 0)? NAN : *t_data - value * floor(*t_data / value););
@@ -761,6 +1194,20 @@ void THTensor_(remainder)(THTensor *r_, THTensor *t, real value)
   }
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(bitand_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+    rp[i] = tp[i] & value;
+  }
+}
+#endif
+
 void THTensor_(bitand)(THTensor *r_, THTensor *t, real value)
 {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_HALF)
@@ -773,17 +1220,27 @@ void THTensor_(bitand)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       long sz = THTensor_(nElement)(t);
-      long i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
-      for (i=0; i<sz; i++) {
-          rp[i] = tp[i] & value;
-      }
+      THTensor_(parallelApply)(THTensor_(bitand_kernel), 1, sz, rp, tp, NULL, value, 0);
   } else {
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data & value;);
   }
 #endif
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(bitor_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+    rp[i] = tp[i] | value;
+  }
+}
+#endif
+
 void THTensor_(bitor)(THTensor *r_, THTensor *t, real value)
 {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_HALF)
@@ -796,17 +1253,27 @@ void THTensor_(bitor)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       long sz = THTensor_(nElement)(t);
-      long i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
-      for (i=0; i<sz; i++) {
-          rp[i] = tp[i] | value;
-      }
+      THTensor_(parallelApply)(THTensor_(bitor_kernel), 1, sz, rp, tp, NULL, value, 0);
   } else {
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data | value;);
   }
 #endif
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(bitxor_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+    rp[i] = tp[i] ^ value;
+  }
+}
+#endif
+
 void THTensor_(bitxor)(THTensor *r_, THTensor *t, real value)
 {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_HALF)
@@ -819,17 +1286,25 @@ void THTensor_(bitxor)(THTensor *r_, THTensor *t, real value)
       real *tp = THTensor_(data)(t);
       real *rp = THTensor_(data)(r_);
       long sz = THTensor_(nElement)(t);
-      long i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
-      for (i=0; i<sz; i++) {
-          rp[i] = tp[i] ^ value;
-      }
+      THTensor_(parallelApply)(THTensor_(bitxor_kernel), 1, sz, rp, tp, NULL, value, 0);
   } else {
       TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data ^ value;);
   }
 #endif
 }
 
+static void THTensor_(clamp_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real min_value = job->value;
+  real max_value = job->value2;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++)
+    rp[i] = (tp[i] < min_value) ? min_value : (tp[i] > max_value ? max_value : tp[i]);
+}
+
 void THTensor_(clamp)(THTensor *r_, THTensor *t, real min_value, real max_value)
 {
   THTensor_(resizeAs)(r_, t);
@@ -838,15 +1313,18 @@ void THTensor_(clamp)(THTensor *r_, THTensor *t, real min_value, real max_value)
     real *rp = THTensor_(data)(r_);
     /* real t_val; */
     ptrdiff_t sz = THTensor_(nElement)(t);
-    ptrdiff_t i;
-    #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++)
-      rp[i] = (tp[i] < min_value) ? min_value : (tp[i] > max_value ? max_value : tp[i]);
+    THTensor_(parallelApply)(THTensor_(clamp_kernel), 1, sz, rp, tp, NULL, min_value, max_value);
   } else {
     TH_TENSOR_APPLY2(real, r_, real, t, *r__data = (*t_data < min_value) ? min_value : (*t_data > max_value ? max_value : *t_data););
   }
 }
 
+static void THTensor_(cadd_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(cadd)(job->r + begin, job->t + begin, job->src + begin, job->value, end - begin);
+}
+
 void THTensor_(cadd)(THTensor *r_, THTensor *t, real value, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
@@ -854,7 +1332,8 @@ void THTensor_(cadd)(THTensor *r_, THTensor *t, real value, THTensor *src)
     if(r_ == t) {
       THBlas_(axpy)(THTensor_(nElement)(t), value, THTensor_(data)(src), 1, THTensor_(data)(r_), 1);
     } else {
-      TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cadd)(r__data, t_data, src_data, value, r__len););
+      THTensor_(parallelApply)(THTensor_(cadd_kernel), 1, THTensor_(nElement)(r_),
+                               THTensor_(data)(r_), THTensor_(data)(t), THTensor_(data)(src), value, 0);
     }
   } else {
     TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data + value * *src_data;);
@@ -866,16 +1345,34 @@ void THTensor_(csub)(THTensor *r_, THTensor *t, real value,THTensor *src)
   THTensor_(cadd)(r_, t, -value, src);
 }
 
+static void THTensor_(cmul_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(cmul)(job->r + begin, job->t + begin, job->src + begin, end - begin);
+}
+
 void THTensor_(cmul)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(isContiguous)(src) && THTensor_(nElement)(r_) == THTensor_(nElement)(src)) {
-    TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cmul)(r__data, t_data, src_data, r__len););
+    THTensor_(parallelApply)(THTensor_(cmul_kernel), 1, THTensor_(nElement)(r_),
+                             THTensor_(data)(r_), THTensor_(data)(t), THTensor_(data)(src), 0, 0);
   } else {
     TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data * *src_data;);
   }
 }
 
+static void THTensor_(cpow_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++)
+    rp[i] = pow(tp[i], sp[i]);
+}
+
 void THTensor_(cpow)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
@@ -884,25 +1381,49 @@ void THTensor_(cpow)(THTensor *r_, THTensor *t, THTensor *src)
     real *sp = THTensor_(data)(src);
     real *rp = THTensor_(data)(r_);
     ptrdiff_t sz = THTensor_(nElement)(t);
-    ptrdiff_t i;
-    #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++)
-      rp[i] = pow(tp[i], sp[i]);
+    THTensor_(parallelApply)(THTensor_(cpow_kernel), 16, sz, rp, tp, sp, 0, 0);
   } else {
     TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = pow(*t_data, *src_data););
   }
 }
 
+static void THTensor_(cdiv_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  THVector_(cdiv)(job->r + begin, job->t + begin, job->src + begin, end - begin);
+}
+
 void THTensor_(cdiv)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
   if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(isContiguous)(src) && THTensor_(nElement)(r_) == THTensor_(nElement)(src)) {
-    TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cdiv)(r__data, t_data, src_data, r__len););
+    THTensor_(parallelApply)(THTensor_(cdiv_kernel), 1, THTensor_(nElement)(r_),
+                             THTensor_(data)(r_), THTensor_(data)(t), THTensor_(data)(src), 0, 0);
   } else {
     TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data / *src_data;);
   }
 }
 
+static void THTensor_(clshift_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_FLOAT)
+    rp[i] = tp[i] * powf(2, sp[i]);
+#elif defined(TH_REAL_IS_DOUBLE)
+    rp[i] = tp[i] * pow(2, sp[i]);
+#elif defined(TH_REAL_IS_BYTE)
+    rp[i] = ((real) tp[i]) << sp[i];
+#else
+    rp[i] = ((unsigned real) tp[i]) << sp[i];
+#endif
+  }
+}
+
 void THTensor_(clshift)(THTensor *r_, THTensor *t, THTensor *src)
 {
 #if defined(TH_REAL_IS_HALF)
@@ -917,19 +1438,7 @@ void THTensor_(clshift)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_FLOAT)
-      rp[i] = tp[i] * powf(2, sp[i]);
-#elif defined(TH_REAL_IS_DOUBLE)
-      rp[i] = tp[i] * pow(2, sp[i]);
-#elif defined(TH_REAL_IS_BYTE)
-      rp[i] = ((real) tp[i]) << sp[i];
-#else
-      rp[i] = ((unsigned real) tp[i]) << sp[i];
-#endif
-    }
+      THTensor_(parallelApply)(THTensor_(clshift_kernel), 16, sz, rp, tp, sp, 0, 0);
   } else {
 #if defined(TH_REAL_IS_FLOAT)
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data * powf(2, *src_data););
@@ -943,6 +1452,26 @@ void THTensor_(clshift)(THTensor *r_, THTensor *t, THTensor *src)
   }
 }
 
+static void THTensor_(crshift_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_FLOAT)
+    rp[i] = tp[i] / powf(2, sp[i]);
+#elif defined(TH_REAL_IS_DOUBLE)
+    rp[i] = tp[i] / pow(2, sp[i]);
+#elif defined(TH_REAL_IS_BYTE)
+    rp[i] = ((real) tp[i]) >> sp[i];
+#else
+    rp[i] = ((unsigned real) tp[i]) >> sp[i];
+#endif
+  }
+}
+
 void THTensor_(crshift)(THTensor *r_, THTensor *t, THTensor *src)
 {
 #if defined(TH_REAL_IS_HALF)
@@ -957,19 +1486,7 @@ void THTensor_(crshift)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_FLOAT)
-      rp[i] = tp[i] / powf(2, sp[i]);
-#elif defined(TH_REAL_IS_DOUBLE)
-      rp[i] = tp[i] / pow(2, sp[i]);
-#elif defined(TH_REAL_IS_BYTE)
-      rp[i] = ((real) tp[i]) >> sp[i];
-#else
-      rp[i] = ((unsigned real) tp[i]) >> sp[i];
-#endif
-    }
+      THTensor_(parallelApply)(THTensor_(crshift_kernel), 16, sz, rp, tp, sp, 0, 0);
   } else {
 #if defined(TH_REAL_IS_FLOAT)
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data / powf(2, *src_data););
@@ -983,6 +1500,22 @@ void THTensor_(crshift)(THTensor *r_, THTensor *t, THTensor *src)
   }
 }
 
+static void THTensor_(cfmod_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+    rp[i] = fmod(tp[i], sp[i]);
+#else
+    rp[i] = tp[i] % sp[i];
+#endif
+  }
+}
+
 void THTensor_(cfmod)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
@@ -991,15 +1524,7 @@ void THTensor_(cfmod)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-      for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-          rp[i] = fmod(tp[i], sp[i]);
-#else
-          rp[i] = tp[i] % sp[i];
-#endif
-      }
+      THTensor_(parallelApply)(THTensor_(cfmod_kernel), 8, sz, rp, tp, sp, 0, 0);
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = fmod(*t_data, *src_data););
@@ -1010,6 +1535,25 @@ void THTensor_(cfmod)(THTensor *r_, THTensor *t, THTensor *src)
   }
 }
 
+static void THTensor_(cremainder_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+    rp[i] = (sp[i] == 0)? NAN : tp[i] - sp[i] * floor(tp[i] / sp[i]);
+#else
+    // There is no NAN for integers
+    rp[i] = tp[i] % sp[i];
+    if (rp[i] * sp[i] < 0)
+      rp[i] += sp[i];
+#endif
+  }
+}
+
 void THTensor_(cremainder)(THTensor *r_, THTensor *t, THTensor *src)
 {
   THTensor_(resizeAs)(r_, t);
@@ -1018,18 +1562,7 @@ void THTensor_(cremainder)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-      for (i=0; i<sz; i++) {
-#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
-          rp[i] = (sp[i] == 0)? NAN : tp[i] - sp[i] * floor(tp[i] / sp[i]);
-#else
-          // There is no NAN for integers
-          rp[i] = tp[i] % sp[i];
-          if (rp[i] * sp[i] < 0)
-            rp[i] += sp[i];
-#endif
-      }
+      THTensor_(parallelApply)(THTensor_(cremainder_kernel), 8, sz, rp, tp, sp, 0, 0);
   } else {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = (*src_data == 0)? NAN : *t_data - *src_data * floor(*t_data / *src_data););
@@ -1042,6 +1575,20 @@ void THTensor_(cremainder)(THTensor *r_, THTensor *t, THTensor *src)
   }
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(cbitand_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+    rp[i] = tp[i] & sp[i];
+  }
+}
+#endif
+
 void THTensor_(cbitand)(THTensor *r_, THTensor *t, THTensor *src)
 {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_HALF)
@@ -1056,17 +1603,27 @@ void THTensor_(cbitand)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++) {
-      rp[i] = tp[i] & sp[i];
-    }
+      THTensor_(parallelApply)(THTensor_(cbitand_kernel), 1, sz, rp, tp, sp, 0, 0);
   } else {
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data & *src_data;);
   }
 #endif
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(cbitor_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+    rp[i] = tp[i] | sp[i];
+  }
+}
+#endif
+
 void THTensor_(cbitor)(THTensor *r_, THTensor *t, THTensor *src)
 {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_HALF)
@@ -1081,17 +1638,27 @@ void THTensor_(cbitor)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++) {
-      rp[i] = tp[i] | sp[i];
-    }
+      THTensor_(parallelApply)(THTensor_(cbitor_kernel), 1, sz, rp, tp, sp, 0, 0);
   } else {
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data | *src_data;);
   }
 #endif
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_HALF)
+static void THTensor_(cbitxor_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *sp = job->src;
+  real *rp = job->r;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++) {
+    rp[i] = tp[i] ^ sp[i];
+  }
+}
+#endif
+
 void THTensor_(cbitxor)(THTensor *r_, THTensor *t, THTensor *src)
 {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_HALF)
@@ -1106,17 +1673,24 @@ void THTensor_(cbitxor)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       ptrdiff_t sz = THTensor_(nElement)(t);
-      ptrdiff_t i;
-      #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++) {
-      rp[i] = tp[i] ^ sp[i];
-    }
+      THTensor_(parallelApply)(THTensor_(cbitxor_kernel), 1, sz, rp, tp, sp, 0, 0);
   } else {
       TH_TENSOR_APPLY3(real, r_, real, t, real, src, *r__data = *t_data ^ *src_data;);
   }
 #endif
 }
 
+static void THTensor_(tpow_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *tp = job->t;
+  real *rp = job->r;
+  real value = job->value;
+  ptrdiff_t i;
+  for (i=begin; i<end; i++)
+    rp[i] = pow(value, tp[i]);
+}
+
 void THTensor_(tpow)(THTensor *r_, real value, THTensor *t)
 {
   THTensor_(resizeAs)(r_, t);
@@ -1124,10 +1698,7 @@ void THTensor_(tpow)(THTensor *r_, real value, THTensor *t)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     ptrdiff_t sz = THTensor_(nElement)(t);
-    ptrdiff_t i;
-    #pragma omp parallel for if(sz > TH_OMP_OVERHEAD_THRESHOLD) private(i)
-    for (i=0; i<sz; i++)
-      rp[i] = pow(value, tp[i]);
+    THTensor_(parallelApply)(THTensor_(tpow_kernel), 16, sz, rp, tp, NULL, value, 0);
   } else {
     TH_TENSOR_APPLY2(real, r_, real, t, *r__data = pow(value, *t_data););
   }
@@ -1199,7 +1770,7 @@ void THTensor_(addmv)(THTensor *r_, real beta, THTensor *t, real alpha, THTensor
   }
   else
   {
-    THTensor *cmat = THTensor_(newContiguous)(mat);
+    THTensor *cmat = THTensor_(newContiguousScratch)(mat);
 
     THBlas_(gemv)('t',  mat->size[1], mat->size[0],
                   alpha, THTensor_(data)(cmat), cmat->stride[0],
@@ -1210,6 +1781,29 @@ void THTensor_(addmv)(THTensor *r_, real beta, THTensor *t, real alpha, THTensor
   }
 }
 
+static void THTensor_(match_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(ParallelJob) *job = data;
+  real *r_p = job->r;
+  real *m1_p = job->t;
+  real *m2_p = job->src;
+  real gain = job->value;
+  long N2 = job->rowsize;
+  long dim = job->dim;
+  long i;
+  for (i=begin; i<end; i++) {
+    long j,k;
+    for (j=0; j<N2; j++) {
+      real sum = 0;
+      for (k=0; k<dim; k++) {
+        real term = m1_p[ i*dim + k ] - m2_p[ j*dim + k ];
+        sum += term*term;
+      }
+      r_p[ i*N2 + j ] = gain * sum;
+    }
+  }
+}
+
 void THTensor_(match)(THTensor *r_, THTensor *m1, THTensor *m2, real gain)
 {
   long N1 = m1->size[0];
@@ -1218,7 +1812,7 @@ void THTensor_(match)(THTensor *r_, THTensor *m1, THTensor *m2, real gain)
   real *m1_p;
   real *m2_p;
   real *r_p;
-  long i;
+  THTensor_(ParallelJob) job;
 
   THTensor_(resize2d)(r_, N1, N2);
 
@@ -1235,18 +1829,13 @@ void THTensor_(match)(THTensor *r_, THTensor *m1, THTensor *m2, real gain)
   m2_p = THTensor_(data)(m2);
   r_p = THTensor_(data)(r_);
 
-#pragma omp parallel for private(i)
-  for (i=0; i<N1; i++) {
-    long j,k;
-    for (j=0; j<N2; j++) {
-      real sum = 0;
-      for (k=0; k<dim; k++) {
-        real term = m1_p[ i*dim + k ] - m2_p[ j*dim + k ];
-        sum += term*term;
-      }
-      r_p[ i*N2 + j ] = gain * sum;
-    }
-  }
+  job.r = r_p;
+  job.t = m1_p;
+  job.src = m2_p;
+  job.value = gain;
+  job.rowsize = N2;
+  job.dim = dim;
+  THParallelFor(0, N1, THParallelGrain(N2*dim*3), THTensor_(match_kernel), &job);
 
   THTensor_(free)(m1);
   THTensor_(free)(m2);
@@ -1324,7 +1913,7 @@ void THTensor_(addmm)(THTensor *r_, real beta, THTensor *t, real alpha, THTensor
   else
   {
     transpose_m1 = (transpose_r == 'n' ? 't' : 'n');
-    m1_ = THTensor_(newContiguous)(m1);
+    m1_ = THTensor_(newContiguousScratch)(m1);
   }
 
   /* m2 */
@@ -1343,7 +1932,7 @@ void THTensor_(addmm)(THTensor *r_, real beta, THTensor *t, real alpha, THTensor
   else
   {
     transpose_m2 = (transpose_r == 'n' ? 't' : 'n');
-    m2_ = THTensor_(newContiguous)(m2);
+    m2_ = THTensor_(newContiguousScratch)(m2);
   }
 
   /* do the operation */
@@ -1528,28 +2117,12 @@ void THTensor_(max)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
   THLongStorage_free(dim);
 
   // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
-    real theMax;
-    real value;
-    long theIndex;
-    long i;
+  if (THTensor_(reduceDim)(values_, indices_, t, dimension, TH_REDUCE_MAX, 0, 1)) {
+    /* contiguous tensors: see the reduction engine */
+  } else if (t->stride[dimension] == 1) {
     TH_TENSOR_DIM_APPLY3(real, t, real, values_, long, indices_, dimension,
-                         theMax = t_data[0];
-                         theIndex = 0;
-
-                         for(i = 0; i < t_size; i++)
-                         {
-                           value = t_data[i*t_stride];
-                           /* This is not the same as value>theMax in the case of NaNs */
-                           if(!(value <= theMax))
-                           {
-                             theIndex = i;
-                             theMax = value;
-                             th_isnan_break(value)
-                           }
-                         }
-                         *indices__data = theIndex;
-                         *values__data = theMax;);
+                         *values__data = THVector_(max)(t_data, t_size);
+                         *indices__data = THTensor_(reduceIndex)(t_data, t_size, *values__data););
   } else {
     if (THTensor_(nDimension)(t) > 1) {
       THTensor *t0 = THTensor_(newSelect)(t, dimension, 0);
@@ -1604,28 +2177,12 @@ void THTensor_(min)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
   THLongStorage_free(dim);
 
   // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
-    real theMax;
-    real value;
-    long theIndex;
-    long i;
+  if (THTensor_(reduceDim)(values_, indices_, t, dimension, TH_REDUCE_MIN, 0, 1)) {
+    /* contiguous tensors: see the reduction engine */
+  } else if (t->stride[dimension] == 1) {
     TH_TENSOR_DIM_APPLY3(real, t, real, values_, long, indices_, dimension,
-                         theMax = t_data[0];
-                         theIndex = 0;
-
-                         for(i = 0; i < t_size; i++)
-                         {
-                           value = t_data[i*t_stride];
-                           /* This is not the same as value>theMax in the case of NaNs */
-                           if(!(value >= theMax))
-                           {
-                             theIndex = i;
-                             theMax = value;
-                             th_isnan_break(value)
-                           }
-                         }
-                         *indices__data = theIndex;
-                         *values__data = theMax;);
+                         *values__data = THVector_(min)(t_data, t_size);
+                         *indices__data = THTensor_(reduceIndex)(t_data, t_size, *values__data););
   } else {
     if (THTensor_(nDimension)(t) > 1) {
       THTensor *t0 = THTensor_(newSelect)(t, dimension, 0);
@@ -1666,33 +2223,27 @@ void THTensor_(min)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
 
 void THTensor_(sum)(THTensor *r_, THTensor *t, int dimension, int keepdim)
 {
-  THLongStorage *dim;
-
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "dimension %d out of range",
       dimension + TH_INDEX_BASE);
 
-  dim = THTensor_(newSizeOf)(t);
-  THLongStorage_set(dim, dimension, 1);
-  THTensor_(resize)(r_, dim, NULL);
-  THLongStorage_free(dim);
+  THTensor_(resizeAlong)(r_, NULL, t, dimension, 1);
 
   // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
+  if (THTensor_(reduceDim)(r_, NULL, t, dimension, TH_REDUCE_SUM, 0, 1)) {
+    /* contiguous tensors: see the reduction engine */
+  } else if (t->stride[dimension] == 1) {
     TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
-                         accreal sum = 0;
-                         long i;
-                         for(i = 0; i < t_size; i++)
-                           sum += t_data[i*t_stride];
-                         *r__data = (real)sum;);
+                         *r__data = (real)THTensor_(reduceRow)(TH_REDUCE_SUM, t_data, t_size, 0););
   } else {
+    long r__stride_dim = r_->stride[dimension];
     THTensor_(zero)(r_);
-    THTensor *temp_ = THTensor_(newWithTensor)(r_);
-    // r_.expand_as(t)
-    temp_->size[dimension] = t->size[dimension];
-    temp_->stride[dimension] = 0;
+    // r_.expand_as(t), in place (no new tensor)
+    r_->size[dimension] = t->size[dimension];
+    r_->stride[dimension] = 0;
 
-    TH_TENSOR_APPLY2(real, temp_, real, t, *temp__data = *temp__data + *t_data;);
-    THTensor_(free)(temp_);
+    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *r__data + *t_data;);
+    r_->size[dimension] = 1;
+    r_->stride[dimension] = r__stride_dim;
   }
 
   if (!keepdim) {
@@ -1702,18 +2253,15 @@ void THTensor_(sum)(THTensor *r_, THTensor *t, int dimension, int keepdim)
 
 void THTensor_(prod)(THTensor *r_, THTensor *t, int dimension, int keepdim)
 {
-  THLongStorage *dim;
-
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "dimension %d out of range",
       dimension + TH_INDEX_BASE);
 
-  dim = THTensor_(newSizeOf)(t);
-  THLongStorage_set(dim, dimension, 1);
-  THTensor_(resize)(r_, dim, NULL);
-  THLongStorage_free(dim);
+  THTensor_(resizeAlong)(r_, NULL, t, dimension, 1);
 
   // two implementations optimized for data locality
-  if (t->stride[dimension] == 1) {
+  if (THTensor_(reduceDim)(r_, NULL, t, dimension, TH_REDUCE_PROD, 0, 1)) {
+    /* contiguous tensors: see the reduction engine */
+  } else if (t->stride[dimension] == 1) {
     TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
                          accreal prod = 1;
                          long i;
@@ -1721,14 +2269,15 @@ void THTensor_(prod)(THTensor *r_, THTensor *t, int dimension, int keepdim)
                            prod *= t_data[i*t_stride];
                          *r__data = (real)prod;);
   } else {
+    long r__stride_dim = r_->stride[dimension];
     THTensor_(fill)(r_, 1);
-    THTensor *temp_ = THTensor_(newWithTensor)(r_);
-    // r_.expand_as(t)
-    temp_->size[dimension] = t->size[dimension];
-    temp_->stride[dimension] = 0;
+    // r_.expand_as(t), in place (no new tensor)
+    r_->size[dimension] = t->size[dimension];
+    r_->stride[dimension] = 0;
 
-    TH_TENSOR_APPLY2(real, temp_, real, t, *temp__data = *temp__data * *t_data;);
-    THTensor_(free)(temp_);
+    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *r__data * *t_data;);
+    r_->size[dimension] = 1;
+    r_->stride[dimension] = r__stride_dim;
   }
 
   if (!keepdim) {
@@ -2217,36 +2766,427 @@ static void THTensor_(quicksortdescend)(real *arr, long *idx, long elements, lon
 #undef MAX_LEVELS
 #undef M_SMALL
 
-void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimension, int descendingOrder)
+/* Sorting and topk
+ *  - the slices along the dimension are processed in parallel, each one
+ *    gathered into contiguous buffers, NaNs apart: they come after all the
+ *    numbers in ascending order, before them in descending order (largest)
+ *  - a slice of TH_SORT_RADIX elements or more is radix sorted (least
+ *    significant digit first, on unsigned keys with the order of the
+ *    values); shorter ones use the quicksort
+ *  - when there are fewer slices than threads, a slice of TH_SORT_BLOCK
+ *    elements or more is radix sorted by all the threads: each pass counts
+ *    the digits of blocks of TH_SORT_BLOCK elements in parallel, then moves
+ *    the blocks in parallel to their offsets
+ *  - topk keeps the k best elements of a slice in a heap when k is small
+ *    relative to the slice (k*TH_TOPK_HEAP <= size); with few slices, one
+ *    heap per block, merged afterwards; otherwise it uses the quickselect */
+
+#ifndef TH_SORT_RADIX
+#define TH_SORT_RADIX 1024
+#define TH_SORT_BLOCK 65536
+#define TH_SORT_BITS 11      /* per pass, from TH_SORT_BLOCK elements */
+#define TH_TOPK_HEAP 16
+#endif
+
+#if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_LONG)
+typedef uint64_t THTensor_(SortKey);
+#else
+typedef uint32_t THTensor_(SortKey);
+#endif
+
+/* unsigned key with the order of the values (NaNs above inf), complemented
+   for a descending order */
+static inline THTensor_(SortKey) THTensor_(sortKey)(real x, int descending)
 {
-  THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "invalid dimension %d",
-      dimension + TH_INDEX_BASE);
+  THTensor_(SortKey) key;
+#if defined(TH_REAL_IS_FLOAT)
+  uint32_t bits;
+  if (isnan(x))
+    x = NAN;
+  memcpy(&bits, &x, sizeof(bits));
+  key = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+#elif defined(TH_REAL_IS_DOUBLE)
+  uint64_t bits;
+  if (isnan(x))
+    x = NAN;
+  memcpy(&bits, &x, sizeof(bits));
+  key = (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+#else
+  key = (THTensor_(SortKey))x ^ (((real)-1 < 0) ? (THTensor_(SortKey))1 << (8*sizeof(real)-1) : 0);
+  if (sizeof(real) < sizeof(key))
+    key &= ((THTensor_(SortKey))1 << (8*sizeof(real) % (8*sizeof(key)))) - 1;
+#endif
+  return descending ? ~key : key;
+}
 
-  THTensor_(resizeAs)(rt_, t);
-  THTensor_(copy)(rt_, t);
+static inline real THTensor_(sortValue)(THTensor_(SortKey) key, int descending)
+{
+  real x;
+  if (descending)
+    key = ~key;
+#if defined(TH_REAL_IS_FLOAT)
+  {
+    uint32_t bits = (key & 0x80000000u) ? (key & 0x7fffffffu) : ~key;
+    memcpy(&x, &bits, sizeof(bits));
+  }
+#elif defined(TH_REAL_IS_DOUBLE)
+  {
+    uint64_t bits = (key & 0x8000000000000000ull) ? (key & 0x7fffffffffffffffull) : ~key;
+    memcpy(&x, &bits, sizeof(bits));
+  }
+#else
+  x = (real)(key ^ (((real)-1 < 0) ? (THTensor_(SortKey))1 << (8*sizeof(real)-1) : 0));
+#endif
+  return x;
+}
 
+/* sorts (*key, *idx) of n elements; *key2 and *idx2 are scratch, the
+   pointers are swapped by the passes so that the result is in (*key, *idx) */
+static void THTensor_(radixSort)(THTensor_(SortKey) **key, THTensor_(SortKey) **key2,
+                                 long **idx, long **idx2, ptrdiff_t n)
+{
+  ptrdiff_t count[1 << TH_SORT_BITS];
+  ptrdiff_t i, offset, c;
+  int bits = (n >= TH_SORT_BLOCK ? TH_SORT_BITS : 8);
+  int digits = 1 << bits;
+  int shift, d;
+
+  for (shift = 0; shift < 8*(int)sizeof(real); shift += bits)
   {
-    THLongStorage *size = THTensor_(newSizeOf)(t);
-    THLongTensor_resize(ri_, size, NULL);
-    THLongStorage_free(size);
+    THTensor_(SortKey) *src = *key, *dst = *key2;
+    long *srci = *idx, *dsti = *idx2;
+    THTensor_(SortKey) mask = digits-1;
+    memset(count, 0, digits*sizeof(ptrdiff_t));
+    for (i = 0; i < n; i++)
+      count[(src[i] >> shift) & mask]++;
+    if (n == 0 || count[(src[0] >> shift) & mask] == n)
+      continue; /* same digit everywhere */
+    for (d = 0, offset = 0; d < digits; d++)
+    {
+      c = count[d];
+      count[d] = offset;
+      offset += c;
+    }
+    for (i = 0; i < n; i++)
+    {
+      ptrdiff_t pos = count[(src[i] >> shift) & mask]++;
+      dst[pos] = src[i];
+      dsti[pos] = srci[i];
+    }
+    *key = dst;
+    *key2 = src;
+    *idx = dsti;
+    *idx2 = srci;
   }
+}
 
-  if(descendingOrder)
+/* copies n elements of stride stride into vals and their positions into
+   idx, NaNs last (by position); returns the number of other elements */
+static ptrdiff_t THTensor_(sortGather)(real *vals, long *idx, const real *src, ptrdiff_t stride, ptrdiff_t n)
+{
+  ptrdiff_t i, m = 0, j = n;
+  for (i = 0; i < n; i++)
   {
-    TH_TENSOR_DIM_APPLY2(real, rt_, long, ri_, dimension,
-                         long i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortdescend)(rt__data, ri__data, rt__size, rt__stride);)
-      }
+    real x = src[i*stride];
+    if (th_isnan(x))
+    {
+      vals[--j] = x;
+      idx[j] = i;
+    }
+    else
+    {
+      vals[m] = x;
+      idx[m++] = i;
+    }
+  }
+  for (i = m, j = n-1; i < j; i++, j--)
+  {
+    long swap = idx[i];
+    idx[i] = idx[j];
+    idx[j] = swap;
+  }
+  return m;
+}
+
+/* sorts (vals, idx) of n elements (no NaN), with scratch for the radix sort:
+   key of 2*n elements and idx2 of n elements */
+static void THTensor_(sortBuffer)(real *vals, long *idx, ptrdiff_t n, int descending,
+                                  THTensor_(SortKey) *key, long *idx2)
+{
+  if (n >= TH_SORT_RADIX)
+  {
+    THTensor_(SortKey) *k = key, *k2 = key + n;
+    long *ix = idx, *ix2 = idx2;
+    ptrdiff_t i;
+    for (i = 0; i < n; i++)
+      k[i] = THTensor_(sortKey)(vals[i], descending);
+    THTensor_(radixSort)(&k, &k2, &ix, &ix2, n);
+    for (i = 0; i < n; i++)
+      vals[i] = THTensor_(sortValue)(k[i], descending);
+    if (ix != idx)
+      memcpy(idx, ix, n*sizeof(long));
+  }
+  else if (descending)
+    THTensor_(quicksortdescend)(vals, idx, n, 1);
   else
+    THTensor_(quicksortascend)(vals, idx, n, 1);
+}
+
+typedef struct THTensor_(SortJob)
+{
+  THTensor *t;
+  THTensor *r;           /* values */
+  THLongTensor *ri;      /* indices */
+  int dimension;
+  ptrdiff_t n;           /* slice size */
+  ptrdiff_t nslices;
+  ptrdiff_t nchunks;     /* ranges of slices, one scratch each */
+  char *scratch;
+  size_t scratchSize;    /* per range */
+  int descending;        /* topk: largest */
+  long k;
+  int sorted;
+  /* one slice by all the threads */
+  real *t_data;
+  ptrdiff_t t_stride;
+  THTensor_(SortKey) *key, *key2;
+  long *idx, *idx2;
+  ptrdiff_t *count;      /* digits of each block */
+  int shift;
+  real *values;          /* topk candidates, k per block */
+  long *indices;
+  ptrdiff_t *found;      /* candidates per block */
+} THTensor_(SortJob);
+
+/* offset of the s-th slice along dimension, for a tensor of sizes size */
+static ptrdiff_t THTensor_(sliceOffset)(const long *size, const long *stride, int nDimension,
+                                        int dimension, ptrdiff_t s)
+{
+  ptrdiff_t offset = 0;
+  int d;
+  for (d = nDimension-1; d >= 0; d--)
   {
-    TH_TENSOR_DIM_APPLY2(real, rt_, long, ri_, dimension,
-                         long i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortascend)(rt__data, ri__data, rt__size, rt__stride);)
+    if (d == dimension)
+      continue;
+    offset += (s % size[d])*stride[d];
+    s /= size[d];
+  }
+  return offset;
+}
+
+static size_t THTensor_(sortScratchSize)(ptrdiff_t n)
+{
+  size_t size = 2*n*sizeof(THTensor_(SortKey)) + 2*n*sizeof(long) + n*sizeof(real);
+  return (size + 63) & ~(size_t)63;
+}
+
+static void THTensor_(sortSlice)(THTensor_(SortJob) *job, ptrdiff_t s, char *scratch)
+{
+  THTensor *t = job->t;
+  int dim = job->dimension;
+  ptrdiff_t n = job->n, m, i;
+  THTensor_(SortKey) *key = (THTensor_(SortKey)*)scratch;
+  long *idx = (long*)(key + 2*n);
+  long *idx2 = idx + n;
+  real *vals = (real*)(idx2 + n);
+  real *src = THTensor_(data)(t) + THTensor_(sliceOffset)(t->size, t->stride, t->nDimension, dim, s);
+  real *r = THTensor_(data)(job->r) + THTensor_(sliceOffset)(t->size, job->r->stride, t->nDimension, dim, s);
+  long *ri = THLongTensor_data(job->ri) + THTensor_(sliceOffset)(t->size, job->ri->stride, t->nDimension, dim, s);
+  ptrdiff_t r_stride = job->r->stride[dim], ri_stride = job->ri->stride[dim];
+
+  if (n >= TH_SORT_RADIX)
+  {
+    /* the keys already order the NaNs */
+    THTensor_(SortKey) *k = key, *k2 = key + n;
+    long *ix = idx, *ix2 = idx2;
+    for (i = 0; i < n; i++)
+    {
+      k[i] = THTensor_(sortKey)(src[i*t->stride[dim]], job->descending);
+      ix[i] = i;
+    }
+    THTensor_(radixSort)(&k, &k2, &ix, &ix2, n);
+    for (i = 0; i < n; i++)
+    {
+      r[i*r_stride] = THTensor_(sortValue)(k[i], job->descending);
+      ri[i*ri_stride] = ix[i];
+    }
+    return;
+  }
+
+  m = THTensor_(sortGather)(vals, idx, src, t->stride[dim], n);
+  THTensor_(sortBuffer)(vals, idx, m, job->descending, key, idx2);
+  for (i = 0; i < n; i++)
+  {
+    /* descending: NaNs first */
+    ptrdiff_t j = !job->descending ? i : (i < n-m ? m+i : i-(n-m));
+    r[i*r_stride] = vals[j];
+    ri[i*ri_stride] = idx[j];
+  }
+}
+
+static void THTensor_(sort_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  ptrdiff_t c, s;
+  for (c = begin; c < end; c++)
+    for (s = c*job->nslices/job->nchunks; s < (c+1)*job->nslices/job->nchunks; s++)
+      THTensor_(sortSlice)(job, s, job->scratch + c*job->scratchSize);
+}
+
+/* parallel radix sort of one slice, by blocks of TH_SORT_BLOCK elements */
+static void THTensor_(radixKeys_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  ptrdiff_t i;
+  for (i = begin*TH_SORT_BLOCK; i < end*TH_SORT_BLOCK && i < job->n; i++)
+  {
+    job->key[i] = THTensor_(sortKey)(job->t_data[i*job->t_stride], job->descending);
+    job->idx[i] = i;
+  }
+}
+
+static void THTensor_(radixCount_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  ptrdiff_t b, i;
+  for (b = begin; b < end; b++)
+  {
+    ptrdiff_t *cnt = job->count + (b << TH_SORT_BITS);
+    ptrdiff_t last = ((b+1)*TH_SORT_BLOCK < job->n ? (b+1)*TH_SORT_BLOCK : job->n);
+    memset(cnt, 0, sizeof(ptrdiff_t) << TH_SORT_BITS);
+    for (i = b*TH_SORT_BLOCK; i < last; i++)
+      cnt[(job->key[i] >> job->shift) & ((1 << TH_SORT_BITS)-1)]++;
+  }
+}
+
+static void THTensor_(radixMove_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  ptrdiff_t b, i;
+  for (b = begin; b < end; b++)
+  {
+    ptrdiff_t *offset = job->count + (b << TH_SORT_BITS);
+    ptrdiff_t last = ((b+1)*TH_SORT_BLOCK < job->n ? (b+1)*TH_SORT_BLOCK : job->n);
+    for (i = b*TH_SORT_BLOCK; i < last; i++)
+    {
+      ptrdiff_t pos = offset[(job->key[i] >> job->shift) & ((1 << TH_SORT_BITS)-1)]++;
+      job->key2[pos] = job->key[i];
+      job->idx2[pos] = job->idx[i];
+    }
+  }
+}
+
+static void THTensor_(radixStore_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  real *r = THTensor_(data)(job->r);
+  long *ri = THLongTensor_data(job->ri);
+  ptrdiff_t r_stride = job->r->stride[job->dimension], ri_stride = job->ri->stride[job->dimension];
+  ptrdiff_t i;
+  for (i = begin*TH_SORT_BLOCK; i < end*TH_SORT_BLOCK && i < job->n; i++)
+  {
+    r[i*r_stride] = THTensor_(sortValue)(job->key[i], job->descending);
+    ri[i*ri_stride] = job->idx[i];
+  }
+}
+
+/* r, ri and t are 1-dimensional views of the slice */
+static void THTensor_(radixSortParallel)(THTensor_(SortJob) *job)
+{
+  ptrdiff_t n = job->n;
+  ptrdiff_t nblocks = (n + TH_SORT_BLOCK - 1)/TH_SORT_BLOCK;
+  ptrdiff_t b, offset, c;
+  int d;
+  THTensor_(SortKey) *swapKey;
+  long *swapIdx;
+
+  job->key = THScratch_alloc(2*n*sizeof(THTensor_(SortKey)));
+  job->key2 = job->key + n;
+  job->idx = THScratch_alloc(2*n*sizeof(long));
+  job->idx2 = job->idx + n;
+  job->count = THScratch_alloc((nblocks << TH_SORT_BITS)*sizeof(ptrdiff_t));
+  THParallelFor(0, nblocks, 1, THTensor_(radixKeys_kernel), job);
+
+  for (job->shift = 0; job->shift < 8*(int)sizeof(real); job->shift += TH_SORT_BITS)
+  {
+    THParallelFor(0, nblocks, 1, THTensor_(radixCount_kernel), job);
+    d = (job->key[0] >> job->shift) & ((1 << TH_SORT_BITS)-1);
+    for (b = 0, c = 0; b < nblocks; b++)
+      c += job->count[(b << TH_SORT_BITS) + d];
+    if (c == n)
+      continue; /* same digit everywhere */
+    /* offset of the digit d of the block b: digits below d, then the same
+       digit in the blocks before b */
+    for (d = 0, offset = 0; d < (1 << TH_SORT_BITS); d++)
+    {
+      for (b = 0; b < nblocks; b++)
+      {
+        c = job->count[(b << TH_SORT_BITS) + d];
+        job->count[(b << TH_SORT_BITS) + d] = offset;
+        offset += c;
       }
+    }
+    THParallelFor(0, nblocks, 1, THTensor_(radixMove_kernel), job);
+    swapKey = job->key; job->key = job->key2; job->key2 = swapKey;
+    swapIdx = job->idx; job->idx = job->idx2; job->idx2 = swapIdx;
+  }
+
+  THParallelFor(0, nblocks, 1, THTensor_(radixStore_kernel), job);
+  THScratch_free(job->count);
+  /* the passes swap the halves of the allocations */
+  THScratch_free(job->idx < job->idx2 ? job->idx : job->idx2);
+  THScratch_free(job->key < job->key2 ? job->key : job->key2);
+}
+
+void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimension, int descendingOrder)
+{
+  THTensor_(SortJob) job;
+  int nThreads = THThreadPool_getNumThreads();
+
+  THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "invalid dimension %d",
+      dimension + TH_INDEX_BASE);
+
+  THTensor_(resizeAs)(rt_, t);
+  THLongTensor_resizeNd(ri_, t->nDimension, t->size, NULL);
+
+  job.t = t;
+  job.r = rt_;
+  job.ri = ri_;
+  job.dimension = dimension;
+  job.descending = descendingOrder;
+  job.n = t->size[dimension];
+  job.nslices = (job.n > 0 ? THTensor_(nElement)(t)/job.n : 0);
+  if (job.nslices == 0)
+    return;
+
+  if (job.nslices < nThreads && job.n >= TH_SORT_BLOCK)
+  {
+    ptrdiff_t s;
+    for (s = 0; s < job.nslices; s++)
+    {
+      job.t_data = THTensor_(data)(t) + THTensor_(sliceOffset)(t->size, t->stride, t->nDimension, dimension, s);
+      job.t_stride = t->stride[dimension];
+      job.r = THTensor_(newWithStorage1d)(rt_->storage,
+        rt_->storageOffset + THTensor_(sliceOffset)(t->size, rt_->stride, t->nDimension, dimension, s),
+        job.n, rt_->stride[dimension]);
+      job.ri = THLongTensor_newWithStorage1d(ri_->storage,
+        ri_->storageOffset + THTensor_(sliceOffset)(t->size, ri_->stride, t->nDimension, dimension, s),
+        job.n, ri_->stride[dimension]);
+      job.dimension = 0;
+      THTensor_(radixSortParallel)(&job);
+      THTensor_(free)(job.r);
+      THLongTensor_free(job.ri);
+    }
+    return;
+  }
+
+  job.nchunks = 1;
+  if (job.n*job.nslices >= THParallelGrain(1))
+    job.nchunks = (job.nslices < nThreads ? job.nslices : nThreads);
+  job.scratchSize = THTensor_(sortScratchSize)(job.n);
+  job.scratch = THScratch_alloc(job.nchunks*job.scratchSize);
+  THParallelFor(0, job.nchunks, 1, THTensor_(sort_kernel), &job);
+  THScratch_free(job.scratch);
 }
 
 /* Implementation of the Quickselect algorithm, based on Nicolas Devillard's
@@ -2304,30 +3244,17 @@ static void THTensor_(quickselect)(real *arr, long *idx, long k, long elements,
 
 void THTensor_(mode)(THTensor *values_, THLongTensor *indices_, THTensor *t, int dimension, int keepdim)
 {
-  THLongStorage *dim;
-  THTensor *temp_;
-  THLongTensor *tempi_;
   real *temp__data;
   long *tempi__data;
   long t_size_dim;
 
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 3, "dimension out of range");
 
-  dim = THTensor_(newSizeOf)(t);
-  THLongStorage_set(dim, dimension, 1);
-  THTensor_(resize)(values_, dim, NULL);
-  THLongTensor_resize(indices_, dim, NULL);
-  THLongStorage_free(dim);
+  THTensor_(resizeAlong)(values_, indices_, t, dimension, 1);
 
   t_size_dim = THTensor_(size)(t, dimension);
-
-  temp_ = THTensor_(new)();
-  THTensor_(resize1d)(temp_, t_size_dim);
-  temp__data = THTensor_(data)(temp_);
-
-  tempi_ = THLongTensor_new();
-  THLongTensor_resize1d(tempi_, t_size_dim);
-  tempi__data = THLongTensor_data(tempi_);
+  temp__data = THScratch_alloc(t_size_dim*sizeof(real));
+  tempi__data = THScratch_alloc(t_size_dim*sizeof(long));
 
   TH_TENSOR_DIM_APPLY3(real, t, real, values_, long, indices_, dimension,
                        long i;
@@ -2358,8 +3285,8 @@ void THTensor_(mode)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
                        *values__data = mode;
                        *indices__data = modei;);
 
-  THTensor_(free)(temp_);
-  THLongTensor_free(tempi_);
+  THScratch_free(tempi__data);
+  THScratch_free(temp__data);
   if (!keepdim) {
     THTensor_(squeeze1d)(values_, values_, dimension);
     THLongTensor_squeeze1d(indices_, indices_, dimension);
@@ -2368,9 +3295,6 @@ void THTensor_(mode)(THTensor *values_, THLongTensor *indices_, THTensor *t, int
 
 void THTensor_(kthvalue)(THTensor *values_, THLongTensor *indices_, THTensor *t, long k, int dimension, int keepdim)
 {
-  THLongStorage *dim;
-  THTensor *temp_;
-  THLongTensor *tempi_;
   real *temp__data;
   long *tempi__data;
   long t_size_dim;
@@ -2378,21 +3302,11 @@ void THTensor_(kthvalue)(THTensor *values_, THLongTensor *indices_, THTensor *t,
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 3, "dimension out of range");
   THArgCheck(k > 0 && k <= t->size[dimension], 2, "selected index out of range");
 
-  dim = THTensor_(newSizeOf)(t);
-  THLongStorage_set(dim, dimension, 1);
-  THTensor_(resize)(values_, dim, NULL);
-  THLongTensor_resize(indices_, dim, NULL);
-  THLongStorage_free(dim);
+  THTensor_(resizeAlong)(values_, indices_, t, dimension, 1);
 
   t_size_dim = THTensor_(size)(t, dimension);
-
-  temp_ = THTensor_(new)();
-  THTensor_(resize1d)(temp_, t_size_dim);
-  temp__data = THTensor_(data)(temp_);
-
-  tempi_ = THLongTensor_new();
-  THLongTensor_resize1d(tempi_, t_size_dim);
-  tempi__data = THLongTensor_data(tempi_);
+  temp__data = THScratch_alloc(t_size_dim*sizeof(real));
+  tempi__data = THScratch_alloc(t_size_dim*sizeof(long));
 
   TH_TENSOR_DIM_APPLY3(real, t, real, values_, long, indices_, dimension,
                        long i;
@@ -2404,8 +3318,8 @@ void THTensor_(kthvalue)(THTensor *values_, THLongTensor *indices_, THTensor *t,
                        *values__data = temp__data[k-1];
                        *indices__data = tempi__data[k-1];);
 
-  THTensor_(free)(temp_);
-  THLongTensor_free(tempi_);
+  THScratch_free(tempi__data);
+  THScratch_free(temp__data);
   if (!keepdim) {
     THTensor_(squeeze1d)(values_, values_, dimension);
     THLongTensor_squeeze1d(indices_, indices_, dimension);
@@ -2424,69 +3338,268 @@ void THTensor_(median)(THTensor *values_, THLongTensor *indices_, THTensor *t, i
   THTensor_(kthvalue)(values_, indices_, t, k+1, dimension, keepdim);
 }
 
+/* a is a better top element than b: larger (largest != 0) or smaller,
+   NaNs being larger than everything */
+#define TOPK_BETTER(a, b) (largest ? ((a) > (b) || (th_isnan(a) && !th_isnan(b))) \
+                                   : ((a) < (b) || (th_isnan(b) && !th_isnan(a))))
+
+/* heap of the m best elements found, the worst one at the root */
+static void THTensor_(topkSiftDown)(real *hv, long *hi, ptrdiff_t i, ptrdiff_t m, int largest)
+{
+  real v = hv[i];
+  long ix = hi[i];
+  for (;;)
+  {
+    ptrdiff_t c = 2*i+1;
+    if (c >= m)
+      break;
+    if (c+1 < m && TOPK_BETTER(hv[c], hv[c+1]))
+      c++;
+    if (!TOPK_BETTER(v, hv[c]))
+      break;
+    hv[i] = hv[c];
+    hi[i] = hi[c];
+    i = c;
+  }
+  hv[i] = v;
+  hi[i] = ix;
+}
+
+/* keeps in (hv, hi) the k best of the n elements of stride stride of x,
+   whose indices are xi (or base + their positions, without xi); returns
+   the number of elements kept */
+static ptrdiff_t THTensor_(topkHeap)(real *hv, long *hi, const real *x, ptrdiff_t stride,
+                                     const long *xi, long base, ptrdiff_t n, long k, int largest)
+{
+  ptrdiff_t m = (n < k ? n : k), i;
+  for (i = 0; i < m; i++)
+  {
+    hv[i] = x[i*stride];
+    hi[i] = (xi ? xi[i] : base + i);
+  }
+  for (i = m/2-1; i >= 0; i--)
+    THTensor_(topkSiftDown)(hv, hi, i, m, largest);
+  for (i = m; i < n; i++)
+  {
+    real v = x[i*stride];
+    if (TOPK_BETTER(v, hv[0]))
+    {
+      hv[0] = v;
+      hi[0] = (xi ? xi[i] : base + i);
+      THTensor_(topkSiftDown)(hv, hi, 0, m, largest);
+    }
+  }
+  return m;
+}
+
+/* heap to an array, the best element first (the worst ones go last) */
+static void THTensor_(topkHeapSort)(real *hv, long *hi, ptrdiff_t m, int largest)
+{
+  ptrdiff_t i;
+  for (i = m-1; i > 0; i--)
+  {
+    real v = hv[0];
+    long ix = hi[0];
+    hv[0] = hv[i];
+    hi[0] = hi[i];
+    hv[i] = v;
+    hi[i] = ix;
+    THTensor_(topkSiftDown)(hv, hi, 0, i, largest);
+  }
+}
+
+#undef TOPK_BETTER
+
+static size_t THTensor_(topkScratchSize)(ptrdiff_t n, long k)
+{
+  size_t size = k*(sizeof(long) + sizeof(real));
+  if (k*TH_TOPK_HEAP > n)
+    size = THTensor_(sortScratchSize)(n);
+  return (size + 63) & ~(size_t)63;
+}
+
+static void THTensor_(topkSlice)(THTensor_(SortJob) *job, ptrdiff_t s, char *scratch)
+{
+  THTensor *t = job->t;
+  int dim = job->dimension;
+  int largest = job->descending;
+  ptrdiff_t n = job->n, i;
+  long k = job->k;
+  real *src = THTensor_(data)(t) + THTensor_(sliceOffset)(t->size, t->stride, t->nDimension, dim, s);
+  real *r = THTensor_(data)(job->r) + THTensor_(sliceOffset)(t->size, job->r->stride, t->nDimension, dim, s);
+  long *ri = THLongTensor_data(job->ri) + THTensor_(sliceOffset)(t->size, job->ri->stride, t->nDimension, dim, s);
+  ptrdiff_t r_stride = job->r->stride[dim], ri_stride = job->ri->stride[dim];
+
+  if (k*TH_TOPK_HEAP <= n)
+  {
+    long *hi = (long*)scratch;
+    real *hv = (real*)(hi + k);
+    THTensor_(topkHeap)(hv, hi, src, t->stride[dim], NULL, 0, n, k, largest);
+    if (job->sorted)
+      THTensor_(topkHeapSort)(hv, hi, k, largest);
+    for (i = 0; i < k; i++)
+    {
+      r[i*r_stride] = hv[i];
+      ri[i*ri_stride] = hi[i];
+    }
+  }
+  else
+  {
+    THTensor_(SortKey) *key = (THTensor_(SortKey)*)scratch;
+    long *idx = (long*)(key + 2*n);
+    long *idx2 = idx + n;
+    real *vals = (real*)(idx2 + n);
+    ptrdiff_t m = THTensor_(sortGather)(vals, idx, src, t->stride[dim], n);
+    ptrdiff_t first = 0; /* k elements from vals + first, NaNs (at m) first if largest */
+    if (largest)
+    {
+      /* k largest elements, descending order (optional: see sorted) */
+      ptrdiff_t nnan = n-m;
+      ptrdiff_t kk = k - nnan; /* taken from the numbers */
+      if (kk > 0)
+      {
+        ptrdiff_t K = m - kk;
+        if (K > 0)
+          THTensor_(quickselect)(vals, idx, K - 1, m, 1);
+        if (job->sorted)
+          THTensor_(sortBuffer)(vals + K, idx + K, kk, 1, key, idx2);
+        first = K;
+      }
+      for (i = 0; i < k; i++)
+      {
+        ptrdiff_t j = (i < nnan ? m + i : first + i - nnan);
+        r[i*r_stride] = vals[j];
+        ri[i*ri_stride] = idx[j];
+      }
+    }
+    else
+    {
+      /* k smallest elements, ascending order (optional: see sorted) */
+      ptrdiff_t kk = (k < m ? k : m);
+      if (k < m)
+        THTensor_(quickselect)(vals, idx, k - 1, m, 1);
+      if (job->sorted)
+        THTensor_(sortBuffer)(vals, idx, kk, 0, key, idx2);
+      for (i = 0; i < k; i++)
+      {
+        r[i*r_stride] = vals[i];
+        ri[i*ri_stride] = idx[i];
+      }
+    }
+  }
+}
+
+static void THTensor_(topk_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  ptrdiff_t c, s;
+  for (c = begin; c < end; c++)
+    for (s = c*job->nslices/job->nchunks; s < (c+1)*job->nslices/job->nchunks; s++)
+      THTensor_(topkSlice)(job, s, job->scratch + c*job->scratchSize);
+}
+
+/* candidates of the blocks of a slice */
+static void THTensor_(topkBlocks_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end)
+{
+  THTensor_(SortJob) *job = data;
+  ptrdiff_t b;
+  for (b = begin; b < end; b++)
+  {
+    ptrdiff_t first = b*TH_SORT_BLOCK;
+    ptrdiff_t n = (job->n - first < TH_SORT_BLOCK ? job->n - first : TH_SORT_BLOCK);
+    job->found[b] = THTensor_(topkHeap)(job->values + b*job->k, job->indices + b*job->k,
+                                        job->t_data + first*job->t_stride, job->t_stride,
+                                        NULL, first, n, job->k, job->descending);
+  }
+}
+
+/* r and ri are 1-dimensional views of the slice */
+static void THTensor_(topkParallel)(THTensor_(SortJob) *job)
+{
+  ptrdiff_t nblocks = (job->n + TH_SORT_BLOCK - 1)/TH_SORT_BLOCK;
+  ptrdiff_t b, m = 0, i;
+  long k = job->k;
+  long *hi = THScratch_alloc(k*sizeof(long));
+  real *hv = THScratch_alloc(k*sizeof(real));
+  real *r = THTensor_(data)(job->r);
+  long *ri = THLongTensor_data(job->ri);
+
+  job->values = THScratch_alloc(nblocks*k*sizeof(real));
+  job->indices = THScratch_alloc(nblocks*k*sizeof(long));
+  job->found = THScratch_alloc(nblocks*sizeof(ptrdiff_t));
+  THParallelFor(0, nblocks, 1, THTensor_(topkBlocks_kernel), job);
+
+  for (b = 0; b < nblocks; b++)
+  {
+    memmove(job->values + m, job->values + b*k, job->found[b]*sizeof(real));
+    memmove(job->indices + m, job->indices + b*k, job->found[b]*sizeof(long));
+    m += job->found[b];
+  }
+  THTensor_(topkHeap)(hv, hi, job->values, 1, job->indices, 0, m, k, job->descending);
+  if (job->sorted)
+    THTensor_(topkHeapSort)(hv, hi, k, job->descending);
+  for (i = 0; i < k; i++)
+  {
+    r[i*job->r->stride[0]] = hv[i];
+    ri[i*job->ri->stride[0]] = hi[i];
+  }
+
+  THScratch_free(job->found);
+  THScratch_free(job->indices);
+  THScratch_free(job->values);
+  THScratch_free(hv);
+  THScratch_free(hi);
+}
+
 void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, long k, int dim, int dir, int sorted)
 {
+  THTensor_(SortJob) job;
+  int nThreads = THThreadPool_getNumThreads();
   int numDims = THTensor_(nDimension)(t);
   THArgCheck(dim >= 0 && dim < numDims, 3, "dim not in range");
 
   long sliceSize = THTensor_(size)(t, dim);
   THArgCheck(k > 0 && k <= sliceSize, 2, "k not in range for dimension");
 
-  THTensor *tmpResults = THTensor_(new)();
-  THTensor_(resize1d)(tmpResults, sliceSize);
-  real *tmp__data = THTensor_(data)(tmpResults);
+  THTensor_(resizeAlong)(rt_, ri_, t, dim, k);
 
-  THLongTensor *tmpIndices = THLongTensor_new();
-  THLongTensor_resize1d(tmpIndices, sliceSize);
-  long *tmpi__data = THLongTensor_data(tmpIndices);
+  job.t = t;
+  job.r = rt_;
+  job.ri = ri_;
+  job.dimension = dim;
+  job.descending = dir;
+  job.k = k;
+  job.sorted = sorted;
+  job.n = sliceSize;
+  job.nslices = THTensor_(nElement)(t)/sliceSize;
 
-  THLongStorage *topKSize = THTensor_(newSizeOf)(t);
-  THLongStorage_set(topKSize, dim, k);
-  THTensor_(resize)(rt_, topKSize, NULL);
-  THLongTensor_resize(ri_, topKSize, NULL);
-  THLongStorage_free(topKSize);
-
-  if (dir) {
-    /* k largest elements, descending order (optional: see sorted) */
-    long K = sliceSize - k;
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, long, ri_, dim,
-                         long i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         if (K > 0)
-                           THTensor_(quickselect)(tmp__data, tmpi__data, K - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortdescend)(tmp__data + K, tmpi__data + K, k, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i + K];
-                           ri__data[i*ri__stride] = tmpi__data[i + K];
-                         })
-  }
-  else {
-    /* k smallest elements, ascending order (optional: see sorted) */
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, long, ri_, dim,
-                         long i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         THTensor_(quickselect)(tmp__data, tmpi__data, k - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortascend)(tmp__data, tmpi__data, k - 1, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i];
-                           ri__data[i*ri__stride] = tmpi__data[i];
-                         })
+  if (job.nslices < nThreads && job.n >= TH_SORT_BLOCK && k*TH_TOPK_HEAP <= TH_SORT_BLOCK)
+  {
+    ptrdiff_t s;
+    for (s = 0; s < job.nslices; s++)
+    {
+      job.t_data = THTensor_(data)(t) + THTensor_(sliceOffset)(t->size, t->stride, numDims, dim, s);
+      job.t_stride = t->stride[dim];
+      job.r = THTensor_(newWithStorage1d)(rt_->storage,
+        rt_->storageOffset + THTensor_(sliceOffset)(t->size, rt_->stride, numDims, dim, s),
+        k, rt_->stride[dim]);
+      job.ri = THLongTensor_newWithStorage1d(ri_->storage,
+        ri_->storageOffset + THTensor_(sliceOffset)(t->size, ri_->stride, numDims, dim, s),
+        k, ri_->stride[dim]);
+      THTensor_(topkParallel)(&job);
+      THTensor_(free)(job.r);
+      THLongTensor_free(job.ri);
+    }
+    return;
   }
 
-  THTensor_(free)(tmpResults);
-  THLongTensor_free(tmpIndices);
+  job.nchunks = 1;
+  if (job.n*job.nslices >= THParallelGrain(1))
+    job.nchunks = (job.nslices < nThreads ? job.nslices : nThreads);
+  job.scratchSize = THTensor_(topkScratchSize)(job.n, k);
+  job.scratch = THScratch_alloc(job.nchunks*job.scratchSize);
+  THParallelFor(0, job.nchunks, 1, THTensor_(topk_kernel), &job);
+  THScratch_free(job.scratch);
 }
 
 void THTensor_(tril)(THTensor *r_, THTensor *t, long k)
@@ -2741,6 +3854,25 @@ TENSOR_IMPLEMENT_LOGICAL(ne,!=)
     TH_TENSOR_APPLY2(real, t, real, r_, *r__data = CFUNC(*t_data);); \
   }                                                           \
 
+/* contiguous tensors go through THVector_(NAME), in parallel */
+#define LAB_IMPLEMENT_VECTORIZED_FUNCTION(NAME, CFUNC, COST)   \
+  static void THTensor_(NAME##_kernel)(void *data, ptrdiff_t begin, ptrdiff_t end) \
+  {                                                           \
+    THTensor_(ParallelJob) *job = data;                       \
+    THVector_(NAME)(job->r + begin, job->t + begin, end - begin); \
+  }                                                           \
+                                                              \
+  void THTensor_(NAME)(THTensor *r_, THTensor *t)             \
+  {                                                           \
+    THTensor_(resizeAs)(r_, t);                               \
+    if (THTensor_(isContiguous)(r_) && THTensor_(isContiguous)(t) && THTensor_(nElement)(r_) == THTensor_(nElement)(t)) { \
+      THTensor_(parallelApply)(THTensor_(NAME##_kernel), COST, THTensor_(nElement)(r_), \
+                               THTensor_(data)(r_), THTensor_(data)(t), NULL, 0, 0); \
+    } else {                                                  \
+      TH_TENSOR_APPLY2(real, t, real, r_, *r__data = CFUNC(*t_data);); \
+    }                                                         \
+  }                                                           \
+
 #define LAB_IMPLEMENT_BASIC_FUNCTION_VALUE(NAME, CFUNC)                 \
   void THTensor_(NAME)(THTensor *r_, THTensor *t, real value)              \
   {                                                                     \
@@ -2781,11 +3913,11 @@ TENSOR_IMPLEMENT_LOGICAL_SUM(logicalany, ||, 0)
 #define TH_MATH_NAME(fn) fn
 #endif
 
-LAB_IMPLEMENT_BASIC_FUNCTION(log,TH_MATH_NAME(log))
+LAB_IMPLEMENT_VECTORIZED_FUNCTION(log,TH_MATH_NAME(log),16)
 LAB_IMPLEMENT_BASIC_FUNCTION(lgamma,TH_MATH_NAME(lgamma))
 LAB_IMPLEMENT_BASIC_FUNCTION(log1p,TH_MATH_NAME(log1p))
-LAB_IMPLEMENT_BASIC_FUNCTION(sigmoid,TH_MATH_NAME(TH_sigmoid))
-LAB_IMPLEMENT_BASIC_FUNCTION(exp,TH_MATH_NAME(exp))
+LAB_IMPLEMENT_VECTORIZED_FUNCTION(sigmoid,TH_MATH_NAME(TH_sigmoid),16)
+LAB_IMPLEMENT_VECTORIZED_FUNCTION(exp,TH_MATH_NAME(exp),16)
 LAB_IMPLEMENT_BASIC_FUNCTION(cos,TH_MATH_NAME(cos))
 LAB_IMPLEMENT_BASIC_FUNCTION(acos,TH_MATH_NAME(acos))
 LAB_IMPLEMENT_BASIC_FUNCTION(cosh,TH_MATH_NAME(cosh))
@@ -2794,10 +3926,10 @@ LAB_IMPLEMENT_BASIC_FUNCTION(asin,TH_MATH_NAME(asin))
 LAB_IMPLEMENT_BASIC_FUNCTION(sinh,TH_MATH_NAME(sinh))
 LAB_IMPLEMENT_BASIC_FUNCTION(tan,TH_MATH_NAME(tan))
 LAB_IMPLEMENT_BASIC_FUNCTION(atan,TH_MATH_NAME(atan))
-LAB_IMPLEMENT_BASIC_FUNCTION(tanh,TH_MATH_NAME(tanh))
+LAB_IMPLEMENT_VECTORIZED_FUNCTION(tanh,TH_MATH_NAME(tanh),16)
 LAB_IMPLEMENT_BASIC_FUNCTION_VALUE(pow,TH_MATH_NAME(pow))
 LAB_IMPLEMENT_BASIC_FUNCTION(sqrt,TH_MATH_NAME(sqrt))
-LAB_IMPLEMENT_BASIC_FUNCTION(rsqrt,TH_MATH_NAME(TH_rsqrt))
+LAB_IMPLEMENT_VECTORIZED_FUNCTION(rsqrt,TH_MATH_NAME(TH_rsqrt),4)
 LAB_IMPLEMENT_BASIC_FUNCTION(ceil,TH_MATH_NAME(ceil))
 LAB_IMPLEMENT_BASIC_FUNCTION(floor,TH_MATH_NAME(floor))
 LAB_IMPLEMENT_BASIC_FUNCTION(round,TH_MATH_NAME(round))
@@ -2923,6 +4055,8 @@ void THTensor_(var)(THTensor *r_, THTensor *t, int dimension, int flag, int keep
 void THTensor_(norm)(THTensor *r_, THTensor *t, real value, int dimension, int keepdim)
 {
   THLongStorage *dim;
+  int op = (value == 0 ? TH_REDUCE_NONZERO : value == 1 ? TH_REDUCE_ASUM :
+            value == 2 ? TH_REDUCE_SUMSQ : TH_REDUCE_POW);
 
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 3, "invalid dimension %d",
       dimension + TH_INDEX_BASE);
@@ -2932,7 +4066,13 @@ void THTensor_(norm)(THTensor *r_, THTensor *t, real value, int dimension, int k
   THTensor_(resize)(r_, dim, NULL);
   THLongStorage_free(dim);
 
-  if(value == 0) {
+  if(THTensor_(reduceDim)(r_, NULL, t, dimension, op, (op == TH_REDUCE_POW ? value : 0),
+                          (op == TH_REDUCE_POW ? 16 : 1))) {
+    if(op == TH_REDUCE_SUMSQ)
+      THTensor_(sqrt)(r_, r_);
+    else if(op == TH_REDUCE_POW)
+      THTensor_(pow)(r_, r_, 1.0/value);
+  } else if(value == 0) {
     TH_TENSOR_DIM_APPLY2(real, t, real, r_, dimension,
                          accreal sum = 0;
                          long i;
@@ -2958,6 +4098,16 @@ void THTensor_(norm)(THTensor *r_, THTensor *t, real value, int dimension, int k
 accreal THTensor_(normall)(THTensor *tensor, real value)
 {
   accreal sum = 0;
+  if(THTensor_(nElement)(tensor) > 0 && THTensor_(isContiguous)(tensor)) {
+    if(value == 0)
+      return THTensor_(reduceAll)(tensor, TH_REDUCE_NONZERO, 0, 1);
+    else if(value == 1)
+      return THTensor_(reduceAll)(tensor, TH_REDUCE_ASUM, 0, 1);
+    else if(value == 2)
+      return sqrt(THTensor_(reduceAll)(tensor, TH_REDUCE_SUMSQ, 0, 1));
+    else
+      return TH_MATH_NAME(pow)(THTensor_(reduceAll)(tensor, TH_REDUCE_POW, value, 16), 1.0/value);
+  }
   if(value == 0) {
     TH_TENSOR_APPLY(real, tensor, sum += *tensor_data != 0.0;);
     return sum;
@@ -3042,6 +4192,8 @@ accreal THTensor_(varall)(THTensor *tensor)
 {
   accreal mean = THTensor_(meanall)(tensor);
   accreal sum = 0;
+  if(THTensor_(isContiguous)(tensor))
+    return THTensor_(reduceAll)(tensor, TH_REDUCE_SUMSQ, mean, 1)/(THTensor_(nElement)(tensor)-1);
   TH_TENSOR_APPLY(real, tensor, sum += (*tensor_data - mean)*(*tensor_data - mean););
   sum /= (THTensor_(nElement)(tensor)-1);
   return sum;
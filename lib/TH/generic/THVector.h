@@ -10,6 +10,39 @@ TH_API void THVector_(muls)(real *y, const real *x, const real c, const ptrdiff_
 TH_API void THVector_(cdiv)(real *z, const real *x, const real *y, const ptrdiff_t n);
 TH_API void THVector_(divs)(real *y, const real *x, const real c, const ptrdiff_t n);
 TH_API void THVector_(copy)(real *y, const real *x, const ptrdiff_t n);
+/* y = x with the bytes of each element in reverse order (byte order
+ * conversion); y may be x */
+TH_API void THVector_(swapBytes)(real *y, const real *x, const ptrdiff_t n);
+/* c[MR x NR] += alpha * a * b, where a holds k packed columns of MR reals
+ * and b k packed rows of NR reals (MR/NR: see THVector_GEMM_MR/NR);
+ * c is column-major, with leading dimension ldc */
+TH_API void THVector_(gemmTile)(real *c, const ptrdiff_t ldc, const real *a, const real *b, const real alpha, const ptrdiff_t k);
+
+/* reductions of x[0..n-1] (n > 0 for max and min). The SIMD versions use
+ * several accumulators: float and double sums may differ from a sequential
+ * loop in the last bits. max and min return nan if x contains a nan. */
+TH_API accreal THVector_(sum)(const real *x, const ptrdiff_t n);
+TH_API real THVector_(max)(const real *x, const ptrdiff_t n);
+TH_API real THVector_(min)(const real *x, const ptrdiff_t n);
+
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+/* y = f(x), element-wise. The SIMD versions are polynomial approximations,
+ * within these bounds of the exact result (in units in the last place,
+ * subnormal results included), checked by test-vectormath:
+ *   exp 1.5, log 1, tanh 2, sigmoid 3, rsqrt 1.5 (1/sqrt: two roundings)
+ * Special values (nan, +-inf, 0, negative input of log/rsqrt) follow libm.
+ * Results do not depend on the position of an element in the array. */
+TH_API void THVector_(exp)(real *y, const real *x, const ptrdiff_t n);
+TH_API void THVector_(log)(real *y, const real *x, const ptrdiff_t n);
+TH_API void THVector_(tanh)(real *y, const real *x, const ptrdiff_t n);
+TH_API void THVector_(sigmoid)(real *y, const real *x, const ptrdiff_t n);
+TH_API void THVector_(rsqrt)(real *y, const real *x, const ptrdiff_t n);
+
+/* sum of x[i] with Kahan compensation, sum of |x[i]|, sum of (x[i]-c)^2 */
+TH_API accreal THVector_(sumCompensated)(const real *x, const ptrdiff_t n);
+TH_API accreal THVector_(asum)(const real *x, const ptrdiff_t n);
+TH_API accreal THVector_(sumsq)(const real *x, const accreal c, const ptrdiff_t n);
+#endif
 
 /* Initialize the dispatch pointers */
 TH_API void THVector_(vectorDispatchInit)(void);
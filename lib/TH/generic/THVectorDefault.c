@@ -17,6 +17,19 @@ void THVector_(copy_DEFAULT)(real *x, const real *y, const ptrdiff_t n) {
     x[i] = y[i];
 }
 
+void THVector_(swapBytes_DEFAULT)(real *y, const real *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  size_t b;
+
+  for(i = 0; i < n; i++)
+  {
+    unsigned char v[sizeof(real)];
+    memcpy(v, x+i, sizeof(real));
+    for(b = 0; b < sizeof(real); b++)
+      ((unsigned char*)(y+i))[b] = v[sizeof(real)-1-b];
+  }
+}
+
 void THVector_(fill_DEFAULT)(real *x, const real c, const ptrdiff_t n) {
   ptrdiff_t i = 0;
 
@@ -128,4 +141,190 @@ void THVector_(divs_DEFAULT)(real *y, const real *x, const real c, const ptrdiff
     y[i] = x[i] / c;
 }
 
+void THVector_(gemmTile_DEFAULT)(real *c, const ptrdiff_t ldc, const real *a, const real *b, const real alpha, const ptrdiff_t k)
+{
+  real acc[THVector_GEMM_MR*THVector_GEMM_NR] = {0};
+  ptrdiff_t i, j, l;
+
+  for(l = 0; l < k; l++)
+  {
+    for(j = 0; j < THVector_GEMM_NR; j++)
+    {
+      real bj = b[j];
+      for(i = 0; i < THVector_GEMM_MR; i++)
+        acc[j*THVector_GEMM_MR+i] += a[i]*bj;
+    }
+    a += THVector_GEMM_MR;
+    b += THVector_GEMM_NR;
+  }
+
+  for(j = 0; j < THVector_GEMM_NR; j++)
+    for(i = 0; i < THVector_GEMM_MR; i++)
+      c[j*ldc+i] += alpha*acc[j*THVector_GEMM_MR+i];
+}
+
+accreal THVector_(sum_DEFAULT)(const real *x, const ptrdiff_t n)
+{
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+  accreal s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  ptrdiff_t i = 0;
+
+  for(; i < n-3; i+=4)
+  {
+    s0 += x[i];
+    s1 += x[i+1];
+    s2 += x[i+2];
+    s3 += x[i+3];
+  }
+
+  for(; i < n; i++)
+    s0 += x[i];
+  return (s0+s1)+(s2+s3);
+#else
+  /* integer additions are associative: the compiler vectorizes this */
+  accreal s = 0;
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+    s += x[i];
+  return s;
+#endif
+}
+
+/* !(v <= m) rather than v > m: a nan is taken, and stops the loop */
+real THVector_(max_DEFAULT)(const real *x, const ptrdiff_t n)
+{
+  real m = x[0];
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+  {
+    real v = x[i];
+    if(!(v <= m))
+    {
+      m = v;
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+      if(isnan(v))
+        break;
+#endif
+    }
+  }
+  return m;
+}
+
+real THVector_(min_DEFAULT)(const real *x, const ptrdiff_t n)
+{
+  real m = x[0];
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+  {
+    real v = x[i];
+    if(!(v >= m))
+    {
+      m = v;
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+      if(isnan(v))
+        break;
+#endif
+    }
+  }
+  return m;
+}
+
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+
+accreal THVector_(sumCompensated_DEFAULT)(const real *x, const ptrdiff_t n)
+{
+  accreal s = 0, c = 0;
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+  {
+    accreal y = x[i] - c;
+    accreal t = s + y;
+    c = (t - s) - y;
+    s = t;
+  }
+  return s;
+}
+
+accreal THVector_(asum_DEFAULT)(const real *x, const ptrdiff_t n)
+{
+  accreal s0 = 0, s1 = 0;
+  ptrdiff_t i = 0;
+
+  for(; i < n-1; i+=2)
+  {
+    s0 += fabs(x[i]);
+    s1 += fabs(x[i+1]);
+  }
+
+  for(; i < n; i++)
+    s0 += fabs(x[i]);
+  return s0+s1;
+}
+
+accreal THVector_(sumsq_DEFAULT)(const real *x, const accreal c, const ptrdiff_t n)
+{
+  accreal s0 = 0, s1 = 0;
+  ptrdiff_t i = 0;
+
+  for(; i < n-1; i+=2)
+  {
+    accreal d0 = (accreal)x[i] - c;
+    accreal d1 = (accreal)x[i+1] - c;
+    s0 += d0*d0;
+    s1 += d1*d1;
+  }
+
+  for(; i < n; i++)
+  {
+    accreal d = (accreal)x[i] - c;
+    s0 += d*d;
+  }
+  return s0+s1;
+}
+
+#if defined(TH_REAL_IS_FLOAT)
+#define TH_MATH_NAME(fn) fn##f
+#else
+#define TH_MATH_NAME(fn) fn
+#endif
+
+void THVector_(exp_DEFAULT)(real *y, const real *x, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+    y[i] = TH_MATH_NAME(exp)(x[i]);
+}
+
+void THVector_(log_DEFAULT)(real *y, const real *x, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+    y[i] = TH_MATH_NAME(log)(x[i]);
+}
+
+void THVector_(tanh_DEFAULT)(real *y, const real *x, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+    y[i] = TH_MATH_NAME(tanh)(x[i]);
+}
+
+void THVector_(sigmoid_DEFAULT)(real *y, const real *x, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+    y[i] = TH_MATH_NAME(TH_sigmoid)(x[i]);
+}
+
+void THVector_(rsqrt_DEFAULT)(real *y, const real *x, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for(i = 0; i < n; i++)
+    y[i] = TH_MATH_NAME(TH_rsqrt)(x[i]);
+}
+
+#undef TH_MATH_NAME
+
+#endif
+
 #endif
@@ -2,9 +2,9 @@
 #define TH_GENERIC_FILE "generic/THVectorDispatch.c"
 #else
 
-/* For now there are only SIMD implementations for FLOAT and DOUBLE.
- * Hopefully in the future this can be made totally generic (e.g, there are SIMD implementations
- * for a lot of functions */
+/* SIMD implementations exist for FLOAT and DOUBLE, and for the integer types
+ * (SSE2 and AVX2, wrapping around like the scalar code) for fill, cadd, adds,
+ * cmul, muls and copy */
 /* Each function with multiple implementations has:
  * 1. A DISPATCHPTR which will be initialized to point to the best available implementation for the host
  * 2. A DISPATCHTABLE which holds pointers to each implementation of a function, and a value indicating
@@ -26,6 +26,12 @@ static FunctionDescription THVector_(fill_DISPATCHTABLE)[] = {
     #endif
   #endif
 
+  #if defined(USE_AVX2)
+    #if !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(fill_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
   #if defined(USE_AVX)
     #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
       FUNCTION_IMPL(THVector_(fill_AVX), SIMDExtension_AVX),
@@ -34,9 +40,7 @@ static FunctionDescription THVector_(fill_DISPATCHTABLE)[] = {
 
   #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
           || defined(USE_SSE4_1) || defined(USE_SSE4_2)
-    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
-      FUNCTION_IMPL(THVector_(fill_SSE), SIMDExtension_SSE),
-    #endif
+    FUNCTION_IMPL(THVector_(fill_SSE), SIMDExtension_SSE),
   #endif
   FUNCTION_IMPL(THVector_(fill_DEFAULT), SIMDExtension_DEFAULT)
 };
@@ -53,9 +57,7 @@ static FunctionDescription THVector_(cadd_DISPATCHTABLE)[] = {
   #endif
 
   #if defined(USE_AVX2)
-    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
-      FUNCTION_IMPL(THVector_(cadd_AVX2), SIMDExtension_AVX2),
-    #endif
+    FUNCTION_IMPL(THVector_(cadd_AVX2), SIMDExtension_AVX2),
   #endif
 
   #if defined(USE_AVX)
@@ -66,9 +68,7 @@ static FunctionDescription THVector_(cadd_DISPATCHTABLE)[] = {
 
   #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
           || defined(USE_SSE4_1) || defined(USE_SSE4_2)
-    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
-      FUNCTION_IMPL(THVector_(cadd_SSE), SIMDExtension_SSE),
-    #endif
+    FUNCTION_IMPL(THVector_(cadd_SSE), SIMDExtension_SSE),
   #endif
 
   FUNCTION_IMPL(THVector_(cadd_DEFAULT), SIMDExtension_DEFAULT)
@@ -91,6 +91,12 @@ static FunctionDescription THVector_(adds_DISPATCHTABLE)[] = {
     #endif
   #endif
 
+  #if defined(USE_AVX2)
+    #if !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(adds_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
   #if defined(USE_AVX)
     #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
       FUNCTION_IMPL(THVector_(adds_AVX), SIMDExtension_AVX),
@@ -99,9 +105,7 @@ static FunctionDescription THVector_(adds_DISPATCHTABLE)[] = {
 
   #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
           || defined(USE_SSE4_1) || defined(USE_SSE4_2)
-    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
-      FUNCTION_IMPL(THVector_(adds_SSE), SIMDExtension_SSE),
-    #endif
+    FUNCTION_IMPL(THVector_(adds_SSE), SIMDExtension_SSE),
   #endif
 
   FUNCTION_IMPL(THVector_(adds_DEFAULT), SIMDExtension_DEFAULT)
@@ -119,6 +123,12 @@ static FunctionDescription THVector_(cmul_DISPATCHTABLE)[] = {
     #endif
   #endif
 
+  #if defined(USE_AVX2)
+    #if !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(cmul_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
   #if defined(USE_AVX)
     #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
       FUNCTION_IMPL(THVector_(cmul_AVX), SIMDExtension_AVX),
@@ -127,9 +137,7 @@ static FunctionDescription THVector_(cmul_DISPATCHTABLE)[] = {
 
   #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
           || defined(USE_SSE4_1) || defined(USE_SSE4_2)
-    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
-      FUNCTION_IMPL(THVector_(cmul_SSE), SIMDExtension_SSE),
-    #endif
+    FUNCTION_IMPL(THVector_(cmul_SSE), SIMDExtension_SSE),
   #endif
 
   FUNCTION_IMPL(THVector_(cmul_DEFAULT), SIMDExtension_DEFAULT)
@@ -152,6 +160,12 @@ static FunctionDescription THVector_(muls_DISPATCHTABLE)[] = {
     #endif
   #endif
 
+  #if defined(USE_AVX2)
+    #if !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(muls_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
   #if defined(USE_AVX)
     #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
       FUNCTION_IMPL(THVector_(muls_AVX), SIMDExtension_AVX),
@@ -160,9 +174,7 @@ static FunctionDescription THVector_(muls_DISPATCHTABLE)[] = {
 
   #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
           || defined(USE_SSE4_1) || defined(USE_SSE4_2)
-    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
-      FUNCTION_IMPL(THVector_(muls_SSE), SIMDExtension_SSE),
-    #endif
+    FUNCTION_IMPL(THVector_(muls_SSE), SIMDExtension_SSE),
   #endif
 
   FUNCTION_IMPL(THVector_(muls_DEFAULT), SIMDExtension_DEFAULT)
@@ -227,18 +239,268 @@ void THVector_(divs)(real *y, const real *x, const real c, const ptrdiff_t n) {
 
 static void (*THVector_(copy_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(copy_DEFAULT);
 static FunctionDescription THVector_(copy_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    #if !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copy_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
   #if defined(USE_AVX)
     #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
       FUNCTION_IMPL(THVector_(copy_AVX), SIMDExtension_AVX),
     #endif
   #endif
 
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    #if !defined(TH_REAL_IS_DOUBLE) && !defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copy_SSE), SIMDExtension_SSE),
+    #endif
+  #endif
+
   FUNCTION_IMPL(THVector_(copy_DEFAULT), SIMDExtension_DEFAULT)
 };
 void THVector_(copy)(real *y, const real *x, const ptrdiff_t n) {
   THVector_(copy_DISPATCHPTR)(y, x, n);
 }
 
+static void (*THVector_(swapBytes_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(swapBytes_DEFAULT);
+static FunctionDescription THVector_(swapBytes_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    #if !defined(TH_REAL_IS_BYTE) && !defined(TH_REAL_IS_CHAR)
+      FUNCTION_IMPL(THVector_(swapBytes_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    #if !defined(TH_REAL_IS_BYTE) && !defined(TH_REAL_IS_CHAR)
+      FUNCTION_IMPL(THVector_(swapBytes_SSE), SIMDExtension_SSE),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(swapBytes_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(swapBytes)(real *y, const real *x, const ptrdiff_t n) {
+  THVector_(swapBytes_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(gemmTile_DISPATCHPTR))(real *, const ptrdiff_t, const real *, const real *, const real, const ptrdiff_t) = &THVector_(gemmTile_DEFAULT);
+static FunctionDescription THVector_(gemmTile_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(gemmTile_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(gemmTile_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(gemmTile_SSE), SIMDExtension_SSE),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(gemmTile_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(gemmTile)(real *c, const ptrdiff_t ldc, const real *a, const real *b, const real alpha, const ptrdiff_t k) {
+  THVector_(gemmTile_DISPATCHPTR)(c, ldc, a, b, alpha, k);
+}
+
+static accreal (*THVector_(sum_DISPATCHPTR))(const real *, const ptrdiff_t) = &THVector_(sum_DEFAULT);
+static FunctionDescription THVector_(sum_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(sum_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(sum_DEFAULT), SIMDExtension_DEFAULT)
+};
+accreal THVector_(sum)(const real *x, const ptrdiff_t n) {
+  return THVector_(sum_DISPATCHPTR)(x, n);
+}
+
+static real (*THVector_(max_DISPATCHPTR))(const real *, const ptrdiff_t) = &THVector_(max_DEFAULT);
+static FunctionDescription THVector_(max_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(max_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(max_DEFAULT), SIMDExtension_DEFAULT)
+};
+real THVector_(max)(const real *x, const ptrdiff_t n) {
+  return THVector_(max_DISPATCHPTR)(x, n);
+}
+
+static real (*THVector_(min_DISPATCHPTR))(const real *, const ptrdiff_t) = &THVector_(min_DEFAULT);
+static FunctionDescription THVector_(min_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(min_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(min_DEFAULT), SIMDExtension_DEFAULT)
+};
+real THVector_(min)(const real *x, const ptrdiff_t n) {
+  return THVector_(min_DISPATCHPTR)(x, n);
+}
+
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+
+static void (*THVector_(exp_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(exp_DEFAULT);
+static FunctionDescription THVector_(exp_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    FUNCTION_IMPL(THVector_(exp_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(exp_AVX), SIMDExtension_AVX),
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    FUNCTION_IMPL(THVector_(exp_SSE), SIMDExtension_SSE),
+  #endif
+
+  FUNCTION_IMPL(THVector_(exp_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(exp)(real *y, const real *x, const ptrdiff_t n) {
+  THVector_(exp_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(log_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(log_DEFAULT);
+static FunctionDescription THVector_(log_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    FUNCTION_IMPL(THVector_(log_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(log_AVX), SIMDExtension_AVX),
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(log_SSE), SIMDExtension_SSE),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(log_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(log)(real *y, const real *x, const ptrdiff_t n) {
+  THVector_(log_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(tanh_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(tanh_DEFAULT);
+static FunctionDescription THVector_(tanh_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    FUNCTION_IMPL(THVector_(tanh_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(tanh_AVX), SIMDExtension_AVX),
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    FUNCTION_IMPL(THVector_(tanh_SSE), SIMDExtension_SSE),
+  #endif
+
+  FUNCTION_IMPL(THVector_(tanh_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(tanh)(real *y, const real *x, const ptrdiff_t n) {
+  THVector_(tanh_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(sigmoid_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(sigmoid_DEFAULT);
+static FunctionDescription THVector_(sigmoid_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    FUNCTION_IMPL(THVector_(sigmoid_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(sigmoid_AVX), SIMDExtension_AVX),
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    FUNCTION_IMPL(THVector_(sigmoid_SSE), SIMDExtension_SSE),
+  #endif
+
+  FUNCTION_IMPL(THVector_(sigmoid_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(sigmoid)(real *y, const real *x, const ptrdiff_t n) {
+  THVector_(sigmoid_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(rsqrt_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(rsqrt_DEFAULT);
+static FunctionDescription THVector_(rsqrt_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    FUNCTION_IMPL(THVector_(rsqrt_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(rsqrt_AVX), SIMDExtension_AVX),
+  #endif
+
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    FUNCTION_IMPL(THVector_(rsqrt_SSE), SIMDExtension_SSE),
+  #endif
+
+  FUNCTION_IMPL(THVector_(rsqrt_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(rsqrt)(real *y, const real *x, const ptrdiff_t n) {
+  THVector_(rsqrt_DISPATCHPTR)(y, x, n);
+}
+
+static accreal (*THVector_(sumCompensated_DISPATCHPTR))(const real *, const ptrdiff_t) = &THVector_(sumCompensated_DEFAULT);
+static FunctionDescription THVector_(sumCompensated_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(sumCompensated_AVX), SIMDExtension_AVX),
+  #endif
+
+  FUNCTION_IMPL(THVector_(sumCompensated_DEFAULT), SIMDExtension_DEFAULT)
+};
+accreal THVector_(sumCompensated)(const real *x, const ptrdiff_t n) {
+  return THVector_(sumCompensated_DISPATCHPTR)(x, n);
+}
+
+static accreal (*THVector_(asum_DISPATCHPTR))(const real *, const ptrdiff_t) = &THVector_(asum_DEFAULT);
+static FunctionDescription THVector_(asum_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(asum_AVX), SIMDExtension_AVX),
+  #endif
+
+  FUNCTION_IMPL(THVector_(asum_DEFAULT), SIMDExtension_DEFAULT)
+};
+accreal THVector_(asum)(const real *x, const ptrdiff_t n) {
+  return THVector_(asum_DISPATCHPTR)(x, n);
+}
+
+static accreal (*THVector_(sumsq_DISPATCHPTR))(const real *, const accreal, const ptrdiff_t) = &THVector_(sumsq_DEFAULT);
+static FunctionDescription THVector_(sumsq_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(sumsq_AVX), SIMDExtension_AVX),
+  #endif
+
+  FUNCTION_IMPL(THVector_(sumsq_DEFAULT), SIMDExtension_DEFAULT)
+};
+accreal THVector_(sumsq)(const real *x, const accreal c, const ptrdiff_t n) {
+  return THVector_(sumsq_DISPATCHPTR)(x, c, n);
+}
+
+#endif
+
 /* This needs to be called in order to initialize the dispatch pointers at runtime.
  * This function simply checks what SIMD extensions are available, and then walks the dispatch table
  * to choose the best function.
@@ -257,6 +519,21 @@ void THVector_(vectorDispatchInit)(void)
   INIT_DISPATCH_PTR(cdiv);
   INIT_DISPATCH_PTR(divs);
   INIT_DISPATCH_PTR(copy);
+  INIT_DISPATCH_PTR(swapBytes);
+  INIT_DISPATCH_PTR(gemmTile);
+  INIT_DISPATCH_PTR(sum);
+  INIT_DISPATCH_PTR(max);
+  INIT_DISPATCH_PTR(min);
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+  INIT_DISPATCH_PTR(exp);
+  INIT_DISPATCH_PTR(log);
+  INIT_DISPATCH_PTR(tanh);
+  INIT_DISPATCH_PTR(sigmoid);
+  INIT_DISPATCH_PTR(rsqrt);
+  INIT_DISPATCH_PTR(sumCompensated);
+  INIT_DISPATCH_PTR(asum);
+  INIT_DISPATCH_PTR(sumsq);
+#endif
 }
 
 #endif
@@ -4,6 +4,7 @@
 #else
 #include <intrin.h>
 #endif
+#include <math.h>
 
 #include "AVX.h"
 
@@ -271,4 +272,452 @@ void THFloatVector_adds_AVX(float *y, const float *x, const float c, const ptrdi
   }
 }
 
+/* 8x6 tile: 12 accumulators */
+void THDoubleVector_gemmTile_AVX(double *c, const ptrdiff_t ldc, const double *a, const double *b, const double alpha, const ptrdiff_t k) {
+  ptrdiff_t l;
+  int j;
+  __m256d YMMALPHA = _mm256_set1_pd(alpha);
+  __m256d C0[6], C1[6];
+  for (j=0; j<6; j++) {
+    C0[j] = _mm256_setzero_pd();
+    C1[j] = _mm256_setzero_pd();
+  }
+  for (l=0; l<k; l++) {
+    __m256d YMM0 = _mm256_loadu_pd(a);
+    __m256d YMM1 = _mm256_loadu_pd(a+4);
+    for (j=0; j<6; j++) {
+      __m256d YMM2 = _mm256_broadcast_sd(b+j);
+      C0[j] = _mm256_add_pd(C0[j], _mm256_mul_pd(YMM0, YMM2));
+      C1[j] = _mm256_add_pd(C1[j], _mm256_mul_pd(YMM1, YMM2));
+    }
+    a += 8;
+    b += 6;
+  }
+  for (j=0; j<6; j++) {
+    double *cp = c+j*ldc;
+    _mm256_storeu_pd(cp, _mm256_add_pd(_mm256_loadu_pd(cp), _mm256_mul_pd(YMMALPHA, C0[j])));
+    _mm256_storeu_pd(cp+4, _mm256_add_pd(_mm256_loadu_pd(cp+4), _mm256_mul_pd(YMMALPHA, C1[j])));
+  }
+}
+
+/* 16x6 tile: 12 accumulators */
+void THFloatVector_gemmTile_AVX(float *c, const ptrdiff_t ldc, const float *a, const float *b, const float alpha, const ptrdiff_t k) {
+  ptrdiff_t l;
+  int j;
+  __m256 YMMALPHA = _mm256_set1_ps(alpha);
+  __m256 C0[6], C1[6];
+  for (j=0; j<6; j++) {
+    C0[j] = _mm256_setzero_ps();
+    C1[j] = _mm256_setzero_ps();
+  }
+  for (l=0; l<k; l++) {
+    __m256 YMM0 = _mm256_loadu_ps(a);
+    __m256 YMM1 = _mm256_loadu_ps(a+8);
+    for (j=0; j<6; j++) {
+      __m256 YMM2 = _mm256_broadcast_ss(b+j);
+      C0[j] = _mm256_add_ps(C0[j], _mm256_mul_ps(YMM0, YMM2));
+      C1[j] = _mm256_add_ps(C1[j], _mm256_mul_ps(YMM1, YMM2));
+    }
+    a += 16;
+    b += 6;
+  }
+  for (j=0; j<6; j++) {
+    float *cp = c+j*ldc;
+    _mm256_storeu_ps(cp, _mm256_add_ps(_mm256_loadu_ps(cp), _mm256_mul_ps(YMMALPHA, C0[j])));
+    _mm256_storeu_ps(cp+8, _mm256_add_ps(_mm256_loadu_ps(cp+8), _mm256_mul_ps(YMMALPHA, C1[j])));
+  }
+}
+
+/* Transcendental functions, 4 doubles or 8 floats at a time: same algorithms
+ * as in SSE.c. AVX has no 256-bit integer instructions: the exponent
+ * manipulations work on 128-bit halves. */
+
+static inline __m256i THVector_combine_AVX(__m128i lo, __m128i hi) {
+  return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/* and/andnot/or rather than blendv, which some compilers turn into
+ * per-element branches without AVX2 */
+static inline __m256d THDoubleVector_select_AVX(__m256d mask, __m256d a, __m256d b) {
+  return _mm256_or_pd(_mm256_and_pd(mask, a), _mm256_andnot_pd(mask, b));
+}
+
+static inline __m256 THFloatVector_select_AVX(__m256 mask, __m256 a, __m256 b) {
+  return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b));
+}
+
+static inline __m256d THDoubleVector_expvec_AVX(__m256d x) {
+  static const double c[] = {1.0/6227020800.0, 1.0/479001600.0, 1.0/39916800.0, 1.0/3628800.0,
+                             1.0/362880.0, 1.0/40320.0, 1.0/5040.0, 1.0/720.0, 1.0/120.0,
+                             1.0/24.0, 1.0/6.0, 1.0/2.0};
+  __m256d n, r, p;
+  __m128i k, h, bias = _mm_set1_epi32(1023), zero = _mm_setzero_si128();
+  int i;
+  x = _mm256_min_pd(_mm256_set1_pd(710.0), _mm256_max_pd(_mm256_set1_pd(-746.0), x));
+  k = _mm256_cvtpd_epi32(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634074)));
+  n = _mm256_cvtepi32_pd(k);
+  r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(6.93145751953125E-1)));
+  r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(1.42860682030941723212E-6)));
+  p = _mm256_set1_pd(c[0]);
+  for (i=1; i<12; i++)
+    p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(c[i]));
+  p = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(p, r), r), r);
+  p = _mm256_add_pd(p, _mm256_set1_pd(1.0));
+  h = _mm_srai_epi32(k, 1);
+  k = _mm_add_epi32(_mm_sub_epi32(k, h), bias);
+  h = _mm_add_epi32(h, bias);
+  p = _mm256_mul_pd(p, _mm256_castsi256_pd(THVector_combine_AVX(_mm_slli_epi64(_mm_unpacklo_epi32(h, zero), 52),
+                                                                _mm_slli_epi64(_mm_unpackhi_epi32(h, zero), 52))));
+  return _mm256_mul_pd(p, _mm256_castsi256_pd(THVector_combine_AVX(_mm_slli_epi64(_mm_unpacklo_epi32(k, zero), 52),
+                                                                   _mm_slli_epi64(_mm_unpackhi_epi32(k, zero), 52))));
+}
+
+static inline __m256 THFloatVector_expvec_AVX(__m256 x) {
+  __m256 n, r, p;
+  __m256i k;
+  __m128i k0, k1, h0, h1, bias = _mm_set1_epi32(127);
+  x = _mm256_min_ps(_mm256_set1_ps(89.0f), _mm256_max_ps(_mm256_set1_ps(-105.0f), x));
+  k = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)));
+  n = _mm256_cvtepi32_ps(k);
+  r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+  p = _mm256_set1_ps(1.9875691500e-4f);
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.3981999507e-3f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(8.3334519073e-3f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(4.1665795894e-2f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.6666665459e-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(5.0000001201e-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, r), r), r);
+  p = _mm256_add_ps(p, _mm256_set1_ps(1.0f));
+  k0 = _mm256_castsi256_si128(k);
+  k1 = _mm256_extractf128_si256(k, 1);
+  h0 = _mm_srai_epi32(k0, 1);
+  h1 = _mm_srai_epi32(k1, 1);
+  k0 = _mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(k0, h0), bias), 23);
+  k1 = _mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(k1, h1), bias), 23);
+  h0 = _mm_slli_epi32(_mm_add_epi32(h0, bias), 23);
+  h1 = _mm_slli_epi32(_mm_add_epi32(h1, bias), 23);
+  p = _mm256_mul_ps(p, _mm256_castsi256_ps(THVector_combine_AVX(h0, h1)));
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(THVector_combine_AVX(k0, k1)));
+}
+
+static inline __m256d THDoubleVector_logvec_AVX(__m256d x) {
+  static const double c[] = {2.0/21, 2.0/19, 2.0/17, 2.0/15, 2.0/13, 2.0/11, 2.0/9, 2.0/7, 2.0/5, 2.0/3};
+  __m256d one = _mm256_set1_pd(1.0);
+  __m256d zero = _mm256_setzero_pd();
+  __m256d invalid = _mm256_cmp_pd(x, zero, _CMP_NGE_UQ); /* x < 0 or nan */
+  __m256d tiny = _mm256_cmp_pd(x, _mm256_set1_pd(2.2250738585072014e-308), _CMP_LT_OQ);
+  __m256d xs = THDoubleVector_select_AVX(tiny, _mm256_mul_pd(x, _mm256_set1_pd(4503599627370496.0)), x);
+  __m256i bits = _mm256_castpd_si256(xs);
+  __m128i magic = _mm_set1_epi64x(0x4330000000000000LL);
+  __m256d e, m, big, f, s, z, p, h, res;
+  int i;
+  e = _mm256_castsi256_pd(THVector_combine_AVX(_mm_or_si128(_mm_srli_epi64(_mm256_castsi256_si128(bits), 52), magic),
+                                               _mm_or_si128(_mm_srli_epi64(_mm256_extractf128_si256(bits, 1), 52), magic)));
+  e = _mm256_sub_pd(e, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+  e = _mm256_sub_pd(e, _mm256_and_pd(tiny, _mm256_set1_pd(52.0)));
+  m = _mm256_or_pd(_mm256_and_pd(xs, _mm256_castsi256_pd(_mm256_set1_epi64x(0x000fffffffffffffLL))), one);
+  big = _mm256_cmp_pd(m, _mm256_set1_pd(1.41421356237309504880), _CMP_GT_OQ);
+  m = THDoubleVector_select_AVX(big, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), m);
+  e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+  f = _mm256_sub_pd(m, one);
+  s = _mm256_div_pd(f, _mm256_add_pd(f, _mm256_set1_pd(2.0)));
+  z = _mm256_mul_pd(s, s);
+  p = _mm256_set1_pd(c[0]);
+  for (i=1; i<10; i++)
+    p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(c[i]));
+  p = _mm256_mul_pd(p, z);
+  h = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+  p = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(h, p)), _mm256_mul_pd(e, _mm256_set1_pd(1.90821492927058770002e-10)));
+  res = _mm256_sub_pd(_mm256_mul_pd(e, _mm256_set1_pd(6.93147180369123816490e-01)), _mm256_sub_pd(_mm256_sub_pd(h, p), f));
+  res = THDoubleVector_select_AVX(_mm256_cmp_pd(x, _mm256_set1_pd(INFINITY), _CMP_EQ_OQ), x, res);
+  res = THDoubleVector_select_AVX(_mm256_cmp_pd(x, zero, _CMP_EQ_OQ), _mm256_set1_pd(-INFINITY), res);
+  return _mm256_or_pd(res, invalid);
+}
+
+static inline __m256 THFloatVector_logvec_AVX(__m256 x) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 invalid = _mm256_cmp_ps(x, zero, _CMP_NGE_UQ); /* x < 0 or nan */
+  __m256 tiny = _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_LT_OQ);
+  __m256 xs = THFloatVector_select_AVX(tiny, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), x);
+  __m256i bits = _mm256_castps_si256(xs);
+  __m128i bias = _mm_set1_epi32(127);
+  __m256 e, m, big, f, s, z, p, h, res;
+  e = _mm256_cvtepi32_ps(THVector_combine_AVX(_mm_sub_epi32(_mm_srli_epi32(_mm256_castsi256_si128(bits), 23), bias),
+                                              _mm_sub_epi32(_mm_srli_epi32(_mm256_extractf128_si256(bits, 1), 23), bias)));
+  e = _mm256_sub_ps(e, _mm256_and_ps(tiny, _mm256_set1_ps(23.0f)));
+  m = _mm256_or_ps(_mm256_and_ps(xs, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))), one);
+  big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+  m = THFloatVector_select_AVX(big, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), m);
+  e = _mm256_add_ps(e, _mm256_and_ps(big, one));
+  f = _mm256_sub_ps(m, one);
+  s = _mm256_div_ps(f, _mm256_add_ps(f, _mm256_set1_ps(2.0f)));
+  z = _mm256_mul_ps(s, s);
+  p = _mm256_set1_ps(2.0f/9);
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.0f/7));
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.0f/5));
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.0f/3));
+  p = _mm256_mul_ps(p, z);
+  h = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), f), f);
+  p = _mm256_add_ps(_mm256_mul_ps(s, _mm256_add_ps(h, p)), _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+  res = _mm256_sub_ps(_mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)), _mm256_sub_ps(_mm256_sub_ps(h, p), f));
+  res = THFloatVector_select_AVX(_mm256_cmp_ps(x, _mm256_set1_ps(INFINITY), _CMP_EQ_OQ), x, res);
+  res = THFloatVector_select_AVX(_mm256_cmp_ps(x, zero, _CMP_EQ_OQ), _mm256_set1_ps(-INFINITY), res);
+  return _mm256_or_ps(res, invalid);
+}
+
+static inline __m256d THDoubleVector_tanhvec_AVX(__m256d x) {
+  __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d ax = _mm256_andnot_pd(sign, x);
+  __m256d z = _mm256_mul_pd(x, x);
+  __m256d p, q, small, large;
+  p = _mm256_set1_pd(-9.64399179425052238628E-1);
+  p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-9.92877231001918586564E1));
+  p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-1.61468768441708447952E3));
+  q = _mm256_add_pd(z, _mm256_set1_pd(1.12811678491632931402E2));
+  q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(2.23548839060100448583E3));
+  q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(4.84406305325125486048E3));
+  small = _mm256_add_pd(x, _mm256_mul_pd(_mm256_mul_pd(x, z), _mm256_div_pd(p, q)));
+  large = THDoubleVector_expvec_AVX(_mm256_add_pd(ax, ax));
+  large = _mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(large, _mm256_set1_pd(1.0))));
+  large = _mm256_or_pd(large, _mm256_and_pd(x, sign));
+  return THDoubleVector_select_AVX(_mm256_cmp_pd(ax, _mm256_set1_pd(0.625), _CMP_LT_OQ), small, large);
+}
+
+static inline __m256 THFloatVector_tanhvec_AVX(__m256 x) {
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 ax = _mm256_andnot_ps(sign, x);
+  __m256 z = _mm256_mul_ps(x, x);
+  __m256 p, small, large;
+  p = _mm256_set1_ps(-5.70498872745e-3f);
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.06390887954e-2f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(-5.37397155531e-2f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.33314422036e-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(-3.33332819422e-1f));
+  small = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x, z), p));
+  large = THFloatVector_expvec_AVX(_mm256_add_ps(ax, ax));
+  large = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(large, _mm256_set1_ps(1.0f))));
+  large = _mm256_or_ps(large, _mm256_and_ps(x, sign));
+  return THFloatVector_select_AVX(_mm256_cmp_ps(ax, _mm256_set1_ps(0.625f), _CMP_LT_OQ), small, large);
+}
+
+static inline __m256d THDoubleVector_sigmoidvec_AVX(__m256d x) {
+  __m256d e = THDoubleVector_expvec_AVX(_mm256_or_pd(x, _mm256_set1_pd(-0.0)));
+  __m256d r = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_add_pd(_mm256_set1_pd(1.0), e));
+  return THDoubleVector_select_AVX(_mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ), _mm256_mul_pd(e, r), r);
+}
+
+static inline __m256 THFloatVector_sigmoidvec_AVX(__m256 x) {
+  __m256 e = THFloatVector_expvec_AVX(_mm256_or_ps(x, _mm256_set1_ps(-0.0f)));
+  __m256 r = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(1.0f), e));
+  return THFloatVector_select_AVX(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_mul_ps(e, r), r);
+}
+
+static inline __m256d THDoubleVector_rsqrtvec_AVX(__m256d x) {
+  return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(x));
+}
+
+static inline __m256 THFloatVector_rsqrtvec_AVX(__m256 x) {
+  return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(x));
+}
+
+/* the tail goes through the vector code too, from a padded copy */
+#define THVector_UNARY_AVX(TYPE, NAME, REAL, WIDTH, LOADU, STOREU)          \
+  void TH##TYPE##Vector_##NAME##_AVX(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    ptrdiff_t i, j;                                                         \
+    REAL buf[WIDTH];                                                        \
+    for (i=0; i<=((n)-WIDTH); i+=WIDTH) {                                   \
+      STOREU(y+i, TH##TYPE##Vector_##NAME##vec_AVX(LOADU(x+i)));            \
+    }                                                                       \
+    if (i < n) {                                                            \
+      for (j=0; j<WIDTH; j++)                                               \
+        buf[j] = (i+j < n ? x[i+j] : 0);                                    \
+      STOREU(buf, TH##TYPE##Vector_##NAME##vec_AVX(LOADU(buf)));            \
+      for (j=0; i+j<n; j++)                                                 \
+        y[i+j] = buf[j];                                                    \
+    }                                                                       \
+  }
+
+THVector_UNARY_AVX(Double, exp, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX(Double, log, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX(Double, tanh, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX(Double, sigmoid, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX(Double, rsqrt, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX(Float, exp, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX(Float, log, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX(Float, tanh, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX(Float, sigmoid, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX(Float, rsqrt, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+
+#undef THVector_UNARY_AVX
+
+/* Reductions: float data is accumulated in double, like in the scalar code;
+ * four vector accumulators (16 elements per iteration) hide the latency of
+ * the additions. */
+
+static inline double THVector_hsum_AVX(__m256d v) {
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+#define THDoubleVector_load_AVX(x) _mm256_loadu_pd(x)
+#define THFloatVector_load_AVX(x) _mm256_cvtps_pd(_mm_loadu_ps(x))
+
+#define THVector_SUM_AVX(TYPE, REAL)                                        \
+  double TH##TYPE##Vector_sum_AVX(const REAL *x, const ptrdiff_t n) {       \
+    ptrdiff_t i;                                                            \
+    double s;                                                               \
+    __m256d YMM0 = _mm256_setzero_pd();                                     \
+    __m256d YMM1 = _mm256_setzero_pd();                                     \
+    __m256d YMM2 = _mm256_setzero_pd();                                     \
+    __m256d YMM3 = _mm256_setzero_pd();                                     \
+    for (i=0; i<=((n)-16); i+=16) {                                         \
+      YMM0 = _mm256_add_pd(YMM0, TH##TYPE##Vector_load_AVX(x+i));           \
+      YMM1 = _mm256_add_pd(YMM1, TH##TYPE##Vector_load_AVX(x+i+4));         \
+      YMM2 = _mm256_add_pd(YMM2, TH##TYPE##Vector_load_AVX(x+i+8));         \
+      YMM3 = _mm256_add_pd(YMM3, TH##TYPE##Vector_load_AVX(x+i+12));        \
+    }                                                                       \
+    s = THVector_hsum_AVX(_mm256_add_pd(_mm256_add_pd(YMM0, YMM1),          \
+                                        _mm256_add_pd(YMM2, YMM3)));        \
+    for (; i<(n); i++) {                                                    \
+      s += x[i];                                                            \
+    }                                                                       \
+    return s;                                                               \
+  }                                                                         \
+                                                                            \
+  double TH##TYPE##Vector_asum_AVX(const REAL *x, const ptrdiff_t n) {      \
+    ptrdiff_t i;                                                            \
+    double s;                                                               \
+    __m256d YMM7 = _mm256_set1_pd(-0.0);                                    \
+    __m256d YMM0 = _mm256_setzero_pd();                                     \
+    __m256d YMM1 = _mm256_setzero_pd();                                     \
+    __m256d YMM2 = _mm256_setzero_pd();                                     \
+    __m256d YMM3 = _mm256_setzero_pd();                                     \
+    for (i=0; i<=((n)-16); i+=16) {                                         \
+      YMM0 = _mm256_add_pd(YMM0, _mm256_andnot_pd(YMM7, TH##TYPE##Vector_load_AVX(x+i))); \
+      YMM1 = _mm256_add_pd(YMM1, _mm256_andnot_pd(YMM7, TH##TYPE##Vector_load_AVX(x+i+4))); \
+      YMM2 = _mm256_add_pd(YMM2, _mm256_andnot_pd(YMM7, TH##TYPE##Vector_load_AVX(x+i+8))); \
+      YMM3 = _mm256_add_pd(YMM3, _mm256_andnot_pd(YMM7, TH##TYPE##Vector_load_AVX(x+i+12))); \
+    }                                                                       \
+    s = THVector_hsum_AVX(_mm256_add_pd(_mm256_add_pd(YMM0, YMM1),          \
+                                        _mm256_add_pd(YMM2, YMM3)));        \
+    for (; i<(n); i++) {                                                    \
+      s += fabs(x[i]);                                                      \
+    }                                                                       \
+    return s;                                                               \
+  }                                                                         \
+                                                                            \
+  double TH##TYPE##Vector_sumsq_AVX(const REAL *x, const double c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    double s;                                                               \
+    __m256d YMM7 = _mm256_set1_pd(c);                                       \
+    __m256d YMM0 = _mm256_setzero_pd();                                     \
+    __m256d YMM1 = _mm256_setzero_pd();                                     \
+    __m256d YMM2 = _mm256_setzero_pd();                                     \
+    __m256d YMM3 = _mm256_setzero_pd();                                     \
+    for (i=0; i<=((n)-16); i+=16) {                                         \
+      __m256d YMM4 = _mm256_sub_pd(TH##TYPE##Vector_load_AVX(x+i), YMM7);   \
+      __m256d YMM5 = _mm256_sub_pd(TH##TYPE##Vector_load_AVX(x+i+4), YMM7); \
+      __m256d YMM6 = _mm256_sub_pd(TH##TYPE##Vector_load_AVX(x+i+8), YMM7); \
+      __m256d YMM8 = _mm256_sub_pd(TH##TYPE##Vector_load_AVX(x+i+12), YMM7); \
+      YMM0 = _mm256_add_pd(YMM0, _mm256_mul_pd(YMM4, YMM4));                \
+      YMM1 = _mm256_add_pd(YMM1, _mm256_mul_pd(YMM5, YMM5));                \
+      YMM2 = _mm256_add_pd(YMM2, _mm256_mul_pd(YMM6, YMM6));                \
+      YMM3 = _mm256_add_pd(YMM3, _mm256_mul_pd(YMM8, YMM8));                \
+    }                                                                       \
+    s = THVector_hsum_AVX(_mm256_add_pd(_mm256_add_pd(YMM0, YMM1),          \
+                                        _mm256_add_pd(YMM2, YMM3)));        \
+    for (; i<(n); i++) {                                                    \
+      double d = (double)x[i] - c;                                          \
+      s += d*d;                                                             \
+    }                                                                       \
+    return s;                                                               \
+  }                                                                         \
+                                                                            \
+  /* one Kahan sum per lane; the lanes are then summed with compensation */ \
+  double TH##TYPE##Vector_sumCompensated_AVX(const REAL *x, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    int j;                                                                  \
+    double s = 0, c = 0, t, y;                                              \
+    double lanes[16];                                                       \
+    __m256d S[4], C[4];                                                     \
+    for (j=0; j<4; j++) {                                                   \
+      S[j] = _mm256_setzero_pd();                                           \
+      C[j] = _mm256_setzero_pd();                                           \
+    }                                                                       \
+    for (i=0; i<=((n)-16); i+=16) {                                         \
+      for (j=0; j<4; j++) {                                                 \
+        __m256d Y = _mm256_sub_pd(TH##TYPE##Vector_load_AVX(x+i+4*j), C[j]); \
+        __m256d T = _mm256_add_pd(S[j], Y);                                 \
+        C[j] = _mm256_sub_pd(_mm256_sub_pd(T, S[j]), Y);                    \
+        S[j] = T;                                                           \
+      }                                                                     \
+    }                                                                       \
+    for (j=0; j<4; j++) {                                                   \
+      _mm256_storeu_pd(lanes+4*j, _mm256_sub_pd(S[j], C[j]));               \
+    }                                                                       \
+    for (j=0; j<16; j++) {                                                  \
+      y = lanes[j] - c;                                                     \
+      t = s + y;                                                            \
+      c = (t - s) - y;                                                      \
+      s = t;                                                                \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y = x[i] - c;                                                         \
+      t = s + y;                                                            \
+      c = (t - s) - y;                                                      \
+      s = t;                                                                \
+    }                                                                       \
+    return s;                                                               \
+  }
+
+THVector_SUM_AVX(Double, double)
+THVector_SUM_AVX(Float, float)
+
+#undef THVector_SUM_AVX
+#undef THDoubleVector_load_AVX
+#undef THFloatVector_load_AVX
+
+/* max and min: a nan anywhere gives nan (unordered compares are or-ed) */
+#define THVector_MAXMIN_AVX(TYPE, REAL, VEC, WIDTH, SUF, NAME, GT, LE)      \
+  REAL TH##TYPE##Vector_##NAME##_AVX(const REAL *x, const ptrdiff_t n) {    \
+    ptrdiff_t i;                                                            \
+    int j;                                                                  \
+    REAL m, buf[WIDTH];                                                     \
+    VEC YMM0 = _mm256_set1_p##SUF(x[0]);                                    \
+    VEC YMM1 = YMM0;                                                        \
+    VEC YMM7 = _mm256_cmp_p##SUF(YMM0, YMM0, _CMP_UNORD_Q);                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      VEC YMM2 = _mm256_loadu_p##SUF(x+i);                                  \
+      VEC YMM3 = _mm256_loadu_p##SUF(x+i+WIDTH);                            \
+      YMM0 = _mm256_##NAME##_p##SUF(YMM0, YMM2);                            \
+      YMM1 = _mm256_##NAME##_p##SUF(YMM1, YMM3);                            \
+      YMM7 = _mm256_or_p##SUF(YMM7, _mm256_cmp_p##SUF(YMM2, YMM3, _CMP_UNORD_Q)); \
+    }                                                                       \
+    if (_mm256_movemask_p##SUF(YMM7)) {                                     \
+      return NAN;                                                           \
+    }                                                                       \
+    _mm256_storeu_p##SUF(buf, _mm256_##NAME##_p##SUF(YMM0, YMM1));          \
+    m = buf[0];                                                             \
+    for (j=1; j<WIDTH; j++) {                                               \
+      m = (buf[j] GT m ? buf[j] : m);                                       \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      if (!(x[i] LE m)) {                                                   \
+        m = x[i];                                                           \
+        if (isnan(m))                                                       \
+          break;                                                            \
+      }                                                                     \
+    }                                                                       \
+    return m;                                                               \
+  }
+
+THVector_MAXMIN_AVX(Double, double, __m256d, 4, d, max, >, <=)
+THVector_MAXMIN_AVX(Double, double, __m256d, 4, d, min, <, >=)
+THVector_MAXMIN_AVX(Float, float, __m256, 8, s, max, >, <=)
+THVector_MAXMIN_AVX(Float, float, __m256, 8, s, min, <, >=)
+
+#undef THVector_MAXMIN_AVX
+
 #endif // defined(__AVX__)
@@ -11,6 +11,7 @@ void THDoubleVector_cmul_AVX(double *z, const double *x, const double *y, const
 void THDoubleVector_muls_AVX(double *y, const double *x, const double c, const ptrdiff_t n);
 void THDoubleVector_cadd_AVX(double *z, const double *x, const double *y, const double c, const ptrdiff_t n);
 void THDoubleVector_adds_AVX(double *y, const double *x, const double c, const ptrdiff_t n);
+void THDoubleVector_gemmTile_AVX(double *c, const ptrdiff_t ldc, const double *a, const double *b, const double alpha, const ptrdiff_t k);
 void THFloatVector_copy_AVX(float *y, const float *x, const ptrdiff_t n);
 void THFloatVector_fill_AVX(float *x, const float c, const ptrdiff_t n);
 void THFloatVector_cdiv_AVX(float *z, const float *x, const float *y, const ptrdiff_t n);
@@ -19,5 +20,29 @@ void THFloatVector_cmul_AVX(float *z, const float *x, const float *y, const ptrd
 void THFloatVector_muls_AVX(float *y, const float *x, const float c, const ptrdiff_t n);
 void THFloatVector_cadd_AVX(float *z, const float *x, const float *y, const float c, const ptrdiff_t n);
 void THFloatVector_adds_AVX(float *y, const float *x, const float c, const ptrdiff_t n);
+void THFloatVector_gemmTile_AVX(float *c, const ptrdiff_t ldc, const float *a, const float *b, const float alpha, const ptrdiff_t k);
+void THDoubleVector_exp_AVX(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_log_AVX(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_tanh_AVX(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_sigmoid_AVX(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_rsqrt_AVX(double *y, const double *x, const ptrdiff_t n);
+void THFloatVector_exp_AVX(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_log_AVX(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_tanh_AVX(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_sigmoid_AVX(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_rsqrt_AVX(float *y, const float *x, const ptrdiff_t n);
+
+double THDoubleVector_sum_AVX(const double *x, const ptrdiff_t n);
+double THDoubleVector_asum_AVX(const double *x, const ptrdiff_t n);
+double THDoubleVector_sumsq_AVX(const double *x, const double c, const ptrdiff_t n);
+double THDoubleVector_sumCompensated_AVX(const double *x, const ptrdiff_t n);
+double THDoubleVector_max_AVX(const double *x, const ptrdiff_t n);
+double THDoubleVector_min_AVX(const double *x, const ptrdiff_t n);
+double THFloatVector_sum_AVX(const float *x, const ptrdiff_t n);
+double THFloatVector_asum_AVX(const float *x, const ptrdiff_t n);
+double THFloatVector_sumsq_AVX(const float *x, const double c, const ptrdiff_t n);
+double THFloatVector_sumCompensated_AVX(const float *x, const ptrdiff_t n);
+float THFloatVector_max_AVX(const float *x, const ptrdiff_t n);
+float THFloatVector_min_AVX(const float *x, const ptrdiff_t n);
 
 #endif
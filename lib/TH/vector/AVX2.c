@@ -4,6 +4,8 @@
 #else
 #include <intrin.h>
 #endif
+#include <math.h>
+#include <limits.h>
 #include "AVX2.h"
 
 void THDoubleVector_cadd_AVX2(double *z, const double *x, const double *y, const double c, const ptrdiff_t n) {
@@ -44,4 +46,424 @@ void THFloatVector_cadd_AVX2(float *z, const float *x, const float *y, const flo
   }
 }
 
+/* 8x6 tile: 12 accumulators, fused multiply-add */
+void THDoubleVector_gemmTile_AVX2(double *c, const ptrdiff_t ldc, const double *a, const double *b, const double alpha, const ptrdiff_t k) {
+  ptrdiff_t l;
+  int j;
+  __m256d YMMALPHA = _mm256_set1_pd(alpha);
+  __m256d C0[6], C1[6];
+  for (j=0; j<6; j++) {
+    C0[j] = _mm256_setzero_pd();
+    C1[j] = _mm256_setzero_pd();
+  }
+  for (l=0; l<k; l++) {
+    __m256d YMM0 = _mm256_loadu_pd(a);
+    __m256d YMM1 = _mm256_loadu_pd(a+4);
+    for (j=0; j<6; j++) {
+      __m256d YMM2 = _mm256_broadcast_sd(b+j);
+      C0[j] = _mm256_fmadd_pd(YMM0, YMM2, C0[j]);
+      C1[j] = _mm256_fmadd_pd(YMM1, YMM2, C1[j]);
+    }
+    a += 8;
+    b += 6;
+  }
+  for (j=0; j<6; j++) {
+    double *cp = c+j*ldc;
+    _mm256_storeu_pd(cp, _mm256_fmadd_pd(YMMALPHA, C0[j], _mm256_loadu_pd(cp)));
+    _mm256_storeu_pd(cp+4, _mm256_fmadd_pd(YMMALPHA, C1[j], _mm256_loadu_pd(cp+4)));
+  }
+}
+
+/* 16x6 tile: 12 accumulators, fused multiply-add */
+void THFloatVector_gemmTile_AVX2(float *c, const ptrdiff_t ldc, const float *a, const float *b, const float alpha, const ptrdiff_t k) {
+  ptrdiff_t l;
+  int j;
+  __m256 YMMALPHA = _mm256_set1_ps(alpha);
+  __m256 C0[6], C1[6];
+  for (j=0; j<6; j++) {
+    C0[j] = _mm256_setzero_ps();
+    C1[j] = _mm256_setzero_ps();
+  }
+  for (l=0; l<k; l++) {
+    __m256 YMM0 = _mm256_loadu_ps(a);
+    __m256 YMM1 = _mm256_loadu_ps(a+8);
+    for (j=0; j<6; j++) {
+      __m256 YMM2 = _mm256_broadcast_ss(b+j);
+      C0[j] = _mm256_fmadd_ps(YMM0, YMM2, C0[j]);
+      C1[j] = _mm256_fmadd_ps(YMM1, YMM2, C1[j]);
+    }
+    a += 16;
+    b += 6;
+  }
+  for (j=0; j<6; j++) {
+    float *cp = c+j*ldc;
+    _mm256_storeu_ps(cp, _mm256_fmadd_ps(YMMALPHA, C0[j], _mm256_loadu_ps(cp)));
+    _mm256_storeu_ps(cp+8, _mm256_fmadd_ps(YMMALPHA, C1[j], _mm256_loadu_ps(cp+8)));
+  }
+}
+
+/* Transcendental functions, 4 doubles or 8 floats at a time: same algorithms
+ * as in SSE.c, with fused multiply-adds. */
+
+static inline __m256d THDoubleVector_expvec_AVX2(__m256d x) {
+  static const double c[] = {1.0/6227020800.0, 1.0/479001600.0, 1.0/39916800.0, 1.0/3628800.0,
+                             1.0/362880.0, 1.0/40320.0, 1.0/5040.0, 1.0/720.0, 1.0/120.0,
+                             1.0/24.0, 1.0/6.0, 1.0/2.0};
+  __m256d n, r, p;
+  __m256i bias = _mm256_set1_epi64x(1023);
+  __m128i k, h;
+  int i;
+  x = _mm256_min_pd(_mm256_set1_pd(710.0), _mm256_max_pd(_mm256_set1_pd(-746.0), x));
+  k = _mm256_cvtpd_epi32(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634074)));
+  n = _mm256_cvtepi32_pd(k);
+  r = _mm256_fnmadd_pd(n, _mm256_set1_pd(6.93145751953125E-1), x);
+  r = _mm256_fnmadd_pd(n, _mm256_set1_pd(1.42860682030941723212E-6), r);
+  p = _mm256_set1_pd(c[0]);
+  for (i=1; i<12; i++)
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(c[i]));
+  p = _mm256_fmadd_pd(_mm256_mul_pd(p, r), r, r);
+  p = _mm256_add_pd(p, _mm256_set1_pd(1.0));
+  h = _mm_srai_epi32(k, 1);
+  k = _mm_sub_epi32(k, h);
+  p = _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(h), bias), 52)));
+  return _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(k), bias), 52)));
+}
+
+static inline __m256 THFloatVector_expvec_AVX2(__m256 x) {
+  __m256 n, r, p;
+  __m256i k, h, bias = _mm256_set1_epi32(127);
+  x = _mm256_min_ps(_mm256_set1_ps(89.0f), _mm256_max_ps(_mm256_set1_ps(-105.0f), x));
+  k = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)));
+  n = _mm256_cvtepi32_ps(k);
+  r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+  r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+  p = _mm256_set1_ps(1.9875691500e-4f);
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+  p = _mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r);
+  p = _mm256_add_ps(p, _mm256_set1_ps(1.0f));
+  h = _mm256_srai_epi32(k, 1);
+  k = _mm256_sub_epi32(k, h);
+  p = _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(h, bias), 23)));
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(k, bias), 23)));
+}
+
+static inline __m256d THDoubleVector_logvec_AVX2(__m256d x) {
+  static const double c[] = {2.0/21, 2.0/19, 2.0/17, 2.0/15, 2.0/13, 2.0/11, 2.0/9, 2.0/7, 2.0/5, 2.0/3};
+  __m256d one = _mm256_set1_pd(1.0);
+  __m256d zero = _mm256_setzero_pd();
+  __m256d invalid = _mm256_cmp_pd(x, zero, _CMP_NGE_UQ); /* x < 0 or nan */
+  __m256d tiny = _mm256_cmp_pd(x, _mm256_set1_pd(2.2250738585072014e-308), _CMP_LT_OQ);
+  __m256d xs = _mm256_blendv_pd(x, _mm256_mul_pd(x, _mm256_set1_pd(4503599627370496.0)), tiny);
+  __m256i bits = _mm256_castpd_si256(xs);
+  __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+  __m256d e, m, big, f, s, z, p, h, res;
+  int i;
+  e = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic));
+  e = _mm256_sub_pd(e, _mm256_set1_pd(4503599627370496.0 + 1023.0));
+  e = _mm256_sub_pd(e, _mm256_and_pd(tiny, _mm256_set1_pd(52.0)));
+  m = _mm256_or_pd(_mm256_and_pd(xs, _mm256_castsi256_pd(_mm256_set1_epi64x(0x000fffffffffffffLL))), one);
+  big = _mm256_cmp_pd(m, _mm256_set1_pd(1.41421356237309504880), _CMP_GT_OQ);
+  m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+  e = _mm256_add_pd(e, _mm256_and_pd(big, one));
+  f = _mm256_sub_pd(m, one);
+  s = _mm256_div_pd(f, _mm256_add_pd(f, _mm256_set1_pd(2.0)));
+  z = _mm256_mul_pd(s, s);
+  p = _mm256_set1_pd(c[0]);
+  for (i=1; i<10; i++)
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(c[i]));
+  p = _mm256_mul_pd(p, z);
+  h = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+  p = _mm256_fmadd_pd(s, _mm256_add_pd(h, p), _mm256_mul_pd(e, _mm256_set1_pd(1.90821492927058770002e-10)));
+  res = _mm256_sub_pd(_mm256_mul_pd(e, _mm256_set1_pd(6.93147180369123816490e-01)), _mm256_sub_pd(_mm256_sub_pd(h, p), f));
+  res = _mm256_blendv_pd(res, x, _mm256_cmp_pd(x, _mm256_set1_pd(INFINITY), _CMP_EQ_OQ));
+  res = _mm256_blendv_pd(res, _mm256_set1_pd(-INFINITY), _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+  return _mm256_or_pd(res, invalid);
+}
+
+static inline __m256 THFloatVector_logvec_AVX2(__m256 x) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 invalid = _mm256_cmp_ps(x, zero, _CMP_NGE_UQ); /* x < 0 or nan */
+  __m256 tiny = _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_LT_OQ);
+  __m256 xs = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), tiny);
+  __m256i bits = _mm256_castps_si256(xs);
+  __m256 e, m, big, f, s, z, p, h, res;
+  e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+  e = _mm256_sub_ps(e, _mm256_and_ps(tiny, _mm256_set1_ps(23.0f)));
+  m = _mm256_or_ps(_mm256_and_ps(xs, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))), one);
+  big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+  m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+  e = _mm256_add_ps(e, _mm256_and_ps(big, one));
+  f = _mm256_sub_ps(m, one);
+  s = _mm256_div_ps(f, _mm256_add_ps(f, _mm256_set1_ps(2.0f)));
+  z = _mm256_mul_ps(s, s);
+  p = _mm256_set1_ps(2.0f/9);
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(2.0f/7));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(2.0f/5));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(2.0f/3));
+  p = _mm256_mul_ps(p, z);
+  h = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), f), f);
+  p = _mm256_fmadd_ps(s, _mm256_add_ps(h, p), _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+  res = _mm256_sub_ps(_mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)), _mm256_sub_ps(_mm256_sub_ps(h, p), f));
+  res = _mm256_blendv_ps(res, x, _mm256_cmp_ps(x, _mm256_set1_ps(INFINITY), _CMP_EQ_OQ));
+  res = _mm256_blendv_ps(res, _mm256_set1_ps(-INFINITY), _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+  return _mm256_or_ps(res, invalid);
+}
+
+static inline __m256d THDoubleVector_tanhvec_AVX2(__m256d x) {
+  __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d ax = _mm256_andnot_pd(sign, x);
+  __m256d z = _mm256_mul_pd(x, x);
+  __m256d p, q, small, large;
+  p = _mm256_set1_pd(-9.64399179425052238628E-1);
+  p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(-9.92877231001918586564E1));
+  p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(-1.61468768441708447952E3));
+  q = _mm256_add_pd(z, _mm256_set1_pd(1.12811678491632931402E2));
+  q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(2.23548839060100448583E3));
+  q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(4.84406305325125486048E3));
+  small = _mm256_add_pd(x, _mm256_mul_pd(_mm256_mul_pd(x, z), _mm256_div_pd(p, q)));
+  large = THDoubleVector_expvec_AVX2(_mm256_add_pd(ax, ax));
+  large = _mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(large, _mm256_set1_pd(1.0))));
+  large = _mm256_or_pd(large, _mm256_and_pd(x, sign));
+  return _mm256_blendv_pd(large, small, _mm256_cmp_pd(ax, _mm256_set1_pd(0.625), _CMP_LT_OQ));
+}
+
+static inline __m256 THFloatVector_tanhvec_AVX2(__m256 x) {
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 ax = _mm256_andnot_ps(sign, x);
+  __m256 z = _mm256_mul_ps(x, x);
+  __m256 p, small, large;
+  p = _mm256_set1_ps(-5.70498872745e-3f);
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(2.06390887954e-2f));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(-5.37397155531e-2f));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(1.33314422036e-1f));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(-3.33332819422e-1f));
+  small = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x, z), p));
+  large = THFloatVector_expvec_AVX2(_mm256_add_ps(ax, ax));
+  large = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(large, _mm256_set1_ps(1.0f))));
+  large = _mm256_or_ps(large, _mm256_and_ps(x, sign));
+  return _mm256_blendv_ps(large, small, _mm256_cmp_ps(ax, _mm256_set1_ps(0.625f), _CMP_LT_OQ));
+}
+
+static inline __m256d THDoubleVector_sigmoidvec_AVX2(__m256d x) {
+  __m256d e = THDoubleVector_expvec_AVX2(_mm256_or_pd(x, _mm256_set1_pd(-0.0)));
+  __m256d r = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_add_pd(_mm256_set1_pd(1.0), e));
+  return _mm256_blendv_pd(r, _mm256_mul_pd(e, r), _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ));
+}
+
+static inline __m256 THFloatVector_sigmoidvec_AVX2(__m256 x) {
+  __m256 e = THFloatVector_expvec_AVX2(_mm256_or_ps(x, _mm256_set1_ps(-0.0f)));
+  __m256 r = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(1.0f), e));
+  return _mm256_blendv_ps(r, _mm256_mul_ps(e, r), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+}
+
+static inline __m256d THDoubleVector_rsqrtvec_AVX2(__m256d x) {
+  return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(x));
+}
+
+static inline __m256 THFloatVector_rsqrtvec_AVX2(__m256 x) {
+  return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(x));
+}
+
+/* the tail goes through the vector code too, from a padded copy */
+#define THVector_UNARY_AVX2(TYPE, NAME, REAL, WIDTH, LOADU, STOREU)         \
+  void TH##TYPE##Vector_##NAME##_AVX2(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    ptrdiff_t i, j;                                                         \
+    REAL buf[WIDTH];                                                        \
+    for (i=0; i<=((n)-WIDTH); i+=WIDTH) {                                   \
+      STOREU(y+i, TH##TYPE##Vector_##NAME##vec_AVX2(LOADU(x+i)));           \
+    }                                                                       \
+    if (i < n) {                                                            \
+      for (j=0; j<WIDTH; j++)                                               \
+        buf[j] = (i+j < n ? x[i+j] : 0);                                    \
+      STOREU(buf, TH##TYPE##Vector_##NAME##vec_AVX2(LOADU(buf)));           \
+      for (j=0; i+j<n; j++)                                                 \
+        y[i+j] = buf[j];                                                    \
+    }                                                                       \
+  }
+
+THVector_UNARY_AVX2(Double, exp, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX2(Double, log, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX2(Double, tanh, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX2(Double, sigmoid, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX2(Double, rsqrt, double, 4, _mm256_loadu_pd, _mm256_storeu_pd)
+THVector_UNARY_AVX2(Float, exp, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX2(Float, log, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX2(Float, tanh, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX2(Float, sigmoid, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+THVector_UNARY_AVX2(Float, rsqrt, float, 8, _mm256_loadu_ps, _mm256_storeu_ps)
+
+#undef THVector_UNARY_AVX2
+
+/* Integer types: arithmetic wraps around, as in the scalar code.
+ * There is no 8-bit nor 64-bit low multiply: they are built from 16-bit
+ * and 32x32->64-bit ones. */
+
+static inline __m256i THVector_mullo_epi8_AVX2(__m256i a, __m256i b) {
+  __m256i even = _mm256_mullo_epi16(a, b);
+  __m256i odd = _mm256_mullo_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+  return _mm256_or_si256(_mm256_slli_epi16(odd, 8), _mm256_and_si256(even, _mm256_set1_epi16(0xff)));
+}
+
+static inline __m256i THVector_mullo_epi64_AVX2(__m256i a, __m256i b) {
+  __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                   _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+#define THVector_INTEGER_AVX2(TYPE, REAL, WIDTH, SET1, ADD, MUL)            \
+  void TH##TYPE##Vector_fill_AVX2(REAL *x, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m256i YMM0 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      _mm256_storeu_si256((__m256i *)(x+i), YMM0);                          \
+      _mm256_storeu_si256((__m256i *)(x+i+WIDTH), YMM0);                    \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      x[i] = c;                                                             \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  void TH##TYPE##Vector_copy_AVX2(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m256i YMM0 = _mm256_loadu_si256((const __m256i *)(x+i));            \
+      __m256i YMM1 = _mm256_loadu_si256((const __m256i *)(x+i+WIDTH));      \
+      _mm256_storeu_si256((__m256i *)(y+i), YMM0);                          \
+      _mm256_storeu_si256((__m256i *)(y+i+WIDTH), YMM1);                    \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y[i] = x[i];                                                          \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  void TH##TYPE##Vector_cadd_AVX2(REAL *z, const REAL *x, const REAL *y, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m256i YMM7 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m256i YMM0 = _mm256_loadu_si256((const __m256i *)(x+i));            \
+      __m256i YMM1 = _mm256_loadu_si256((const __m256i *)(y+i));            \
+      __m256i YMM2 = _mm256_loadu_si256((const __m256i *)(x+i+WIDTH));      \
+      __m256i YMM3 = _mm256_loadu_si256((const __m256i *)(y+i+WIDTH));      \
+      _mm256_storeu_si256((__m256i *)(z+i), ADD(YMM0, MUL(YMM1, YMM7)));    \
+      _mm256_storeu_si256((__m256i *)(z+i+WIDTH), ADD(YMM2, MUL(YMM3, YMM7))); \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      z[i] = x[i] + c * y[i];                                               \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  void TH##TYPE##Vector_adds_AVX2(REAL *y, const REAL *x, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m256i YMM7 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m256i YMM0 = _mm256_loadu_si256((const __m256i *)(x+i));            \
+      __m256i YMM1 = _mm256_loadu_si256((const __m256i *)(x+i+WIDTH));      \
+      _mm256_storeu_si256((__m256i *)(y+i), ADD(YMM0, YMM7));               \
+      _mm256_storeu_si256((__m256i *)(y+i+WIDTH), ADD(YMM1, YMM7));         \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y[i] = x[i] + c;                                                      \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  void TH##TYPE##Vector_cmul_AVX2(REAL *z, const REAL *x, const REAL *y, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m256i YMM0 = _mm256_loadu_si256((const __m256i *)(x+i));            \
+      __m256i YMM1 = _mm256_loadu_si256((const __m256i *)(y+i));            \
+      __m256i YMM2 = _mm256_loadu_si256((const __m256i *)(x+i+WIDTH));      \
+      __m256i YMM3 = _mm256_loadu_si256((const __m256i *)(y+i+WIDTH));      \
+      _mm256_storeu_si256((__m256i *)(z+i), MUL(YMM0, YMM1));               \
+      _mm256_storeu_si256((__m256i *)(z+i+WIDTH), MUL(YMM2, YMM3));         \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      z[i] = x[i] * y[i];                                                   \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  void TH##TYPE##Vector_muls_AVX2(REAL *y, const REAL *x, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m256i YMM7 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m256i YMM0 = _mm256_loadu_si256((const __m256i *)(x+i));            \
+      __m256i YMM1 = _mm256_loadu_si256((const __m256i *)(x+i+WIDTH));      \
+      _mm256_storeu_si256((__m256i *)(y+i), MUL(YMM0, YMM7));               \
+      _mm256_storeu_si256((__m256i *)(y+i+WIDTH), MUL(YMM1, YMM7));         \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y[i] = x[i] * c;                                                      \
+    }                                                                       \
+  }
+
+#define THVector_set1_epi8_AVX2(c) _mm256_set1_epi8((char)(c))
+#define THVector_set1_epi16_AVX2(c) _mm256_set1_epi16((short)(c))
+#define THVector_set1_epi32_AVX2(c) _mm256_set1_epi32((int)(c))
+#define THVector_set1_epi64_AVX2(c) _mm256_set1_epi64x((long long)(c))
+
+THVector_INTEGER_AVX2(Byte, unsigned char, 32, THVector_set1_epi8_AVX2, _mm256_add_epi8, THVector_mullo_epi8_AVX2)
+THVector_INTEGER_AVX2(Char, char, 32, THVector_set1_epi8_AVX2, _mm256_add_epi8, THVector_mullo_epi8_AVX2)
+THVector_INTEGER_AVX2(Short, short, 16, THVector_set1_epi16_AVX2, _mm256_add_epi16, _mm256_mullo_epi16)
+THVector_INTEGER_AVX2(Int, int, 8, THVector_set1_epi32_AVX2, _mm256_add_epi32, _mm256_mullo_epi32)
+#if LONG_MAX == INT_MAX
+THVector_INTEGER_AVX2(Long, long, 8, THVector_set1_epi32_AVX2, _mm256_add_epi32, _mm256_mullo_epi32)
+#else
+THVector_INTEGER_AVX2(Long, long, 4, THVector_set1_epi64_AVX2, _mm256_add_epi64, THVector_mullo_epi64_AVX2)
+#endif
+
+#undef THVector_set1_epi8_AVX2
+#undef THVector_set1_epi16_AVX2
+#undef THVector_set1_epi32_AVX2
+#undef THVector_set1_epi64_AVX2
+#undef THVector_INTEGER_AVX2
+
+/* Byte order reversal: a byte shuffle within each 128-bit lane, the
+ * elements never cross lanes */
+
+#define THVector_SWAPBYTES_AVX2(TYPE, REAL, MASK)                           \
+  void TH##TYPE##Vector_swapBytes_AVX2(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    const ptrdiff_t width = 32/sizeof(REAL);                                \
+    const __m256i YMM7 = MASK;                                              \
+    ptrdiff_t i;                                                            \
+    size_t b;                                                               \
+    for (i=0; i<=((n)-2*width); i+=2*width) {                               \
+      __m256i YMM0 = _mm256_loadu_si256((const __m256i *)(x+i));            \
+      __m256i YMM1 = _mm256_loadu_si256((const __m256i *)(x+i+width));      \
+      _mm256_storeu_si256((__m256i *)(y+i), _mm256_shuffle_epi8(YMM0, YMM7)); \
+      _mm256_storeu_si256((__m256i *)(y+i+width), _mm256_shuffle_epi8(YMM1, YMM7)); \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      REAL v = x[i];                                                        \
+      for (b=0; b<sizeof(REAL); b++) {                                      \
+        ((unsigned char *)(y+i))[b] = ((unsigned char *)&v)[sizeof(REAL)-1-b]; \
+      }                                                                     \
+    }                                                                       \
+  }
+
+#define THVector_swapMask16_AVX2 _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, \
+                                                  1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+#define THVector_swapMask32_AVX2 _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, \
+                                                  3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+#define THVector_swapMask64_AVX2 _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, \
+                                                  7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+
+THVector_SWAPBYTES_AVX2(Short, short, THVector_swapMask16_AVX2)
+THVector_SWAPBYTES_AVX2(Int, int, THVector_swapMask32_AVX2)
+THVector_SWAPBYTES_AVX2(Float, float, THVector_swapMask32_AVX2)
+THVector_SWAPBYTES_AVX2(Double, double, THVector_swapMask64_AVX2)
+#if LONG_MAX == INT_MAX
+THVector_SWAPBYTES_AVX2(Long, long, THVector_swapMask32_AVX2)
+#else
+THVector_SWAPBYTES_AVX2(Long, long, THVector_swapMask64_AVX2)
+#endif
+
+#undef THVector_swapMask16_AVX2
+#undef THVector_swapMask32_AVX2
+#undef THVector_swapMask64_AVX2
+#undef THVector_SWAPBYTES_AVX2
+
 #endif // defined(__AVX2__)
@@ -5,5 +5,52 @@
 
 void THDoubleVector_cadd_AVX2(double *z, const double *x, const double *y, const double c, const ptrdiff_t n);
 void THFloatVector_cadd_AVX2(float *z, const float *x, const float *y, const float c, const ptrdiff_t n);
+void THDoubleVector_gemmTile_AVX2(double *c, const ptrdiff_t ldc, const double *a, const double *b, const double alpha, const ptrdiff_t k);
+void THFloatVector_gemmTile_AVX2(float *c, const ptrdiff_t ldc, const float *a, const float *b, const float alpha, const ptrdiff_t k);
+void THDoubleVector_exp_AVX2(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_log_AVX2(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_tanh_AVX2(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_sigmoid_AVX2(double *y, const double *x, const ptrdiff_t n);
+void THDoubleVector_rsqrt_AVX2(double *y, const double *x, const ptrdiff_t n);
+void THFloatVector_exp_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_log_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_tanh_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_sigmoid_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_rsqrt_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THByteVector_fill_AVX2(unsigned char *x, const unsigned char c, const ptrdiff_t n);
+void THByteVector_copy_AVX2(unsigned char *y, const unsigned char *x, const ptrdiff_t n);
+void THByteVector_cadd_AVX2(unsigned char *z, const unsigned char *x, const unsigned char *y, const unsigned char c, const ptrdiff_t n);
+void THByteVector_adds_AVX2(unsigned char *y, const unsigned char *x, const unsigned char c, const ptrdiff_t n);
+void THByteVector_cmul_AVX2(unsigned char *z, const unsigned char *x, const unsigned char *y, const ptrdiff_t n);
+void THByteVector_muls_AVX2(unsigned char *y, const unsigned char *x, const unsigned char c, const ptrdiff_t n);
+void THCharVector_fill_AVX2(char *x, const char c, const ptrdiff_t n);
+void THCharVector_copy_AVX2(char *y, const char *x, const ptrdiff_t n);
+void THCharVector_cadd_AVX2(char *z, const char *x, const char *y, const char c, const ptrdiff_t n);
+void THCharVector_adds_AVX2(char *y, const char *x, const char c, const ptrdiff_t n);
+void THCharVector_cmul_AVX2(char *z, const char *x, const char *y, const ptrdiff_t n);
+void THCharVector_muls_AVX2(char *y, const char *x, const char c, const ptrdiff_t n);
+void THShortVector_fill_AVX2(short *x, const short c, const ptrdiff_t n);
+void THShortVector_copy_AVX2(short *y, const short *x, const ptrdiff_t n);
+void THShortVector_cadd_AVX2(short *z, const short *x, const short *y, const short c, const ptrdiff_t n);
+void THShortVector_adds_AVX2(short *y, const short *x, const short c, const ptrdiff_t n);
+void THShortVector_cmul_AVX2(short *z, const short *x, const short *y, const ptrdiff_t n);
+void THShortVector_muls_AVX2(short *y, const short *x, const short c, const ptrdiff_t n);
+void THIntVector_fill_AVX2(int *x, const int c, const ptrdiff_t n);
+void THIntVector_copy_AVX2(int *y, const int *x, const ptrdiff_t n);
+void THIntVector_cadd_AVX2(int *z, const int *x, const int *y, const int c, const ptrdiff_t n);
+void THIntVector_adds_AVX2(int *y, const int *x, const int c, const ptrdiff_t n);
+void THIntVector_cmul_AVX2(int *z, const int *x, const int *y, const ptrdiff_t n);
+void THIntVector_muls_AVX2(int *y, const int *x, const int c, const ptrdiff_t n);
+void THLongVector_fill_AVX2(long *x, const long c, const ptrdiff_t n);
+void THLongVector_copy_AVX2(long *y, const long *x, const ptrdiff_t n);
+void THLongVector_cadd_AVX2(long *z, const long *x, const long *y, const long c, const ptrdiff_t n);
+void THLongVector_adds_AVX2(long *y, const long *x, const long c, const ptrdiff_t n);
+void THLongVector_cmul_AVX2(long *z, const long *x, const long *y, const ptrdiff_t n);
+void THLongVector_muls_AVX2(long *y, const long *x, const long c, const ptrdiff_t n);
+void THShortVector_swapBytes_AVX2(short *y, const short *x, const ptrdiff_t n);
+void THIntVector_swapBytes_AVX2(int *y, const int *x, const ptrdiff_t n);
+void THLongVector_swapBytes_AVX2(long *y, const long *x, const ptrdiff_t n);
+void THFloatVector_swapBytes_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THDoubleVector_swapBytes_AVX2(double *y, const double *x, const ptrdiff_t n);
 
 #endif
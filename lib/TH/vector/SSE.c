@@ -3,6 +3,7 @@
 #else
 #include <intrin.h>
 #endif
+#include <limits.h>
 
 static void THDoubleVector_fill_SSE(double *x, const double c, const ptrdiff_t n) {
   ptrdiff_t i;
@@ -266,3 +267,467 @@ static void THFloatVector_divs_SSE(float *y, const float *x, const float c, cons
     y[i] = x[i] / c;
   }
 }
+
+/* 8x6 tile, in two passes of 4 rows (the 24 accumulators would not fit) */
+static void THDoubleVector_gemmTile_SSE(double *c, const ptrdiff_t ldc, const double *a, const double *b, const double alpha, const ptrdiff_t k) {
+  ptrdiff_t l;
+  int h, j;
+  __m128d XMMALPHA = _mm_set1_pd(alpha);
+  for (h=0; h<8; h+=4) {
+    const double *ap = a+h;
+    const double *bp = b;
+    __m128d C0[6], C1[6];
+    for (j=0; j<6; j++) {
+      C0[j] = _mm_setzero_pd();
+      C1[j] = _mm_setzero_pd();
+    }
+    for (l=0; l<k; l++) {
+      __m128d XMM0 = _mm_loadu_pd(ap);
+      __m128d XMM1 = _mm_loadu_pd(ap+2);
+      for (j=0; j<6; j++) {
+        __m128d XMM2 = _mm_set1_pd(bp[j]);
+        C0[j] = _mm_add_pd(C0[j], _mm_mul_pd(XMM0, XMM2));
+        C1[j] = _mm_add_pd(C1[j], _mm_mul_pd(XMM1, XMM2));
+      }
+      ap += 8;
+      bp += 6;
+    }
+    for (j=0; j<6; j++) {
+      double *cp = c+j*ldc+h;
+      _mm_storeu_pd(cp, _mm_add_pd(_mm_loadu_pd(cp), _mm_mul_pd(XMMALPHA, C0[j])));
+      _mm_storeu_pd(cp+2, _mm_add_pd(_mm_loadu_pd(cp+2), _mm_mul_pd(XMMALPHA, C1[j])));
+    }
+  }
+}
+
+/* 16x6 tile, in two passes of 8 rows */
+static void THFloatVector_gemmTile_SSE(float *c, const ptrdiff_t ldc, const float *a, const float *b, const float alpha, const ptrdiff_t k) {
+  ptrdiff_t l;
+  int h, j;
+  __m128 XMMALPHA = _mm_set1_ps(alpha);
+  for (h=0; h<16; h+=8) {
+    const float *ap = a+h;
+    const float *bp = b;
+    __m128 C0[6], C1[6];
+    for (j=0; j<6; j++) {
+      C0[j] = _mm_setzero_ps();
+      C1[j] = _mm_setzero_ps();
+    }
+    for (l=0; l<k; l++) {
+      __m128 XMM0 = _mm_loadu_ps(ap);
+      __m128 XMM1 = _mm_loadu_ps(ap+4);
+      for (j=0; j<6; j++) {
+        __m128 XMM2 = _mm_set1_ps(bp[j]);
+        C0[j] = _mm_add_ps(C0[j], _mm_mul_ps(XMM0, XMM2));
+        C1[j] = _mm_add_ps(C1[j], _mm_mul_ps(XMM1, XMM2));
+      }
+      ap += 16;
+      bp += 6;
+    }
+    for (j=0; j<6; j++) {
+      float *cp = c+j*ldc+h;
+      _mm_storeu_ps(cp, _mm_add_ps(_mm_loadu_ps(cp), _mm_mul_ps(XMMALPHA, C0[j])));
+      _mm_storeu_ps(cp+4, _mm_add_ps(_mm_loadu_ps(cp+4), _mm_mul_ps(XMMALPHA, C1[j])));
+    }
+  }
+}
+
+/* Transcendental functions, 2 doubles or 4 floats at a time.
+ * exp: x = n*log(2) + r with |r| <= log(2)/2, exp(r) by a polynomial
+ *      (Taylor for double, Cephes for float), times 2^n applied as two
+ *      factors so that subnormal results are reached
+ * log: x = m*2^e with m in [sqrt(1/2), sqrt(2)), log(m) = 2*atanh(s)
+ *      with s = (m-1)/(m+1), by its odd series
+ * tanh: Cephes rational/polynomial below 0.625, 1 - 2/(exp(2|x|)+1) above
+ * sigmoid: 1/(1+exp(-x)), as exp(x)/(1+exp(x)) for x < 0
+ * Blends use and/andnot/or: only SSE2 is assumed here.
+ * The double log is left to libm: with 2 lanes and a division it is no
+ * faster. */
+
+static inline __m128d THDoubleVector_select_SSE(__m128d mask, __m128d a, __m128d b) {
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+static inline __m128 THFloatVector_select_SSE(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128d THDoubleVector_expvec_SSE(__m128d x) {
+  static const double c[] = {1.0/6227020800.0, 1.0/479001600.0, 1.0/39916800.0, 1.0/3628800.0,
+                             1.0/362880.0, 1.0/40320.0, 1.0/5040.0, 1.0/720.0, 1.0/120.0,
+                             1.0/24.0, 1.0/6.0, 1.0/2.0};
+  __m128d n, r, p;
+  __m128i k, h, bias = _mm_set1_epi32(1023), zero = _mm_setzero_si128();
+  int i;
+  x = _mm_min_pd(_mm_set1_pd(710.0), _mm_max_pd(_mm_set1_pd(-746.0), x));
+  k = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(1.4426950408889634074)));
+  n = _mm_cvtepi32_pd(k);
+  r = _mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(6.93145751953125E-1)));
+  r = _mm_sub_pd(r, _mm_mul_pd(n, _mm_set1_pd(1.42860682030941723212E-6)));
+  p = _mm_set1_pd(c[0]);
+  for (i=1; i<12; i++)
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(c[i]));
+  p = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(p, r), r), r);
+  p = _mm_add_pd(p, _mm_set1_pd(1.0));
+  h = _mm_srai_epi32(k, 1);
+  k = _mm_sub_epi32(k, h);
+  h = _mm_slli_epi64(_mm_unpacklo_epi32(_mm_add_epi32(h, bias), zero), 52);
+  k = _mm_slli_epi64(_mm_unpacklo_epi32(_mm_add_epi32(k, bias), zero), 52);
+  p = _mm_mul_pd(p, _mm_castsi128_pd(h));
+  return _mm_mul_pd(p, _mm_castsi128_pd(k));
+}
+
+static inline __m128 THFloatVector_expvec_SSE(__m128 x) {
+  __m128 n, r, p;
+  __m128i k, h, bias = _mm_set1_epi32(127);
+  x = _mm_min_ps(_mm_set1_ps(89.0f), _mm_max_ps(_mm_set1_ps(-105.0f), x));
+  k = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)));
+  n = _mm_cvtepi32_ps(k);
+  r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+  r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+  p = _mm_set1_ps(1.9875691500e-4f);
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.3981999507e-3f));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.3334519073e-3f));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.1665795894e-2f));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.6666665459e-1f));
+  p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.0000001201e-1f));
+  p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r);
+  p = _mm_add_ps(p, _mm_set1_ps(1.0f));
+  h = _mm_srai_epi32(k, 1);
+  k = _mm_sub_epi32(k, h);
+  h = _mm_slli_epi32(_mm_add_epi32(h, bias), 23);
+  k = _mm_slli_epi32(_mm_add_epi32(k, bias), 23);
+  p = _mm_mul_ps(p, _mm_castsi128_ps(h));
+  return _mm_mul_ps(p, _mm_castsi128_ps(k));
+}
+
+static inline __m128d THDoubleVector_logvec_SSE(__m128d x) {
+  static const double c[] = {2.0/21, 2.0/19, 2.0/17, 2.0/15, 2.0/13, 2.0/11, 2.0/9, 2.0/7, 2.0/5, 2.0/3};
+  __m128d one = _mm_set1_pd(1.0);
+  __m128d zero = _mm_setzero_pd();
+  __m128d invalid = _mm_or_pd(_mm_cmplt_pd(x, zero), _mm_cmpunord_pd(x, x));
+  __m128d tiny = _mm_cmplt_pd(x, _mm_set1_pd(2.2250738585072014e-308));
+  __m128d xs = THDoubleVector_select_SSE(tiny, _mm_mul_pd(x, _mm_set1_pd(4503599627370496.0)), x);
+  __m128i bits = _mm_castpd_si128(xs);
+  __m128d e, m, big, f, s, z, p, h, res;
+  int i;
+  /* exponent bits below 2^52, as a double */
+  e = _mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52), _mm_set1_epi64x(0x4330000000000000LL)));
+  e = _mm_sub_pd(e, _mm_set1_pd(4503599627370496.0 + 1023.0));
+  e = _mm_sub_pd(e, _mm_and_pd(tiny, _mm_set1_pd(52.0)));
+  m = _mm_or_pd(_mm_and_pd(xs, _mm_castsi128_pd(_mm_set1_epi64x(0x000fffffffffffffLL))), one);
+  big = _mm_cmpgt_pd(m, _mm_set1_pd(1.41421356237309504880));
+  m = THDoubleVector_select_SSE(big, _mm_mul_pd(m, _mm_set1_pd(0.5)), m);
+  e = _mm_add_pd(e, _mm_and_pd(big, one));
+  f = _mm_sub_pd(m, one);
+  s = _mm_div_pd(f, _mm_add_pd(f, _mm_set1_pd(2.0)));
+  z = _mm_mul_pd(s, s);
+  p = _mm_set1_pd(c[0]);
+  for (i=1; i<10; i++)
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(c[i]));
+  p = _mm_mul_pd(p, z);
+  h = _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(0.5), f), f);
+  p = _mm_add_pd(_mm_mul_pd(s, _mm_add_pd(h, p)), _mm_mul_pd(e, _mm_set1_pd(1.90821492927058770002e-10)));
+  res = _mm_sub_pd(_mm_mul_pd(e, _mm_set1_pd(6.93147180369123816490e-01)), _mm_sub_pd(_mm_sub_pd(h, p), f));
+  res = THDoubleVector_select_SSE(_mm_cmpeq_pd(x, _mm_set1_pd(INFINITY)), x, res);
+  res = THDoubleVector_select_SSE(_mm_cmpeq_pd(x, zero), _mm_set1_pd(-INFINITY), res);
+  return _mm_or_pd(res, invalid);
+}
+
+static inline __m128 THFloatVector_logvec_SSE(__m128 x) {
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 zero = _mm_setzero_ps();
+  __m128 invalid = _mm_or_ps(_mm_cmplt_ps(x, zero), _mm_cmpunord_ps(x, x));
+  __m128 tiny = _mm_cmplt_ps(x, _mm_set1_ps(1.17549435e-38f));
+  __m128 xs = THFloatVector_select_SSE(tiny, _mm_mul_ps(x, _mm_set1_ps(8388608.0f)), x);
+  __m128i bits = _mm_castps_si128(xs);
+  __m128 e, m, big, f, s, z, p, h, res;
+  e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+  e = _mm_sub_ps(e, _mm_and_ps(tiny, _mm_set1_ps(23.0f)));
+  m = _mm_or_ps(_mm_and_ps(xs, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff))), one);
+  big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+  m = THFloatVector_select_SSE(big, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+  e = _mm_add_ps(e, _mm_and_ps(big, one));
+  f = _mm_sub_ps(m, one);
+  s = _mm_div_ps(f, _mm_add_ps(f, _mm_set1_ps(2.0f)));
+  z = _mm_mul_ps(s, s);
+  p = _mm_set1_ps(2.0f/9);
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(2.0f/7));
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(2.0f/5));
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(2.0f/3));
+  p = _mm_mul_ps(p, z);
+  h = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), f), f);
+  p = _mm_add_ps(_mm_mul_ps(s, _mm_add_ps(h, p)), _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+  res = _mm_sub_ps(_mm_mul_ps(e, _mm_set1_ps(0.693359375f)), _mm_sub_ps(_mm_sub_ps(h, p), f));
+  res = THFloatVector_select_SSE(_mm_cmpeq_ps(x, _mm_set1_ps(INFINITY)), x, res);
+  res = THFloatVector_select_SSE(_mm_cmpeq_ps(x, zero), _mm_set1_ps(-INFINITY), res);
+  return _mm_or_ps(res, invalid);
+}
+
+static inline __m128d THDoubleVector_tanhvec_SSE(__m128d x) {
+  __m128d sign = _mm_set1_pd(-0.0);
+  __m128d ax = _mm_andnot_pd(sign, x);
+  __m128d z = _mm_mul_pd(x, x);
+  __m128d p, q, small, large;
+  p = _mm_set1_pd(-9.64399179425052238628E-1);
+  p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-9.92877231001918586564E1));
+  p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(-1.61468768441708447952E3));
+  q = _mm_add_pd(z, _mm_set1_pd(1.12811678491632931402E2));
+  q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(2.23548839060100448583E3));
+  q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(4.84406305325125486048E3));
+  small = _mm_add_pd(x, _mm_mul_pd(_mm_mul_pd(x, z), _mm_div_pd(p, q)));
+  large = THDoubleVector_expvec_SSE(_mm_add_pd(ax, ax));
+  large = _mm_sub_pd(_mm_set1_pd(1.0), _mm_div_pd(_mm_set1_pd(2.0), _mm_add_pd(large, _mm_set1_pd(1.0))));
+  large = _mm_or_pd(large, _mm_and_pd(x, sign));
+  return THDoubleVector_select_SSE(_mm_cmplt_pd(ax, _mm_set1_pd(0.625)), small, large);
+}
+
+static inline __m128 THFloatVector_tanhvec_SSE(__m128 x) {
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 ax = _mm_andnot_ps(sign, x);
+  __m128 z = _mm_mul_ps(x, x);
+  __m128 p, small, large;
+  p = _mm_set1_ps(-5.70498872745e-3f);
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(2.06390887954e-2f));
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-5.37397155531e-2f));
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.33314422036e-1f));
+  p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-3.33332819422e-1f));
+  small = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, z), p));
+  large = THFloatVector_expvec_SSE(_mm_add_ps(ax, ax));
+  large = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_div_ps(_mm_set1_ps(2.0f), _mm_add_ps(large, _mm_set1_ps(1.0f))));
+  large = _mm_or_ps(large, _mm_and_ps(x, sign));
+  return THFloatVector_select_SSE(_mm_cmplt_ps(ax, _mm_set1_ps(0.625f)), small, large);
+}
+
+static inline __m128d THDoubleVector_sigmoidvec_SSE(__m128d x) {
+  __m128d e = THDoubleVector_expvec_SSE(_mm_or_pd(x, _mm_set1_pd(-0.0)));
+  __m128d r = _mm_div_pd(_mm_set1_pd(1.0), _mm_add_pd(_mm_set1_pd(1.0), e));
+  return THDoubleVector_select_SSE(_mm_cmplt_pd(x, _mm_setzero_pd()), _mm_mul_pd(e, r), r);
+}
+
+static inline __m128 THFloatVector_sigmoidvec_SSE(__m128 x) {
+  __m128 e = THFloatVector_expvec_SSE(_mm_or_ps(x, _mm_set1_ps(-0.0f)));
+  __m128 r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_set1_ps(1.0f), e));
+  return THFloatVector_select_SSE(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_mul_ps(e, r), r);
+}
+
+static inline __m128d THDoubleVector_rsqrtvec_SSE(__m128d x) {
+  return _mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(x));
+}
+
+static inline __m128 THFloatVector_rsqrtvec_SSE(__m128 x) {
+  return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x));
+}
+
+/* the tail goes through the vector code too, from a padded copy */
+#define THVector_UNARY_SSE(TYPE, NAME, REAL, WIDTH, LOADU, STOREU)          \
+  static void TH##TYPE##Vector_##NAME##_SSE(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    ptrdiff_t i, j;                                                         \
+    REAL buf[WIDTH];                                                        \
+    for (i=0; i<=((n)-WIDTH); i+=WIDTH) {                                   \
+      STOREU(y+i, TH##TYPE##Vector_##NAME##vec_SSE(LOADU(x+i)));            \
+    }                                                                       \
+    if (i < n) {                                                            \
+      for (j=0; j<WIDTH; j++)                                               \
+        buf[j] = (i+j < n ? x[i+j] : 0);                                    \
+      STOREU(buf, TH##TYPE##Vector_##NAME##vec_SSE(LOADU(buf)));            \
+      for (j=0; i+j<n; j++)                                                 \
+        y[i+j] = buf[j];                                                    \
+    }                                                                       \
+  }
+
+THVector_UNARY_SSE(Double, exp, double, 2, _mm_loadu_pd, _mm_storeu_pd)
+THVector_UNARY_SSE(Double, tanh, double, 2, _mm_loadu_pd, _mm_storeu_pd)
+THVector_UNARY_SSE(Double, sigmoid, double, 2, _mm_loadu_pd, _mm_storeu_pd)
+THVector_UNARY_SSE(Double, rsqrt, double, 2, _mm_loadu_pd, _mm_storeu_pd)
+THVector_UNARY_SSE(Float, exp, float, 4, _mm_loadu_ps, _mm_storeu_ps)
+THVector_UNARY_SSE(Float, log, float, 4, _mm_loadu_ps, _mm_storeu_ps)
+THVector_UNARY_SSE(Float, tanh, float, 4, _mm_loadu_ps, _mm_storeu_ps)
+THVector_UNARY_SSE(Float, sigmoid, float, 4, _mm_loadu_ps, _mm_storeu_ps)
+THVector_UNARY_SSE(Float, rsqrt, float, 4, _mm_loadu_ps, _mm_storeu_ps)
+
+#undef THVector_UNARY_SSE
+
+/* Integer types: arithmetic wraps around, as in the scalar code.
+ * SSE2 has no 8-bit, 32-bit nor 64-bit low multiply: they are built from
+ * 16-bit and 32x32->64-bit ones (SSE4.1 has the 32-bit one). */
+
+static inline __m128i THVector_mullo_epi8_SSE(__m128i a, __m128i b) {
+  __m128i even = _mm_mullo_epi16(a, b);
+  __m128i odd = _mm_mullo_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+  return _mm_or_si128(_mm_slli_epi16(odd, 8), _mm_and_si128(even, _mm_set1_epi16(0xff)));
+}
+
+static inline __m128i THVector_mullo_epi32_SSE(__m128i a, __m128i b) {
+#if defined(__SSE4_1__)
+  return _mm_mullo_epi32(a, b);
+#else
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+static inline __m128i THVector_mullo_epi64_SSE(__m128i a, __m128i b) {
+  __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b),
+                                _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+  return _mm_add_epi64(_mm_mul_epu32(a, b), _mm_slli_epi64(cross, 32));
+}
+
+#define THVector_INTEGER_SSE(TYPE, REAL, WIDTH, SET1, ADD, MUL)             \
+  static void TH##TYPE##Vector_fill_SSE(REAL *x, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m128i XMM0 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      _mm_storeu_si128((__m128i *)(x+i), XMM0);                             \
+      _mm_storeu_si128((__m128i *)(x+i+WIDTH), XMM0);                       \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      x[i] = c;                                                             \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  static void TH##TYPE##Vector_copy_SSE(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x+i));               \
+      __m128i XMM1 = _mm_loadu_si128((const __m128i *)(x+i+WIDTH));         \
+      _mm_storeu_si128((__m128i *)(y+i), XMM0);                             \
+      _mm_storeu_si128((__m128i *)(y+i+WIDTH), XMM1);                       \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y[i] = x[i];                                                          \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  static void TH##TYPE##Vector_cadd_SSE(REAL *z, const REAL *x, const REAL *y, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m128i XMM7 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x+i));               \
+      __m128i XMM1 = _mm_loadu_si128((const __m128i *)(y+i));               \
+      __m128i XMM2 = _mm_loadu_si128((const __m128i *)(x+i+WIDTH));         \
+      __m128i XMM3 = _mm_loadu_si128((const __m128i *)(y+i+WIDTH));         \
+      _mm_storeu_si128((__m128i *)(z+i), ADD(XMM0, MUL(XMM1, XMM7)));       \
+      _mm_storeu_si128((__m128i *)(z+i+WIDTH), ADD(XMM2, MUL(XMM3, XMM7))); \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      z[i] = x[i] + c * y[i];                                               \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  static void TH##TYPE##Vector_adds_SSE(REAL *y, const REAL *x, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m128i XMM7 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x+i));               \
+      __m128i XMM1 = _mm_loadu_si128((const __m128i *)(x+i+WIDTH));         \
+      _mm_storeu_si128((__m128i *)(y+i), ADD(XMM0, XMM7));                  \
+      _mm_storeu_si128((__m128i *)(y+i+WIDTH), ADD(XMM1, XMM7));            \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y[i] = x[i] + c;                                                      \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  static void TH##TYPE##Vector_cmul_SSE(REAL *z, const REAL *x, const REAL *y, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x+i));               \
+      __m128i XMM1 = _mm_loadu_si128((const __m128i *)(y+i));               \
+      __m128i XMM2 = _mm_loadu_si128((const __m128i *)(x+i+WIDTH));         \
+      __m128i XMM3 = _mm_loadu_si128((const __m128i *)(y+i+WIDTH));         \
+      _mm_storeu_si128((__m128i *)(z+i), MUL(XMM0, XMM1));                  \
+      _mm_storeu_si128((__m128i *)(z+i+WIDTH), MUL(XMM2, XMM3));            \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      z[i] = x[i] * y[i];                                                   \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  static void TH##TYPE##Vector_muls_SSE(REAL *y, const REAL *x, const REAL c, const ptrdiff_t n) { \
+    ptrdiff_t i;                                                            \
+    __m128i XMM7 = SET1(c);                                                 \
+    for (i=0; i<=((n)-2*WIDTH); i+=2*WIDTH) {                               \
+      __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x+i));               \
+      __m128i XMM1 = _mm_loadu_si128((const __m128i *)(x+i+WIDTH));         \
+      _mm_storeu_si128((__m128i *)(y+i), MUL(XMM0, XMM7));                  \
+      _mm_storeu_si128((__m128i *)(y+i+WIDTH), MUL(XMM1, XMM7));            \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      y[i] = x[i] * c;                                                      \
+    }                                                                       \
+  }
+
+#define THVector_set1_epi8_SSE(c) _mm_set1_epi8((char)(c))
+#define THVector_set1_epi16_SSE(c) _mm_set1_epi16((short)(c))
+#define THVector_set1_epi32_SSE(c) _mm_set1_epi32((int)(c))
+#define THVector_set1_epi64_SSE(c) _mm_set1_epi64x((long long)(c))
+
+THVector_INTEGER_SSE(Byte, unsigned char, 16, THVector_set1_epi8_SSE, _mm_add_epi8, THVector_mullo_epi8_SSE)
+THVector_INTEGER_SSE(Char, char, 16, THVector_set1_epi8_SSE, _mm_add_epi8, THVector_mullo_epi8_SSE)
+THVector_INTEGER_SSE(Short, short, 8, THVector_set1_epi16_SSE, _mm_add_epi16, _mm_mullo_epi16)
+THVector_INTEGER_SSE(Int, int, 4, THVector_set1_epi32_SSE, _mm_add_epi32, THVector_mullo_epi32_SSE)
+#if LONG_MAX == INT_MAX
+THVector_INTEGER_SSE(Long, long, 4, THVector_set1_epi32_SSE, _mm_add_epi32, THVector_mullo_epi32_SSE)
+#else
+THVector_INTEGER_SSE(Long, long, 2, THVector_set1_epi64_SSE, _mm_add_epi64, THVector_mullo_epi64_SSE)
+#endif
+
+#undef THVector_set1_epi8_SSE
+#undef THVector_set1_epi16_SSE
+#undef THVector_set1_epi32_SSE
+#undef THVector_set1_epi64_SSE
+#undef THVector_INTEGER_SSE
+
+/* Byte order reversal: only the size of the elements counts. SSE2 has no
+ * byte shuffle: 16-bit words are swapped by shifts, after the words of
+ * each element are reversed. */
+
+static inline __m128i THVector_swapBytes16_SSE(__m128i v) {
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i THVector_swapBytes32_SSE(__m128i v) {
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return THVector_swapBytes16_SSE(v);
+}
+
+static inline __m128i THVector_swapBytes64_SSE(__m128i v) {
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  return THVector_swapBytes16_SSE(v);
+}
+
+#define THVector_SWAPBYTES_SSE(TYPE, REAL, SWAP)                            \
+  static void TH##TYPE##Vector_swapBytes_SSE(REAL *y, const REAL *x, const ptrdiff_t n) { \
+    const ptrdiff_t width = 16/sizeof(REAL);                                \
+    ptrdiff_t i;                                                            \
+    size_t b;                                                               \
+    for (i=0; i<=((n)-2*width); i+=2*width) {                               \
+      __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x+i));               \
+      __m128i XMM1 = _mm_loadu_si128((const __m128i *)(x+i+width));         \
+      _mm_storeu_si128((__m128i *)(y+i), SWAP(XMM0));                       \
+      _mm_storeu_si128((__m128i *)(y+i+width), SWAP(XMM1));                 \
+    }                                                                       \
+    for (; i<(n); i++) {                                                    \
+      REAL v = x[i];                                                        \
+      for (b=0; b<sizeof(REAL); b++) {                                      \
+        ((unsigned char *)(y+i))[b] = ((unsigned char *)&v)[sizeof(REAL)-1-b]; \
+      }                                                                     \
+    }                                                                       \
+  }
+
+THVector_SWAPBYTES_SSE(Short, short, THVector_swapBytes16_SSE)
+THVector_SWAPBYTES_SSE(Int, int, THVector_swapBytes32_SSE)
+THVector_SWAPBYTES_SSE(Float, float, THVector_swapBytes32_SSE)
+THVector_SWAPBYTES_SSE(Double, double, THVector_swapBytes64_SSE)
+#if LONG_MAX == INT_MAX
+THVector_SWAPBYTES_SSE(Long, long, THVector_swapBytes32_SSE)
+#else
+THVector_SWAPBYTES_SSE(Long, long, THVector_swapBytes64_SSE)
+#endif
+
+#undef THVector_SWAPBYTES_SSE
@@ -0,0 +1,451 @@
+#include "Archive.h"
+#include "TensorTH.h"
+#include "FileIO.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TH.h"
+#undef THTensor
+
+namespace xt {
+
+// file of an archive: the header, the index (a record per tensor, followed
+// by its sizes (int64_t each) and its name, padded to 8 bytes), zeros up to
+// dataOffset, then the data of the tensors, each at a multiple of kArchiveAlign
+// the checksum of a tensor chains the hashes of its chunks of kArchiveChunk
+// bytes, so that the chunks of a large tensor are written and read by
+// different threads
+
+static const char kArchiveMagic[8] = {'X', 'T', 'A', 'R', 'C', 'H', 'I', 'V'};
+static const uint32_t kArchiveEndian = 0x01020304;
+static const uint32_t kArchiveVersion = 1;
+static const int64_t kArchiveAlign = 64;
+static const int64_t kArchiveMaxDim = 64;
+static const int64_t kArchiveChunk = 256 << 10;
+static const uint32_t kArchiveChecksums = 1; // flags
+
+struct ArchiveHeader
+{
+  char magic[8];
+  uint32_t endian;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t reserved;
+  int64_t count; // tensors
+  int64_t indexSize; // bytes, after the header
+  int64_t dataOffset; // bytes
+  int64_t fileSize; // bytes
+};
+
+struct ArchiveRecord
+{
+  int32_t type; // TensorType
+  int32_t elemSize;
+  int64_t dim;
+  int64_t nameSize; // bytes
+  int64_t offset; // bytes, in the file
+  int64_t size; // bytes
+  uint64_t checksum;
+};
+
+static std::runtime_error archiveError(const std::string& filename, const std::string& what)
+{
+  return std::runtime_error("archive <" + filename + ">: " + what);
+}
+
+static int64_t elementSize(TensorType type)
+{
+  static const int64_t sizes[] = {1, 1, 2, 4, 8, 4, 8};
+  return sizes[type];
+}
+
+static int64_t align(int64_t size)
+{
+  return (size + kArchiveAlign-1)/kArchiveAlign*kArchiveAlign;
+}
+
+static int64_t recordSize(int64_t dim, int64_t nameSize)
+{
+  return sizeof(ArchiveRecord) + std::max<int64_t>(dim, 0)*sizeof(int64_t) + (nameSize+7)/8*8;
+}
+
+static uint64_t chainHash(uint64_t h, uint64_t chunk)
+{
+  return ((h ^ chunk) * 0x100000001b3ULL) ^ (h >> 31);
+}
+
+// Fletcher sums over 8-byte words, in 4 lanes: additions only, which the
+// compiler vectorizes (the hash keeps up with the reads); the order of the
+// words counts, through the second sums
+static uint64_t hashChunk(const char* data, int64_t size)
+{
+  uint64_t a[4] = {1, 2, 3, 4}, b[4] = {0, 0, 0, 0};
+  int64_t i = 0;
+  for(; i+32 <= size; i += 32) {
+    uint64_t w[4];
+    std::memcpy(w, data+i, 32);
+    for(int k = 0; k < 4; k++) {
+      a[k] += w[k];
+      b[k] += a[k];
+    }
+  }
+  uint64_t tail[4] = {0, 0, 0, 0};
+  std::memcpy(tail, data+i, size-i);
+  uint64_t h = (uint64_t)size;
+  for(int k = 0; k < 4; k++) {
+    a[k] += tail[k];
+    b[k] += a[k];
+    h = chainHash(chainHash(h, a[k]), b[k]);
+  }
+  return h;
+}
+
+// a range of the data of a tensor, read or written by one thread
+struct ArchivePiece
+{
+  size_t tensor;
+  int64_t begin; // bytes, in the tensor
+  int64_t size;
+  char* data;
+  int64_t offset; // bytes, in the file
+  uint64_t hash;
+};
+
+static std::vector<ArchivePiece> pieces(size_t tensor, char* data, int64_t offset, int64_t size)
+{
+  std::vector<ArchivePiece> p;
+  for(int64_t begin = 0; begin < size; begin += kArchiveChunk) {
+    int64_t n = std::min(kArchiveChunk, size-begin);
+    p.push_back({tensor, begin, n, data+begin, offset+begin, 0});
+  }
+  return p;
+}
+
+// a call of transfer, shared by the threads of the TH pool
+template<typename F>
+struct ArchiveTransfer
+{
+  std::vector<ArchivePiece>* p;
+  F* io;
+  std::atomic<int> error;
+};
+
+template<typename F>
+static void transferRange(void* data, ptrdiff_t begin, ptrdiff_t end)
+{
+  ArchiveTransfer<F>* t = (ArchiveTransfer<F>*)data;
+  for(ptrdiff_t i = begin; i < end && t->error == 0; i++) {
+    if(!(*t->io)((*t->p)[i])) {
+      int e = errno;
+      t->error = e ? e : EIO;
+    }
+  }
+}
+
+// runs io(piece) over the pieces with up to numThreads threads of the TH
+// pool (0: all of them); io returns false on an error of the system,
+// reported by errno
+template<typename F>
+static void transfer(std::vector<ArchivePiece>& p, int numThreads, const std::string& filename,
+                     const std::string& what, F io)
+{
+  ArchiveTransfer<F> t;
+  t.p = &p;
+  t.io = &io;
+  t.error = 0;
+  // a share of at least p.size()/numThreads pieces per thread
+  ptrdiff_t grain = numThreads > 0 ? ((ptrdiff_t)p.size() + numThreads-1)/numThreads : 1;
+  THParallelFor(0, p.size(), grain, &transferRange<F>, &t);
+  if(t.error != 0) {
+    throw archiveError(filename, what + ": " + std::strerror(t.error));
+  }
+}
+
+static uint64_t checksum(const std::vector<ArchivePiece>& p, size_t first, size_t last)
+{
+  uint64_t h = 0;
+  for(size_t i = first; i < last; i++) {
+    h = chainHash(h, p[i].hash);
+  }
+  return h ? h : 1; // 0: not recorded
+}
+
+void save(const std::string& filename, const std::vector<std::pair<std::string, Tensor>>& tensors,
+          bool checksums, int numThreads)
+{
+  // the data of each tensor, contiguous, and its place in the file
+  std::vector<ArchiveEntry> entries;
+  std::vector<std::shared_ptr<void>> data;
+  std::map<std::string, size_t> names;
+  int64_t indexSize = 0;
+  for(auto& named : tensors) {
+    const Tensor& t = named.second;
+    if(t.device() != kCPU) {
+      throw std::invalid_argument("archive: tensor <" + named.first + "> is not a CPU tensor");
+    }
+    if(!names.insert({named.first, names.size()}).second) {
+      throw std::invalid_argument("archive: tensor <" + named.first + "> given twice");
+    }
+    ArchiveEntry e;
+    e.name = named.first;
+    e.type = t.type();
+    e.dim = t.dim();
+    if(e.dim > kArchiveMaxDim) {
+      throw std::invalid_argument("archive: tensor <" + named.first + "> has too many dimensions");
+    }
+    e.sizes = t.sizes().vec();
+    e.size = e.dim < 0 ? 0 : numel(t)*elementSize(e.type);
+    e.checksum = 0;
+    data.push_back(e.size == 0 ? nullptr : (e.dim > 0 && !isContiguous(t) ? contiguous(t) : t).share());
+    indexSize += recordSize(e.dim, e.name.size());
+    entries.push_back(e);
+  }
+  int64_t offset = align(sizeof(ArchiveHeader) + indexSize);
+  const int64_t dataOffset = offset;
+  std::vector<ArchivePiece> p;
+  std::vector<size_t> firstPiece;
+  for(size_t i = 0; i < entries.size(); i++) {
+    entries[i].offset = offset;
+    std::vector<ArchivePiece> q = pieces(i, (char*)data[i].get(), offset, entries[i].size);
+    firstPiece.push_back(p.size());
+    p.insert(p.end(), q.begin(), q.end());
+    offset = align(offset + entries[i].size);
+  }
+  firstPiece.push_back(p.size());
+  const int64_t fileSize = std::max(offset, dataOffset);
+
+  // written beside the file, then renamed over it: a crash or an error
+  // leaves the previous archive (if any) as it was
+  const std::string temporary = filename + ".tmp";
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0) {
+    throw archiveError(filename, std::string("cannot create: ") + std::strerror(errno));
+  }
+  std::shared_ptr<int> closer(new int(fd), [temporary](int* fd) {
+      if(*fd >= 0) {
+        close(*fd);
+        unlink(temporary.c_str());
+      }
+      delete fd;
+    });
+  if(ftruncate(fd, fileSize) != 0) { // the padding: zeros
+    throw archiveError(filename, std::string("cannot write: ") + std::strerror(errno));
+  }
+  transfer(p, numThreads, filename, "cannot write", [&](ArchivePiece& piece) {
+      if(checksums) {
+        piece.hash = hashChunk(piece.data, piece.size);
+      }
+      return writeAt(fd, piece.data, piece.size, piece.offset);
+    });
+
+  // the index, last: an archive cut short has no valid header
+  std::vector<char> index(dataOffset, 0);
+  ArchiveHeader* header = (ArchiveHeader*)index.data();
+  std::memcpy(header->magic, kArchiveMagic, sizeof(kArchiveMagic));
+  header->endian = kArchiveEndian;
+  header->version = kArchiveVersion;
+  header->flags = checksums ? kArchiveChecksums : 0;
+  header->count = entries.size();
+  header->indexSize = indexSize;
+  header->dataOffset = dataOffset;
+  header->fileSize = fileSize;
+  char* r = index.data() + sizeof(ArchiveHeader);
+  for(size_t i = 0; i < entries.size(); i++) {
+    const ArchiveEntry& e = entries[i];
+    ArchiveRecord record;
+    record.type = e.type;
+    record.elemSize = elementSize(e.type);
+    record.dim = e.dim;
+    record.nameSize = e.name.size();
+    record.offset = e.offset;
+    record.size = e.size;
+    record.checksum = checksums ? checksum(p, firstPiece[i], firstPiece[i+1]) : 0;
+    std::memcpy(r, &record, sizeof(record));
+    std::memcpy(r + sizeof(record), e.sizes.data(), e.sizes.size()*sizeof(int64_t));
+    std::memcpy(r + sizeof(record) + e.sizes.size()*sizeof(int64_t), e.name.data(), e.name.size());
+    r += recordSize(e.dim, e.name.size());
+  }
+  if(!writeAt(fd, index.data(), index.size(), 0) || fsync(fd) != 0) {
+    throw archiveError(filename, std::string("cannot write: ") + std::strerror(errno));
+  }
+  *closer = -1;
+  if(close(fd) != 0 || rename(temporary.c_str(), filename.c_str()) != 0) {
+    int error = errno;
+    unlink(temporary.c_str());
+    throw archiveError(filename, std::string("cannot write: ") + std::strerror(error));
+  }
+}
+
+Archive::Archive(const std::string& filename)
+  : filename_(filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw archiveError(filename, std::string("cannot open: ") + std::strerror(errno));
+  }
+  fd_ = std::shared_ptr<int>(new int(fd), [](int* fd) { close(*fd); delete fd; });
+  struct stat st;
+  ArchiveHeader header;
+  if(fstat(fd, &st) != 0 || !readAt(fd, (char*)&header, sizeof(header), 0)
+     || std::memcmp(header.magic, kArchiveMagic, sizeof(kArchiveMagic))) {
+    throw archiveError(filename, "not an archive");
+  }
+  if(header.endian != kArchiveEndian) {
+    throw archiveError(filename, "written with another byte order");
+  }
+  if(header.version != kArchiveVersion) {
+    throw archiveError(filename, "unsupported version " + std::to_string(header.version));
+  }
+  if(header.fileSize != st.st_size) {
+    throw archiveError(filename, "size does not match its header");
+  }
+  if(header.count < 0 || header.indexSize < 0 || header.dataOffset % kArchiveAlign
+     || header.dataOffset < (int64_t)sizeof(header) + header.indexSize || header.dataOffset > header.fileSize) {
+    throw archiveError(filename, "corrupted header");
+  }
+
+  std::vector<char> index(header.indexSize);
+  if(!readAt(fd, index.data(), index.size(), sizeof(header))) {
+    throw archiveError(filename, "truncated index");
+  }
+  const char* r = index.data();
+  const char* end = r + index.size();
+  for(int64_t i = 0; i < header.count; i++) {
+    ArchiveRecord record;
+    if(end - r < (int64_t)sizeof(record)) {
+      throw archiveError(filename, "corrupted index");
+    }
+    std::memcpy(&record, r, sizeof(record));
+    if(record.type < kUInt8 || record.type > kDouble || record.elemSize != elementSize((TensorType)record.type)
+       || record.dim < -1 || record.dim > kArchiveMaxDim || record.nameSize < 0
+       || record.nameSize > end - r || end - r < recordSize(record.dim, record.nameSize)) {
+      throw archiveError(filename, "corrupted index");
+    }
+    ArchiveEntry e;
+    e.type = (TensorType)record.type;
+    e.dim = record.dim;
+    e.sizes.resize(std::max<int64_t>(record.dim, 0));
+    std::memcpy(e.sizes.data(), r + sizeof(record), e.sizes.size()*sizeof(int64_t));
+    e.name.assign(r + sizeof(record) + e.sizes.size()*sizeof(int64_t), record.nameSize);
+    e.offset = record.offset;
+    e.size = record.size;
+    e.checksum = record.checksum;
+    r += recordSize(record.dim, record.nameSize);
+
+    int64_t n = e.dim < 0 ? 0 : 1;
+    for(int64_t size : e.sizes) {
+      if(size <= 0 || n > (INT64_MAX/size)/record.elemSize) {
+        throw archiveError(filename, "invalid sizes of <" + e.name + ">");
+      }
+      n *= size;
+    }
+    if(e.size != n*record.elemSize || e.offset % kArchiveAlign || e.offset < header.dataOffset
+       || e.offset > header.fileSize - e.size) {
+      throw archiveError(filename, "tensor <" + e.name + "> out of the file");
+    }
+    if(!index_.insert({e.name, entries_.size()}).second) {
+      throw archiveError(filename, "tensor <" + e.name + "> found twice");
+    }
+    entries_.push_back(e);
+  }
+
+  // only address space: pages are read by the tensors of map()
+  void* mapping = mmap(nullptr, header.fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(mapping == MAP_FAILED) {
+    throw archiveError(filename, std::string("cannot map: ") + std::strerror(errno));
+  }
+  int64_t fileSize = header.fileSize;
+  mapping_ = std::shared_ptr<void>(mapping, [fileSize](void* p) { munmap(p, fileSize); });
+}
+
+const std::vector<ArchiveEntry>& Archive::entries() const
+{
+  return entries_;
+}
+
+bool Archive::has(const std::string& name) const
+{
+  return index_.count(name) > 0;
+}
+
+const ArchiveEntry& Archive::entry(const std::string& name) const
+{
+  auto it = index_.find(name);
+  if(it == index_.end()) {
+    throw std::invalid_argument("archive <" + filename_ + ">: no tensor <" + name + ">");
+  }
+  return entries_[it->second];
+}
+
+Tensor Archive::load(const std::string& name) const
+{
+  return load(std::vector<std::string>{name}, 1)[0];
+}
+
+std::vector<Tensor> Archive::load(const std::vector<std::string>& names, int numThreads) const
+{
+  std::vector<const ArchiveEntry*> selected;
+  for(const std::string& name : names) {
+    selected.push_back(&entry(name));
+  }
+
+  // the tensors, made first; then their data, read in the order of the file
+  std::vector<Tensor> tensors;
+  std::vector<ArchivePiece> p;
+  for(size_t i = 0; i < selected.size(); i++) {
+    const ArchiveEntry& e = *selected[i];
+    if(e.dim < 0) {
+      tensors.push_back(Tensor(e.type));
+    } else if(e.dim == 0) {
+      tensors.push_back(Tensor({1}, e.type)); // made a value once read
+    } else {
+      tensors.push_back(Tensor(e.sizes, e.type));
+    }
+    std::vector<ArchivePiece> q = pieces(i, (char*)tensors.back().share().get(), e.offset, e.size);
+    p.insert(p.end(), q.begin(), q.end());
+  }
+  std::sort(p.begin(), p.end(), [](const ArchivePiece& a, const ArchivePiece& b) { return a.offset < b.offset; });
+  int fd = *fd_;
+  transfer(p, numThreads, filename_, "cannot read", [&](ArchivePiece& piece) {
+      if(!readAt(fd, piece.data, piece.size, piece.offset)) {
+        return false;
+      }
+      if(selected[piece.tensor]->checksum != 0) {
+        piece.hash = hashChunk(piece.data, piece.size);
+      }
+      return true;
+    });
+
+  // the pieces of each tensor are in order
+  std::vector<uint64_t> sums(selected.size(), 0);
+  for(const ArchivePiece& piece : p) {
+    sums[piece.tensor] = chainHash(sums[piece.tensor], piece.hash);
+  }
+  for(size_t i = 0; i < selected.size(); i++) {
+    const ArchiveEntry& e = *selected[i];
+    if(e.checksum != 0 && e.size > 0 && (sums[i] ? sums[i] : 1) != e.checksum) {
+      throw archiveError(filename_, "checksum mismatch for <" + e.name + ">");
+    }
+    if(e.dim == 0) {
+      tensors[i].tovalue();
+    }
+  }
+  return tensors;
+}
+
+Tensor Archive::map(const std::string& name) const
+{
+  const ArchiveEntry& e = entry(name);
+  if(e.dim < 0) {
+    return Tensor(e.type);
+  }
+  std::shared_ptr<void> mapping = mapping_;
+  return Tensor::from((char*)mapping_.get() + e.offset, e.sizes, {}, e.type, [mapping](void*) {});
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef XT_ARCHIVE_H
+#define XT_ARCHIVE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Tensor.h"
+
+namespace xt {
+
+// a file of named tensors: a header, an index (name, type, sizes, place and
+// checksum of each tensor), then the data of each tensor, contiguous and
+// aligned on 64 bytes; all in the byte order of the writer
+
+struct ArchiveEntry
+{
+  std::string name;
+  TensorType type;
+  int64_t dim; // 0 for a value, -1 for an empty tensor
+  std::vector<int64_t> sizes;
+  int64_t offset; // bytes, in the file
+  int64_t size; // bytes
+  uint64_t checksum; // of the data, 0 when not recorded
+};
+
+// writes the CPU tensors (any strides) in the given order, with up to
+// numThreads threads of the TH thread pool (0: all of them); names must be
+// unique; with checksums, the data of each tensor is verified when read back
+// the archive is written to filename.tmp, synced, then renamed to filename:
+// an existing archive is only replaced by a complete one
+void save(const std::string& filename, const std::vector<std::pair<std::string, Tensor>>& tensors,
+          bool checksums = true, int numThreads = 0);
+
+// an opened archive: only its index is read, the tensors are read on demand
+// copies share the file
+class Archive
+{
+public:
+  explicit Archive(const std::string& filename);
+  const std::vector<ArchiveEntry>& entries() const; // in the order of the file
+  bool has(const std::string& name) const;
+  const ArchiveEntry& entry(const std::string& name) const;
+  // tensors read from the file (pread), large ones in chunks shared by up
+  // to numThreads threads of the TH thread pool (0: all of them); throws
+  // std::runtime_error on a checksum mismatch
+  Tensor load(const std::string& name) const;
+  std::vector<Tensor> load(const std::vector<std::string>& names, int numThreads = 0) const;
+  // tensor on the mapping of the file (copy-on-write): nothing is read
+  // before the first access to its pages; its checksum is not verified
+  Tensor map(const std::string& name) const;
+private:
+  std::string filename_;
+  std::vector<ArchiveEntry> entries_;
+  std::map<std::string, size_t> index_;
+  std::shared_ptr<int> fd_; // closed with the last copy
+  std::shared_ptr<void> mapping_; // of the whole file, unmapped with the last tensor on it
+};
+
+}
+
+#endif
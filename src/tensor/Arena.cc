@@ -0,0 +1,50 @@
+#include "Arena.h"
+#include "TH.h"
+
+namespace xt {
+
+// innermost scope of the thread
+static thread_local ArenaScope* innermost = nullptr;
+
+ArenaScope::ArenaScope(int64_t chunkSize)
+  : arena_(THArena_new(chunkSize)), outer_(innermost)
+{
+  previous_ = THArena_setCurrent(arena_);
+  innermost = this;
+}
+
+ArenaScope::~ArenaScope()
+{
+  if(innermost == this) {
+    innermost = outer_;
+    THArena_setCurrent(previous_);
+  } else {
+    // ended before the scopes made inside it: the one just inside goes back
+    // to this scope's previous arena when it ends
+    for(ArenaScope* scope = innermost; scope; scope = scope->outer_) {
+      if(scope->outer_ == this) {
+        scope->outer_ = outer_;
+        scope->previous_ = previous_;
+        break;
+      }
+    }
+  }
+  THArena_close(arena_); // does not raise
+}
+
+int64_t ArenaScope::live() const
+{
+  return THArena_live(arena_);
+}
+
+int64_t ArenaScope::size() const
+{
+  return THArena_size(arena_);
+}
+
+int64_t ArenaScope::numEscaped()
+{
+  return THArena_numEscaped();
+}
+
+}
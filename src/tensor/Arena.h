@@ -0,0 +1,36 @@
+#ifndef XT_ARENA_H
+#define XT_ARENA_H
+
+#include <cstdint>
+
+struct THArena;
+
+namespace xt {
+
+// while alive, the CPU tensors made on the current thread (TH structures and
+// data) come from a bump arena, which goes back to the heap at once when the
+// scope ends and its tensors are gone
+// tensors which outlive the scope (escaped) stay valid, and keep the arena
+// until they are freed; resized later, their data moves to the heap
+// scopes nest: the innermost one is used; a scope ended before the scopes
+// made inside it (out of order) is taken out of the nesting, which goes on
+// with the scope around it
+class ArenaScope
+{
+public:
+  explicit ArenaScope(int64_t chunkSize = 1 << 20); // bytes taken at a time
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+  ~ArenaScope();
+  int64_t live() const; // blocks (structures, data) not freed yet
+  int64_t size() const; // bytes taken from the heap
+  static int64_t numEscaped(); // scopes which ended before all their tensors
+private:
+  THArena* arena_;
+  THArena* previous_; // current arena when the scope was made
+  ArenaScope* outer_; // scope around this one on its thread
+};
+
+}
+
+#endif
@@ -8,6 +8,22 @@ namespace xt {
 
 thread_local Context defaultContext;
 
+// pick the SIMD implementations of THVector (and thus of the built-in gemm)
+// matching the host, once, when the library is loaded
+static struct THVectorInit
+{
+  THVectorInit()
+  {
+    THByteVector_vectorDispatchInit();
+    THCharVector_vectorDispatchInit();
+    THShortVector_vectorDispatchInit();
+    THIntVector_vectorDispatchInit();
+    THLongVector_vectorDispatchInit();
+    THFloatVector_vectorDispatchInit();
+    THDoubleVector_vectorDispatchInit();
+  }
+} thVectorInit;
+
 Context::Context()
   : generator_(nullptr), thcstate_(nullptr)
 {
@@ -53,6 +69,103 @@ bool Context::hasGPU()
 #endif
 }
 
+bool Context::compensatedSum()
+{
+  return THGetCompensatedSum() != 0;
+}
+
+void Context::setCompensatedSum(bool enabled)
+{
+  THSetCompensatedSum(enabled);
+}
+
+bool Context::hugePages()
+{
+  return (THGetLargeAllocFlags() & TH_LARGE_ALLOC_HUGEPAGES) != 0;
+}
+
+void Context::setHugePages(bool enabled)
+{
+  int flags = THGetLargeAllocFlags() & ~TH_LARGE_ALLOC_HUGEPAGES;
+  THSetLargeAllocFlags(enabled ? flags | TH_LARGE_ALLOC_HUGEPAGES : flags);
+}
+
+bool Context::prefault()
+{
+  return (THGetLargeAllocFlags() & TH_LARGE_ALLOC_PREFAULT) != 0;
+}
+
+void Context::setPrefault(bool enabled)
+{
+  int flags = THGetLargeAllocFlags() & ~TH_LARGE_ALLOC_PREFAULT;
+  THSetLargeAllocFlags(enabled ? flags | TH_LARGE_ALLOC_PREFAULT : flags);
+}
+
+bool Context::cachingAllocator()
+{
+  return THGetDefaultStorageAllocator() == &THCachingAllocator;
+}
+
+void Context::setCachingAllocator(bool enabled)
+{
+  THSetDefaultStorageAllocator(enabled ? &THCachingAllocator : nullptr);
+}
+
+void Context::emptyCache()
+{
+  THCachingAllocator_emptyCache();
+}
+
+CachingAllocatorStats Context::cachingAllocatorStats()
+{
+  THCachingAllocatorStats stats;
+  THCachingAllocator_getStats(&stats);
+  return {stats.allocated, stats.cached, stats.peakAllocated, stats.hits, stats.misses};
+}
+
+HeapStats Context::heapStats()
+{
+  THHeapStats stats;
+  THHeapGetStats(&stats);
+  return {stats.allocated, stats.peakAllocated, stats.numAllocs, stats.numFrees,
+          std::vector<int64_t>(stats.histogram, stats.histogram+TH_HEAP_HISTOGRAM_SIZE)};
+}
+
+void Context::resetPeakHeap()
+{
+  THHeapResetPeak();
+}
+
+int64_t Context::scratchLimit()
+{
+  return THScratch_getLimit();
+}
+
+void Context::setScratchLimit(int64_t size)
+{
+  THScratch_setLimit(size);
+}
+
+int64_t Context::scratchSize()
+{
+  return THScratch_size();
+}
+
+void Context::releaseScratch()
+{
+  THScratch_release();
+}
+
+int64_t Context::outOfCoreBudget()
+{
+  return THOutOfCore_getBudget();
+}
+
+void Context::setOutOfCoreBudget(int64_t size)
+{
+  THOutOfCore_setBudget(size);
+}
+
 Context::~Context()
 {
 }
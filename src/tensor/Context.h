@@ -2,12 +2,36 @@
 #define XT_CONTEXT_H
 
 #include <thread>
+#include <memory>
+#include <cstdint>
+#include <vector>
 
 struct THGenerator;
 struct THCState;
 
 namespace xt {
 
+// memory of the caching allocator, in bytes (see THCachingAllocator.h)
+struct CachingAllocatorStats
+{
+  int64_t allocated; // in use
+  int64_t cached; // kept for reuse
+  int64_t peakAllocated;
+  int64_t hits; // allocations served from the cache
+  int64_t misses;
+};
+
+// memory allocated by TH (THAlloc and the allocators of the storages, see
+// THHeapStats), in bytes; peakAllocated is seen to within 1MB per thread
+struct HeapStats
+{
+  int64_t allocated; // in use
+  int64_t peakAllocated; // since the start or resetPeakHeap()
+  int64_t numAllocs;
+  int64_t numFrees;
+  std::vector<int64_t> histogram; // numAllocs of [2^i, 2^(i+1)) bytes at i
+};
+
 class Context
 {
 public:
@@ -15,6 +39,41 @@ public:
   std::shared_ptr<THGenerator> generator(std::shared_ptr<THGenerator> gen = nullptr);
   std::shared_ptr<THCState> thcstate(std::shared_ptr<THCState> state = nullptr);
   bool hasGPU(); // return true if compiled with GPU support
+  // Kahan summation for the float and double sums of the reductions
+  // (sum, mean, ...); process-wide, off by default
+  bool compensatedSum();
+  void setCompensatedSum(bool enabled);
+  // storages of at least 2MB aligned on transparent huge pages (Linux), and
+  // with their pages touched on the TH threads when made (prefault), rather
+  // than in the first kernel writing them; process-wide, from the environment
+  // variable TH_LARGE_ALLOC (e.g. "hugepages,prefault") unless set
+  bool hugePages();
+  void setHugePages(bool enabled);
+  bool prefault();
+  void setPrefault(bool enabled);
+  // storages of the new CPU tensors from a caching allocator, which keeps
+  // freed blocks for the next tensors of about the same size; process-wide,
+  // off by default
+  bool cachingAllocator();
+  void setCachingAllocator(bool enabled);
+  void emptyCache(); // gives the cached blocks back to the system
+  CachingAllocatorStats cachingAllocatorStats();
+  HeapStats heapStats();
+  void resetPeakHeap();
+  // each thread has a workspace for the temporaries of the TH kernels (see
+  // THScratch.h), which grows up to scratchLimit() bytes (64MB by default,
+  // process-wide)
+  int64_t scratchLimit();
+  void setScratchLimit(int64_t size);
+  int64_t scratchSize(); // workspace of the calling thread
+  void releaseScratch(); // gives it back to the heap
+  // ops over tensors on file mappings (Tensor::map, shared tensors) which
+  // are larger than outOfCoreBudget() bytes run in chunks, whose pages are
+  // read ahead and given back when done, so that the mapped pages resident
+  // stay within the budget (see THOutOfCore.h): element-wise ops, copies and
+  // reductions of contiguous tensors; process-wide, 0 (off) by default
+  int64_t outOfCoreBudget();
+  void setOutOfCoreBudget(int64_t size);
   ~Context();
 private:
   std::shared_ptr<THGenerator> generator_;
@@ -0,0 +1,294 @@
+#ifndef XT_EXPRESSION_H
+#define XT_EXPRESSION_H
+
+#include "Tensor.h"
+#include "TensorTH.h"
+#include "dispatch.h"
+
+namespace xt {
+
+// Lazy element-wise expressions (opt-in)
+// lazy(a)*2 + lazy(b)/c - d builds an expression tree, which is evaluated
+// in a single pass (no temporaries) by eval() or eval_()
+// beware: * is element-wise here
+// all tensors must have the same type and sizes; 0-dim tensors and numbers
+// are broadcasted
+
+struct ExpressionInfo
+{
+  ExpressionInfo() : type(kDouble), device(kUnknown), typed(false), shaped(false), contiguous(true) {}
+  std::vector<int64_t> sizes;
+  TensorType type;
+  TensorDevice device;
+  bool typed;
+  bool shaped;
+  bool contiguous;
+};
+
+template<class E> struct Expression
+{
+  const E& self() const { return static_cast<const E&>(*this); }
+};
+
+class TensorExpression : public Expression<TensorExpression>
+{
+public:
+  TensorExpression(const Tensor& t) : t_(t) {}
+  void collect(ExpressionInfo& info) const
+  {
+    int64_t dim = t_.dim();
+    if(dim < 0) {
+      throw std::invalid_argument("lazy: empty tensor");
+    }
+    if(!info.typed) {
+      info.type = t_.type();
+      info.device = t_.device();
+      info.typed = true;
+    } else if((t_.type() != info.type) || (t_.device() != info.device)) {
+      throw std::invalid_argument("lazy: tensor type mismatch");
+    }
+    if(dim > 0) {
+      if(!info.shaped) {
+        info.sizes = t_.size();
+        info.shaped = true;
+      } else if(t_.sizes() != info.sizes) {
+        throw std::invalid_argument("lazy: tensor size mismatch");
+      }
+      info.contiguous = info.contiguous && isContiguous(t_);
+    }
+  }
+  template<typename T> struct Bound
+  {
+    T* p;
+    int64_t s; // 1 for contiguous access, 0 for values
+    std::vector<int64_t> stride;
+    T get() const { return *p; }
+    T at(int64_t i) const { return p[i*s]; }
+    void step(int64_t d) { p += stride[d]; }
+    void back(int64_t d, int64_t n) { p -= stride[d]*n; }
+  };
+  template<typename T> Bound<T> bind(int64_t dim) const
+  {
+    Bound<T> b;
+    b.p = t_.data<T>();
+    if(t_.dim() == 0) {
+      b.s = 0;
+      b.stride.assign(dim, 0);
+    } else {
+      b.s = 1;
+      b.stride = t_.stride();
+    }
+    return b;
+  }
+private:
+  Tensor t_; // keeps the tensor alive
+};
+
+class ScalarExpression : public Expression<ScalarExpression>
+{
+public:
+  ScalarExpression(double v) : v_(v) {}
+  void collect(ExpressionInfo& info) const {}
+  template<typename T> struct Bound
+  {
+    T v;
+    T get() const { return v; }
+    T at(int64_t i) const { return v; }
+    void step(int64_t d) {}
+    void back(int64_t d, int64_t n) {}
+  };
+  template<typename T> Bound<T> bind(int64_t dim) const
+  {
+    return Bound<T>{static_cast<T>(v_)};
+  }
+private:
+  double v_;
+};
+
+template<class Op, class L, class R>
+class BinaryExpression : public Expression<BinaryExpression<Op, L, R>>
+{
+public:
+  BinaryExpression(const L& l, const R& r) : l_(l), r_(r) {}
+  void collect(ExpressionInfo& info) const
+  {
+    l_.collect(info);
+    r_.collect(info);
+  }
+  template<typename T> struct Bound
+  {
+    typename L::template Bound<T> l;
+    typename R::template Bound<T> r;
+    T get() const { return Op::apply(l.get(), r.get()); }
+    T at(int64_t i) const { return Op::apply(l.at(i), r.at(i)); }
+    void step(int64_t d) { l.step(d); r.step(d); }
+    void back(int64_t d, int64_t n) { l.back(d, n); r.back(d, n); }
+  };
+  template<typename T> Bound<T> bind(int64_t dim) const
+  {
+    return Bound<T>{l_.template bind<T>(dim), r_.template bind<T>(dim)};
+  }
+private:
+  L l_;
+  R r_;
+};
+
+template<class E>
+class NegExpression : public Expression<NegExpression<E>>
+{
+public:
+  NegExpression(const E& e) : e_(e) {}
+  void collect(ExpressionInfo& info) const
+  {
+    e_.collect(info);
+  }
+  template<typename T> struct Bound
+  {
+    typename E::template Bound<T> e;
+    T get() const { return -e.get(); }
+    T at(int64_t i) const { return -e.at(i); }
+    void step(int64_t d) { e.step(d); }
+    void back(int64_t d, int64_t n) { e.back(d, n); }
+  };
+  template<typename T> Bound<T> bind(int64_t dim) const
+  {
+    return Bound<T>{e_.template bind<T>(dim)};
+  }
+private:
+  E e_;
+};
+
+struct AddOp { template<typename T> static T apply(T a, T b) { return a + b; } };
+struct SubOp { template<typename T> static T apply(T a, T b) { return a - b; } };
+struct MulOp { template<typename T> static T apply(T a, T b) { return a * b; } };
+struct DivOp { template<typename T> static T apply(T a, T b) { return a / b; } };
+
+inline TensorExpression lazy(const Tensor& t)
+{
+  return TensorExpression(t);
+}
+
+#define XT_EXPRESSION_OPERATOR(OP, NAME)                                \
+  template<class L, class R>                                            \
+  BinaryExpression<NAME, L, R> operator OP(const Expression<L>& l, const Expression<R>& r) \
+  {                                                                     \
+    return BinaryExpression<NAME, L, R>(l.self(), r.self());            \
+  }                                                                     \
+  template<class L>                                                     \
+  BinaryExpression<NAME, L, TensorExpression> operator OP(const Expression<L>& l, const Tensor& r) \
+  {                                                                     \
+    return BinaryExpression<NAME, L, TensorExpression>(l.self(), TensorExpression(r)); \
+  }                                                                     \
+  template<class R>                                                     \
+  BinaryExpression<NAME, TensorExpression, R> operator OP(const Tensor& l, const Expression<R>& r) \
+  {                                                                     \
+    return BinaryExpression<NAME, TensorExpression, R>(TensorExpression(l), r.self()); \
+  }                                                                     \
+  template<class L>                                                     \
+  BinaryExpression<NAME, L, ScalarExpression> operator OP(const Expression<L>& l, double r) \
+  {                                                                     \
+    return BinaryExpression<NAME, L, ScalarExpression>(l.self(), ScalarExpression(r)); \
+  }                                                                     \
+  template<class R>                                                     \
+  BinaryExpression<NAME, ScalarExpression, R> operator OP(double l, const Expression<R>& r) \
+  {                                                                     \
+    return BinaryExpression<NAME, ScalarExpression, R>(ScalarExpression(l), r.self()); \
+  }
+
+XT_EXPRESSION_OPERATOR(+, AddOp)
+XT_EXPRESSION_OPERATOR(-, SubOp)
+XT_EXPRESSION_OPERATOR(*, MulOp)
+XT_EXPRESSION_OPERATOR(/, DivOp)
+
+#undef XT_EXPRESSION_OPERATOR
+
+template<class E>
+NegExpression<E> operator-(const Expression<E>& e)
+{
+  return NegExpression<E>(e.self());
+}
+
+template<class E> struct eval_op
+{
+  template<typename T> void cpu(Tensor& r, const E& e, const ExpressionInfo& info)
+  {
+    int64_t dim = info.sizes.size();
+    auto rb = TensorExpression(r).template bind<T>(dim);
+    auto eb = e.template bind<T>(dim);
+    if(info.contiguous && isContiguous(r)) {
+      int64_t n = 1;
+      for(int64_t d = 0; d < dim; d++) {
+        n *= info.sizes[d];
+      }
+      T* r_p = rb.p;
+      for(int64_t i = 0; i < n; i++) {
+        r_p[i] = eb.at(i);
+      }
+    } else {
+      // strided: same traversal as TH_TENSOR_APPLY
+      std::vector<int64_t> counter(dim, 0);
+      int64_t last = dim-1;
+      int64_t n = info.sizes[last];
+      while(true) {
+        for(int64_t i = 0; i < n; i++) {
+          *rb.p = eb.get();
+          rb.step(last);
+          eb.step(last);
+        }
+        rb.back(last, n);
+        eb.back(last, n);
+        int64_t d = last-1;
+        for(; d >= 0; d--) {
+          counter[d]++;
+          rb.step(d);
+          eb.step(d);
+          if(counter[d] < info.sizes[d]) {
+            break;
+          }
+          rb.back(d, info.sizes[d]);
+          eb.back(d, info.sizes[d]);
+          counter[d] = 0;
+        }
+        if(d < 0) {
+          break;
+        }
+      }
+    }
+  }
+  template<typename T> void gpu(Tensor& r, const E& e, const ExpressionInfo& info)
+  {
+    throw std::invalid_argument("lazy: unsupported device gpu");
+  }
+};
+
+// evaluate into r (allocated on first use, resized only if needed)
+template<class E>
+void eval_(Tensor& r, const Expression<E>& e)
+{
+  ExpressionInfo info;
+  e.self().collect(info);
+  if(!info.typed) {
+    throw std::invalid_argument("lazy: expression without tensor");
+  }
+  if(r.device() == kUnknown) {
+    r.resize(info.type, info.device);
+  } else if((r.type() != info.type) || (r.device() != info.device)) {
+    throw std::invalid_argument("lazy: output type mismatch");
+  }
+  if((r.dim() != (int64_t)info.sizes.size()) || (r.sizes() != info.sizes)) {
+    r.resize(info.sizes);
+  }
+  dispatch<eval_op<E>>(r, e.self(), info);
+}
+
+template<class E>
+Tensor eval(const Expression<E>& e)
+{
+  Tensor r;
+  eval_(r, e);
+  return r;
+}
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#include "FileIO.h"
+#include <cerrno>
+#include <unistd.h>
+
+namespace xt {
+
+bool writeAt(int fd, const char* data, int64_t size, int64_t offset)
+{
+  while(size > 0) {
+    ssize_t n = pwrite(fd, data, size, offset);
+    if(n <= 0) {
+      if(n < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= n;
+    offset += n;
+  }
+  return true;
+}
+
+bool readAt(int fd, char* data, int64_t size, int64_t offset)
+{
+  while(size > 0) {
+    ssize_t n = pread(fd, data, size, offset);
+    if(n <= 0) {
+      if(n < 0 && errno == EINTR) {
+        continue;
+      }
+      if(n == 0) {
+        errno = EIO; // truncated
+      }
+      return false;
+    }
+    data += n;
+    size -= n;
+    offset += n;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef XT_FILE_IO_H
+#define XT_FILE_IO_H
+
+#include <cstdint>
+
+// internal: not installed with the headers of xt
+
+namespace xt {
+
+// size bytes at offset of the file fd (pwrite, pread), retried on EINTR and
+// short transfers; false on an error, reported by errno (EIO for a file
+// ending before size bytes are read)
+bool writeAt(int fd, const char* data, int64_t size, int64_t offset);
+bool readAt(int fd, char* data, int64_t size, int64_t offset);
+
+}
+
+#endif
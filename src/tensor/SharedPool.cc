@@ -0,0 +1,50 @@
+#include "SharedPool.h"
+#include <stdexcept>
+
+namespace xt {
+
+SharedPool::SharedPool(int64_t size, IntList sizes, TensorType type)
+{
+  if(size <= 0) {
+    throw std::invalid_argument("pool size must be a positive number");
+  }
+  tensors_.reserve(size);
+  for(int64_t i = 0; i < size; i++) {
+    tensors_.push_back(Tensor::shared(sizes, type));
+  }
+}
+
+SharedPool::SharedPool(const std::vector<SharedHandle>& handles)
+{
+  if(handles.empty()) {
+    throw std::invalid_argument("no handle");
+  }
+  tensors_.reserve(handles.size());
+  for(const SharedHandle& handle : handles) {
+    tensors_.push_back(Tensor::shared(handle));
+  }
+}
+
+int64_t SharedPool::size() const
+{
+  return tensors_.size();
+}
+
+Tensor& SharedPool::operator[](int64_t i)
+{
+  if(i < 0 || i >= (int64_t)tensors_.size()) {
+    throw std::out_of_range("no such tensor in the pool");
+  }
+  return tensors_[i];
+}
+
+std::vector<SharedHandle> SharedPool::handles() const
+{
+  std::vector<SharedHandle> handles;
+  for(const Tensor& t : tensors_) {
+    handles.push_back(t.handle());
+  }
+  return handles;
+}
+
+}
@@ -0,0 +1,32 @@
+#ifndef XT_SHARED_POOL_H
+#define XT_SHARED_POOL_H
+
+#include <cstdint>
+#include <vector>
+#include "Tensor.h"
+
+namespace xt {
+
+// tensors of the same sizes and type in shared memory, made once and
+// refilled: a producer process (a worker) fills a tensor of its pool and
+// sends its number (pipe, socket) to a consumer process, which opened the
+// same pool once from its handles, and gives the number back when done with
+// the tensor; the memory is mapped and faulted in once by each process,
+// instead of for every batch with a new Tensor::shared
+// each tensor is freed with the last pool on it, of any process: the
+// producer keeps its pool until the consumer has opened its own
+class SharedPool
+{
+public:
+  SharedPool(int64_t size, IntList sizes, TensorType type); // made by the producer
+  explicit SharedPool(const std::vector<SharedHandle>& handles); // opened by the consumer
+  int64_t size() const;
+  Tensor& operator[](int64_t i); // throws std::out_of_range
+  std::vector<SharedHandle> handles() const; // to send to the consumer
+private:
+  std::vector<Tensor> tensors_;
+};
+
+}
+
+#endif
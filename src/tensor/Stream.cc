@@ -0,0 +1,273 @@
+#include "Stream.h"
+#include "TensorTH.h"
+#include "FileIO.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xt {
+
+// yields before sleeping, for a batch which is about to be ready
+static const int kStreamSpins = 64;
+
+static std::runtime_error streamError(const std::string& filename, const std::string& what)
+{
+  return std::runtime_error("stream <" + filename + ">: " + what);
+}
+
+// records of a batch which follow each other in the file and in the batch,
+// read at once
+struct StreamRun
+{
+  int64_t offset; // bytes, in the file
+  int64_t size; // bytes
+  int64_t row; // in the batch
+};
+
+StreamReader::StreamReader(const std::string& filename, IntList sizes, TensorType type, int64_t batchSize,
+                           int64_t offset, int depth)
+  : filename_(filename), fd_(-1), offset_(offset), size_(0), batchSize_(batchSize), ordered_(true), count_(0),
+    batches_(0),
+    produced_(0), consumed_(0), holding_(false), consumerWaiting_(false), producerWaiting_(false),
+    cancel_(false), failed_(false), pass_(0), idle_(true), stop_(false)
+{
+  if(batchSize < 1 || depth < 2 || offset < 0) {
+    throw std::invalid_argument("stream <" + filename + ">: invalid batch size, depth or offset");
+  }
+  std::vector<int64_t> batchSizes(1, batchSize);
+  batchSizes.insert(batchSizes.end(), sizes.begin(), sizes.end());
+  for(int i = 0; i < depth; i++) {
+    ring_.push_back(Tensor(batchSizes, type));
+  }
+  recordSize_ = ring_[0].elemSize();
+  for(int64_t size : sizes) {
+    recordSize_ *= size;
+  }
+  if(recordSize_ == 0) {
+    throw std::invalid_argument("stream <" + filename + ">: empty records");
+  }
+
+  fd_ = open(filename.c_str(), O_RDONLY);
+  struct stat st;
+  if(fd_ < 0 || fstat(fd_, &st) != 0) {
+    int error = errno;
+    if(fd_ >= 0) {
+      close(fd_);
+    }
+    throw streamError(filename, std::string("cannot open: ") + std::strerror(error));
+  }
+  size_ = std::max<int64_t>(st.st_size - offset, 0)/recordSize_;
+  thread_ = std::thread(&StreamReader::run, this);
+}
+
+StreamReader::~StreamReader()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    cancel_ = true;
+    wake_.notify_all();
+  }
+  thread_.join();
+  close(fd_);
+}
+
+int64_t StreamReader::size() const
+{
+  return size_;
+}
+
+void StreamReader::start()
+{
+  start(true, std::vector<int64_t>());
+}
+
+void StreamReader::start(std::vector<int64_t> index)
+{
+  for(int64_t record : index) {
+    if(record < 0 || record >= size_) {
+      throw std::invalid_argument("stream <" + filename_ + ">: no record " + std::to_string(record));
+    }
+  }
+  start(false, std::move(index));
+}
+
+void StreamReader::start(bool ordered, std::vector<int64_t> index)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  // the pass under way ends after the batch being read
+  cancel_ = true;
+  wake_.notify_all();
+  wake_.wait(lock, [&]() { return idle_; });
+  cancel_ = false;
+  failed_ = false;
+  error_.clear();
+  holding_ = false;
+  ordered_ = ordered;
+  count_ = ordered ? size_ : (int64_t)index.size();
+  batches_ = (count_ + batchSize_-1)/batchSize_;
+  index_ = std::move(index);
+  produced_ = 0;
+  consumed_ = 0;
+  idle_ = false;
+  pass_++;
+  wake_.notify_all();
+}
+
+void StreamReader::shuffle(uint64_t seed)
+{
+  std::vector<int64_t> index(size_);
+  for(int64_t i = 0; i < size_; i++) {
+    index[i] = i;
+  }
+  std::mt19937_64 random(seed);
+  std::shuffle(index.begin(), index.end(), random);
+  start(std::move(index));
+}
+
+template<typename F>
+void StreamReader::wait(std::atomic<bool>& waiting, F ready)
+{
+  for(int i = 0; i < kStreamSpins; i++) {
+    if(ready()) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+  // the other side notifies when it sees the flag; it sees it, or ready()
+  // sees its update (sequentially consistent)
+  std::unique_lock<std::mutex> lock(mutex_);
+  waiting = true;
+  wake_.wait(lock, ready);
+  waiting = false;
+}
+
+void StreamReader::notify(std::atomic<bool>& waiting)
+{
+  if(waiting) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_.notify_all();
+  }
+}
+
+bool StreamReader::next(Tensor& batch)
+{
+  if(holding_) {
+    holding_ = false;
+    consumed_++;
+    notify(producerWaiting_);
+  }
+  int64_t b = consumed_;
+  if(b >= batches_) {
+    return false;
+  }
+  wait(consumerWaiting_, [&]() { return produced_ > b || failed_; });
+  if(produced_ <= b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    throw streamError(filename_, error_);
+  }
+  holding_ = true;
+  const Tensor& slot = ring_[b % ring_.size()];
+  int64_t rows = std::min(batchSize_, count_ - b*batchSize_);
+  if(rows == batchSize_) {
+    batch = slot;
+  } else {
+    batch = narrow(slot, 0, 0, rows);
+  }
+  return true;
+}
+
+// records of batch b (of all the records in order, or of index), in the
+// order of the file
+static std::vector<StreamRun> runs(bool ordered, const std::vector<int64_t>& index, int64_t count,
+                                   int64_t batchSize, int64_t recordSize, int64_t offset, int64_t b)
+{
+  int64_t first = b*batchSize, rows = std::min(batchSize, count - first);
+  std::vector<StreamRun> r;
+  if(ordered) {
+    r.push_back({offset + first*recordSize, rows*recordSize, 0});
+    return r;
+  }
+  std::vector<std::pair<int64_t, int64_t>> records; // (record, row)
+  for(int64_t row = 0; row < rows; row++) {
+    records.push_back({index[first+row], row});
+  }
+  std::sort(records.begin(), records.end());
+  for(size_t i = 0; i < records.size(); i++) {
+    if(i > 0 && records[i].first == records[i-1].first+1 && records[i].second == records[i-1].second+1) {
+      r.back().size += recordSize;
+    } else {
+      r.push_back({offset + records[i].first*recordSize, recordSize, records[i].second});
+    }
+  }
+  return r;
+}
+
+// the thread: waits for a pass, then reads its batches into the ring while
+// there is room
+void StreamReader::run()
+{
+  std::vector<char*> data;
+  for(const Tensor& slot : ring_) {
+    data.push_back((char*)slot.share().get());
+  }
+  const int64_t depth = ring_.size();
+  uint64_t pass = 0;
+  for(;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&]() { return stop_ || pass_ != pass; });
+      if(stop_) {
+        return;
+      }
+      pass = pass_;
+    }
+    // the kernel reads ahead an ordered pass; the records of a shuffled one
+    // are asked for a batch ahead
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd_, 0, 0, ordered_ ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_RANDOM);
+#endif
+    std::vector<StreamRun> r, ahead;
+    for(int64_t b = 0; b < batches_; b++) {
+      wait(producerWaiting_, [&]() { return b - consumed_ < depth || cancel_; });
+      if(cancel_) {
+        break;
+      }
+      r = ordered_ || b == 0 ? runs(ordered_, index_, count_, batchSize_, recordSize_, offset_, b) : std::move(ahead);
+      if(!ordered_ && b+1 < batches_) {
+        ahead = runs(ordered_, index_, count_, batchSize_, recordSize_, offset_, b+1);
+#ifdef POSIX_FADV_WILLNEED
+        for(const StreamRun& run : ahead) {
+          posix_fadvise(fd_, run.offset, run.size, POSIX_FADV_WILLNEED);
+        }
+#endif
+      }
+      char* batch = data[b % depth];
+      for(const StreamRun& run : r) {
+        if(!readAt(fd_, batch + run.row*recordSize_, run.size, run.offset)) {
+          int error = errno;
+          std::lock_guard<std::mutex> lock(mutex_);
+          error_ = std::string("cannot read: ") + std::strerror(error);
+          failed_ = true;
+          wake_.notify_all();
+          break;
+        }
+      }
+      if(failed_) {
+        break;
+      }
+      produced_ = b+1;
+      notify(consumerWaiting_);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_ = true;
+    wake_.notify_all();
+  }
+}
+
+}
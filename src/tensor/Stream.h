@@ -0,0 +1,83 @@
+#ifndef XT_STREAM_H
+#define XT_STREAM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Tensor.h"
+
+namespace xt {
+
+// a dataset of records: tensors of the same sizes and type, one after the
+// other in a file from offset (as THFile_write*Raw writes them, in the byte
+// order of the reader), read in batches by a thread of the reader
+// the batches are depth tensors of {batchSize, sizes...} made once: the
+// thread fills them ahead of the consumer, which takes them from a lock-free
+// ring (a batch goes back to the thread at the next call to next(); with a
+// depth of 2, one batch is worked on while the other is read), so that
+// reading overlaps the work on the batches; a pass reads the records in the
+// order of an index (shuffled, a subset...) or all of them in order
+// one consumer thread
+class StreamReader
+{
+public:
+  StreamReader(const std::string& filename, IntList sizes, TensorType type, int64_t batchSize,
+               int64_t offset = 0, int depth = 2);
+  StreamReader(const StreamReader&) = delete;
+  StreamReader& operator=(const StreamReader&) = delete;
+  ~StreamReader(); // waits for the read under way
+  int64_t size() const; // records in the file
+  // starts a pass (ending the one under way) over all the records in order,
+  // over the records of index (numbers, in any order, repeats allowed; none
+  // if it is empty), or over all the records shuffled by seed
+  void start();
+  void start(std::vector<int64_t> index);
+  void shuffle(uint64_t seed);
+  // the next batch of the pass, {batchSize, sizes...} (fewer records for the
+  // last one): a tensor of the ring, valid until the next call to next() or
+  // start() (copy what must last longer); false at the end of the pass;
+  // throws std::runtime_error on a read error
+  bool next(Tensor& batch);
+private:
+  void start(bool ordered, std::vector<int64_t> index);
+  void run();
+  template<typename F> void wait(std::atomic<bool>& waiting, F ready);
+  void notify(std::atomic<bool>& waiting);
+  std::string filename_;
+  int fd_;
+  int64_t recordSize_; // bytes
+  int64_t offset_;
+  int64_t size_;
+  int64_t batchSize_;
+  std::vector<Tensor> ring_;
+  // the pass: all the records in order, or those of its index; and its
+  // batches; set while the thread is idle
+  bool ordered_;
+  std::vector<int64_t> index_;
+  int64_t count_; // records
+  int64_t batches_;
+  // batches read and given back, each written by one side only
+  std::atomic<int64_t> produced_;
+  std::atomic<int64_t> consumed_;
+  bool holding_; // the consumer has batch consumed_
+  // waits are lock-free while short; longer ones sleep on wake_
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::atomic<bool> consumerWaiting_;
+  std::atomic<bool> producerWaiting_;
+  std::atomic<bool> cancel_; // of the pass
+  std::atomic<bool> failed_;
+  std::string error_;
+  uint64_t pass_; // started passes
+  bool idle_;
+  bool stop_;
+  std::thread thread_;
+};
+
+}
+
+#endif
@@ -62,11 +62,15 @@ Tensor::~Tensor()
 
 template<> void Tensor::value(uint8_t value, TensorDevice device)
 {
-  resize({}, kUInt8, device);
   if(device == kCPU) {
-    THByteTensor_set1d((THByteTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kUInt8;
+    device_ = kCPU;
+    isValue_ = true;
+    *(uint8_t*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kUInt8, device);
     THCudaByteTensor_set1d(thcstate(), (THCudaByteTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -75,11 +79,15 @@ template<> void Tensor::value(uint8_t value, TensorDevice device)
 }
 template<> void Tensor::value(int8_t value, TensorDevice device)
 {
-  resize({}, kInt8, device);
   if(device == kCPU) {
-    THCharTensor_set1d((THCharTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kInt8;
+    device_ = kCPU;
+    isValue_ = true;
+    *(int8_t*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kInt8, device);
     THCudaCharTensor_set1d(defaultContext.thcstate().get(), (THCudaCharTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -88,11 +96,15 @@ template<> void Tensor::value(int8_t value, TensorDevice device)
 }
 template<> void Tensor::value(int16_t value, TensorDevice device)
 {
-  resize({}, kInt16, device);
   if(device == kCPU) {
-    THShortTensor_set1d((THShortTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kInt16;
+    device_ = kCPU;
+    isValue_ = true;
+    *(int16_t*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kInt16, device);
     THCudaShortTensor_set1d(defaultContext.thcstate().get(), (THCudaShortTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -101,11 +113,15 @@ template<> void Tensor::value(int16_t value, TensorDevice device)
 }
 template<> void Tensor::value(int32_t value, TensorDevice device)
 {
-  resize({}, kInt32, device);
   if(device == kCPU) {
-    THIntTensor_set1d((THIntTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kInt32;
+    device_ = kCPU;
+    isValue_ = true;
+    *(int32_t*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kInt32, device);
     THCudaIntTensor_set1d(defaultContext.thcstate().get(), (THCudaIntTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -114,11 +130,15 @@ template<> void Tensor::value(int32_t value, TensorDevice device)
 }
 template<> void Tensor::value(int64_t value, TensorDevice device)
 {
-  resize({}, kInt64, device);
   if(device == kCPU) {
-    THLongTensor_set1d((THLongTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kInt64;
+    device_ = kCPU;
+    isValue_ = true;
+    *(int64_t*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kInt64, device);
     THCudaLongTensor_set1d(defaultContext.thcstate().get(), (THCudaLongTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -127,11 +147,15 @@ template<> void Tensor::value(int64_t value, TensorDevice device)
 }
 template<> void Tensor::value(float value, TensorDevice device)
 {
-  resize({}, kFloat, device);
   if(device == kCPU) {
-    THFloatTensor_set1d((THFloatTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kFloat;
+    device_ = kCPU;
+    isValue_ = true;
+    *(float*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kFloat, device);
     THCudaTensor_set1d(defaultContext.thcstate().get(), (THCudaTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -140,11 +164,15 @@ template<> void Tensor::value(float value, TensorDevice device)
 }
 template<> void Tensor::value(double value, TensorDevice device)
 {
-  resize({}, kDouble, device);
   if(device == kCPU) {
-    THDoubleTensor_set1d((THDoubleTensor*)th_tensor_, 0, value);
+    clear();
+    type_ = kDouble;
+    device_ = kCPU;
+    isValue_ = true;
+    *(double*)&scalar_ = value;
 #ifdef XT_HAS_CUDA
   } else if(device == kGPU) {
+    resize({}, kDouble, device);
     THCudaDoubleTensor_set1d(defaultContext.thcstate().get(), (THCudaDoubleTensor*)th_tensor_, 0, value);
 #endif
   } else {
@@ -182,7 +210,7 @@ Tensor::Tensor(const Tensor& o)
 }
 
 Tensor::Tensor(Tensor&& o)
-  : type_(o.type_), device_(o.device_), isValue_(o.isValue_), th_tensor_(o.th_tensor_)
+  : type_(o.type_), device_(o.device_), isValue_(o.isValue_), th_tensor_(o.th_tensor_), scalar_(o.scalar_)
 {
   o.th_tensor_ = nullptr;
   o.device_ = kUnknown;
@@ -194,7 +222,8 @@ Tensor& Tensor::operator=(const Tensor& o) &
   type_ = o.type_;
   device_ = o.device_;
   isValue_ = o.isValue_;
-  if(device_ != kUnknown) {
+  scalar_ = o.scalar_;
+  if(device_ != kUnknown && __atomic_load_n(&o.th_tensor_, __ATOMIC_ACQUIRE)) {
     o.retain();
     th_tensor_ = o.th_tensor_;
   }
@@ -214,6 +243,7 @@ Tensor& Tensor::operator=(Tensor&& o) &
   device_ = o.device_;
   isValue_ = o.isValue_;
   th_tensor_ = o.th_tensor_;
+  scalar_ = o.scalar_;
   if(device_ != kUnknown) {
     o.th_tensor_ = nullptr;
     o.device_ = kUnknown;
@@ -232,13 +262,13 @@ Tensor::Tensor(TensorType type, TensorDevice device)
   resize(type, device);
 }
 
-Tensor::Tensor(const std::vector<int64_t>& sizes, TensorType type, TensorDevice device)
+Tensor::Tensor(IntList sizes, TensorType type, TensorDevice device)
   : type_(kDouble), device_(kUnknown), isValue_(false), th_tensor_(nullptr)
 {
   resize(sizes, type, device);
 }
 
-Tensor::Tensor(const std::vector<int64_t>& sizes, const std::vector<int64_t>& strides, TensorType type, TensorDevice device)
+Tensor::Tensor(IntList sizes, IntList strides, TensorType type, TensorDevice device)
   : type_(kDouble), device_(kUnknown), isValue_(false), th_tensor_(nullptr)
 {
   resize(sizes, strides, type, device);
@@ -256,56 +286,56 @@ TensorDevice Tensor::device() const
 
 template<> THByteTensor* Tensor::THTensor<THByteTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THByteTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kUInt8) {
+    return (THByteTensor*)(thTensor());
   } else {
     throw std::invalid_argument("uint8_t tensor expected");
   }
 }
 template<> THCharTensor* Tensor::THTensor<THCharTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THCharTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kInt8) {
+    return (THCharTensor*)(thTensor());
   } else {
     throw std::invalid_argument("int8_t tensor expected");
   }
 }
 template<> THShortTensor* Tensor::THTensor<THShortTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THShortTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kInt16) {
+    return (THShortTensor*)(thTensor());
   } else {
     throw std::invalid_argument("int16_t tensor expected");
   }
 }
 template<> THIntTensor* Tensor::THTensor<THIntTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THIntTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kInt32) {
+    return (THIntTensor*)(thTensor());
   } else {
     throw std::invalid_argument("int32_t tensor expected");
   }
 }
 template<> THLongTensor* Tensor::THTensor<THLongTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THLongTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kInt64) {
+    return (THLongTensor*)(thTensor());
   } else {
     throw std::invalid_argument("int64_t tensor expected");
   }
 }
 template<> THFloatTensor* Tensor::THTensor<THFloatTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THFloatTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kFloat) {
+    return (THFloatTensor*)(thTensor());
   } else {
     throw std::invalid_argument("float tensor expected");
   }
 }
 template<> THDoubleTensor* Tensor::THTensor<THDoubleTensor>() const
 {
-  if(device_ == kCPU) {
-    return (THDoubleTensor*)(th_tensor_);
+  if(device_ == kCPU && type_ == kDouble) {
+    return (THDoubleTensor*)(thTensor());
   } else {
     throw std::invalid_argument("double tensor expected");
   }
@@ -313,7 +343,7 @@ template<> THDoubleTensor* Tensor::THTensor<THDoubleTensor>() const
 #ifdef XT_HAS_CUDA
 template<> THCudaByteTensor* Tensor::THTensor<THCudaByteTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kUInt8) {
     return (THCudaByteTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("uint8_t cuda tensor expected");
@@ -321,7 +351,7 @@ template<> THCudaByteTensor* Tensor::THTensor<THCudaByteTensor>() const
 }
 template<> THCudaCharTensor* Tensor::THTensor<THCudaCharTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kInt8) {
     return (THCudaCharTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("int8_t cuda tensor expected");
@@ -329,7 +359,7 @@ template<> THCudaCharTensor* Tensor::THTensor<THCudaCharTensor>() const
 }
 template<> THCudaShortTensor* Tensor::THTensor<THCudaShortTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kInt16) {
     return (THCudaShortTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("int16_t cuda tensor expected");
@@ -337,7 +367,7 @@ template<> THCudaShortTensor* Tensor::THTensor<THCudaShortTensor>() const
 }
 template<> THCudaIntTensor* Tensor::THTensor<THCudaIntTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kInt32) {
     return (THCudaIntTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("int32_t cuda tensor expected");
@@ -345,7 +375,7 @@ template<> THCudaIntTensor* Tensor::THTensor<THCudaIntTensor>() const
 }
 template<> THCudaLongTensor* Tensor::THTensor<THCudaLongTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kInt64) {
     return (THCudaLongTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("int64_t cuda tensor expected");
@@ -353,7 +383,7 @@ template<> THCudaLongTensor* Tensor::THTensor<THCudaLongTensor>() const
 }
 template<> THCudaTensor* Tensor::THTensor<THCudaTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kFloat) {
     return (THCudaTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("float cuda tensor expected");
@@ -361,7 +391,7 @@ template<> THCudaTensor* Tensor::THTensor<THCudaTensor>() const
 }
 template<> THCudaDoubleTensor* Tensor::THTensor<THCudaDoubleTensor>() const
 {
-  if(device_ == kGPU) {
+  if(device_ == kGPU && type_ == kDouble) {
     return (THCudaDoubleTensor*)(th_tensor_);
   } else {
     throw std::invalid_argument("double cuda tensor expected");
@@ -406,7 +436,7 @@ int64_t Tensor::dim() const
 
 int64_t Tensor::offset() const
 {
-  if(device_ == kUnknown) {
+  if(device_ == kUnknown || isScalar()) {
     return 0;
   } else if(device_ == kCPU) {
     static std::array<std::function<int64_t (const Tensor&)>, 7> dyn = {{
@@ -470,104 +500,85 @@ int64_t Tensor::size(int64_t idx) const
   }
 }
 
-template <typename FS, typename FD, typename T> std::vector<int64_t> tpl_size(FS size, FD nDimension, T* t) {
-  std::vector<int64_t> dims(nDimension(t));
-  for(uint64_t i = 0; i < dims.size(); i++) {
-    dims[i] = size(t, i);
-  }
-  return dims;
-}
-
-template <typename FS, typename FD, typename T> std::vector<int64_t> tpl_size_cuda(FS size, FD nDimension, T* t) {
-  std::vector<int64_t> dims(nDimension(thcstate(), t));
-  for(uint64_t i = 0; i < dims.size(); i++) {
-    dims[i] = size(thcstate(), t, i);
-  }
-  return dims;
-}
+// TH sizes and strides are long, seen as int64_t
+static_assert(sizeof(long) == sizeof(int64_t), "TH sizes and strides (long) must be 64 bits");
 
-std::vector<int64_t> Tensor::size() const
+IntList Tensor::sizes() const
 {
   if(isValue_) {
-    return std::vector<int64_t>{};
+    return IntList();
   } else if(device_ == kCPU) {
-    static std::array<std::function<std::vector<int64_t> (const Tensor&)>, 7> dyn = {{
-        [](const Tensor& t) { return tpl_size(THByteTensor_size, THByteTensor_nDimension, t.THTensor<THByteTensor>()); },
-        [](const Tensor& t) { return tpl_size(THCharTensor_size, THCharTensor_nDimension, t.THTensor<THCharTensor>()); },
-        [](const Tensor& t) { return tpl_size(THShortTensor_size, THShortTensor_nDimension, t.THTensor<THShortTensor>()); },
-        [](const Tensor& t) { return tpl_size(THIntTensor_size, THIntTensor_nDimension, t.THTensor<THIntTensor>()); },
-        [](const Tensor& t) { return tpl_size(THLongTensor_size, THLongTensor_nDimension, t.THTensor<THLongTensor>()); },
-        [](const Tensor& t) { return tpl_size(THFloatTensor_size, THFloatTensor_nDimension, t.THTensor<THFloatTensor>()); },
-        [](const Tensor& t) { return tpl_size(THDoubleTensor_size, THDoubleTensor_nDimension, t.THTensor<THDoubleTensor>()); },
-      }};
-    return dyn.at(type_)(*this);
+    switch(type_) {
+      case kUInt8: { auto t = THTensor<THByteTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt8: { auto t = THTensor<THCharTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt16: { auto t = THTensor<THShortTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt32: { auto t = THTensor<THIntTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt64: { auto t = THTensor<THLongTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kFloat: { auto t = THTensor<THFloatTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kDouble: { auto t = THTensor<THDoubleTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+    }
+    throw std::out_of_range("unsupported type");
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
-    static std::array<std::function<std::vector<int64_t> (const Tensor&)>, 7> dyn = {{
-        [](const Tensor& t) { return tpl_size_cuda(THCudaByteTensor_size, THCudaByteTensor_nDimension, t.THTensor<THCudaByteTensor>()); },
-        [](const Tensor& t) { return tpl_size_cuda(THCudaCharTensor_size, THCudaCharTensor_nDimension, t.THTensor<THCudaCharTensor>()); },
-        [](const Tensor& t) { return tpl_size_cuda(THCudaShortTensor_size, THCudaShortTensor_nDimension, t.THTensor<THCudaShortTensor>()); },
-        [](const Tensor& t) { return tpl_size_cuda(THCudaIntTensor_size, THCudaIntTensor_nDimension, t.THTensor<THCudaIntTensor>()); },
-        [](const Tensor& t) { return tpl_size_cuda(THCudaLongTensor_size, THCudaLongTensor_nDimension, t.THTensor<THCudaLongTensor>()); },
-        [](const Tensor& t) { return tpl_size_cuda(THCudaTensor_size, THCudaTensor_nDimension, t.THTensor<THCudaTensor>()); },
-        [](const Tensor& t) { return tpl_size_cuda(THCudaDoubleTensor_size, THCudaDoubleTensor_nDimension, t.THTensor<THCudaDoubleTensor>()); },
-      }};
-    return dyn.at(type_)(*this);
+    switch(type_) {
+      case kUInt8: { auto t = THTensor<THCudaByteTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt8: { auto t = THTensor<THCudaCharTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt16: { auto t = THTensor<THCudaShortTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt32: { auto t = THTensor<THCudaIntTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kInt64: { auto t = THTensor<THCudaLongTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kFloat: { auto t = THTensor<THCudaTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+      case kDouble: { auto t = THTensor<THCudaDoubleTensor>(); return IntList((int64_t*)t->size, t->nDimension); }
+    }
+    throw std::out_of_range("unsupported type");
 #endif
   } else {
     throw std::invalid_argument("unsupported device");
   }
 }
 
-template <typename FS, typename FD, typename T> std::vector<int64_t> tpl_stride(FS stride, FD nDimension, T* t) {
-  std::vector<int64_t> dims(nDimension(t));
-  for(uint64_t i = 0; i < dims.size(); i++) {
-    dims[i] = stride(t, i);
-  }
-  return dims;
-}
-
-template <typename FS, typename FD, typename T> std::vector<int64_t> tpl_stride_cuda(FS stride, FD nDimension, T* t) {
-  std::vector<int64_t> dims(nDimension(thcstate(), t));
-  for(uint64_t i = 0; i < dims.size(); i++) {
-    dims[i] = stride(thcstate(), t, i);
-  }
-  return dims;
+std::vector<int64_t> Tensor::size() const
+{
+  return sizes().vec();
 }
 
-std::vector<int64_t> Tensor::stride() const
+IntList Tensor::strides() const
 {
   if(isValue_) {
-    return std::vector<int64_t>{};
+    return IntList();
   } else if(device_ == kCPU) {
-    static std::array<std::function<std::vector<int64_t> (const Tensor&)>, 7> dyn = {{
-        [](const Tensor& t) { return tpl_stride(THByteTensor_stride, THByteTensor_nDimension, t.THTensor<THByteTensor>()); },
-        [](const Tensor& t) { return tpl_stride(THCharTensor_stride, THCharTensor_nDimension, t.THTensor<THCharTensor>()); },
-        [](const Tensor& t) { return tpl_stride(THShortTensor_stride, THShortTensor_nDimension, t.THTensor<THShortTensor>()); },
-        [](const Tensor& t) { return tpl_stride(THIntTensor_stride, THIntTensor_nDimension, t.THTensor<THIntTensor>()); },
-        [](const Tensor& t) { return tpl_stride(THLongTensor_stride, THLongTensor_nDimension, t.THTensor<THLongTensor>()); },
-        [](const Tensor& t) { return tpl_stride(THFloatTensor_stride, THFloatTensor_nDimension, t.THTensor<THFloatTensor>()); },
-        [](const Tensor& t) { return tpl_stride(THDoubleTensor_stride, THDoubleTensor_nDimension, t.THTensor<THDoubleTensor>()); },
-      }};
-    return dyn.at(type_)(*this);
+    switch(type_) {
+      case kUInt8: { auto t = THTensor<THByteTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt8: { auto t = THTensor<THCharTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt16: { auto t = THTensor<THShortTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt32: { auto t = THTensor<THIntTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt64: { auto t = THTensor<THLongTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kFloat: { auto t = THTensor<THFloatTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kDouble: { auto t = THTensor<THDoubleTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+    }
+    throw std::out_of_range("unsupported type");
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
-    static std::array<std::function<std::vector<int64_t> (const Tensor&)>, 7> dyn = {{
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaByteTensor_stride, THCudaByteTensor_nDimension, t.THTensor<THCudaByteTensor>()); },
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaCharTensor_stride, THCudaCharTensor_nDimension, t.THTensor<THCudaCharTensor>()); },
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaShortTensor_stride, THCudaShortTensor_nDimension, t.THTensor<THCudaShortTensor>()); },
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaIntTensor_stride, THCudaIntTensor_nDimension, t.THTensor<THCudaIntTensor>()); },
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaLongTensor_stride, THCudaLongTensor_nDimension, t.THTensor<THCudaLongTensor>()); },
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaTensor_stride, THCudaTensor_nDimension, t.THTensor<THCudaTensor>()); },
-        [](const Tensor& t) { return tpl_stride_cuda(THCudaDoubleTensor_stride, THCudaDoubleTensor_nDimension, t.THTensor<THCudaDoubleTensor>()); },
-      }};
-    return dyn.at(type_)(*this);
+    switch(type_) {
+      case kUInt8: { auto t = THTensor<THCudaByteTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt8: { auto t = THTensor<THCudaCharTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt16: { auto t = THTensor<THCudaShortTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt32: { auto t = THTensor<THCudaIntTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kInt64: { auto t = THTensor<THCudaLongTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kFloat: { auto t = THTensor<THCudaTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+      case kDouble: { auto t = THTensor<THCudaDoubleTensor>(); return IntList((int64_t*)t->stride, t->nDimension); }
+    }
+    throw std::out_of_range("unsupported type");
 #endif
   } else {
     throw std::invalid_argument("unsupported device");
   }
 }
 
+std::vector<int64_t> Tensor::stride() const
+{
+  return strides().vec();
+}
+
 int64_t Tensor::stride(int64_t idx) const
 {
   if((device_ == kUnknown) || idx < 0 || idx >= this->dim() || isValue_) {
@@ -617,7 +628,8 @@ int64_t Tensor::elemSize() const
 
 Tensor& Tensor::resizeAs(const Tensor &o, bool wtype)
 {
-  resize(o.size(), (wtype ? o.type() : type_), (wtype ? o.device() : device_));
+  // the sizes of o itself would not survive resize(type, device)
+  resize(this == &o ? IntList(o.size()) : o.sizes(), (wtype ? o.type() : type_), (wtype ? o.device() : device_));
   return *this;
 }
 
@@ -677,64 +689,50 @@ Tensor& Tensor::resize(TensorType type, TensorDevice device)
   return *this;
 }
 
-Tensor& Tensor::resize(const std::vector<int64_t>& sizes)
+Tensor& Tensor::resize(IntList sizes)
 {
-  std::vector<int64_t> strides(sizes.size());
-  int64_t stride = 1;
-  for(int64_t i = sizes.size()-1; i >= 0; i--) {
-    if(sizes[i] <= 0) {
+  for(int64_t size : sizes) {
+    if(size <= 0) {
       throw std::invalid_argument("sizes must be positive numbers");
     }
-    strides[i] = stride;
-    stride *= sizes[i];
   }
-  resize(sizes, strides);
-  return *this;
+  return resize(sizes, IntList());
 }
 
-Tensor& Tensor::resize(const std::vector<int64_t>& sizes, const std::vector<int64_t>& strides)
+// straight from the sizes and strides, no THLongStorage
+Tensor& Tensor::resize(IntList sizes, IntList strides)
 {
-  if(sizes.size() != strides.size()) {
+  if(!strides.empty() && sizes.size() != strides.size()) {
     throw std::invalid_argument("sizes and strides size mismatch");
   }
-  int64_t dim = sizes.size();
-  isValue_ = (dim == 0 ? true : false);
-  auto sizes_s = std::shared_ptr<THLongStorage>(THLongStorage_newWithSize(isValue_ ? 1 : dim), THLongStorage_free);
-  auto strides_s = std::shared_ptr<THLongStorage>(THLongStorage_newWithSize(isValue_ ? 1 : dim), THLongStorage_free);
-  if(isValue_) {
-    sizes_s->data[0] = 1;
-    strides_s->data[0] = 1;
-  } else {
-    for(uint64_t i = 0; i < sizes.size(); i++) {
-      sizes_s->data[i] = sizes[i];
-    }
-    for(uint64_t i = 0; i < strides.size(); i++) {
-      strides_s->data[i] = strides[i];
-    }
-  }
+  static const int64_t one[1] = {1};
+  isValue_ = sizes.empty();
+  int dim = isValue_ ? 1 : sizes.size();
+  long* sizes_p = (long*)(isValue_ ? one : sizes.data());
+  long* strides_p = (long*)(isValue_ ? one : (strides.empty() ? nullptr : strides.data()));
   if(device_ == kCPU) {
-    static std::array<std::function<void (Tensor&, THLongStorage*, THLongStorage*)>, 7> dyn = {{
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THByteTensor_resize(t.THTensor<THByteTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCharTensor_resize(t.THTensor<THCharTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THShortTensor_resize(t.THTensor<THShortTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THIntTensor_resize(t.THTensor<THIntTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THLongTensor_resize(t.THTensor<THLongTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THFloatTensor_resize(t.THTensor<THFloatTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THDoubleTensor_resize(t.THTensor<THDoubleTensor>(), sizes, strides);}
+    static std::array<std::function<void (Tensor&, int, long*, long*)>, 7> dyn = {{
+        [](Tensor& t, int dim, long *sizes, long *strides) {THByteTensor_resizeNd(t.THTensor<THByteTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCharTensor_resizeNd(t.THTensor<THCharTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THShortTensor_resizeNd(t.THTensor<THShortTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THIntTensor_resizeNd(t.THTensor<THIntTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THLongTensor_resizeNd(t.THTensor<THLongTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THFloatTensor_resizeNd(t.THTensor<THFloatTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THDoubleTensor_resizeNd(t.THTensor<THDoubleTensor>(), dim, sizes, strides);}
       }};
-    dyn.at(type_)(*this, sizes_s.get(), strides_s.get());
+    dyn.at(type_)(*this, dim, sizes_p, strides_p);
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
-    static std::array<std::function<void (Tensor&, THLongStorage*, THLongStorage*)>, 7> dyn = {{
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaByteTensor_resize(thcstate(), t.THTensor<THCudaByteTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaCharTensor_resize(thcstate(), t.THTensor<THCudaCharTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaShortTensor_resize(thcstate(), t.THTensor<THCudaShortTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaIntTensor_resize(thcstate(), t.THTensor<THCudaIntTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaLongTensor_resize(thcstate(), t.THTensor<THCudaLongTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaTensor_resize(thcstate(), t.THTensor<THCudaTensor>(), sizes, strides);},
-        [](Tensor& t, THLongStorage *sizes, THLongStorage *strides) {THCudaDoubleTensor_resize(thcstate(), t.THTensor<THCudaDoubleTensor>(), sizes, strides);}
+    static std::array<std::function<void (Tensor&, int, long*, long*)>, 7> dyn = {{
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaByteTensor_resizeNd(thcstate(), t.THTensor<THCudaByteTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaCharTensor_resizeNd(thcstate(), t.THTensor<THCudaCharTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaShortTensor_resizeNd(thcstate(), t.THTensor<THCudaShortTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaIntTensor_resizeNd(thcstate(), t.THTensor<THCudaIntTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaLongTensor_resizeNd(thcstate(), t.THTensor<THCudaLongTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaTensor_resizeNd(thcstate(), t.THTensor<THCudaTensor>(), dim, sizes, strides);},
+        [](Tensor& t, int dim, long *sizes, long *strides) {THCudaDoubleTensor_resizeNd(thcstate(), t.THTensor<THCudaDoubleTensor>(), dim, sizes, strides);}
       }};
-    dyn.at(type_)(*this, sizes_s.get(), strides_s.get());
+    dyn.at(type_)(*this, dim, sizes_p, strides_p);
 #endif
   } else {
     throw std::invalid_argument("unsupported device");
@@ -742,14 +740,14 @@ Tensor& Tensor::resize(const std::vector<int64_t>& sizes, const std::vector<int6
   return *this;
 }
 
-Tensor& Tensor::resize(const std::vector<int64_t>& sizes, TensorType type, TensorDevice device)
+Tensor& Tensor::resize(IntList sizes, TensorType type, TensorDevice device)
 {
   resize(type, device);
   resize(sizes);
   return *this;
 }
 
-Tensor& Tensor::resize(const std::vector<int64_t>& sizes, const std::vector<int64_t>& strides, TensorType type, TensorDevice device)
+Tensor& Tensor::resize(IntList sizes, IntList strides, TensorType type, TensorDevice device)
 {
   resize(type, device);
   resize(sizes, strides);
@@ -761,7 +759,9 @@ template<> uint8_t* Tensor::data() const
   if(type_ != kUInt8) {
     throw std::invalid_argument("uint8_t tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (uint8_t*)&scalar_;
+  } else if(device_ == kCPU) {
     return THByteTensor_data(THTensor<THByteTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -776,7 +776,9 @@ template<> int8_t* Tensor::data() const
   if(type_ != kInt8) {
     throw std::invalid_argument("int8_t tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (int8_t*)&scalar_;
+  } else if(device_ == kCPU) {
     return (int8_t*)THCharTensor_data(THTensor<THCharTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -791,7 +793,9 @@ template<> int16_t* Tensor::data() const
   if(type_ != kInt16) {
     throw std::invalid_argument("int16_t tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (int16_t*)&scalar_;
+  } else if(device_ == kCPU) {
     return THShortTensor_data(THTensor<THShortTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -806,7 +810,9 @@ template<> int32_t* Tensor::data() const
   if(type_ != kInt32) {
     throw std::invalid_argument("int32_t tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (int32_t*)&scalar_;
+  } else if(device_ == kCPU) {
     return THIntTensor_data(THTensor<THIntTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -821,7 +827,9 @@ template<> int64_t* Tensor::data() const
   if(type_ != kInt64) {
     throw std::invalid_argument("int64_t tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (int64_t*)&scalar_;
+  } else if(device_ == kCPU) {
     return (int64_t*)THLongTensor_data(THTensor<THLongTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -836,7 +844,9 @@ template<> float* Tensor::data() const
   if(type_ != kFloat) {
     throw std::invalid_argument("float tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (float*)&scalar_;
+  } else if(device_ == kCPU) {
     return THFloatTensor_data(THTensor<THFloatTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -851,7 +861,9 @@ template<> double* Tensor::data() const
   if(type_ != kDouble) {
     throw std::invalid_argument("double tensor expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    return (double*)&scalar_;
+  } else if(device_ == kCPU) {
     return THDoubleTensor_data(THTensor<THDoubleTensor>());
 #ifdef XT_HAS_CUDA
   } else if(device_ == kGPU) {
@@ -867,7 +879,18 @@ template<typename T> T Tensor::value() const
   if(!isValue_) {
     throw std::invalid_argument("value expected");
   }
-  if(device_ == kCPU) {
+  if(isScalar()) {
+    switch(type_) {
+      case kUInt8: return (T)*(const uint8_t*)&scalar_;
+      case kInt8: return (T)*(const int8_t*)&scalar_;
+      case kInt16: return (T)*(const int16_t*)&scalar_;
+      case kInt32: return (T)*(const int32_t*)&scalar_;
+      case kInt64: return (T)*(const int64_t*)&scalar_;
+      case kFloat: return (T)*(const float*)&scalar_;
+      case kDouble: return (T)*(const double*)&scalar_;
+    }
+    throw std::out_of_range("unsupported type");
+  } else if(device_ == kCPU) {
     static std::array<std::function<T (const Tensor&)>, 7> dyn = {{
         [](const Tensor& t) {return (T)THByteTensor_get1d(t.THTensor<THByteTensor>(), 0); },
         [](const Tensor& t) {return (T)THCharTensor_get1d(t.THTensor<THCharTensor>(), 0); },
@@ -903,6 +926,37 @@ template int64_t Tensor::value() const;
 template float Tensor::value() const;
 template double Tensor::value() const;
 
+bool Tensor::isScalar() const
+{
+  return device_ == kCPU && !__atomic_load_n(&th_tensor_, __ATOMIC_ACQUIRE);
+}
+
+void* Tensor::thTensor() const
+{
+  if(isScalar()) {
+    static std::array<std::function<void* (const void*)>, 7> dyn = {{
+        [](const void* v) -> void* {THByteTensor* t = THByteTensor_newWithSize1d(1); THByteTensor_set1d(t, 0, *(const uint8_t*)v); return t;},
+        [](const void* v) -> void* {THCharTensor* t = THCharTensor_newWithSize1d(1); THCharTensor_set1d(t, 0, *(const int8_t*)v); return t;},
+        [](const void* v) -> void* {THShortTensor* t = THShortTensor_newWithSize1d(1); THShortTensor_set1d(t, 0, *(const int16_t*)v); return t;},
+        [](const void* v) -> void* {THIntTensor* t = THIntTensor_newWithSize1d(1); THIntTensor_set1d(t, 0, *(const int32_t*)v); return t;},
+        [](const void* v) -> void* {THLongTensor* t = THLongTensor_newWithSize1d(1); THLongTensor_set1d(t, 0, *(const int64_t*)v); return t;},
+        [](const void* v) -> void* {THFloatTensor* t = THFloatTensor_newWithSize1d(1); THFloatTensor_set1d(t, 0, *(const float*)v); return t;},
+        [](const void* v) -> void* {THDoubleTensor* t = THDoubleTensor_newWithSize1d(1); THDoubleTensor_set1d(t, 0, *(const double*)v); return t;}
+      }};
+    // threads reading the same const value may get here at once: one TH
+    // tensor is published, the others are freed
+    void* t = dyn.at(type_)(&scalar_);
+    void* expected = nullptr;
+    if(!__atomic_compare_exchange_n(&th_tensor_, &expected, t, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      Tensor loser;
+      loser.type_ = type_;
+      loser.device_ = kCPU;
+      loser.th_tensor_ = t;
+    }
+  }
+  return th_tensor_;
+}
+
 void Tensor::retain() const
 {
   if(device_ == kCPU) {
@@ -2,6 +2,7 @@
 #define XT_TENSOR_H
 
 #include <vector>
+#include <initializer_list>
 #include <memory>
 #include <functional>
 #include <map>
@@ -31,6 +32,87 @@ enum TensorType {
   kDouble
 };
 
+// sizes or strides: a view of a std::vector or of the sizes of a Tensor
+// (valid until the tensor is resized or freed), or a braced list ({2, 3}),
+// copied into the IntList up to kInline elements, so that it can be stored
+// (a longer braced list is viewed, and lives until the end of the call)
+class IntList {
+public:
+  static const size_t kInline = 8;
+  IntList() : data_(nullptr), size_(0) {}
+  IntList(const int64_t* data, size_t size) : data_(data), size_(size) {}
+  IntList(const std::vector<int64_t>& v) : data_(v.data()), size_(v.size()) {}
+  IntList(std::initializer_list<int64_t> l) : data_(inline_), size_(l.size())
+  {
+    if(size_ <= kInline) {
+      for(size_t i = 0; i < size_; i++) {
+        inline_[i] = l.begin()[i];
+      }
+    } else {
+      data_ = l.begin();
+    }
+  }
+  IntList(const IntList& o) { *this = o; }
+  IntList& operator=(const IntList& o)
+  {
+    size_ = o.size_;
+    data_ = o.data_;
+    if(o.data_ == o.inline_) {
+      for(size_t i = 0; i < size_; i++) {
+        inline_[i] = o.inline_[i];
+      }
+      data_ = inline_;
+    }
+    return *this;
+  }
+  const int64_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const int64_t* begin() const { return data_; }
+  const int64_t* end() const { return data_+size_; }
+  int64_t operator[](size_t i) const { return data_[i]; }
+  std::vector<int64_t> vec() const { return std::vector<int64_t>(begin(), end()); }
+  friend bool operator==(IntList lhs, IntList rhs)
+  {
+    if(lhs.size_ != rhs.size_) {
+      return false;
+    }
+    for(size_t i = 0; i < lhs.size_; i++) {
+      if(lhs.data_[i] != rhs.data_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  friend bool operator!=(IntList lhs, IntList rhs) { return !(lhs == rhs); }
+private:
+  const int64_t* data_;
+  size_t size_;
+  int64_t inline_[kInline];
+};
+
+// access to the file of a mapped tensor (see Tensor::map)
+enum TensorMapMode {
+  kMapReadOnly, // writes to the tensor fault
+  kMapPrivate, // copy-on-write: writes stay in the process
+  kMapShared // writes go to the file
+};
+
+// a tensor in shared memory (see Tensor::shared), as plain data: it can be
+// sent to another process of the machine (pipe, socket), which opens the
+// same memory with Tensor::shared(handle)
+struct SharedHandle
+{
+  static const int kMaxDim = 16;
+  char name[64]; // of the shared memory object
+  int64_t storageSize; // elements
+  int64_t offset; // elements, in the storage
+  int32_t type; // TensorType
+  int32_t dim;
+  int64_t sizes[kMaxDim];
+  int64_t strides[kMaxDim];
+};
+
 class Tensor {
 public:
   Tensor(); /* not allocated, no type */
@@ -40,24 +122,50 @@ public:
   Tensor& operator=(const Tensor& o) &&; // (deep copy)
   Tensor& operator=(Tensor&& o) &;
   Tensor(TensorType type, TensorDevice device = kCPU); /* TH struct allocated, not the data */
-  Tensor(const std::vector<int64_t>& sizes, TensorType type, TensorDevice device = kCPU); /* full allocated */
-  Tensor(const std::vector<int64_t>& sizes, const std::vector<int64_t>& strides, TensorType type, TensorDevice device = kCPU); /* full allocated */
-  template<typename T> Tensor(T value); /* creates a 0-dim tensor with given value */
+  Tensor(IntList sizes, TensorType type, TensorDevice device = kCPU); /* full allocated */
+  Tensor(IntList sizes, IntList strides, TensorType type, TensorDevice device = kCPU); /* full allocated */
+  template<typename T> Tensor(T value); /* creates a 0-dim tensor with given value (no allocation, see below) */
+  // tensor whose storage is a mapping of file filename, which starts with a
+  // small header recording type, sizes and strides: no copy, pages are read
+  // on first access
+  static Tensor map(const std::string& filename, TensorMapMode mode = kMapReadOnly);
+  // creates (or replaces) filename for a contiguous tensor (zeros), mapped shared
+  static Tensor map(const std::string& filename, IntList sizes, TensorType type);
+  // CPU tensor on the memory at data (sizes and strides in elements, empty
+  // strides: contiguous), without copy; deleter(data), if any, is called by
+  // the thread freeing the last tensor on it (it must not throw); the tensor
+  // cannot grow beyond this memory
+  static Tensor from(void* data, IntList sizes, IntList strides, TensorType type,
+                     std::function<void (void*)> deleter = nullptr);
+  // data() of a CPU tensor, with a handle holding its storage: the memory
+  // outlives the tensor (but is reallocated if the tensor grows); empty for a
+  // tensor without storage
+  std::shared_ptr<void> share() const;
+  // CPU tensor (zeros, contiguous) in a new object of shared memory, which
+  // other processes open from its handle(); the memory is refcounted across
+  // processes, and freed with the last tensor on it: the creator keeps its
+  // tensor until the others have opened theirs (see SharedPool to send
+  // batches: the same memory, refilled)
+  static Tensor shared(IntList sizes, TensorType type);
+  static Tensor shared(const SharedHandle& handle);
+  SharedHandle handle() const; // of a tensor in shared memory
   //  Tensor(Tensor &o, int64_t offset, std::vector<int64_t> sizes, std::vector<int64_t> strides); /* view */
   int64_t dim() const;
   int64_t offset() const; /* no notion of storage */
   int64_t size(int64_t dim) const;
   std::vector<int64_t> size() const;
+  IntList sizes() const; // no copy, empty for a value
   int64_t stride(int64_t dim) const;
   std::vector<int64_t> stride() const;
+  IntList strides() const; // no copy, empty for a value
   int64_t elemSize() const;
-  template<typename T> void value(T value, TensorDevice device=kCPU); // resize to value (0-dim tensor)
+  template<typename T> void value(T value, TensorDevice device=kCPU); // resize to value (0-dim tensor, held inline on kCPU)
   Tensor& tovalue(); // convert a 1-dim tensor of size 1 into a value
   Tensor& resize(TensorType type, TensorDevice device = kCPU); // empty (kGPU or kCPU)
-  Tensor& resize(const std::vector<int64_t>& sizes);
-  Tensor& resize(const std::vector<int64_t>& sizes, const std::vector<int64_t>& strides);
-  Tensor& resize(const std::vector<int64_t>& sizes, TensorType type, TensorDevice device = kCPU);
-  Tensor& resize(const std::vector<int64_t>& sizes, const std::vector<int64_t>& strides, TensorType type, TensorDevice device = kCPU);
+  Tensor& resize(IntList sizes);
+  Tensor& resize(IntList sizes, IntList strides); // empty strides: contiguous
+  Tensor& resize(IntList sizes, TensorType type, TensorDevice device = kCPU);
+  Tensor& resize(IntList sizes, IntList strides, TensorType type, TensorDevice device = kCPU);
   Tensor& resizeAs(const Tensor& o, bool wtype=false); // wtype = true: use same type/device than o
   TensorDevice device() const;
   TensorType type() const;
@@ -95,6 +203,8 @@ public:
 private:
   void retain() const;
   void release() const;
+  bool isScalar() const;
+  void* thTensor() const;
   TensorType type_;
   TensorDevice device_;
 
@@ -102,7 +212,18 @@ private:
   /* highly subject to change */
   /* for now we rely on TH */
   bool isValue_;
-  void* th_tensor_;
+  mutable void* th_tensor_;
+
+  // a CPU value made by Tensor(T) or value(T) is held here, with no TH tensor
+  // (isScalar()): reading it, or passing it to an op as a number, allocates
+  // nothing; thTensor() makes the TH tensor when TH needs one (the value then
+  // lives in th_tensor_, set once with an atomic compare-and-swap, so that
+  // threads can read the same const value)
+  // unlike TH tensors, such a value is copied by copies of the Tensor
+  union {
+    int64_t i;
+    double d;
+  } scalar_;
 };
 
 } // namespace xt
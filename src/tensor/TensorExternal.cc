@@ -0,0 +1,209 @@
+#include "Tensor.h"
+#include <array>
+#include <memory>
+#include "TH.h"
+#undef THTensor
+
+namespace xt {
+
+// storages of Tensor::from: the memory of the caller, given back to its
+// deleter (the context of the allocator) with the storage
+struct ExternalData
+{
+  std::function<void (void*)> deleter;
+};
+
+static void* externalAlloc(void* ctx, ptrdiff_t size)
+{
+  THError("cannot allocate external data");
+  return nullptr;
+}
+
+static void* externalRealloc(void* ctx, void* ptr, ptrdiff_t size)
+{
+  THError("cannot realloc external data");
+  return nullptr;
+}
+
+static void externalFree(void* ctx, void* ptr)
+{
+  ExternalData* external = (ExternalData*)ctx;
+  if(external->deleter) {
+    external->deleter(ptr);
+  }
+  delete external;
+}
+
+static THAllocator externalAllocator = {
+  externalAlloc,
+  externalRealloc,
+  externalFree
+};
+
+// TH tensor on a storage of size elements at data
+static void* newExternalTensor(TensorType type, void* data, ptrdiff_t size, ExternalData* external,
+                               int dim, long* sizes, long* strides)
+{
+  static std::array<std::function<void* (void*, ptrdiff_t, ExternalData*, int, long*, long*)>, 7> dyn = {{
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THByteStorage* s = THByteStorage_newWithDataAndAllocator((uint8_t*)data, size, &externalAllocator, e);
+        THByteTensor* t = THByteTensor_new();
+        THByteTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THByteStorage_free(s);
+        return t;
+      },
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THCharStorage* s = THCharStorage_newWithDataAndAllocator((char*)data, size, &externalAllocator, e);
+        THCharTensor* t = THCharTensor_new();
+        THCharTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THCharStorage_free(s);
+        return t;
+      },
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THShortStorage* s = THShortStorage_newWithDataAndAllocator((int16_t*)data, size, &externalAllocator, e);
+        THShortTensor* t = THShortTensor_new();
+        THShortTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THShortStorage_free(s);
+        return t;
+      },
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THIntStorage* s = THIntStorage_newWithDataAndAllocator((int32_t*)data, size, &externalAllocator, e);
+        THIntTensor* t = THIntTensor_new();
+        THIntTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THIntStorage_free(s);
+        return t;
+      },
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THLongStorage* s = THLongStorage_newWithDataAndAllocator((long*)data, size, &externalAllocator, e);
+        THLongTensor* t = THLongTensor_new();
+        THLongTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THLongStorage_free(s);
+        return t;
+      },
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THFloatStorage* s = THFloatStorage_newWithDataAndAllocator((float*)data, size, &externalAllocator, e);
+        THFloatTensor* t = THFloatTensor_new();
+        THFloatTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THFloatStorage_free(s);
+        return t;
+      },
+      [](void* data, ptrdiff_t size, ExternalData* e, int dim, long* sizes, long* strides) -> void* {
+        THDoubleStorage* s = THDoubleStorage_newWithDataAndAllocator((double*)data, size, &externalAllocator, e);
+        THDoubleTensor* t = THDoubleTensor_new();
+        THDoubleTensor_setStorageNd(t, s, 0, dim, sizes, strides);
+        THDoubleStorage_free(s);
+        return t;
+      }
+    }};
+  return dyn.at(type)(data, size, external, dim, sizes, strides);
+}
+
+Tensor Tensor::from(void* data, IntList sizes, IntList strides, TensorType type, std::function<void (void*)> deleter)
+{
+  if(type < kUInt8 || type > kDouble) {
+    throw std::invalid_argument("unknown type");
+  }
+  if(!strides.empty() && strides.size() != sizes.size()) {
+    throw std::invalid_argument("as many strides as sizes expected");
+  }
+
+  // elements of the storage: up to the last element of the tensor (none if
+  // it is empty); shapes whose elements overflow int64_t are rejected
+  int64_t size = 1, last = 0;
+  for(int64_t i = sizes.size()-1; i >= 0; i--) {
+    int64_t stride = (strides.empty() ? size : strides[i]);
+    if(sizes[i] < 0 || stride < 0) {
+      throw std::invalid_argument("sizes and strides must be non-negative numbers");
+    }
+    if((sizes[i] > 0 && size > INT64_MAX/sizes[i])
+       || (stride > 0 && sizes[i]-1 > (INT64_MAX-1 - last)/stride)) {
+      throw std::invalid_argument("sizes and strides too large");
+    }
+    if(sizes[i] > 0) {
+      last += (sizes[i]-1)*stride;
+    }
+    size *= sizes[i];
+  }
+  if(size == 0) {
+    last = -1;
+  }
+  if(!data && last >= 0) {
+    throw std::invalid_argument("null data for a tensor of some elements");
+  }
+
+  // a value is held by a TH tensor of size 1 (as a value from Tensor::map)
+  const long one = 1;
+  Tensor t;
+  t.type_ = type;
+  t.device_ = kCPU;
+  t.isValue_ = sizes.empty();
+  // owned by the storage once it is made
+  std::unique_ptr<ExternalData> external(new ExternalData{deleter});
+  t.th_tensor_ = newExternalTensor(type, data, last+1, external.get(),
+                                   t.isValue_ ? 1 : sizes.size(),
+                                   (long*)(t.isValue_ ? &one : sizes.data()),
+                                   (long*)(t.isValue_ ? &one : strides.empty() ? nullptr : strides.data()));
+  external.release();
+  return t;
+}
+
+std::shared_ptr<void> Tensor::share() const
+{
+  if(device_ != kCPU) {
+    throw std::invalid_argument("CPU tensor expected");
+  }
+  static std::array<std::function<std::shared_ptr<void> (void*)>, 7> dyn = {{
+      [](void* tensor) -> std::shared_ptr<void> {
+        THByteTensor* t = (THByteTensor*)tensor;
+        THByteStorage* s = t->storage;
+        if(!s) return nullptr;
+        THByteStorage_retain(s);
+        return std::shared_ptr<void>(THByteTensor_data(t), [s](void*) {THByteStorage_free(s);});
+      },
+      [](void* tensor) -> std::shared_ptr<void> {
+        THCharTensor* t = (THCharTensor*)tensor;
+        THCharStorage* s = t->storage;
+        if(!s) return nullptr;
+        THCharStorage_retain(s);
+        return std::shared_ptr<void>(THCharTensor_data(t), [s](void*) {THCharStorage_free(s);});
+      },
+      [](void* tensor) -> std::shared_ptr<void> {
+        THShortTensor* t = (THShortTensor*)tensor;
+        THShortStorage* s = t->storage;
+        if(!s) return nullptr;
+        THShortStorage_retain(s);
+        return std::shared_ptr<void>(THShortTensor_data(t), [s](void*) {THShortStorage_free(s);});
+      },
+      [](void* tensor) -> std::shared_ptr<void> {
+        THIntTensor* t = (THIntTensor*)tensor;
+        THIntStorage* s = t->storage;
+        if(!s) return nullptr;
+        THIntStorage_retain(s);
+        return std::shared_ptr<void>(THIntTensor_data(t), [s](void*) {THIntStorage_free(s);});
+      },
+      [](void* tensor) -> std::shared_ptr<void> {
+        THLongTensor* t = (THLongTensor*)tensor;
+        THLongStorage* s = t->storage;
+        if(!s) return nullptr;
+        THLongStorage_retain(s);
+        return std::shared_ptr<void>(THLongTensor_data(t), [s](void*) {THLongStorage_free(s);});
+      },
+      [](void* tensor) -> std::shared_ptr<void> {
+        THFloatTensor* t = (THFloatTensor*)tensor;
+        THFloatStorage* s = t->storage;
+        if(!s) return nullptr;
+        THFloatStorage_retain(s);
+        return std::shared_ptr<void>(THFloatTensor_data(t), [s](void*) {THFloatStorage_free(s);});
+      },
+      [](void* tensor) -> std::shared_ptr<void> {
+        THDoubleTensor* t = (THDoubleTensor*)tensor;
+        THDoubleStorage* s = t->storage;
+        if(!s) return nullptr;
+        THDoubleStorage_retain(s);
+        return std::shared_ptr<void>(THDoubleTensor_data(t), [s](void*) {THDoubleStorage_free(s);});
+      }
+    }};
+  return dyn.at(type_)(thTensor()); // a value gets its TH tensor
+}
+
+}
@@ -0,0 +1,217 @@
+#include "Tensor.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include "TH.h"
+#undef THTensor
+
+namespace xt {
+
+// file of a mapped tensor: the header, the sizes and strides (int64_t each),
+// zeros up to headerSize (a multiple of kMapAlign, which keeps the data
+// aligned), then the storage
+// all in the byte order of the writer, recorded in endian
+
+static const char kMapMagic[8] = {'X', 'T', 'T', 'E', 'N', 'S', 'O', 'R'};
+static const uint32_t kMapEndian = 0x01020304;
+static const uint32_t kMapVersion = 1;
+static const int64_t kMapAlign = 64;
+static const int64_t kMapMaxDim = 64;
+
+struct MapHeader
+{
+  char magic[8];
+  uint32_t endian;
+  uint32_t version;
+  int32_t type; // TensorType
+  int32_t elemSize;
+  int64_t dim; // 0 for a value
+  int64_t headerSize; // bytes
+  int64_t storageSize; // elements
+  int64_t offset; // elements, in the storage
+};
+
+static std::runtime_error mapError(const std::string& filename, const std::string& what)
+{
+  return std::runtime_error("tensor file <" + filename + ">: " + what);
+}
+
+// TH tensor on the whole file, seen as a storage of the tensor type
+static void* newMappedTensor(TensorType type, const std::string& filename, int flags,
+                             ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides)
+{
+  static std::array<std::function<void* (const char*, int, ptrdiff_t, THLongStorage*, THLongStorage*)>, 7> dyn = {{
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THByteStorage* s = THByteStorage_newWithMapping(f, 0, flags);
+        THByteTensor* t = THByteTensor_newWithStorage(s, offset, sizes, strides);
+        THByteStorage_free(s);
+        return t;
+      },
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THCharStorage* s = THCharStorage_newWithMapping(f, 0, flags);
+        THCharTensor* t = THCharTensor_newWithStorage(s, offset, sizes, strides);
+        THCharStorage_free(s);
+        return t;
+      },
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THShortStorage* s = THShortStorage_newWithMapping(f, 0, flags);
+        THShortTensor* t = THShortTensor_newWithStorage(s, offset, sizes, strides);
+        THShortStorage_free(s);
+        return t;
+      },
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THIntStorage* s = THIntStorage_newWithMapping(f, 0, flags);
+        THIntTensor* t = THIntTensor_newWithStorage(s, offset, sizes, strides);
+        THIntStorage_free(s);
+        return t;
+      },
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THLongStorage* s = THLongStorage_newWithMapping(f, 0, flags);
+        THLongTensor* t = THLongTensor_newWithStorage(s, offset, sizes, strides);
+        THLongStorage_free(s);
+        return t;
+      },
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THFloatStorage* s = THFloatStorage_newWithMapping(f, 0, flags);
+        THFloatTensor* t = THFloatTensor_newWithStorage(s, offset, sizes, strides);
+        THFloatStorage_free(s);
+        return t;
+      },
+      [](const char* f, int flags, ptrdiff_t offset, THLongStorage* sizes, THLongStorage* strides) -> void* {
+        THDoubleStorage* s = THDoubleStorage_newWithMapping(f, 0, flags);
+        THDoubleTensor* t = THDoubleTensor_newWithStorage(s, offset, sizes, strides);
+        THDoubleStorage_free(s);
+        return t;
+      }
+    }};
+  return dyn.at(type)(filename.c_str(), flags, offset, sizes, strides);
+}
+
+Tensor Tensor::map(const std::string& filename, TensorMapMode mode)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if(!file) {
+    throw mapError(filename, "cannot open");
+  }
+  MapHeader header;
+  if(!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, kMapMagic, sizeof(kMapMagic))) {
+    throw mapError(filename, "not a tensor file");
+  }
+  if(header.endian != kMapEndian) {
+    throw mapError(filename, "written with another byte order");
+  }
+  if(header.version != kMapVersion) {
+    throw mapError(filename, "unsupported version " + std::to_string(header.version));
+  }
+  if(header.type < kUInt8 || header.type > kDouble || header.dim < 0 || header.dim > kMapMaxDim) {
+    throw mapError(filename, "corrupted header");
+  }
+  Tensor t;
+  t.type_ = (TensorType)header.type;
+  if(header.elemSize != t.elemSize() || header.headerSize % kMapAlign
+     || header.headerSize < (int64_t)sizeof(header) + 2*header.dim*(int64_t)sizeof(int64_t)) {
+    throw mapError(filename, "corrupted header");
+  }
+
+  int64_t dim = header.dim;
+  std::vector<int64_t> sizes(dim), strides(dim);
+  if(!file.read((char*)sizes.data(), dim*sizeof(int64_t)) || !file.read((char*)strides.data(), dim*sizeof(int64_t))) {
+    throw mapError(filename, "truncated header");
+  }
+  // sizes from the file: checked not to overflow before they are used
+  if(header.storageSize < 0 || header.storageSize > (INT64_MAX - header.headerSize)/header.elemSize) {
+    throw mapError(filename, "corrupted header");
+  }
+  file.seekg(0, std::ios::end);
+  if((int64_t)file.tellg() != header.headerSize + header.storageSize*header.elemSize) {
+    throw mapError(filename, "size does not match its header");
+  }
+  file.close();
+
+  // the tensor must lie within the storage
+  if(header.offset < 0 || header.offset >= header.storageSize) {
+    throw mapError(filename, "tensor out of the storage");
+  }
+  int64_t last = header.offset;
+  for(int64_t i = 0; i < dim; i++) {
+    if(sizes[i] <= 0 || strides[i] < 0) {
+      throw mapError(filename, "invalid sizes or strides");
+    }
+    if(strides[i] > 0 && sizes[i]-1 > (header.storageSize-1 - last)/strides[i]) {
+      throw mapError(filename, "tensor out of the storage");
+    }
+    last += (sizes[i]-1)*strides[i];
+  }
+  if(last >= header.storageSize) {
+    throw mapError(filename, "tensor out of the storage");
+  }
+
+  int flags = (mode == kMapReadOnly ? TH_ALLOCATOR_MAPPED_READONLY :
+               mode == kMapShared ? TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_NOCREATE : 0);
+  t.isValue_ = (dim == 0);
+  auto sizes_s = std::shared_ptr<THLongStorage>(THLongStorage_newWithSize(t.isValue_ ? 1 : dim), THLongStorage_free);
+  auto strides_s = std::shared_ptr<THLongStorage>(THLongStorage_newWithSize(t.isValue_ ? 1 : dim), THLongStorage_free);
+  if(t.isValue_) {
+    sizes_s->data[0] = 1;
+    strides_s->data[0] = 1;
+  }
+  for(int64_t i = 0; i < dim; i++) {
+    sizes_s->data[i] = sizes[i];
+    strides_s->data[i] = strides[i];
+  }
+  t.th_tensor_ = newMappedTensor(t.type_, filename, flags, header.headerSize/header.elemSize + header.offset,
+                                 sizes_s.get(), strides_s.get());
+  t.device_ = kCPU;
+  return t;
+}
+
+Tensor Tensor::map(const std::string& filename, IntList sizes, TensorType type)
+{
+  if(sizes.size() > (size_t)kMapMaxDim) {
+    throw std::invalid_argument("too many dimensions");
+  }
+  MapHeader header;
+  std::memcpy(header.magic, kMapMagic, sizeof(kMapMagic));
+  header.endian = kMapEndian;
+  header.version = kMapVersion;
+  header.type = type;
+  Tensor t;
+  t.type_ = type;
+  header.elemSize = t.elemSize();
+  header.dim = sizes.size();
+  header.headerSize = (sizeof(header) + 2*sizes.size()*sizeof(int64_t) + kMapAlign-1)/kMapAlign*kMapAlign;
+  header.offset = 0;
+  std::vector<int64_t> strides(sizes.size());
+  int64_t stride = 1;
+  for(int64_t i = sizes.size()-1; i >= 0; i--) {
+    if(sizes[i] <= 0) {
+      throw std::invalid_argument("sizes must be positive numbers");
+    }
+    // checked before the file is made: its bytes must not overflow
+    if(sizes[i] > (INT64_MAX - header.headerSize)/header.elemSize/stride) {
+      throw std::invalid_argument("sizes too large");
+    }
+    strides[i] = stride;
+    stride *= sizes[i];
+  }
+  header.storageSize = stride;
+
+  // the storage is made of zeros by extending the file: nothing is written
+  {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    std::vector<char> padding(header.headerSize - sizeof(header) - 2*sizes.size()*sizeof(int64_t), 0);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)sizes.data(), sizes.size()*sizeof(int64_t));
+    file.write((const char*)strides.data(), strides.size()*sizeof(int64_t));
+    file.write(padding.data(), padding.size());
+    file.seekp(header.headerSize + header.storageSize*header.elemSize - 1);
+    file.put(0);
+    if(!file) {
+      throw mapError(filename, "cannot write");
+    }
+  }
+  return map(filename, kMapShared);
+}
+
+}
@@ -1,18 +1,42 @@
 #include "Tensor.h"
 #include "TensorTH.h"
 #include "dispatch.h"
+#include <functional>
 
 namespace xt {
 
+// arithmetic between values held inline (see Tensor::isScalar): the result
+// of the TH op (in the type of lhs), without any TH tensor
+template<template<typename> class Op>
+struct scalar_op
+{
+  template<typename T> Tensor cpu(const Tensor& lhs, const Tensor& rhs) { return Tensor(Op<T>()(lhs.value<T>(), rhs.value<T>())); }
+  template<typename T> Tensor gpu(const Tensor& lhs, const Tensor& rhs) { throw std::invalid_argument("unsupported device"); }
+};
+
+// same, in place (lhs op= rhs)
+template<template<typename> class Op>
+struct scalar_assign_op
+{
+  template<typename T> void cpu(Tensor& lhs, const Tensor& rhs) { T* p = lhs.data<T>(); *p = Op<T>()(*p, rhs.value<T>()); }
+  template<typename T> void gpu(Tensor& lhs, const Tensor& rhs) { throw std::invalid_argument("unsupported device"); }
+};
+
 Tensor& Tensor::operator+=(const Tensor& rhs)
 {
+  if(isScalar() && rhs.isValue_) {
+    dispatch<scalar_assign_op<std::plus>>(*this, rhs);
+    return *this;
+  }
   add_(*this, *this, rhs);
   return *this;
 }
 
 Tensor& Tensor::operator/=(const Tensor& rhs)
 {
-  if(rhs.dim() == 0)
+  if(isScalar() && rhs.isValue_)
+    dispatch<scalar_assign_op<std::divides>>(*this, rhs);
+  else if(rhs.dim() == 0)
     div_(*this, *this, rhs);
   else
     cdiv_(*this, *this, rhs);
@@ -51,17 +75,25 @@ Tensor Tensor::operator[](const Tensor &rhs)
 
 Tensor operator+(const Tensor& lhs, const Tensor& rhs)
 {
+  if(lhs.isScalar() && rhs.isValue_) {
+    return dispatch<scalar_op<std::plus>>(lhs, rhs);
+  }
   return add(lhs, rhs);
 }
 
 Tensor operator-(const Tensor& lhs, const Tensor& rhs)
 {
+  if(lhs.isScalar() && rhs.isValue_) {
+    return dispatch<scalar_op<std::minus>>(lhs, rhs);
+  }
   return add(lhs, -1, rhs);
 }
 
 Tensor operator*(const Tensor& lhs, const Tensor& rhs)
 {
-  if(lhs.dim() == 0 || rhs.dim() == 0) {
+  if(lhs.isScalar() && rhs.isValue_) {
+    return dispatch<scalar_op<std::multiplies>>(lhs, rhs);
+  } else if(lhs.dim() == 0 || rhs.dim() == 0) {
     return mul(lhs, rhs);
   } else if(lhs.dim() == 2 && rhs.dim() == 2) {
     return mm(lhs, rhs);
@@ -74,12 +106,20 @@ Tensor operator*(const Tensor& lhs, const Tensor& rhs)
 
 Tensor& Tensor::operator++(int)
 {
+  if(isScalar()) {
+    const Tensor one(1);
+    dispatch<scalar_assign_op<std::plus>>(*this, one);
+    return *this;
+  }
   add_(*this, *this, Tensor(1));
   return *this;
 }
 
 Tensor operator/(const Tensor& lhs, const Tensor& rhs)
 {
+  if(lhs.isScalar() && rhs.isValue_) {
+    return dispatch<scalar_op<std::divides>>(lhs, rhs);
+  }
   return div(lhs, rhs);
 }
 
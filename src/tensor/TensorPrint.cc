@@ -211,13 +211,11 @@ std::ostream& Tensor::print(std::ostream& stream, int64_t linesize) const
     stream << "[Tensor<" << typedesc() << "," << devicedesc() << ">]";    
   } else if(dim() == -1) {
     stream << "[Tensor<" << typedesc() << "," << devicedesc() << "> (empty)]";
+  } else if(isValue_) {
+    stream << std::defaultfloat << value<double>();
   } else {
     Tensor tensor = this->cast<double>(kCPU);
-    if(tensor.dim() == 0) {
-      stream << std::defaultfloat << tensor.data<double>()[0];
-//      stream << "[Tensor<" << typedesc() << "," << devicedesc() << "> (value)]";
-    }
-    else if(tensor.dim() == 1) {
+    if(tensor.dim() == 1) {
       double scale;
       int64_t sz;
       std::tie(scale, sz) =  __printFormat(stream, tensor);
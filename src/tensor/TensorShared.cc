@@ -0,0 +1,266 @@
+#include "Tensor.h"
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include "TH.h"
+#undef THTensor
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xt {
+
+// the storage of a tensor in shared memory is made by the refcounted map
+// allocator of TH: the object holds a small header with the number of
+// storages on it in all processes (the last one unlinks it), then the data
+
+static const int64_t kSharedHeaderSize = 64; // TH_ALLOC_ALIGNMENT of THAllocator.c
+
+static std::runtime_error sharedError(const std::string& name, const std::string& what)
+{
+  return std::runtime_error("shared memory <" + name + ">: " + what);
+}
+
+// bytes of the object name, -1 if there is none
+static int64_t sharedObjectSize(const char* name)
+{
+#ifndef _WIN32
+  int fd = shm_open(name, O_RDONLY, 0);
+  if(fd == -1) {
+    return -1;
+  }
+  struct stat st;
+  int64_t size = (fstat(fd, &st) == 0 ? st.st_size : -1);
+  close(fd);
+  return size;
+#else
+  return -1;
+#endif
+}
+
+// TH tensor on a storage of storageSize elements in the object of ctx
+static void* newSharedTensor(TensorType type, THMapAllocatorContext* ctx, ptrdiff_t storageSize,
+                             ptrdiff_t offset, int dim, long* sizes, long* strides)
+{
+  static std::array<std::function<void* (THMapAllocatorContext*, ptrdiff_t, ptrdiff_t, int, long*, long*)>, 7> dyn = {{
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THByteStorage* s = THByteStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THByteTensor* t = THByteTensor_new();
+        THByteTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THByteStorage_free(s);
+        return t;
+      },
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THCharStorage* s = THCharStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THCharTensor* t = THCharTensor_new();
+        THCharTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THCharStorage_free(s);
+        return t;
+      },
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THShortStorage* s = THShortStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THShortTensor* t = THShortTensor_new();
+        THShortTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THShortStorage_free(s);
+        return t;
+      },
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THIntStorage* s = THIntStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THIntTensor* t = THIntTensor_new();
+        THIntTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THIntStorage_free(s);
+        return t;
+      },
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THLongStorage* s = THLongStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THLongTensor* t = THLongTensor_new();
+        THLongTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THLongStorage_free(s);
+        return t;
+      },
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THFloatStorage* s = THFloatStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THFloatTensor* t = THFloatTensor_new();
+        THFloatTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THFloatStorage_free(s);
+        return t;
+      },
+      [](THMapAllocatorContext* ctx, ptrdiff_t size, ptrdiff_t offset, int dim, long* sizes, long* strides) -> void* {
+        THDoubleStorage* s = THDoubleStorage_newWithAllocator(size, &THRefcountedMapAllocator, ctx);
+        THDoubleTensor* t = THDoubleTensor_new();
+        THDoubleTensor_setStorageNd(t, s, offset, dim, sizes, strides);
+        THDoubleStorage_free(s);
+        return t;
+      }
+    }};
+  return dyn.at(type)(ctx, storageSize, offset, dim, sizes, strides);
+}
+
+Tensor Tensor::shared(IntList sizes, TensorType type)
+{
+#ifdef _WIN32
+  throw std::runtime_error("shared memory tensors are not supported on Windows");
+#endif
+  if(type < kUInt8 || type > kDouble) {
+    throw std::invalid_argument("unknown type");
+  }
+  if(sizes.size() > (size_t)SharedHandle::kMaxDim) {
+    throw std::invalid_argument("too many dimensions");
+  }
+  Tensor t;
+  t.type_ = type;
+  int64_t size = 1;
+  for(int64_t s : sizes) {
+    if(s <= 0) {
+      throw std::invalid_argument("sizes must be positive numbers");
+    }
+    // the bytes of the object must not overflow
+    if(s > (INT64_MAX - kSharedHeaderSize)/t.elemSize()/size) {
+      throw std::invalid_argument("sizes too large");
+    }
+    size *= s;
+  }
+
+  // a name of this process not in use (a process of the same pid may have
+  // left objects behind)
+  static std::atomic<int64_t> counter(0);
+  char name[sizeof(SharedHandle::name)];
+  do {
+    std::snprintf(name, sizeof(name), "/xt-%ld-%lld", (long)getpid(), (long long)counter++);
+  } while(sharedObjectSize(name) >= 0);
+
+  t.device_ = kCPU;
+  t.isValue_ = sizes.empty();
+  const long one = 1;
+  THMapAllocatorContext* ctx = THMapAllocatorContext_new(name, TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE);
+  t.th_tensor_ = newSharedTensor(type, ctx, size, 0, t.isValue_ ? 1 : sizes.size(),
+                                 (long*)(t.isValue_ ? &one : sizes.data()), nullptr);
+  return t;
+}
+
+Tensor Tensor::shared(const SharedHandle& handle)
+{
+  if(!std::memchr(handle.name, 0, sizeof(handle.name))) {
+    throw std::invalid_argument("invalid shared memory name");
+  }
+  std::string name = handle.name;
+  if(handle.type < kUInt8 || handle.type > kDouble || handle.dim < 0 || handle.dim > SharedHandle::kMaxDim) {
+    throw sharedError(name, "invalid handle");
+  }
+  Tensor t;
+  t.type_ = (TensorType)handle.type;
+
+  // the tensor must lie within the storage; the handle comes from another
+  // process: checked not to overflow before it is used
+  if(handle.storageSize <= 0 || handle.storageSize > (INT64_MAX - kSharedHeaderSize)/t.elemSize()) {
+    throw sharedError(name, "invalid handle");
+  }
+  if(handle.offset < 0 || handle.offset >= handle.storageSize) {
+    throw sharedError(name, "tensor out of the storage");
+  }
+  int64_t last = handle.offset;
+  for(int32_t i = 0; i < handle.dim; i++) {
+    if(handle.sizes[i] <= 0 || handle.strides[i] < 0) {
+      throw sharedError(name, "invalid sizes or strides");
+    }
+    if(handle.strides[i] > 0 && handle.sizes[i]-1 > (handle.storageSize-1 - last)/handle.strides[i]) {
+      throw sharedError(name, "tensor out of the storage");
+    }
+    last += (handle.sizes[i]-1)*handle.strides[i];
+  }
+  if(sharedObjectSize(handle.name) < kSharedHeaderSize + handle.storageSize*t.elemSize()) {
+    throw sharedError(name, "does not exist (freed by all processes?) or is too small");
+  }
+
+  t.device_ = kCPU;
+  t.isValue_ = (handle.dim == 0);
+  const long one = 1;
+  THMapAllocatorContext* ctx = THMapAllocatorContext_new(handle.name, TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE);
+  t.th_tensor_ = newSharedTensor(t.type_, ctx, handle.storageSize, handle.offset, t.isValue_ ? 1 : handle.dim,
+                                 (long*)(t.isValue_ ? &one : handle.sizes),
+                                 (long*)(t.isValue_ ? &one : handle.strides));
+  return t;
+}
+
+// storage of a TH tensor, as needed by handle()
+struct SharedStorage
+{
+  THAllocator* allocator;
+  void* allocatorContext;
+  ptrdiff_t size;
+  ptrdiff_t offset;
+};
+
+SharedHandle Tensor::handle() const
+{
+  if(device_ != kCPU) {
+    throw std::invalid_argument("CPU tensor expected");
+  }
+  static std::array<std::function<SharedStorage (void*)>, 7> dyn = {{
+      [](void* tensor) -> SharedStorage {
+        THByteTensor* t = (THByteTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      },
+      [](void* tensor) -> SharedStorage {
+        THCharTensor* t = (THCharTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      },
+      [](void* tensor) -> SharedStorage {
+        THShortTensor* t = (THShortTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      },
+      [](void* tensor) -> SharedStorage {
+        THIntTensor* t = (THIntTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      },
+      [](void* tensor) -> SharedStorage {
+        THLongTensor* t = (THLongTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      },
+      [](void* tensor) -> SharedStorage {
+        THFloatTensor* t = (THFloatTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      },
+      [](void* tensor) -> SharedStorage {
+        THDoubleTensor* t = (THDoubleTensor*)tensor;
+        if(!t->storage) return {nullptr, nullptr, 0, 0};
+        return {t->storage->allocator, t->storage->allocatorContext, t->storage->size, t->storageOffset};
+      }
+    }};
+  SharedStorage storage = (isScalar() ? SharedStorage{nullptr, nullptr, 0, 0} : dyn.at(type_)(th_tensor_));
+  if(storage.allocator != &THRefcountedMapAllocator) {
+    throw std::invalid_argument("tensor in shared memory expected (see Tensor::shared)");
+  }
+
+  SharedHandle handle;
+  std::memset(&handle, 0, sizeof(handle));
+  std::strncpy(handle.name, THMapAllocatorContext_filename((THMapAllocatorContext*)storage.allocatorContext),
+               sizeof(handle.name)-1);
+  handle.storageSize = storage.size;
+  handle.offset = storage.offset;
+  handle.type = type_;
+  int64_t d = dim();
+  if(d < 0 || d > SharedHandle::kMaxDim) {
+    throw std::invalid_argument(d < 0 ? "empty tensor" : "too many dimensions");
+  }
+  handle.dim = d;
+  IntList sizes_ = sizes(), strides_ = strides();
+  for(int64_t i = 0; i < handle.dim; i++) {
+    handle.sizes[i] = sizes_[i];
+    handle.strides[i] = strides_[i];
+  }
+  return handle;
+}
+
+}
@@ -2,178 +2,81 @@
 #define XT_DISPATCH_H
 
 #include "Tensor.h"
-#include <array>
+#include <utility>
 
 namespace xt {
 
-// Tensor version
-template<class F, class ... T>
-auto dispatch(Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Tensor&, T&...)>::type
+// compile-time type switch: each case inlines F::cpu<T> (or F::gpu<T>)
+// no type-erased call, no static table, no bound check on the hot path
+template<class R, class F, class ... T>
+inline R dispatch_switch(TensorType ttype, TensorDevice tdev, T&&... args)
 {
-  using ReturnType = typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Tensor&, T&...)>::type;
-  if(t.device() == kCPU) {
-    static std::array<std::function<ReturnType (F&, Tensor&, T&...)>, 7> dyn = {{
-        &F::template cpu<uint8_t>,
-        &F::template cpu<int8_t>,
-        &F::template cpu<int16_t>,
-        &F::template cpu<int32_t>,
-        &F::template cpu<int64_t>,
-        &F::template cpu<float>,
-        &F::template cpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, t, args...);
-  } else if(t.device() == kGPU) {
-    static std::array<std::function<ReturnType (F&, Tensor&, T&...)>, 7> dyn = {{
-        &F::template gpu<uint8_t>,
-        &F::template gpu<int8_t>,
-        &F::template gpu<int16_t>,
-        &F::template gpu<int32_t>,
-        &F::template gpu<int64_t>,
-        &F::template gpu<float>,
-        &F::template gpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, t, args...);
+  F functor;
+  if(tdev == kCPU) {
+    switch(ttype) {
+      case kUInt8: return functor.template cpu<uint8_t>(std::forward<T>(args)...);
+      case kInt8: return functor.template cpu<int8_t>(std::forward<T>(args)...);
+      case kInt16: return functor.template cpu<int16_t>(std::forward<T>(args)...);
+      case kInt32: return functor.template cpu<int32_t>(std::forward<T>(args)...);
+      case kInt64: return functor.template cpu<int64_t>(std::forward<T>(args)...);
+      case kFloat: return functor.template cpu<float>(std::forward<T>(args)...);
+      case kDouble: return functor.template cpu<double>(std::forward<T>(args)...);
+    }
+    throw std::out_of_range("unsupported type");
+  } else if(tdev == kGPU) {
+    switch(ttype) {
+      case kUInt8: return functor.template gpu<uint8_t>(std::forward<T>(args)...);
+      case kInt8: return functor.template gpu<int8_t>(std::forward<T>(args)...);
+      case kInt16: return functor.template gpu<int16_t>(std::forward<T>(args)...);
+      case kInt32: return functor.template gpu<int32_t>(std::forward<T>(args)...);
+      case kInt64: return functor.template gpu<int64_t>(std::forward<T>(args)...);
+      case kFloat: return functor.template gpu<float>(std::forward<T>(args)...);
+      case kDouble: return functor.template gpu<double>(std::forward<T>(args)...);
+    }
+    throw std::out_of_range("unsupported type");
   } else {
     throw std::invalid_argument("unsupported device");
   }
 }
 
+// Tensor version
+template<class F, class ... T>
+inline auto dispatch(Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Tensor&, T&...)>::type
+{
+  using ReturnType = typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Tensor&, T&...)>::type;
+  return dispatch_switch<ReturnType, F, Tensor&, T&...>(t.type(), t.device(), t, args...);
+}
+
 // Context, Tensor version
 template<class F, class ... T>
-auto dispatch(Context& ctx, Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Context&, Tensor&, T&...)>::type
+inline auto dispatch(Context& ctx, Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Context&, Tensor&, T&...)>::type
 {
   using ReturnType = typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Context&, Tensor&, T&...)>::type;
-  if(t.device() == kCPU) {
-    static std::array<std::function<ReturnType (F&, Context&, Tensor&, T&...)>, 7> dyn = {{
-        &F::template cpu<uint8_t>,
-        &F::template cpu<int8_t>,
-        &F::template cpu<int16_t>,
-        &F::template cpu<int32_t>,
-        &F::template cpu<int64_t>,
-        &F::template cpu<float>,
-        &F::template cpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, t, args...);
-  } else if(t.device() == kGPU) {
-    static std::array<std::function<ReturnType (F&, Context&, Tensor&, T&...)>, 7> dyn = {{
-        &F::template gpu<uint8_t>,
-        &F::template gpu<int8_t>,
-        &F::template gpu<int16_t>,
-        &F::template gpu<int32_t>,
-        &F::template gpu<int64_t>,
-        &F::template gpu<float>,
-        &F::template gpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, ctx, t, args...);
-  } else {
-    throw std::invalid_argument("unsupported device");
-  }
+  return dispatch_switch<ReturnType, F, Context&, Tensor&, T&...>(t.type(), t.device(), ctx, t, args...);
 }
 
 // const Tensor version
 template<class F, class ... T>
-auto dispatch(const Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, const Tensor&, T&...)>::type
+inline auto dispatch(const Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, const Tensor&, T&...)>::type
 {
   using ReturnType = typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, const Tensor&, T&...)>::type;
-  if(t.device() == kCPU) {
-    static std::array<std::function<ReturnType (F&, const Tensor&, T&...)>, 7> dyn = {{
-        &F::template cpu<uint8_t>,
-        &F::template cpu<int8_t>,
-        &F::template cpu<int16_t>,
-        &F::template cpu<int32_t>,
-        &F::template cpu<int64_t>,
-        &F::template cpu<float>,
-        &F::template cpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, t, args...);
-  } else if(t.device() == kGPU) {
-    static std::array<std::function<ReturnType (F&, const Tensor&, T&...)>, 7> dyn = {{
-        &F::template gpu<uint8_t>,
-        &F::template gpu<int8_t>,
-        &F::template gpu<int16_t>,
-        &F::template gpu<int32_t>,
-        &F::template gpu<int64_t>,
-        &F::template gpu<float>,
-        &F::template gpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, t, args...);
-  } else {
-    throw std::invalid_argument("unsupported device");
-  }
+  return dispatch_switch<ReturnType, F, const Tensor&, T&...>(t.type(), t.device(), t, args...);
 }
 
 // Context, const Tensor version
 template<class F, class ... T>
-auto dispatch(Context& ctx, const Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Context&, const Tensor&, T&...)>::type
+inline auto dispatch(Context& ctx, const Tensor& t, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Context&, const Tensor&, T&...)>::type
 {
   using ReturnType = typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, Context&, const Tensor&, T&...)>::type;
-  if(t.device() == kCPU) {
-    static std::array<std::function<ReturnType (F&, Context&, const Tensor&, T&...)>, 7> dyn = {{
-        &F::template cpu<uint8_t>,
-        &F::template cpu<int8_t>,
-        &F::template cpu<int16_t>,
-        &F::template cpu<int32_t>,
-        &F::template cpu<int64_t>,
-        &F::template cpu<float>,
-        &F::template cpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, ctx, t, args...);
-  } else if(t.device() == kGPU) {
-    static std::array<std::function<ReturnType (F&, Context&, const Tensor&, T&...)>, 7> dyn = {{
-        &F::template gpu<uint8_t>,
-        &F::template gpu<int8_t>,
-        &F::template gpu<int16_t>,
-        &F::template gpu<int32_t>,
-        &F::template gpu<int64_t>,
-        &F::template gpu<float>,
-        &F::template gpu<double>,
-      }};
-    F functor;
-    return dyn.at(t.type())(functor, ctx, t, args...);
-  } else {
-    throw std::invalid_argument("unsupported device");
-  }
+  return dispatch_switch<ReturnType, F, Context&, const Tensor&, T&...>(t.type(), t.device(), ctx, t, args...);
 }
 
 // type/device version
 template<class F, class ... T>
-auto dispatch(TensorType ttype, TensorDevice tdev, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, T&...)>::type
+inline auto dispatch(TensorType ttype, TensorDevice tdev, T&... args) -> typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, T&...)>::type
 {
   using ReturnType = typename std::result_of<decltype(&F::template cpu<int64_t>)(F&, T&...)>::type;
-  if(tdev == kCPU) {
-    static std::array<std::function<ReturnType (F&, T&...)>, 7> dyn = {{
-        &F::template cpu<uint8_t>,
-        &F::template cpu<int8_t>,
-        &F::template cpu<int16_t>,
-        &F::template cpu<int32_t>,
-        &F::template cpu<int64_t>,
-        &F::template cpu<float>,
-        &F::template cpu<double>,
-      }};
-    F functor;
-    return dyn.at(ttype)(functor, args...);
-  } else if(tdev == kGPU) {
-    static std::array<std::function<ReturnType (F&, T&...)>, 7> dyn = {{
-        &F::template gpu<uint8_t>,
-        &F::template gpu<int8_t>,
-        &F::template gpu<int16_t>,
-        &F::template gpu<int32_t>,
-        &F::template gpu<int64_t>,
-        &F::template gpu<float>,
-        &F::template gpu<double>,
-      }};
-    F functor;
-    return dyn.at(ttype)(functor, args...);
-  } else {
-    throw std::invalid_argument("unsupported device");
-  }
+  return dispatch_switch<ReturnType, F, T&...>(ttype, tdev, args...);
 }
 
 }
@@ -109,7 +109,7 @@ local function wrap(name, cname, args)
 
    for variant=0,(2^nopt)-1 do
       local ccargs = {[0]={}}
-      local dynidx
+      local dynidx, dynfallback
 
       local function checkreturn(arg)
          if arg.creturned or arg.returned then
@@ -117,9 +117,15 @@ local function wrap(name, cname, args)
          end
       end
       -- dynidx refers to ccargs idx
+      -- inputs tensors come first: a provided returned tensor
+      -- might not be allocated yet (or be of another type)
       local function checkdyn(arg, idx)
          if arg.dyn then
-            dynidx = dynidx or idx -- first ccargs which is dyn
+            if arg.returned or arg:signature() == 'real' then
+               dynfallback = dynfallback or idx
+            else
+               dynidx = dynidx or idx -- first ccargs which is a dyn input tensor
+            end
          end
       end
 
@@ -158,6 +164,7 @@ local function wrap(name, cname, args)
             -- checkreturn(arg)
          end
       end
+      dynidx = dynidx or dynfallback
       local funcname = name
       if #ccargs[0] == 0 then
          table.insert(ccargs[0], maketype({name='void'}))
@@ -458,8 +465,11 @@ local function implementrt(rech, rec, defs)
       end
       if isdyn(signature.v) then
          local dynidx = signature.v[1].dynidx
-         if dynidx then
+         if dynidx == 1 then
             rec:add(string.format("return dispatch<%s_op>(%s);", signature.k, args))
+         elseif dynidx then
+            local dynarg = ref.ccargs[dynidx]:ccarg()
+            rec:add(string.format("return dispatch<%s_op>(%s.type(), %s.device(), %s);", signature.k, dynarg, dynarg, args))
          else
             rec:add(string.format("return dispatch<%s_op>(ttype, tdev, %s);", signature.k, args))
          end
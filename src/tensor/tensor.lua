@@ -16,6 +16,8 @@ else
 end
 
 rech:add([[
+#ifndef XT_TENSORTH_H
+#define XT_TENSORTH_H
 #include "Tensor.h"
 namespace xt {
 ]])
@@ -38,6 +40,22 @@ static THCState* thcstate()
 {
   return defaultContext.thcstate().get();
 }
+
+// THLongStorage on the memory of l, for the TH functions which only read
+// their size arguments: neither allocated, nor freed, nor resized
+static_assert(sizeof(long) == sizeof(int64_t), "TH sizes (long) must be 64 bits");
+static THLongStorage THLongStorage_view__(const IntList& l)
+{
+  THLongStorage s;
+  s.data = (long*)l.data();
+  s.size = l.size();
+  s.refcount = 1;
+  s.flag = 0;
+  s.allocator = &THDefaultAllocator;
+  s.allocatorContext = nullptr;
+  s.view = nullptr;
+  return s;
+}
 ]])
 
 rec:add[[
@@ -1499,6 +1517,10 @@ for dd,ddv in ipairs(devices) do
             local SRX = SRC -- !!!
             SRC = SRC:gsub("CudaFloat", "Cuda")
             local z = "[](Tensor& d, const Tensor& s) { THDSTTensor_copySRX(STATEd.THTensor<THDSTTensor>(), s.THTensor<THSRCTensor>()); }"
+            if ddv == "cpu" and ssv == "cpu" and dt.name == st.name then
+               -- same type: contiguous tensors are copied with THVector
+               SRX = ""
+            end
             z = z:gsub("SRC", SRC):gsub("DST", DST):gsub("SRX", SRX):gsub("STATE", (ddv=="gpu" or ssv=="gpu") and "thcstate(), " or "")
             table.insert(txt, z)
          end
@@ -1540,6 +1562,7 @@ void copy_(Tensor& d, const Tensor& s)
 
 rech:add([[
 } // namespace xt
+#endif
 ]])
 rec:add([[
 } // namespace xt
@@ -0,0 +1,130 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+using namespace xt;
+
+// steady-state loop allocating and freeing the same activations (1 to 16MB,
+// plus small tensors) with the default allocator, then with the caching
+// allocator (Context::setCachingAllocator), which reuses the freed blocks
+// instead of getting fresh pages from the system at each iteration
+// also checks the stats, the blocks of an exiting thread, resize, emptyCache
+// (with the caches of other threads) and huge pages; then the heap stats of TH (Context::heapStats), with the time
+// of a small tensor made and freed, counted in them
+// returns 1 on a wrong result
+
+// one step of a small network: activations, a loss
+static double step()
+{
+  double loss = 0;
+  for(int64_t batch : {64, 256, 1024}) {
+    Tensor h = zeros({batch, 4096}, kFloat);
+    Tensor g = add(h, Tensor(1.f));
+    Tensor bias = ones({4096}, kFloat);
+    loss += sum(g).value<double>() + sum(bias).value<double>();
+  }
+  return loss;
+}
+
+int main()
+{
+  const int64_t nrep = 50;
+  const double expected = (64+256+1024)*4096. + 3*4096.;
+  bool ok = true;
+  std::cout.precision(4);
+
+  {
+    double loss = 0, loss_ref = 0;
+    double t_ref = seconds(nrep, [&]() { loss_ref = step(); });
+    defaultContext.setCachingAllocator(true);
+    CachingAllocatorStats before = defaultContext.cachingAllocatorStats();
+    double t = seconds(nrep, [&]() { loss = step(); });
+    CachingAllocatorStats after = defaultContext.cachingAllocatorStats();
+    defaultContext.setCachingAllocator(false);
+    int64_t hits = after.hits - before.hits, misses = after.misses - before.misses;
+    bool good = (loss == expected) && (loss_ref == expected) && (after.allocated == before.allocated)
+      && (hits >= nrep*9) && (misses <= 9) && (after.peakAllocated >= (1024*4096*4)*2);
+    ok = good && ok;
+    std::cout << "step: " << t*1e3 << " ms (default allocator " << t_ref*1e3 << " ms, speedup " << t_ref/t << ")"
+              << ", " << hits << " hits, " << misses << " misses, " << after.cached/(1 << 20) << " MB cached"
+              << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    defaultContext.setCachingAllocator(true);
+    bool good = defaultContext.cachingAllocator();
+
+    // blocks freed by a thread which exits stay cached, for the others
+    CachingAllocatorStats before = defaultContext.cachingAllocatorStats();
+    std::thread([]() { Tensor x = zeros({1000}, kFloat); }).join();
+    Tensor x = zeros({1000}, kFloat);
+    CachingAllocatorStats after = defaultContext.cachingAllocatorStats();
+    good = (after.hits == before.hits+1) && (after.allocated == before.allocated+4096) && good;
+
+    // resized within its size class, a tensor keeps its block
+    float* p = x.data<float>();
+    x.resize({1010});
+    fill_(x, Tensor(2.f));
+    good = (x.data<float>() == p) && (sum(x).value<double>() == 2020) && good;
+    x.resize({100000});
+    good = (x.data<float>() != p) && (x.data<float>()[5] == 2) && good;
+
+    // emptyCache also takes the blocks cached by the threads still running
+    // (as the workers of the TH thread pool)
+    std::atomic<int> state(0);
+    std::thread running([&]() {
+        zeros({1000}, kFloat);
+        state = 1;
+        while(state != 2) {
+          std::this_thread::yield();
+        }
+      });
+    while(state != 1) {
+      std::this_thread::yield();
+    }
+    good = (defaultContext.cachingAllocatorStats().cached > 0) && good;
+    defaultContext.emptyCache();
+    good = (defaultContext.cachingAllocatorStats().cached == 0) && good;
+    state = 2;
+    running.join();
+
+    // blocks from the system get the huge page option of THAlloc
+    defaultContext.setHugePages(true);
+    Tensor h({1 << 20}, kFloat);
+    good = ((uintptr_t)h.data<float>() % (2 << 20) == 64) && good;
+    h = Tensor();
+    defaultContext.setHugePages(false);
+    defaultContext.emptyCache();
+    defaultContext.setCachingAllocator(false);
+    good = !defaultContext.cachingAllocator() && (zeros({10}, kFloat).data<float>() != nullptr) && good;
+    ok = good && ok;
+    std::cout << "thread exit, resize, emptyCache, huge pages: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  {
+    const int64_t mb = 1 << 20;
+    HeapStats before = defaultContext.heapStats();
+    Tensor x = zeros({mb/4}, kFloat);
+    HeapStats during = defaultContext.heapStats();
+    x = Tensor();
+    HeapStats after = defaultContext.heapStats();
+    bool good = (during.allocated >= before.allocated+mb) && (after.allocated == before.allocated)
+      && (during.histogram.at(20) == before.histogram.at(20)+1) && (during.numAllocs > before.numAllocs)
+      && (after.numFrees-before.numFrees == during.numAllocs-before.numAllocs);
+
+    defaultContext.resetPeakHeap();
+    good = (defaultContext.heapStats().peakAllocated < after.allocated+mb) && good;
+    zeros({64*mb/4}, kFloat);
+    good = (defaultContext.heapStats().peakAllocated >= after.allocated+64*mb) && good;
+
+    double t = seconds(1000000, []() { Tensor y({16}, kFloat); });
+    ok = good && ok;
+    std::cout << "heap stats: " << after.allocated << " bytes in use, " << after.numAllocs << " allocations"
+              << ", small tensor made and freed in " << t*1e9 << " ns" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
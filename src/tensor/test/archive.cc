@@ -0,0 +1,238 @@
+#include "xttensor.h"
+#include "bench.h"
+#include "TH.h"
+#undef THTensor
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace xt;
+
+// a checkpoint of 2000 named float tensors (20 of 8MB, the others of 4 to
+// 256KB, about 400MB), saved as an archive (xt::save) and as a sequential
+// dump of THDiskFile (per tensor: name, sizes, then the data); then, with
+// the files out of the page cache (cold start), the load of all the tensors
+// and of a subset of 50: from the dump (read in order, seeking past the
+// tensors not wanted), from the archive (its index, then pread of the
+// tensors, with up to 4 threads of the TH pool), and mapped from the archive
+// (read on access)
+// also checks values, empty, strided and integer tensors, a corrupted
+// tensor, a failed save and wrong names
+// returns 1 on a wrong result
+
+static const int kTensors = 2000, kLarge = 100; // one large tensor every kLarge
+
+// out of the page cache: the next read comes from the disk
+static void evict(const std::string& filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+static void dump(const std::string& filename, const std::vector<std::pair<std::string, Tensor>>& tensors)
+{
+  THFile* file = THDiskFile_new(filename.c_str(), "w", 0);
+  THFile_binary(file);
+  for(auto& named : tensors) {
+    long n = named.first.size();
+    THFile_writeLongRaw(file, &n, 1);
+    THFile_writeCharRaw(file, (char*)named.first.data(), n);
+    std::vector<long> sizes(named.second.sizes().begin(), named.second.sizes().end());
+    long dim = sizes.size();
+    THFile_writeLongRaw(file, &dim, 1);
+    THFile_writeLongRaw(file, sizes.data(), dim);
+    THFile_writeFloatRaw(file, named.second.data<float>(), numel(named.second));
+  }
+  THFile_close(file);
+  THFile_free(file);
+}
+
+// the tensors of the dump with a name in wanted (all if empty)
+static std::vector<Tensor> undump(const std::string& filename, const std::vector<std::string>& wanted)
+{
+  std::vector<Tensor> tensors;
+  THFile* file = THDiskFile_new(filename.c_str(), "r", 0);
+  THFile_binary(file);
+  for(int i = 0; i < kTensors; i++) {
+    long n, dim;
+    THFile_readLongRaw(file, &n, 1);
+    std::string name(n, ' ');
+    THFile_readCharRaw(file, &name[0], n);
+    THFile_readLongRaw(file, &dim, 1);
+    std::vector<long> sizes(dim);
+    THFile_readLongRaw(file, sizes.data(), dim);
+    std::vector<int64_t> sizes64(sizes.begin(), sizes.end());
+    Tensor x(sizes64, kFloat);
+    if(wanted.empty() || std::find(wanted.begin(), wanted.end(), name) != wanted.end()) {
+      THFile_readFloatRaw(file, x.data<float>(), numel(x));
+      tensors.push_back(x);
+    } else {
+      THFile_seek(file, THFile_position(file) + numel(x)*sizeof(float));
+    }
+  }
+  THFile_close(file);
+  THFile_free(file);
+  return tensors;
+}
+
+static bool same(const std::vector<Tensor>& a, const std::vector<Tensor>& b)
+{
+  bool ok = (a.size() == b.size());
+  for(size_t i = 0; ok && i < a.size(); i++) {
+    ok = (a[i].sizes() == b[i].sizes()) && equal(a[i], b[i]);
+  }
+  return ok;
+}
+
+int main()
+{
+  const std::string archive = "xt-test.archive", dumped = "xt-test.dump";
+  bool ok = true;
+  std::cout.precision(4);
+
+  std::vector<std::pair<std::string, Tensor>> tensors;
+  std::vector<std::string> all, subset;
+  for(int i = 0; i < kTensors; i++) {
+    std::string name = "layer" + std::to_string(i/10) + ".weight" + std::to_string(i%10);
+    Tensor x = (i % kLarge == 0) ? rand({2048, 1024}, kFloat) : rand({8 << (i % 7), 128}, kFloat);
+    tensors.push_back({name, x});
+    all.push_back(name);
+    if(i % 40 == 0) {
+      subset.push_back(name);
+    }
+  }
+  std::vector<Tensor> expected;
+  for(const std::string& name : subset) {
+    for(auto& named : tensors) {
+      if(named.first == name) {
+        expected.push_back(named.second);
+      }
+    }
+  }
+
+  {
+    double t = seconds([&]() { save(archive, tensors, true, 4); evict(archive); });
+    double t_ref = seconds([&]() { dump(dumped, tensors); evict(dumped); });
+    std::cout << "save: " << t*1e3 << " ms (THDiskFile dump " << t_ref*1e3 << " ms)" << std::endl;
+  }
+
+  {
+    // best of 3 cold loads each, which one reads first alternating (the
+    // timings of the disk vary much from one read to the next)
+    std::vector<Tensor> x, ref;
+    double t = 1e9, t_ref = 1e9;
+    for(int round = 0; round < 3; round++) {
+      evict(archive);
+      evict(dumped);
+      for(int k = 0; k < 2; k++) {
+        if((round+k) % 2 == 0) {
+          t_ref = std::min(t_ref, seconds([&]() { ref = undump(dumped, {}); }));
+        } else {
+          t = std::min(t, seconds([&]() { x = Archive(archive).load(all, 4); }));
+        }
+      }
+    }
+    bool good = (x.size() == (size_t)kTensors) && equal(x[0], tensors[0].second) && equal(x.back(), tensors.back().second)
+      && same(x, ref);
+    ok = good && ok;
+    std::cout << "cold load of all (best of 3): " << t*1e3 << " ms (THDiskFile dump " << t_ref*1e3 << " ms)"
+              << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    evict(archive);
+    evict(dumped);
+    std::vector<Tensor> x, ref;
+    double t_ref = seconds([&]() { ref = undump(dumped, subset); });
+    double t = seconds([&]() { x = Archive(archive).load(subset, 4); });
+    evict(archive);
+    double s = 0;
+    double t_map = seconds([&]() {
+        Archive a(archive);
+        for(const std::string& name : subset) {
+          s += sum(a.map(name)).value<double>();
+        }
+      });
+    double s_ref = 0;
+    for(const Tensor& y : expected) {
+      s_ref += sum(y).value<double>();
+    }
+    bool good = same(x, expected) && same(ref, expected) && (s == s_ref);
+    ok = good && ok;
+    std::cout << "cold load of " << subset.size() << " tensors: " << t*1e3 << " ms, mapped and summed "
+              << t_map*1e3 << " ms (THDiskFile dump " << t_ref*1e3 << " ms)" << (good ? "" : " FAILED") << std::endl;
+  }
+  std::remove(dumped.c_str());
+
+  {
+    // other kinds of tensors, and errors
+    Tensor strided = transpose(rand({3, 5}, kDouble), 0, 1);
+    Tensor ints = zeros({4}, kInt64);
+    ints.data<int64_t>()[2] = 7;
+    save(archive, {{"value", Tensor(2.5f)}, {"empty", zeros({0, 4}, kFloat)}, {"strided", strided},
+                   {"ints", ints}});
+    Archive a(archive);
+    std::vector<Tensor> x = a.load({"value", "empty", "strided", "ints"});
+    bool good = (a.entries().size() == 4) && (x[0].dim() == 0) && (x[0].value<float>() == 2.5f)
+      && (x[1].dim() == zeros({0, 4}, kFloat).dim()) && (numel(x[1]) == 0)
+      && equal(x[2], strided) && equal(x[3], ints) && equal(a.map("strided"), strided)
+      && (a.map("value").value<float>() == 2.5f) && (a.entry("ints").size == 32);
+
+    bool rejected = false;
+    try {
+      a.load("missing");
+    } catch(std::invalid_argument& e) {
+      rejected = true;
+    }
+    good = rejected && good;
+
+    // the low byte of ints[2] set to 1: load fails, map does not verify
+    {
+      FILE* file = std::fopen(archive.c_str(), "r+b");
+      std::fseek(file, a.entry("ints").offset + 16, SEEK_SET);
+      std::fputc(1, file);
+      std::fclose(file);
+    }
+    rejected = false;
+    try {
+      Archive(archive).load("ints");
+    } catch(std::runtime_error& e) {
+      rejected = true;
+    }
+    good = rejected && (Archive(archive).map("ints").data<int64_t>()[2] == 1) && good;
+
+    // a save which fails leaves the archive as it was, and no temporary file
+    good = (access((archive + ".tmp").c_str(), F_OK) != 0) && good;
+    mkdir((archive + ".tmp").c_str(), 0755);
+    rejected = false;
+    try {
+      save(archive, {{"other", ints}});
+    } catch(std::runtime_error& e) {
+      rejected = true;
+    }
+    rmdir((archive + ".tmp").c_str());
+    good = rejected && Archive(archive).has("ints") && !Archive(archive).has("other") && good;
+
+    rejected = false;
+    try {
+      Archive("/proc/self/status");
+    } catch(std::runtime_error& e) {
+      rejected = true;
+    }
+    good = rejected && good;
+    ok = good && ok;
+    std::cout << "values, empty, strided and integer tensors, errors: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+  std::remove(archive.c_str());
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <vector>
+
+using namespace xt;
+
+// an inference request (8 small layers, a few dozens of short-lived tensors)
+// with its tensors on the heap, then in an ArenaScope; also checks a tensor
+// escaping its scope (valid, resized on the heap, freeing the arena with it),
+// nested scopes, scopes ended out of order and tensors made by another scope
+// returns 1 on a wrong result
+
+static const int64_t kLayers = 8, kWidth = 32;
+
+static Tensor forward(const Tensor& x, const std::vector<Tensor>& weights, const std::vector<Tensor>& biases)
+{
+  Tensor h = x;
+  for(int64_t i = 0; i < kLayers; i++) {
+    h = tanh(add(mm(h, weights[i]), biases[i]));
+  }
+  return h;
+}
+
+int main()
+{
+  const int64_t nrep = 20000;
+  bool ok = true;
+  std::cout.precision(4);
+
+  Tensor x = ones({1, kWidth}, kFloat);
+  std::vector<Tensor> weights, biases;
+  for(int64_t i = 0; i < kLayers; i++) {
+    weights.push_back(ones({kWidth, kWidth}, kFloat)*Tensor(0.01f));
+    biases.push_back(ones({1, kWidth}, kFloat)*Tensor(-0.1f*i));
+  }
+  double expected = sum(forward(x, weights, biases)).value<double>();
+
+  {
+    double s = 0, s_ref = 0;
+    int64_t size = 0;
+    double t_ref = seconds(nrep, [&]() { s_ref += sum(forward(x, weights, biases)).value<double>(); });
+    double t = seconds(nrep, [&]() {
+      ArenaScope scope(16 << 10);
+      s += sum(forward(x, weights, biases)).value<double>();
+      size = scope.size();
+    });
+    bool good = (s == s_ref) && (s == expected*(nrep+1));
+    ok = good && ok;
+    std::cout << "request: " << t*1e6 << " us (heap " << t_ref*1e6 << " us, speedup " << t_ref/t << ")"
+              << ", arena of " << size/1024 << " kB" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    int64_t allocated = defaultContext.heapStats().allocated;
+    int64_t escaped = ArenaScope::numEscaped();
+    Tensor y, z;
+    int64_t live;
+    {
+      ArenaScope scope;
+      y = forward(x, weights, biases);
+      {
+        ArenaScope inner;
+        z = add(y, y); // from the inner scope
+      }
+      live = scope.live();
+    }
+    bool good = (live > 0) && (ArenaScope::numEscaped() == escaped+2) && (sum(y).value<double>() == expected)
+      && (sum(z).value<double>() == 2*expected);
+    y.resize({4, kWidth}); // out of its scope: to the heap
+    good = (sum(narrow(y, 0, 0, 1)).value<double>() == expected) && good;
+    y = Tensor();
+    z = Tensor();
+    good = (defaultContext.heapStats().allocated == allocated) && good; // arenas freed
+    ok = good && ok;
+    std::cout << "escaped tensors: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  {
+    // scopes ended out of order: the inner one stays in use, then the heap
+    int64_t allocated = defaultContext.heapStats().allocated;
+    bool good = true;
+    try {
+      ArenaScope* outer = new ArenaScope();
+      ArenaScope* inner = new ArenaScope();
+      Tensor x = ones({kWidth}, kFloat); // the inner arena takes its chunk
+      delete outer;
+      int64_t live = inner->live(), heap = defaultContext.heapStats().allocated;
+      Tensor y = ones({kWidth}, kFloat);
+      good = (inner->live() > live) && (defaultContext.heapStats().allocated == heap);
+      x = Tensor();
+      y = Tensor();
+      delete inner;
+      y = ones({kWidth}, kFloat);
+      good = (defaultContext.heapStats().allocated > allocated) && (sum(y).value<double>() == kWidth) && good;
+    } catch(std::exception& e) {
+      std::cout << "   " << e.what() << std::endl;
+      good = false;
+    }
+    good = (defaultContext.heapStats().allocated == allocated) && good;
+    ok = good && ok;
+    std::cout << "scopes ended out of order: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
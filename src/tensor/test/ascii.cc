@@ -0,0 +1,303 @@
+#include "xttensor.h"
+#include "bench.h"
+#include "TH.h"
+#undef THTensor
+#include "THAscii.h"
+#include <iostream>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace xt;
+
+// 4M floats and 2M doubles written to an ascii THDiskFile and read back,
+// against fprintf %.9g / %.17g and fscanf per element (the former
+// implementation); the same to a THMemoryFile against snprintf and sscanf
+// also checks the round trip of all the types, the shortest text of some
+// values, the read of text written by printf, the separators of
+// THMemoryFile and parsing in the C locale
+// returns 1 on a wrong result
+
+static const int64_t kFloats = 4 << 20, kDoubles = 2 << 20;
+
+static long fileSize(const std::string& filename)
+{
+  FILE* file = std::fopen(filename.c_str(), "rb");
+  std::fseek(file, 0, SEEK_END);
+  long size = std::ftell(file);
+  std::fclose(file);
+  return size;
+}
+
+static void THFile_writeRaw(THFile* file, float* data, int64_t n) { THFile_writeFloatRaw(file, data, n); }
+static void THFile_writeRaw(THFile* file, double* data, int64_t n) { THFile_writeDoubleRaw(file, data, n); }
+static size_t THFile_readRaw(THFile* file, float* data, int64_t n) { return THFile_readFloatRaw(file, data, n); }
+static size_t THFile_readRaw(THFile* file, double* data, int64_t n) { return THFile_readDoubleRaw(file, data, n); }
+
+template<typename T>
+static void writeFile(const std::string& filename, T* data, int64_t n)
+{
+  THFile* file = THDiskFile_new(filename.c_str(), "w", 0);
+  THFile_writeRaw(file, data, n);
+  THFile_close(file);
+  THFile_free(file);
+}
+
+template<typename T>
+static size_t readFile(const std::string& filename, T* data, int64_t n)
+{
+  THFile* file = THDiskFile_new(filename.c_str(), "r", 0);
+  THFile_quiet(file);
+  size_t nread = THFile_readRaw(file, data, n);
+  THFile_close(file);
+  THFile_free(file);
+  return nread;
+}
+
+// the former loops
+template<typename T>
+static void printFile(const std::string& filename, const T* data, int64_t n, const char* format)
+{
+  FILE* file = std::fopen(filename.c_str(), "w");
+  for(int64_t i = 0; i < n; i++) {
+    std::fprintf(file, format, data[i]);
+    std::fprintf(file, i < n-1 ? " " : "\n");
+  }
+  std::fclose(file);
+}
+
+template<typename T>
+static void scanFile(const std::string& filename, T* data, int64_t n, const char* format)
+{
+  FILE* file = std::fopen(filename.c_str(), "r");
+  for(int64_t i = 0; i < n; i++) {
+    if(std::fscanf(file, format, &data[i]) <= 0) {
+      break;
+    }
+  }
+  std::fclose(file);
+}
+
+template<typename T>
+static bool compare(const std::string& name, Tensor x, const char* printFormat, const char* scanFormat)
+{
+  const std::string filename = "xt-test.ascii", reference = "xt-test.ascii.ref";
+  const int64_t n = numel(x);
+  Tensor y(x.sizes(), x.type());
+  T* data = x.data<T>();
+  T* out = y.data<T>();
+
+  double t_write = seconds([&]() { writeFile(filename, data, n); });
+  double t_write_ref = seconds([&]() { printFile(reference, data, n, printFormat); });
+  std::memset(out, 0, n*sizeof(T));
+  size_t nread = 0;
+  double t_read = seconds([&]() { nread = readFile(filename, out, n); });
+  bool good = (nread == (size_t)n) && (std::memcmp(data, out, n*sizeof(T)) == 0);
+  // the text of printf, read by THDiskFile
+  std::memset(out, 0, n*sizeof(T));
+  good = (readFile(reference, out, n) == (size_t)n) && (std::memcmp(data, out, n*sizeof(T)) == 0) && good;
+  double t_read_ref = seconds([&]() { scanFile(reference, out, n, scanFormat); });
+
+  double mb = n*sizeof(T)/double(1 << 20);
+  std::cout << name << ": write " << mb/t_write << " MB/s (fprintf " << mb/t_write_ref << " MB/s), read "
+            << mb/t_read << " MB/s (fscanf " << mb/t_read_ref << " MB/s), " << fileSize(filename)/double(n)
+            << " bytes per value (" << fileSize(reference)/double(n) << ")" << (good ? "" : " FAILED") << std::endl;
+  std::remove(filename.c_str());
+  std::remove(reference.c_str());
+  return good;
+}
+
+static bool memory(Tensor x)
+{
+  const int64_t n = numel(x);
+  const float* data = x.data<float>();
+  Tensor y({n}, kFloat);
+  float* out = y.data<float>();
+
+  THCharStorage* text = nullptr;
+  double t_write = seconds([&]() {
+      THFile* file = THMemoryFile_new("w");
+      THFile_writeFloatRaw(file, x.data<float>(), n);
+      text = THMemoryFile_storage(file);
+      THCharStorage_retain(text);
+      THFile_close(file);
+      THFile_free(file);
+    });
+  size_t nread = 0;
+  double t_read = seconds([&]() {
+      THFile* file = THMemoryFile_newWithStorage(text, "r");
+      nread = THFile_readFloatRaw(file, out, n);
+      THFile_close(file);
+      THFile_free(file);
+    });
+  bool good = (nread == (size_t)n) && (std::memcmp(data, out, n*sizeof(float)) == 0);
+  THCharStorage_free(text);
+
+  std::string ref(n*16, ' ');
+  size_t length = 0;
+  double t_write_ref = seconds([&]() {
+      for(int64_t i = 0; i < n; i++) {
+        length += std::snprintf(&ref[length], ref.size()-length, "%.9g ", data[i]);
+      }
+    });
+  // each value ended by a null, as THMemoryFile did: sscanf takes the length
+  // of its string
+  double t_read_ref = seconds([&]() {
+      char* p = &ref[0];
+      for(int64_t i = 0; i < n; i++) {
+        char* space = std::strchr(p, ' ');
+        *space = '\0';
+        std::sscanf(p, "%g", &out[i]);
+        *space = ' ';
+        p = space+1;
+      }
+    });
+  good = (std::memcmp(data, out, n*sizeof(float)) == 0) && good;
+
+  double mb = n*sizeof(float)/double(1 << 20);
+  std::cout << "THMemoryFile, floats: write " << mb/t_write << " MB/s (snprintf " << mb/t_write_ref
+            << " MB/s), read " << mb/t_read << " MB/s (sscanf " << mb/t_read_ref << " MB/s)"
+            << (good ? "" : " FAILED") << std::endl;
+  return good;
+}
+
+// n values of each type through a memory file, back to the same values
+static bool types()
+{
+  const size_t n = 1000;
+  short s[n], s2[n];
+  int i4[n], i42[n];
+  long l[n], l2[n];
+  float f[n], f2[n];
+  double d[n], d2[n];
+  THHalf h[n], h2[n];
+  unsigned char b[n], b2[n];
+  for(int k = 0; k < (int)n; k++) {
+    s[k] = (short)(k*65 - 32768);
+    i4[k] = (int)((long)k*4294967 - 2147483647);
+    l[k] = (long)k*9223372036854775L - 9223372036854775807L;
+    f[k] = (k % 3 == 0 ? -1 : 1)*std::ldexp(float(k*12345%1000 + 1)/7, k % 200 - 100);
+    d[k] = (k % 3 == 0 ? -1 : 1)*std::ldexp(double(k*12345%1000 + 1)/7, k*3 % 2000 - 1000);
+    h[k] = TH_float2half(float(k)/3 - 100);
+    b[k] = (unsigned char)k;
+  }
+  f[0] = 0.f; f[1] = -0.f; d[0] = 5e-324; d[1] = 1.7976931348623157e308; l[0] = -9223372036854775807L-1;
+
+  THFile* file = THMemoryFile_new("rw");
+  THFile_writeShortRaw(file, s, n);
+  THFile_writeIntRaw(file, i4, n);
+  THFile_writeLongRaw(file, l, n);
+  THFile_writeFloatRaw(file, f, n);
+  THFile_writeDoubleRaw(file, d, n);
+  THFile_writeHalfRaw(file, h, n);
+  THFile_writeByteRaw(file, b, n);
+  THFile_writeIntScalar(file, 42);
+  THFile_seek(file, 0);
+  bool good = (THFile_readShortRaw(file, s2, n) == n) && (THFile_readIntRaw(file, i42, n) == n)
+    && (THFile_readLongRaw(file, l2, n) == n) && (THFile_readFloatRaw(file, f2, n) == n)
+    && (THFile_readDoubleRaw(file, d2, n) == n) && (THFile_readHalfRaw(file, h2, n) == n)
+    && (THFile_readByteRaw(file, b2, n) == n) && (THFile_readIntScalar(file) == 42);
+  good = good && !std::memcmp(s, s2, sizeof(s)) && !std::memcmp(i4, i42, sizeof(i4)) && !std::memcmp(l, l2, sizeof(l))
+    && !std::memcmp(f, f2, sizeof(f)) && !std::memcmp(d, d2, sizeof(d)) && !std::memcmp(h, h2, sizeof(h))
+    && !std::memcmp(b, b2, sizeof(b));
+  THFile_close(file);
+  THFile_free(file);
+  return good;
+}
+
+static bool shortest()
+{
+  const struct { double value; bool isFloat; const char* text; } cases[] = {
+    {0.1, true, "0.1"}, {0.1, false, "0.1"}, {1.0/3, false, "0.3333333333333333"}, {100, true, "100"},
+    {1e9, true, "1e+09"}, {123456789, true, "123456790"}, {1e-5, false, "1e-05"}, {0.0001, false, "0.0001"},
+    {-2.5e300, false, "-2.5e+300"}, {5e-324, false, "5e-324"}, {1e16, false, "10000000000000000"},
+    {1e17, false, "1e+17"}, {-0.0, false, "-0"}, {HUGE_VAL, false, "inf"}, {-HUGE_VAL, true, "-inf"},
+  };
+  bool good = true;
+  char str[TH_ASCII_SIZE];
+  for(auto& c : cases) {
+    if(c.isFloat) {
+      THAscii_formatFloat(str, (float)c.value);
+    } else {
+      THAscii_formatDouble(str, c.value);
+    }
+    if(std::strcmp(str, c.text) != 0) {
+      std::cout << c.text << " written " << str << std::endl;
+      good = false;
+    }
+  }
+  char* end;
+  good = (THAscii_parseDouble(" -12.5e-1x", &end) == -1.25) && (*end == 'x') && good;
+  good = (THAscii_parseFloat("3.4028235e38", nullptr) == 3.4028235e38f) && good;
+  good = (THAscii_parseLong("99999999999999999999", nullptr) == 9223372036854775807L) && good;
+  good = (THAscii_parseDouble("nan", &end) != THAscii_parseDouble("nan", &end)) && good;
+  good = (THAscii_parseDouble("abc", &end) == 0) && (std::strcmp(end, "abc") == 0) && good;
+  return good;
+}
+
+// ':' and ';' separate numbers in a THMemoryFile; a long decimal (parsed by
+// strtod_l) read the same with a locale of decimal commas, if there is one
+static bool separators()
+{
+  char text[] = "1;2:3 ;4\n:5";
+  THFile* file = THMemoryFile_new("rw");
+  THFile_writeCharRaw(file, text, std::strlen(text));
+  THFile_seek(file, 0);
+  THFile_quiet(file);
+  int values[6] = {0, 0, 0, 0, 0, 0};
+  bool good = (THFile_readIntRaw(file, values, 6) == 5);
+  for(int i = 0; i < 5; i++) {
+    good = (values[i] == i+1) && good;
+  }
+  THFile_close(file);
+  THFile_free(file);
+
+  const char* decimal = "0.12345678901234567890123";
+  double x = THAscii_parseDouble(decimal, nullptr);
+  float f = THAscii_parseFloat(decimal, nullptr);
+  const char* locales[] = {"de_DE.UTF-8", "fr_FR.UTF-8", "de_DE", "fr_FR"};
+  for(const char* locale : locales) {
+    if(std::setlocale(LC_NUMERIC, locale)) {
+      good = (THAscii_parseDouble(decimal, nullptr) == x) && (THAscii_parseFloat(decimal, nullptr) == f) && good;
+      std::cout << "   in " << locale << ": " << (good ? "ok" : "FAILED") << std::endl;
+      std::setlocale(LC_NUMERIC, "C");
+      return good;
+    }
+  }
+  std::cout << "   no locale of decimal commas" << std::endl;
+  return good && (x == 0.12345678901234568) && (f == 0.12345679f);
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+
+  Tensor x = rand({kFloats}, kFloat);
+  Tensor z = rand({kDoubles}, kDouble);
+  // wider exponents than rand
+  {
+    float* p = x.data<float>();
+    for(int64_t i = 0; i < kFloats; i += 2) {
+      p[i] = std::ldexp(p[i], int(i % 60) - 30);
+    }
+  }
+
+  ok = compare<float>("THDiskFile, floats", x, "%.9g", "%g") && ok;
+  ok = compare<double>("THDiskFile, doubles", z, "%.17g", "%lg") && ok;
+  ok = memory(x) && ok;
+
+  bool good = types();
+  ok = good && ok;
+  std::cout << "round trip of all types: " << (good ? "ok" : "FAILED") << std::endl;
+  good = shortest();
+  ok = good && ok;
+  std::cout << "shortest text, parsing: " << (good ? "ok" : "FAILED") << std::endl;
+  good = separators();
+  ok = good && ok;
+  std::cout << "':' and ';' separators, C locale: " << (good ? "ok" : "FAILED") << std::endl;
+
+  return ok ? 0 : 1;
+}
@@ -116,6 +116,66 @@ static void test(TensorDevice device)
   }
 
 
+  {
+    std::cout << "loads of adds (output reuse):" << std::endl;
+    auto begin = std::chrono::high_resolution_clock::now();
+    Tensor d = ones({3, 4}, kFloat, device);
+    Tensor r = zeros({3,4}, kFloat, device);
+    Tensor o; // allocated by the first call, then reused
+    for(auto i = 0; i < 100000; i++) {
+      add_(o, r, d);
+      std::swap(o, r);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << std::dec << "   " << std::chrono::duration_cast<std::chrono::milliseconds>(end-begin).count() << " ms" << std::endl;
+    std::cout << "   norm: " << norm(r).value<double>() << std::endl;
+  }
+
+  {
+    std::cout << "output with another type:" << std::endl;
+    Tensor a = rand({3, 4}, kFloat, device);
+    Tensor b = rand({3, 4}, kFloat, device);
+    Tensor m;
+    gt_(m, a, b);
+    std::cout << a << std::endl;
+    std::cout << b << std::endl;
+    std::cout << m << std::endl;
+  }
+
+  if(device == kCPU)
+  {
+    std::cout << "lazy expression:" << std::endl;
+    Tensor a = rand({3, 4}, kFloat, device);
+    Tensor b = rand({3, 4}, kFloat, device);
+    Tensor c = add(rand({3, 4}, kFloat, device), 1);
+    Tensor d = transpose(rand({4, 3}, kFloat, device)); // not contiguous
+    Tensor r = eval(lazy(a)*2 + lazy(b)/c - d);
+    std::cout << r << std::endl;
+    std::cout << norm(r - (add(mul(a, 2), cdiv(b, c)) - d)).value<double>() << " -- should be 0" << std::endl;
+  }
+
+  if(device == kCPU)
+  {
+    std::cout << "lazy vs eager (a*2 + b/c - d):" << std::endl;
+    Tensor a = rand({1000, 1000}, kFloat, device);
+    Tensor b = rand({1000, 1000}, kFloat, device);
+    Tensor c = add(rand({1000, 1000}, kFloat, device), 1);
+    Tensor d = rand({1000, 1000}, kFloat, device);
+    Tensor r;
+    auto begin = std::chrono::high_resolution_clock::now();
+    for(auto i = 0; i < 100; i++) {
+      r = add(mul(a, 2), cdiv(b, c)) - d;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << std::dec << "   eager: " << std::chrono::duration_cast<std::chrono::milliseconds>(end-begin).count() << " ms" << std::endl;
+    begin = std::chrono::high_resolution_clock::now();
+    for(auto i = 0; i < 100; i++) {
+      eval_(r, lazy(a)*2 + lazy(b)/c - d);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    std::cout << std::dec << "   lazy: " << std::chrono::duration_cast<std::chrono::milliseconds>(end-begin).count() << " ms" << std::endl;
+  }
+
   {
     std::cout << "isContiguous:" << std::endl;
     Tensor a = rand({3, 4}, kFloat, device);
@@ -0,0 +1,32 @@
+#ifndef XT_TEST_BENCH_H
+#define XT_TEST_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+
+// timing of the benchmarks
+
+// seconds taken by one call of func
+template<typename F>
+static double seconds(F func)
+{
+  auto begin = std::chrono::high_resolution_clock::now();
+  func();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count()*1e-9;
+}
+
+// seconds per call of func, over nrep calls after a warmup one
+template<typename F>
+static double seconds(int64_t nrep, F func)
+{
+  func(); // warmup
+  auto begin = std::chrono::high_resolution_clock::now();
+  for(int64_t i = 0; i < nrep; i++) {
+    func();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count()*1e-9/nrep;
+}
+
+#endif
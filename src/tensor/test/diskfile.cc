@@ -0,0 +1,197 @@
+#include "xttensor.h"
+#include "bench.h"
+#include "TH.h"
+#undef THTensor
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace xt;
+
+// 512MB of floats written to a binary THDiskFile and read back, out of the
+// page cache (cold reads), through the buffer of the stream
+// (THDiskFile_bulkSize 0), then with the bulk path (pread/pwrite by chunks),
+// in native and in swapped byte order; then the bulk reads of noCache
+// (O_DIRECT, or pages dropped after use), which leave the file out of the
+// cache, as for files larger than memory; and the byte swap alone, in cache,
+// against a loop over the bytes
+// also checks the positions around bulk reads and writes, and a short read
+// returns 1 on a wrong result
+
+static const int64_t kSize = 128 << 20; // floats
+
+static void evict(const std::string& filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// fraction of the pages of the file in the page cache
+static double cached(const std::string& filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  off_t size = lseek(fd, 0, SEEK_END);
+  void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  long page = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> in((size+page-1)/page);
+  mincore(p, size, in.data());
+  munmap(p, size);
+  close(fd);
+  int64_t n = 0;
+  for(unsigned char c : in) {
+    n += c & 1;
+  }
+  return double(n)/in.size();
+}
+
+static THFile* openFile(const std::string& filename, const char* mode, bool bulk, bool swapped)
+{
+  THFile* file = THDiskFile_new(filename.c_str(), mode, 0);
+  THFile_binary(file);
+  if(!bulk) {
+    THDiskFile_bulkSize(file, 0);
+  }
+  if(swapped) {
+    if(THDiskFile_isLittleEndianCPU()) {
+      THDiskFile_bigEndianEncoding(file);
+    } else {
+      THDiskFile_littleEndianEncoding(file);
+    }
+  }
+  return file;
+}
+
+static void done(THFile* file)
+{
+  THFile_close(file);
+  THFile_free(file);
+}
+
+int main()
+{
+  const std::string filename = "xt-test.diskfile";
+  const double mb = kSize*sizeof(float)/double(1 << 20);
+  bool ok = true;
+  std::cout.precision(4);
+
+  Tensor x = rand({kSize}, kFloat);
+  Tensor y({kSize}, kFloat);
+  fill_(y, Tensor(0.f));
+
+  for(bool swapped : {false, true}) {
+    double t_write[2], t_read[2];
+    bool good = true;
+    for(bool bulk : {false, true}) {
+      t_write[bulk] = seconds([&]() {
+          THFile* file = openFile(filename, "w", bulk, swapped);
+          THFile_writeFloatRaw(file, x.data<float>(), kSize);
+          done(file);
+          evict(filename);
+        });
+      fill_(y, Tensor(0.f));
+      t_read[bulk] = seconds([&]() {
+          THFile* file = openFile(filename, "r", bulk, swapped);
+          good = (THFile_readFloatRaw(file, y.data<float>(), kSize) == (size_t)kSize) && good;
+          done(file);
+        });
+      good = equal(x, y) && good;
+      evict(filename);
+    }
+    ok = good && ok;
+    std::cout << (swapped ? "swapped" : "native") << " byte order, write: " << mb/t_write[1] << " MB/s (stream "
+              << mb/t_write[0] << " MB/s), cold read: " << mb/t_read[1] << " MB/s (stream " << mb/t_read[0]
+              << " MB/s)" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    // the file now holds x swapped: read back swapped without the cache
+    fill_(y, Tensor(0.f));
+    bool good = true;
+    double t = seconds([&]() {
+        THFile* file = openFile(filename, "r", true, true);
+        THDiskFile_noCache(file, 1);
+        good = (THFile_readFloatRaw(file, y.data<float>(), kSize) == (size_t)kSize);
+        done(file);
+      });
+    double c = cached(filename);
+    good = equal(x, y) && (c < 0.05) && good;
+
+    THFile* file = openFile(filename, "r", true, true);
+    THFile_readFloatRaw(file, y.data<float>(), kSize);
+    done(file);
+    double c_ref = cached(filename);
+    ok = good && ok;
+    std::cout << "noCache, cold read: " << mb/t << " MB/s, " << c*100 << "% of the file left in the page cache ("
+              << c_ref*100 << "% after a bulk read)" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    // on 1MB, in cache, as a chunk just read
+    const int64_t n = 1 << 18, nrep = 1000;
+    Tensor z({n}, kFloat);
+    double t = seconds([&]() {
+        for(int64_t r = 0; r < nrep; r++) {
+          THFloatVector_swapBytes(z.data<float>(), x.data<float>(), n);
+        }
+      });
+    double t_ref = seconds([&]() {
+        for(int64_t r = 0; r < nrep; r++) {
+          const unsigned char* p = (const unsigned char*)x.data<float>();
+          unsigned char* q = (unsigned char*)z.data<float>();
+          for(int64_t i = 0; i < n; i++, p += 4, q += 4) {
+            q[0] = p[3]; q[1] = p[2]; q[2] = p[1]; q[3] = p[0];
+          }
+        }
+      });
+    THFloatVector_swapBytes(y.data<float>(), z.data<float>(), n);
+    bool good = equal(narrow(x, 0, 0, n), narrow(y, 0, 0, n));
+    ok = good && ok;
+    std::cout << "byte swap of 1MB: " << nrep*n*sizeof(float)/double(1 << 20)/t << " MB/s (byte loop "
+              << nrep*n*sizeof(float)/double(1 << 20)/t_ref << " MB/s)" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    // small writes around bulk ones, in both byte orders; a short read
+    bool good = true;
+    for(bool swapped : {false, true}) {
+      const int64_t n = 1 << 20;
+      THFile* file = openFile(filename, "w", true, swapped);
+      THFile_writeIntScalar(file, 7);
+      THFile_writeFloatRaw(file, x.data<float>(), n);
+      THFile_writeLongScalar(file, 8);
+      THFile_writeDoubleRaw(file, (double*)x.data<float>(), n/2);
+      THFile_writeShortScalar(file, 9);
+      good = (THFile_position(file) == 4 + 4*n + 8 + 4*n + 2) && good;
+      done(file);
+
+      fill_(y, Tensor(0.f));
+      file = openFile(filename, "r", true, swapped);
+      good = (THFile_readIntScalar(file) == 7) && good;
+      THFile_readFloatRaw(file, y.data<float>(), n);
+      good = (THFile_readLongScalar(file) == 8) && good;
+      THFile_readDoubleRaw(file, (double*)(y.data<float>() + n), n/2);
+      good = (THFile_readShortScalar(file) == 9) && good;
+      good = equal(narrow(x, 0, 0, n), narrow(y, 0, 0, n)) && equal(narrow(x, 0, 0, n), narrow(y, 0, n, n)) && good;
+      done(file);
+
+      file = openFile(filename, "r", true, swapped);
+      THFile_quiet(file);
+      THFile_seek(file, 4);
+      good = (THFile_readFloatRaw(file, y.data<float>(), 4*n) == (size_t)(2*n) + 2) && THFile_hasError(file) && good;
+      done(file);
+    }
+    ok = good && ok;
+    std::cout << "positions, short read: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+  std::remove(filename.c_str());
+
+  return ok ? 0 : 1;
+}
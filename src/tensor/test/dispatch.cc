@@ -0,0 +1,90 @@
+#include "xttensor.h"
+#include <iostream>
+#include <chrono>
+#include <array>
+
+using namespace xt;
+
+// per-call overhead of small tensor ops: the work done by TH is negligible,
+// so timings reflect the wrapper (dispatch, Tensor construction...)
+
+static const int64_t ncall = 1000000;
+
+struct noop_op
+{
+  template<typename T> int64_t cpu(const Tensor& x)
+  {
+    return sizeof(T);
+  };
+  template<typename T> int64_t gpu(const Tensor& x)
+  {
+    throw std::invalid_argument("device not supported");
+  };
+};
+
+// the former std::function jump table, kept for reference
+template<class F>
+static int64_t dispatch_table(const Tensor& t)
+{
+  static std::array<std::function<int64_t (F&, const Tensor&)>, 7> dyn = {{
+      &F::template cpu<uint8_t>,
+      &F::template cpu<int8_t>,
+      &F::template cpu<int16_t>,
+      &F::template cpu<int32_t>,
+      &F::template cpu<int64_t>,
+      &F::template cpu<float>,
+      &F::template cpu<double>,
+    }};
+  F functor;
+  return dyn.at(t.type())(functor, t);
+}
+
+template<typename F>
+static void bench(const std::string& name, F func)
+{
+  for(int64_t i = 0; i < ncall/10; i++) { // warmup
+    func();
+  }
+  auto begin = std::chrono::high_resolution_clock::now();
+  for(int64_t i = 0; i < ncall; i++) {
+    func();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count();
+  std::cout << "   " << name << ": " << ns/ncall << " ns/call" << std::endl;
+}
+
+int main()
+{
+  volatile int64_t sink = 0;
+
+  {
+    std::cout << "dispatch only:" << std::endl;
+    Tensor a = ones({1}, kFloat);
+    bench("std::function table", [&]() { sink += dispatch_table<noop_op>(a); });
+    bench("switch", [&]() { sink += dispatch<noop_op>(a); });
+  }
+
+  {
+    std::cout << "0-dim tensors:" << std::endl;
+    Tensor a(3.f);
+    Tensor b(4.f);
+    Tensor r;
+    bench("add", [&]() { r = add(a, b); });
+    bench("add_", [&]() { add_(r, a, b); });
+    bench("narrow", [&]() { r = narrow(a, 0, 0, 1); });
+  }
+
+  {
+    std::cout << "1-element tensors:" << std::endl;
+    Tensor a = ones({1}, kFloat);
+    Tensor b = ones({1}, kFloat);
+    Tensor r;
+    bench("add", [&]() { r = add(a, b); });
+    bench("add_", [&]() { add_(r, a, b); });
+    bench("select", [&]() { r = select(a, 0, 0); });
+    bench("narrow", [&]() { r = narrow(a, 0, 0, 1); });
+  }
+
+  return (sink > 0 ? 0 : 1);
+}
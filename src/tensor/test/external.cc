@@ -0,0 +1,97 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+using namespace xt;
+
+// a 256MB buffer of another library taken as a tensor (Tensor::from, no
+// copy) against allocate-then-copy, and the reverse (Tensor::share, a handle
+// on the data of a tensor, given back to Tensor::from)
+// also checks the deleter (called once, when the last view is freed),
+// strided and empty buffers, and the rejection of wrong arguments
+// returns 1 on a wrong result
+
+static bool throws(void* data, IntList sizes, IntList strides)
+{
+  try {
+    Tensor::from(data, sizes, strides, kFloat);
+  } catch(std::invalid_argument& e) {
+    return true;
+  }
+  return false;
+}
+
+int main()
+{
+  const int64_t rows = 1 << 16, cols = 1024; // 256MB of floats
+  const int64_t n = rows*cols;
+  bool ok = true;
+  std::cout.precision(4);
+
+  {
+    float* buffer = new float[n];
+    for(int64_t i = 0; i < n; i++) {
+      buffer[i] = (float)(i % 3);
+    }
+    int deletes = 0;
+    Tensor x, ref;
+    double t = seconds([&]() {
+      x = Tensor::from(buffer, {rows, cols}, {}, kFloat, [&](void* p) { delete[] (float*)p; deletes++; });
+    });
+    double t_ref = seconds([&]() {
+      ref = Tensor({rows, cols}, kFloat);
+      std::memcpy(ref.data<float>(), buffer, n*sizeof(float));
+    });
+    bool good = (x.data<float>() == buffer) && equal(x, ref) && (x.sizes() == IntList({rows, cols}));
+
+    // the buffer lives with its last view
+    Tensor row = select(x, 0, 7);
+    x = Tensor();
+    good = (deletes == 0) && (sum(row).value<double>() == sum(select(ref, 0, 7)).value<double>()) && good;
+    row = Tensor();
+    good = (deletes == 1) && good;
+    ok = good && ok;
+    std::cout << "from, " << n*sizeof(float)/(1 << 20) << "MB: " << t*1e6 << " us (allocate and copy "
+              << t_ref*1e6 << " us)" << (good ? "" : " FAILED") << std::endl;
+
+    // the other way: the data of ref, held by the handle, then by a tensor
+    std::shared_ptr<void> handle;
+    t = seconds([&]() { handle = ref.share(); });
+    float* p = ref.data<float>();
+    double s = sum(ref).value<double>();
+    ref = Tensor();
+    Tensor y = Tensor::from(handle.get(), {rows, cols}, {}, kFloat, [handle](void*) {});
+    handle.reset();
+    good = (y.data<float>() == p) && (sum(y).value<double>() == s);
+    ok = good && ok;
+    std::cout << "share: " << t*1e6 << " us" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    // a column-major matrix, 3x4, and an empty one
+    float buffer[12];
+    for(int i = 0; i < 12; i++) {
+      buffer[i] = i;
+    }
+    Tensor x = Tensor::from(buffer, {3, 4}, {1, 3}, kFloat);
+    Tensor c = contiguous(x);
+    bool good = (x.data<float>() == buffer) && (x.strides() == IntList({1, 3}))
+      && (c.data<float>()[1] == 3) && (c.data<float>()[4] == 1);
+    Tensor e = Tensor::from(nullptr, {0, 4}, {}, kFloat);
+    good = (e.dim() == zeros({0, 4}, kFloat).dim()) && (numel(e) == 0) && good; // empty, as in TH
+    Tensor v = Tensor::from(buffer+5, {}, {}, kFloat);
+    good = (v.dim() == 0) && (v.value<float>() == 5) && good;
+
+    good = throws(buffer, {3, 4}, {1}) && throws(buffer, {3, -4}, {}) && throws(buffer, {3, 4}, {-1, 3})
+      && throws(nullptr, {3, 4}, {}) && good;
+    // elements overflowing int64_t
+    good = throws(buffer, {3}, {(int64_t)1 << 62}) && throws(buffer, {(int64_t)1 << 32, (int64_t)1 << 32}, {})
+      && good;
+    ok = good && ok;
+    std::cout << "strided, empty, value, wrong arguments: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
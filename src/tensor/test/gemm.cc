@@ -0,0 +1,133 @@
+#include "xttensor.h"
+#include "TH.h"
+#include "bench.h"
+#include <iostream>
+#include <cmath>
+
+using namespace xt;
+
+// mm goes through THBlas_(gemm): a BLAS library when one was found at compile
+// time, the built-in blocked kernel otherwise (configure with -DWITH_BLAS=none
+// to measure it); compared here to the former fallback, a plain triple loop
+// with a scalar accumulator
+// also checks the four combinations of transposed operands (views with
+// swapped strides, passed as such to gemm) with 1 and 3 threads against the
+// naive loop; returns 1 on a wrong result
+
+template<typename T>
+static void naive_mm(Tensor& r, const Tensor& a, const Tensor& b)
+{
+  int64_t m = a.size(0);
+  int64_t k = a.size(1);
+  int64_t n = b.size(1);
+  T* r_p = r.data<T>();
+  T* a_p = a.data<T>();
+  T* b_p = b.data<T>();
+  for(int64_t i = 0; i < m; i++) {
+    for(int64_t j = 0; j < n; j++) {
+      T sum = 0;
+      for(int64_t l = 0; l < k; l++) {
+        sum += a_p[i*k+l]*b_p[l*n+j];
+      }
+      r_p[i*n+j] = sum;
+    }
+  }
+}
+
+template<typename T>
+static void bench(TensorType type, int64_t m, int64_t k, int64_t n)
+{
+  Tensor a = rand({m, k}, type);
+  Tensor b = rand({k, n}, type);
+  Tensor r;
+  Tensor ref = zeros({m, n}, type);
+  double flop = 2.0*m*n*k;
+  int64_t nrep = std::max<int64_t>(1, (int64_t)(2e9/flop));
+
+  double t_mm = seconds(nrep, [&]() { mm_(r, a, b); });
+  double t_naive = seconds(std::max<int64_t>(1, nrep/20), [&]() { naive_mm<T>(ref, a, b); });
+
+  double err = 0;
+  double amp = 0;
+  T* r_p = r.data<T>();
+  T* ref_p = ref.data<T>();
+  for(int64_t i = 0; i < m*n; i++) {
+    err = std::max(err, (double)std::abs(r_p[i]-ref_p[i]));
+    amp = std::max(amp, (double)std::abs(ref_p[i]));
+  }
+
+  std::cout << "   " << m << "x" << k << " * " << k << "x" << n << ": "
+            << "mm " << flop/t_mm*1e-9 << " GFLOP/s, "
+            << "naive " << flop/t_naive*1e-9 << " GFLOP/s, "
+            << "speedup " << t_naive/t_mm << ", "
+            << "rel. error " << err/amp << std::endl;
+}
+
+// operand of m rows and n columns: contiguous, or the transpose of one
+static Tensor operand(TensorType type, int64_t m, int64_t n, bool trans)
+{
+  return trans ? transpose(rand({n, m}, type)) : rand({m, n}, type);
+}
+
+// sizes across the blocks of the built-in kernel (KC 256), not multiples of
+// the tiles
+template<typename T>
+static bool check(TensorType type, double tol)
+{
+  const int64_t m = 301, k = 515, n = 263;
+  int threads = THThreadPool_getNumThreads();
+  bool ok = true;
+  for(int trans = 0; trans < 4; trans++) {
+    bool transa = trans & 1, transb = trans & 2;
+    Tensor a = operand(type, m, k, transa);
+    Tensor b = operand(type, k, n, transb);
+    Tensor ref = zeros({m, n}, type);
+    naive_mm<T>(ref, contiguous(a), contiguous(b));
+    for(int nthreads : {1, 3}) {
+      THThreadPool_setNumThreads(nthreads);
+      Tensor r;
+      mm_(r, a, b);
+      double err = 0;
+      double amp = 0;
+      T* r_p = r.data<T>();
+      T* ref_p = ref.data<T>();
+      for(int64_t i = 0; i < m*n; i++) {
+        err = std::max(err, (double)std::abs(r_p[i]-ref_p[i]));
+        amp = std::max(amp, (double)std::abs(ref_p[i]));
+      }
+      bool good = err <= tol*amp;
+      ok = good && ok;
+      std::cout << "   " << (transa ? "t" : "n") << (transb ? "t" : "n") << ", " << nthreads << " thread(s): "
+                << "rel. error " << err/amp << (good ? "" : " FAILED") << std::endl;
+    }
+  }
+  THThreadPool_setNumThreads(threads);
+  return ok;
+}
+
+template<typename T>
+static void bench_all(TensorType type)
+{
+  // square
+  bench<T>(type, 64, 64, 64);
+  bench<T>(type, 256, 256, 256);
+  bench<T>(type, 512, 512, 512);
+  bench<T>(type, 1024, 1024, 1024);
+  // skinny
+  bench<T>(type, 16, 1024, 4096);
+  bench<T>(type, 4096, 1024, 16);
+  bench<T>(type, 1024, 16, 1024);
+  bench<T>(type, 1000, 3, 1000);
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout << "float:" << std::endl;
+  bench_all<float>(kFloat);
+  ok = check<float>(kFloat, 1e-5) && ok;
+  std::cout << "double:" << std::endl;
+  bench_all<double>(kDouble);
+  ok = check<double>(kDouble, 1e-13) && ok;
+  return ok ? 0 : 1;
+}
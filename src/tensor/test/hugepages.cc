@@ -0,0 +1,112 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+
+using namespace xt;
+
+// large tensors (2GB) made with the default allocation, then aligned on
+// transparent huge pages (Context::setHugePages), then also prefaulted on the
+// TH threads (Context::setPrefault): page faults and bandwidth of fill and
+// copy on fresh tensors, time of an addmm writing a fresh 2GB result, and
+// anonymous huge pages taken by the process (Linux); needs about 4GB
+// also checks that a block grown by realloc keeps the options
+// returns 1 on a wrong result
+
+static int64_t faults()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+// kB of anonymous huge pages of the process, -1 if unknown
+static int64_t anonHugePages()
+{
+  std::ifstream smaps("/proc/self/smaps_rollup");
+  std::string key;
+  while(smaps >> key) {
+    if(key == "AnonHugePages:") {
+      int64_t kb;
+      smaps >> kb;
+      return kb;
+    }
+    smaps.ignore(1 << 20, '\n');
+  }
+  return -1;
+}
+
+static bool bench(const char* desc)
+{
+  const int64_t n = 1 << 29; // 2GB of floats
+  const int64_t m = 32768, p = 16384, k = 8; // addmm: 2GB result
+  const double gb = n*sizeof(float)/1e9;
+  bool ok;
+  double t_alloc, t_fill, t_copy;
+  int64_t f, f_alloc, f_fill, f_copy, huge;
+
+  {
+    Tensor x, y;
+    f = faults();
+    t_alloc = seconds([&]() { x = Tensor({n}, kFloat); });
+    f_alloc = faults() - f;
+    f = faults();
+    t_fill = seconds([&]() { fill_(x, Tensor(1.f)); });
+    f_fill = faults() - f;
+
+    y = Tensor({n}, kFloat);
+    f = faults();
+    t_copy = seconds([&]() { copy_(y, x); });
+    f_copy = faults() - f;
+    huge = anonHugePages();
+    ok = (sum(y).value<double>() == n);
+  }
+
+  // beta*c + a*b, into a fresh result (c is copied into it first)
+  Tensor c = ones({m, p}, kFloat), a = ones({m, k}, kFloat), b = ones({k, p}, kFloat);
+  Tensor r;
+  f = faults();
+  double t_addmm = seconds([&]() { r = addmm(c, a, b); });
+  int64_t f_addmm = faults() - f;
+  ok = (r.data<float>()[m*p-1] == k+1) && ok;
+
+  std::cout << desc << ": alloc " << t_alloc*1e3 << " ms (" << f_alloc << " faults)"
+            << ", fill " << gb/t_fill << " GB/s (" << f_fill << " faults)"
+            << ", copy " << gb/t_copy << " GB/s (" << f_copy << " faults)"
+            << ", addmm " << t_addmm*1e3 << " ms (" << f_addmm << " faults)"
+            << ", " << huge/1024 << " MB of huge pages" << (ok ? "" : " FAILED") << std::endl;
+  return ok;
+}
+
+// a tensor grown from 1MB to 64MB (THRealloc) is aligned on huge pages, with
+// its data
+static bool grow()
+{
+  Tensor x = ones({1 << 18}, kFloat);
+  x.resize({1 << 24});
+  bool ok = ((uintptr_t)x.data<float>() % (2 << 20) == 64) && (x.data<float>()[(1 << 18)-1] == 1);
+  std::cout << "grown to 64MB: " << (ok ? "ok" : "FAILED") << std::endl;
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+  defaultContext.setHugePages(false);
+  defaultContext.setPrefault(false);
+  ok = bench("default") && ok;
+  defaultContext.setHugePages(true);
+  ok = bench("huge pages") && ok;
+  ok = grow() && ok;
+  defaultContext.setPrefault(true);
+  ok = bench("huge pages, prefault") && ok;
+  defaultContext.setHugePages(false);
+  ok = bench("prefault") && ok;
+  defaultContext.setPrefault(false);
+  ok = !defaultContext.hugePages() && !defaultContext.prefault() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <algorithm>
+
+using namespace xt;
+
+// throughput of fill, add (adds), add with tensor (cadd), mul (muls),
+// cmul and copy on contiguous integer tensors, which go through the SSE2 or
+// AVX2 kernels of THVector; results are checked against a scalar loop
+// (values wrap around)
+// run with TH_NO_AVX2=1 and/or TH_NO_SSE=1 to compare with the other
+// implementations; returns 1 on a wrong result
+
+// wraparound arithmetic, without signed overflow
+template<typename T> static T wrap_add(T a, T b)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  return (T)(U)((U)a + (U)b);
+}
+
+template<typename T> static T wrap_mul(T a, T b)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  typedef typename std::conditional<sizeof(T) < sizeof(unsigned), unsigned, U>::type P; // no promotion to int
+  return (T)(U)((P)(U)a * (P)(U)b);
+}
+
+template<typename T, typename F>
+static bool verify(const char* name, const Tensor& r, int64_t n, F expected)
+{
+  const T* r_p = r.data<T>();
+  for(int64_t i = 0; i < n; i++) {
+    if(r_p[i] != expected(i)) {
+      std::cout << "   " << name << ": wrong result at " << i << ": "
+                << (int64_t)r_p[i] << " instead of " << (int64_t)expected(i) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+template<typename T>
+static bool bench(TensorType type, const char* desc, int64_t n)
+{
+  const int64_t nrep = std::max<int64_t>(20, (1 << 26)/n);
+  Tensor a = zeros({n}, type);
+  Tensor b = zeros({n}, type);
+  Tensor r = zeros({n}, type);
+  T* a_p = a.data<T>();
+  T* b_p = b.data<T>();
+  std::mt19937_64 gen(1);
+  for(int64_t i = 0; i < n; i++) {
+    a_p[i] = (T)gen();
+    b_p[i] = (T)gen();
+  }
+  const T c = (T)0x5b5b5b5b5b5b5b5bLL; // large enough to overflow
+  bool ok = true;
+  double bytes = (double)n*sizeof(T);
+
+  std::cout << desc << ", " << n << " elements:" << std::endl;
+
+  double t = seconds(nrep, [&]() { fill_(r, c); });
+  ok = verify<T>("fill", r, n, [&](int64_t i) { return c; }) && ok;
+  std::cout << "   fill " << bytes/t*1e-9 << " GB/s";
+
+  t = seconds(nrep, [&]() { add_(r, a, c); });
+  ok = verify<T>("adds", r, n, [&](int64_t i) { return wrap_add(a_p[i], c); }) && ok;
+  std::cout << ", adds " << 2*bytes/t*1e-9 << " GB/s";
+
+  t = seconds(nrep, [&]() { add_(r, a, c, b); });
+  ok = verify<T>("cadd", r, n, [&](int64_t i) { return wrap_add(a_p[i], wrap_mul(c, b_p[i])); }) && ok;
+  std::cout << ", cadd " << 3*bytes/t*1e-9 << " GB/s";
+
+  t = seconds(nrep, [&]() { mul_(r, a, c); });
+  ok = verify<T>("muls", r, n, [&](int64_t i) { return wrap_mul(a_p[i], c); }) && ok;
+  std::cout << ", muls " << 2*bytes/t*1e-9 << " GB/s";
+
+  t = seconds(nrep, [&]() { cmul_(r, a, b); });
+  ok = verify<T>("cmul", r, n, [&](int64_t i) { return wrap_mul(a_p[i], b_p[i]); }) && ok;
+  std::cout << ", cmul " << 3*bytes/t*1e-9 << " GB/s";
+
+  t = seconds(nrep, [&]() { copy_(r, a); });
+  ok = verify<T>("copy", r, n, [&](int64_t i) { return a_p[i]; }) && ok;
+  std::cout << ", copy " << 2*bytes/t*1e-9 << " GB/s" << std::endl;
+
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  // in cache, then in memory; odd sizes: tails are checked too
+  for(int64_t n : {(1 << 16) + 3, (1 << 22) + 3}) {
+    ok = bench<uint8_t>(kUInt8, "uint8", n) && ok;
+    ok = bench<int8_t>(kInt8, "int8", n) && ok;
+    ok = bench<int16_t>(kInt16, "int16", n) && ok;
+    ok = bench<int32_t>(kInt32, "int32", n) && ok;
+    ok = bench<int64_t>(kInt64, "int64", n) && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace xt;
+
+// tensors mapped from a file (Tensor::map) against the same tensor read into
+// heap memory: time until the tensor is ready, time of a first pass over it,
+// and anonymous memory (RssAnon, Linux) taken by each
+// also checks the three modes and the rejection of broken files; the files
+// go to TMPDIR (default /tmp); returns 1 on a wrong result
+
+// kB of anonymous memory of the process, -1 if unknown
+static int64_t rssAnon()
+{
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  while(status >> key) {
+    if(key == "RssAnon:") {
+      int64_t kb;
+      status >> kb;
+      return kb;
+    }
+    status.ignore(1 << 20, '\n');
+  }
+  return -1;
+}
+
+static bool throws(const std::string& filename)
+{
+  try {
+    Tensor::map(filename);
+  } catch(std::runtime_error& e) {
+    std::cout << "   rejected: " << e.what() << std::endl;
+    return true;
+  }
+  std::cout << "   not rejected: " << filename << " FAILED" << std::endl;
+  return false;
+}
+
+int main()
+{
+  const char* tmpdir = getenv("TMPDIR");
+  std::string filename = std::string(tmpdir ? tmpdir : "/tmp") + "/xt-test-map.bin";
+  const int64_t rows = 1 << 16, cols = 1024; // 256MB of floats
+  bool ok = true;
+  std::cout.precision(4);
+
+  {
+    Tensor x = Tensor::map(filename, {rows, cols}, kFloat);
+    float* x_p = x.data<float>();
+    for(int64_t i = 0; i < rows*cols; i++) {
+      x_p[i] = (float)(i % 1000);
+    }
+  }
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  int64_t bytes = file.tellg();
+  int64_t header = bytes - rows*cols*sizeof(float);
+  std::cout << "file of " << bytes << " bytes (" << header << " bytes of header)" << std::endl;
+
+  // both from the page cache: mapping shares it, reading copies it
+  double expected = 0;
+  for(int64_t i = 0; i < rows*cols; i++) {
+    expected += i % 1000;
+  }
+  {
+    Tensor x;
+    int64_t rss = rssAnon();
+    double t_open = seconds([&]() { x = Tensor::map(filename); });
+    double s;
+    double t_sum = seconds([&]() { s = sum(x).value<double>(); });
+    int64_t rss_x = rssAnon() - rss;
+    Tensor y;
+    rss = rssAnon();
+    double t_read = seconds([&]() {
+      y = zeros({rows, cols}, kFloat);
+      file.seekg(header);
+      file.read((char*)y.data<float>(), rows*cols*sizeof(float));
+    });
+    double s_y;
+    double t_sum_y = seconds([&]() { s_y = sum(y).value<double>(); });
+    int64_t rss_y = rssAnon() - rss;
+    bool good = (s == expected) && (s_y == expected) && (x.size() == y.size()) && x.type() == kFloat;
+    ok = good && ok;
+    std::cout << "mapped: ready in " << t_open*1e3 << " ms, first sum " << t_sum*1e3 << " ms"
+              << ", anonymous memory " << rss_x/1024 << " MB" << std::endl;
+    std::cout << "read: ready in " << t_read*1e3 << " ms, first sum " << t_sum_y*1e3 << " ms"
+              << ", anonymous memory " << rss_y/1024 << " MB" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    // private: writes stay in the process; shared: writes reach the file
+    Tensor p = Tensor::map(filename, kMapPrivate);
+    p.data<float>()[5] = -1;
+    bool good = (Tensor::map(filename).data<float>()[5] == 5);
+    Tensor s = Tensor::map(filename, kMapShared);
+    s.data<float>()[5] = -2;
+    good = (Tensor::map(filename).data<float>()[5] == -2) && (p.data<float>()[5] == -1) && good;
+    // rows of an embedding table (indices start at 1)
+    Tensor index = zeros({3}, kInt64);
+    index.data<int64_t>()[0] = 8;
+    index.data<int64_t>()[1] = rows;
+    index.data<int64_t>()[2] = 1;
+    Tensor e = xt::index(Tensor::map(filename), 0, index);
+    good = (e.size(0) == 3) && (e.data<float>()[0] == (7*cols) % 1000)
+      && (e.data<float>()[cols] == ((rows-1)*cols) % 1000) && (e.data<float>()[2*cols+5] == -2) && good;
+    ok = good && ok;
+    std::cout << "private, shared, index: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  {
+    std::cout << "broken files:" << std::endl;
+    std::string broken = filename + ".broken";
+    ok = throws(broken + ".missing") && ok;
+    std::ofstream(broken) << "not a tensor file, not a tensor file, not a tensor file, not a tensor file";
+    ok = throws(broken) && ok;
+    Tensor::map(broken, {10, 10}, kDouble);
+    ok = (Tensor::map(broken).size() == std::vector<int64_t>{10, 10}) && ok;
+    {
+      std::ofstream grow(broken, std::ios::app | std::ios::binary);
+      grow.put(0);
+    }
+    ok = throws(broken) && ok; // size mismatch
+    Tensor::map(broken, {10, 10}, kDouble);
+    {
+      // storage size (elements, at byte 40) whose bytes wrap around to the
+      // bytes of the file
+      std::fstream crafted(broken, std::ios::in | std::ios::out | std::ios::binary);
+      int64_t storageSize = ((int64_t)1 << 61) + 100;
+      crafted.seekp(40);
+      crafted.write((const char*)&storageSize, sizeof(storageSize));
+    }
+    ok = throws(broken) && ok;
+    std::remove(broken.c_str());
+
+    // a shape of more bytes than int64_t: rejected before the file is made
+    bool rejected = false;
+    try {
+      Tensor::map(broken, {(int64_t)1 << 31, (int64_t)1 << 31, 4}, kDouble);
+    } catch(std::invalid_argument& e) {
+      rejected = true;
+    }
+    rejected = rejected && !std::ifstream(broken);
+    std::cout << "   shape overflowing int64_t: " << (rejected ? "rejected" : "not rejected FAILED") << std::endl;
+    ok = rejected && ok;
+  }
+
+  std::remove(filename.c_str());
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace xt;
+
+// ops over two 512MB tensors mapped from files (Tensor::map, shared), out
+// of the page cache: fill, add, copy, sum and sum of the rows, in one pass
+// (budget 0) and out of core (budget 64MB); time and peak memory of the
+// process (VmHWM, Linux) during each op
+// also checks that both give the same results; the files go to TMPDIR
+// (default /tmp); returns 1 on a wrong result
+
+static const int64_t kRows = 16384, kCols = 8192; // floats
+static const int64_t kBudget = 64 << 20;
+
+// kB of the status line key of the process, -1 if unknown
+static int64_t status(const std::string& name)
+{
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  while(status >> key) {
+    if(key == name) {
+      int64_t kb;
+      status >> kb;
+      return kb;
+    }
+    status.ignore(1 << 20, '\n');
+  }
+  return -1;
+}
+
+// the peak memory from now on is the current one
+static void resetPeak()
+{
+  std::ofstream clear("/proc/self/clear_refs");
+  clear << "5";
+}
+
+static void evict(const std::string& filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// runs op on the tensors of the files, mapped afresh out of the page cache;
+// prints its time and the growth of the peak memory
+static void run(const std::string& name, int64_t budget, const std::string& xname, const std::string& yname,
+                std::function<void (Tensor& x, Tensor& y)> op)
+{
+  evict(xname);
+  evict(yname);
+  defaultContext.setOutOfCoreBudget(budget);
+  double t;
+  int64_t peak;
+  {
+    Tensor x = Tensor::map(xname, kMapShared);
+    Tensor y = Tensor::map(yname, kMapShared);
+    resetPeak();
+    int64_t before = status("VmRSS:");
+    t = seconds([&]() { op(x, y); });
+    peak = status("VmHWM:") - before;
+  }
+  defaultContext.setOutOfCoreBudget(0);
+  double mb = kRows*kCols*sizeof(float)/double(1 << 20);
+  std::cout << "  " << name << ": " << t << " s (" << mb/t << " MB/s), peak memory +" << peak/1024 << "MB"
+            << std::endl;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+  const char* tmpdir = getenv("TMPDIR");
+  const std::string xname = std::string(tmpdir ? tmpdir : "/tmp") + "/xt-test-outofcore-x.bin";
+  const std::string yname = std::string(tmpdir ? tmpdir : "/tmp") + "/xt-test-outofcore-y.bin";
+  {
+    Tensor::map(xname, {kRows, kCols}, kFloat);
+    Tensor::map(yname, {kRows, kCols}, kFloat);
+  }
+
+  double sums[2][4];
+  for(int mode = 0; mode < 2; mode++) {
+    int64_t budget = mode ? kBudget : 0;
+    std::cout << (mode ? "out of core (budget 64MB):" : "one pass:") << std::endl;
+    run("fill x", budget, xname, yname, [](Tensor& x, Tensor& y) { fill_(x, Tensor(0.25f)); });
+    run("y = x + 1", budget, xname, yname, [](Tensor& x, Tensor& y) { add_(y, x, Tensor(1.f)); });
+    run("sum y", budget, xname, yname, [&](Tensor& x, Tensor& y) { sums[mode][0] = sum(y).value<double>(); });
+    run("copy x to y", budget, xname, yname, [](Tensor& x, Tensor& y) { copy_(y, x); });
+    run("sum of the rows of y", budget, xname, yname, [&](Tensor& x, Tensor& y) {
+        Tensor s = sum(y, 1);
+        sums[mode][1] = sum(s).value<double>();
+      });
+    // the files hold what the ops wrote
+    Tensor x = Tensor::map(xname);
+    Tensor y = Tensor::map(yname);
+    sums[mode][2] = sum(x).value<double>();
+    sums[mode][3] = sum(y).value<double>();
+  }
+  const double n = kRows*kCols;
+  auto near = [](double a, double b) { return std::abs(a-b) <= 1e-6*std::abs(b); };
+  // chunks of whole blocks of the reductions: the same sums
+  bool good = sums[0][0] == sums[1][0] && sums[0][1] == sums[1][1] && near(sums[0][0], 1.25*n)
+    && near(sums[0][1], 0.25*n) && near(sums[1][2], 0.25*n) && near(sums[1][3], 0.25*n);
+  std::cout << "same results: " << (good ? "ok" : "FAILED") << std::endl;
+  ok = good && ok;
+
+  std::remove(xname.c_str());
+  std::remove(yname.c_str());
+  return ok ? 0 : 1;
+}
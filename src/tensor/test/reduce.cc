@@ -0,0 +1,245 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+using namespace xt;
+
+// full and per-dimension reductions of contiguous tensors go through the
+// reduction engine of THTensorMath (THVector kernels, several threads);
+// compared here to the former implementation, a sequential loop with one
+// accumulator, for speed and (sums) for accuracy against a long double sum
+// run with TH_NO_AVX=1 to measure the scalar kernels, and with
+// OMP_NUM_THREADS to change the number of threads; returns 1 on a wrong
+// result
+
+static bool close(double x, double ref, double tol)
+{
+  return std::abs(x-ref) <= tol*std::max(1.0, std::abs(ref));
+}
+
+static void report(const char* name, double bytes, double t, double t_ref, bool ok)
+{
+  std::cout << "   " << name << ": " << bytes/t*1e-9 << " GB/s"
+            << " (loop " << bytes/t_ref*1e-9 << " GB/s, speedup " << t_ref/t << ")"
+            << (ok ? "" : " FAILED") << std::endl;
+}
+
+template<typename T, typename A>
+static bool bench_all(TensorType type, const char* desc, double tol)
+{
+  const int64_t n = (1 << 24) + 5;
+  const int64_t nrep = 10;
+  Tensor x = zeros({n}, type);
+  T* x_p = x.data<T>();
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> uniform(-400, 600); // both signs
+  for(int64_t i = 0; i < n; i++) {
+    x_p[i] = (T)uniform(gen);
+  }
+  double bytes = (double)n*sizeof(T);
+  bool ok = true, good;
+  double t, t_ref;
+  A r;
+
+  std::cout << desc << ", " << n << " elements:" << std::endl;
+
+  long double exact = 0;
+  for(int64_t i = 0; i < n; i++) {
+    exact += x_p[i];
+  }
+  A s;
+  t = seconds(nrep, [&]() { s = sum(x).value<A>(); });
+  t_ref = seconds(nrep, [&]() {
+    r = 0;
+    for(int64_t i = 0; i < n; i++) {
+      r += x_p[i];
+    }
+  });
+  good = close(s, r, tol);
+  ok = good && ok;
+  report("sum", bytes, t, t_ref, good);
+  std::cout << "      relative error " << std::abs((long double)s-exact)/std::abs(exact)
+            << " (loop " << std::abs((long double)r-exact)/std::abs(exact) << ")";
+  defaultContext.setCompensatedSum(true);
+  double t_comp = seconds(nrep, [&]() { s = sum(x).value<A>(); });
+  defaultContext.setCompensatedSum(false);
+  std::cout << ", compensated " << std::abs((long double)s-exact)/std::abs(exact)
+            << " at " << bytes/t_comp*1e-9 << " GB/s" << std::endl;
+
+  T m;
+  t = seconds(nrep, [&]() { m = max(x).value<T>(); });
+  T m_ref;
+  t_ref = seconds(nrep, [&]() {
+    m_ref = x_p[0];
+    for(int64_t i = 0; i < n; i++) {
+      if(!(x_p[i] <= m_ref)) {
+        m_ref = x_p[i];
+      }
+    }
+  });
+  good = (m == m_ref);
+  ok = good && ok;
+  report("max", bytes, t, t_ref, good);
+
+  t = seconds(nrep, [&]() { m = min(x).value<T>(); });
+  t_ref = seconds(nrep, [&]() {
+    m_ref = x_p[0];
+    for(int64_t i = 0; i < n; i++) {
+      if(!(x_p[i] >= m_ref)) {
+        m_ref = x_p[i];
+      }
+    }
+  });
+  good = (m == m_ref);
+  ok = good && ok;
+  report("min", bytes, t, t_ref, good);
+
+  return ok;
+}
+
+template<typename T>
+static bool bench_float(TensorType type, double tol)
+{
+  const int64_t n = (1 << 24) + 5;
+  const int64_t nrep = 10;
+  Tensor x = rand({n}, type);
+  T* x_p = x.data<T>();
+  double bytes = (double)n*sizeof(T);
+  bool ok = true, good;
+  double t, t_ref, r, v;
+
+  t = seconds(nrep, [&]() { v = norm(x).value<double>(); });
+  t_ref = seconds(nrep, [&]() {
+    r = 0;
+    for(int64_t i = 0; i < n; i++) {
+      r += (double)x_p[i]*x_p[i];
+    }
+    r = std::sqrt(r);
+  });
+  good = close(v, r, tol);
+  ok = good && ok;
+  report("norm", bytes, t, t_ref, good);
+
+  t = seconds(nrep, [&]() { v = var(x).value<double>(); });
+  t_ref = seconds(nrep, [&]() {
+    double mean = 0;
+    for(int64_t i = 0; i < n; i++) {
+      mean += x_p[i];
+    }
+    mean /= n;
+    r = 0;
+    for(int64_t i = 0; i < n; i++) {
+      r += (x_p[i]-mean)*(x_p[i]-mean);
+    }
+    r /= n-1;
+  });
+  good = close(v, r, tol);
+  ok = good && ok;
+  report("var", bytes, t, t_ref, good);
+
+  // small spread around a large mean: rounding the mean to T would bias
+  // the sum of squares (by about 1e-4 of the variance for floats)
+  Tensor y = zeros({n}, type);
+  T* y_p = y.data<T>();
+  double mean = 0;
+  for(int64_t i = 0; i < n; i++) {
+    y_p[i] = (T)(1000.1 + 0.01*x_p[i]);
+    mean += y_p[i];
+  }
+  mean /= n;
+  r = 0;
+  for(int64_t i = 0; i < n; i++) {
+    r += (y_p[i]-mean)*(y_p[i]-mean);
+  }
+  r /= n-1;
+  v = var(y).value<double>();
+  good = std::abs(v-r) <= 1e-9*r;
+  ok = good && ok;
+  std::cout << "   var around 1000: relative error " << std::abs(v-r)/r << (good ? "" : " FAILED") << std::endl;
+
+  return ok;
+}
+
+// sum and max of a rows x cols matrix along both dimensions
+template<typename T>
+static bool bench_dim(TensorType type, int64_t rows, int64_t cols, double tol)
+{
+  const int64_t nrep = 10;
+  Tensor x = rand({rows, cols}, type);
+  T* x_p = x.data<T>();
+  double bytes = (double)rows*cols*sizeof(T);
+  bool ok = true, good;
+  double t, t_ref;
+  Tensor r;
+  Tensor ref = zeros({std::max(rows, cols)}, type);
+  T* ref_p = ref.data<T>();
+
+  std::cout << "   " << rows << "x" << cols << ":" << std::endl;
+
+  for(int dim = 0; dim < 2; dim++) {
+    int64_t m = (dim == 0 ? cols : rows);
+    // former implementations: an accumulator per row (stride 1), or
+    // accumulation into the result, in the order of the elements (otherwise)
+    t = seconds(nrep, [&]() { sum_(r, x, dim); });
+    t_ref = seconds(nrep, [&]() {
+      if(dim == 1) {
+        for(int64_t i = 0; i < rows; i++) {
+          double s = 0;
+          for(int64_t j = 0; j < cols; j++) {
+            s += x_p[i*cols+j];
+          }
+          ref_p[i] = (T)s;
+        }
+      } else {
+        std::fill(ref_p, ref_p+cols, (T)0);
+        for(int64_t i = 0; i < rows; i++) {
+          for(int64_t j = 0; j < cols; j++) {
+            ref_p[j] += x_p[i*cols+j];
+          }
+        }
+      }
+    });
+    good = true;
+    for(int64_t i = 0; i < m; i++) {
+      good = good && close(r.data<T>()[i], ref_p[i], tol);
+    }
+    ok = good && ok;
+    report(dim == 0 ? "   sum(0)" : "   sum(1)", bytes, t, t_ref, good);
+
+    Tensor values, indices;
+    t = seconds(nrep, [&]() { max_(values, indices, x, dim); });
+    good = true;
+    for(int64_t i = 0; i < m; i++) {
+      int64_t index = indices.data<int64_t>()[i];
+      T best = x_p[dim == 0 ? index*cols+i : i*cols+index];
+      good = good && (values.data<T>()[i] == best);
+      for(int64_t j = 0; j < (dim == 0 ? rows : cols); j++) {
+        T v = x_p[dim == 0 ? j*cols+i : i*cols+j];
+        good = good && (v < best || (v == best && j >= index));
+      }
+    }
+    ok = good && ok;
+    std::cout << "      max(" << dim << "): " << bytes/t*1e-9 << " GB/s"
+              << (good ? "" : " FAILED") << std::endl;
+  }
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+  ok = bench_all<float, double>(kFloat, "float", 1e-9) && ok;
+  ok = bench_float<float>(kFloat, 1e-6) && ok;
+  ok = bench_all<double, double>(kDouble, "double", 1e-9) && ok;
+  ok = bench_float<double>(kDouble, 1e-9) && ok;
+  ok = bench_all<int32_t, int64_t>(kInt32, "int32", 0) && ok;
+  std::cout << "per dimension (float):" << std::endl;
+  ok = bench_dim<float>(kFloat, 4096, 4096, 1e-4) && ok;
+  ok = bench_dim<float>(kFloat, 100000, 16, 1e-4) && ok;
+  ok = bench_dim<float>(kFloat, 16, 100000, 1e-4) && ok;
+  return ok ? 0 : 1;
+}
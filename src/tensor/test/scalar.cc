@@ -0,0 +1,135 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace xt;
+
+// values (0-dim tensors) made by Tensor(T) are held in the Tensor, with no TH
+// tensor until TH needs one; compared here to values backed by a TH tensor
+// (the former Tensor(T)) on scalar-heavy code: creation, step counter, loss
+// accumulation, scalar arithmetic, scalar times a small tensor
+// returns 1 on a wrong result
+
+// value backed by a TH tensor of size 1
+template<typename T>
+static Tensor thvalue(T v)
+{
+  Tensor t({1}, Tensor::type<T>());
+  t.data<T>()[0] = v;
+  t.tovalue();
+  return t;
+}
+
+static void report(const char* desc, double t, double t_ref, bool good)
+{
+  std::cout << desc << ": " << t*1e9 << " ns (TH value " << t_ref*1e9 << " ns, speedup " << t_ref/t << ")"
+            << (good ? "" : " FAILED") << std::endl;
+}
+
+int main()
+{
+  const int64_t nrep = 1000000;
+  bool ok = true;
+  std::cout.precision(4);
+
+  {
+    double s = 0, s_ref = 0;
+    double t = seconds(nrep, [&]() { Tensor v(1.5); s += v.value<double>(); });
+    double t_ref = seconds(nrep, [&]() { Tensor v = thvalue(1.5); s_ref += v.value<double>(); });
+    bool good = (s == s_ref);
+    ok = good && ok;
+    report("create and read", t, t_ref, good);
+  }
+
+  {
+    Tensor step(0_i64);
+    Tensor step_ref = thvalue(0_i64);
+    double t = seconds(nrep, [&]() { step++; });
+    double t_ref = seconds(nrep, [&]() { step_ref++; });
+    bool good = (step.value<int64_t>() == nrep+1) && (step_ref.value<int64_t>() == nrep+1) && step.type() == kInt64;
+    ok = good && ok;
+    report("step++", t, t_ref, good);
+  }
+
+  {
+    Tensor x = ones({16}, kFloat);
+    Tensor loss(0.);
+    Tensor loss_ref = thvalue(0.);
+    double t = seconds(nrep, [&]() { loss += sum(x); });
+    double t_ref = seconds(nrep, [&]() { loss_ref += sum(x); });
+    bool good = (loss.value<double>() == 16.*(nrep+1)) && (loss_ref.value<double>() == 16.*(nrep+1));
+    ok = good && ok;
+    report("loss += sum(16 floats)", t, t_ref, good);
+  }
+
+  {
+    Tensor a(3.f), b(0.5f), c(-1.f);
+    Tensor a_ref = thvalue(3.f), b_ref = thvalue(0.5f), c_ref = thvalue(-1.f);
+    Tensor r, r_ref;
+    double t = seconds(nrep, [&]() { r = (a*b - c)/b + a; });
+    double t_ref = seconds(nrep, [&]() { r_ref = (a_ref*b_ref - c_ref)/b_ref + a_ref; });
+    // TH ops on TH values give tensors of size 1, not values
+    bool good = (r.value<float>() == 8.f) && (r_ref.data<float>()[0] == 8.f) && r.type() == kFloat && r.dim() == 0;
+    ok = good && ok;
+    report("(a*b-c)/b+a", t, t_ref, good);
+  }
+
+  {
+    Tensor x = ones({16}, kFloat);
+    Tensor r, r_ref;
+    double t = seconds(nrep, [&]() { r = mul(x, Tensor(2.f)); });
+    double t_ref = seconds(nrep, [&]() { r_ref = mul(x, thvalue(2.f)); });
+    bool good = (sum(r).value<double>() == 32) && (sum(r_ref).value<double>() == 32);
+    ok = good && ok;
+    report("16 floats * value", t, t_ref, good);
+  }
+
+  {
+    // a value given to TH as a tensor gets its TH tensor, and keeps its value
+    Tensor v((int16_t)7);
+    Tensor w = v; // copied with the value
+    Tensor x = zeros({3}, kInt16);
+    add_(x, x, v);
+    add_(v, v, Tensor((int16_t)1)); // v as a TH tensor
+    v++;
+    bool good = (x.data<int16_t>()[2] == 7) && (v.value<int16_t>() == 9) && (w.value<int16_t>() == 7)
+      && (v.dim() == 0) && (v.type() == kInt16) && (v.size().empty()) && (w.data<int16_t>()[0] == 7);
+    ok = good && ok;
+    std::cout << "value given to TH: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  {
+    // threads giving the same const value to TH at once (share() makes its
+    // TH tensor) get one TH tensor
+    bool good = true;
+    for(int rep = 0; rep < 1000; rep++) {
+      const Tensor v(2.5f);
+      std::atomic<bool> go(false);
+      std::shared_ptr<void> seen[4];
+      std::vector<std::thread> threads;
+      for(int i = 0; i < 4; i++) {
+        threads.emplace_back([&, i]() {
+            while(!go) {
+              std::this_thread::yield();
+            }
+            seen[i] = v.share();
+          });
+      }
+      go = true;
+      for(std::thread& thread : threads) {
+        thread.join();
+      }
+      for(int i = 0; i < 4; i++) {
+        good = good && (seen[i].get() == seen[0].get());
+      }
+      good = good && (*(float*)seen[0].get() == 2.5f) && (v.value<float>() == 2.5f);
+    }
+    ok = good && ok;
+    std::cout << "value given to TH by several threads: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
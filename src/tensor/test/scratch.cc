@@ -0,0 +1,111 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <functional>
+#include <string>
+
+using namespace xt;
+
+// TH ops with temporaries (index with a strided index, topk, mode,
+// kthvalue, copy of a transposed matrix, mm of a strided operand), repeated
+// on the same tensors: heap allocations per call (Context::heapStats) and
+// time with the scratch workspaces of the threads, then with a scratch
+// limit of 0 (the temporaries on the heap); sum along a strided dimension
+// has no temporary (the result is expanded in place), only the counters of
+// TH_TENSOR_APPLY2, with or without workspace
+// also checks scratchSize and releaseScratch
+// returns 1 on a wrong result
+
+// heap allocations per call, in the steady state (the workspace grows to
+// its size in the first calls)
+static double allocations(int64_t nrep, const std::function<void()>& func)
+{
+  for(int i = 0; i < 3; i++) {
+    func(); // warmup
+  }
+  int64_t before = defaultContext.heapStats().numAllocs;
+  for(int64_t i = 0; i < nrep; i++) {
+    func();
+  }
+  return double(defaultContext.heapStats().numAllocs - before)/nrep;
+}
+
+// maxAllocs: allocations left with the workspace (tensor headers, counters
+// of the apply macros)
+static bool bench(const std::string& name, int64_t nrep, double maxAllocs, const std::function<void()>& func,
+                  const Tensor& result)
+{
+  const int64_t limit = defaultContext.scratchLimit();
+  double n = allocations(nrep, func);
+  double t = seconds(nrep, func);
+  Tensor r(result.sizes(), kFloat);
+  copy_(r, result);
+
+  defaultContext.setScratchLimit(0);
+  defaultContext.releaseScratch();
+  double n_ref = allocations(nrep, func);
+  double t_ref = seconds(nrep, func);
+  defaultContext.setScratchLimit(limit);
+
+  bool ok = (n <= maxAllocs+0.01) && (n <= n_ref) && equal(r, result);
+  std::cout << name << ": " << n << " allocations per call (" << n_ref << " without workspace), "
+            << t*1e6 << " us (" << t_ref*1e6 << " us)" << (ok ? "" : " FAILED") << std::endl;
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+
+  {
+    Tensor x = rand({4096, 64}, kFloat);
+    Tensor pairs = zeros({1000, 2}, kInt64);
+    Tensor index = select(pairs, 1, 0); // stride 2
+    for(int64_t i = 0; i < 1000; i++) {
+      index.data<int64_t>()[2*i] = (i*37) % 4096 + 1; // TH_INDEX_BASE
+    }
+    Tensor r;
+    ok = bench("index (strided index)", 10000, 0, [&]() { index_(r, x, 0, index); }, r) && ok;
+  }
+
+  {
+    Tensor x = rand({64, 1000}, kFloat);
+    Tensor r, ri;
+    ok = bench("topk", 1000, 0, [&]() { topk_(r, ri, x, 10, 1, true, true); }, r) && ok;
+    ok = bench("mode", 1000, 1, [&]() { mode_(r, ri, x, 1); }, r) && ok;
+    ok = bench("kthvalue", 1000, 1, [&]() { kthvalue_(r, ri, x, 5, 1); }, r) && ok;
+  }
+
+  {
+    Tensor x = transpose(rand({1024, 256}, kFloat)); // strides (1, 256)
+    Tensor r;
+    ok = bench("sum along a strided dim (no temporary)", 1000, 2, [&]() { sum_(r, x, 1); }, r) && ok;
+  }
+
+  {
+    Tensor x = transpose(rand({512, 512}, kFloat));
+    Tensor r = zeros({512, 512}, kFloat);
+    ok = bench("copy of a transposed matrix", 1000, 0, [&]() { copy_(r, x); }, r) && ok;
+  }
+
+  {
+    Tensor a = rand({256, 256}, kFloat);
+    Tensor b = select(rand({256, 256, 2}, kFloat), 2, 0); // strides (512, 2)
+    Tensor r;
+    ok = bench("mm (strided operand)", 200, 3, [&]() { mm_(r, a, b); }, r) && ok;
+  }
+
+  {
+    Tensor x = transpose(rand({512, 512}, kFloat));
+    Tensor r = zeros({512, 512}, kFloat);
+    copy_(r, x);
+    bool good = (defaultContext.scratchSize() > 0);
+    defaultContext.releaseScratch();
+    good = (defaultContext.scratchSize() == 0) && good;
+    ok = good && ok;
+    std::cout << "releaseScratch: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
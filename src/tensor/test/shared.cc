@@ -0,0 +1,290 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace xt;
+
+// batches of 4MB made by worker processes for this one, through shared
+// memory against the same batches written to a pipe: each worker refills
+// the tensors of a SharedPool, which this process opens once, and sends
+// their numbers; or each worker makes a new tensor per batch
+// (Tensor::shared), sends its handle, and frees it once this process has
+// opened it
+// also checks views, the refcount across processes (the object goes with
+// the last tensor, of any process), the rejection of a freed object and of
+// handles whose sizes overflow
+// returns 1 on a wrong result
+
+static const int kWorkers = 2, kBatches = 32, kSlots = 2; // tensors of a pool
+static const int64_t kRows = 1024, kCols = 1024;
+
+static bool readAll(int fd, void* data, size_t size)
+{
+  for(char* p = (char*)data; size > 0; ) {
+    ssize_t n = read(fd, p, size);
+    if(n <= 0) {
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool writeAll(int fd, const void* data, size_t size)
+{
+  for(const char* p = (const char*)data; size > 0; ) {
+    ssize_t n = write(fd, p, size);
+    if(n <= 0) {
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool exists(const SharedHandle& handle)
+{
+  return (bool)std::ifstream(std::string("/dev/shm") + handle.name); // Linux
+}
+
+struct Worker
+{
+  pid_t pid;
+  int data; // batches (or their handles), from the worker
+  int ack; // to the worker
+};
+
+enum Mode {
+  kPool, // numbers of the tensors of a SharedPool
+  kNew, // handles of new tensors
+  kPipe // the data
+};
+
+// the batch b of worker w: filled with w*kBatches+b
+static Worker spawn(int w, Mode mode)
+{
+  int data[2], ack[2];
+  if(pipe(data) != 0 || pipe(ack) != 0) {
+    throw std::runtime_error("pipe");
+  }
+  pid_t pid = fork();
+  if(pid == 0) {
+    close(data[0]);
+    close(ack[1]);
+    if(mode == kPool) {
+      // the tensors of the pool are used in turn: the tensor of batch b
+      // comes back (its number) before batch b+kSlots
+      SharedPool pool(kSlots, {kRows, kCols}, kFloat);
+      std::vector<SharedHandle> handles = pool.handles();
+      if(!writeAll(data[1], handles.data(), kSlots*sizeof(SharedHandle))) {
+        _exit(1);
+      }
+      for(int32_t b = 0; b < kBatches+kSlots; b++) {
+        int32_t slot = b % kSlots, back;
+        if(b >= kSlots && (!readAll(ack[0], &back, sizeof(back)) || back != slot)) {
+          _exit(1);
+        }
+        if(b < kBatches) {
+          fill_(pool[slot], Tensor(float(w*kBatches+b)));
+          if(!writeAll(data[1], &slot, sizeof(slot))) {
+            _exit(1);
+          }
+        }
+      }
+    }
+    for(int b = 0; b < kBatches && mode != kPool; b++) {
+      float value = w*kBatches+b;
+      if(mode == kNew) {
+        Tensor x = Tensor::shared({kRows, kCols}, kFloat);
+        fill_(x, Tensor(value));
+        SharedHandle handle = x.handle();
+        char c;
+        if(!writeAll(data[1], &handle, sizeof(handle)) || !readAll(ack[0], &c, 1)) {
+          _exit(1);
+        }
+      } else {
+        Tensor x({kRows, kCols}, kFloat);
+        fill_(x, Tensor(value));
+        if(!writeAll(data[1], x.data<float>(), kRows*kCols*sizeof(float))) {
+          _exit(1);
+        }
+      }
+    }
+    _exit(0);
+  }
+  close(data[1]);
+  close(ack[0]);
+  return {pid, data[0], ack[1]};
+}
+
+static bool join(std::vector<Worker>& workers)
+{
+  bool ok = true;
+  for(Worker& worker : workers) {
+    int status;
+    close(worker.data);
+    close(worker.ack);
+    ok = (waitpid(worker.pid, &status, 0) == worker.pid) && WIFEXITED(status) && (WEXITSTATUS(status) == 0) && ok;
+  }
+  return ok;
+}
+
+int main()
+{
+  const double mb = kWorkers*kBatches*kRows*kCols*sizeof(float)/double(1 << 20);
+  bool ok = true;
+  std::cout.precision(4);
+
+  double t_pool;
+  {
+    bool good = true;
+    std::vector<Worker> workers;
+    std::vector<SharedPool> pools;
+    t_pool = seconds([&]() {
+      for(int w = 0; w < kWorkers; w++) {
+        workers.push_back(spawn(w, kPool));
+      }
+      for(int w = 0; w < kWorkers; w++) {
+        std::vector<SharedHandle> handles(kSlots);
+        good = readAll(workers[w].data, handles.data(), kSlots*sizeof(SharedHandle)) && good;
+        pools.push_back(SharedPool(handles));
+      }
+      for(int b = 0; b < kBatches; b++) {
+        for(int w = 0; w < kWorkers; w++) {
+          int32_t slot;
+          good = readAll(workers[w].data, &slot, sizeof(slot)) && good;
+          Tensor& y = pools[w][slot];
+          good = (sum(y).value<double>() == double(w*kBatches+b)*kRows*kCols) && good;
+          good = writeAll(workers[w].ack, &slot, sizeof(slot)) && good;
+        }
+      }
+      good = join(workers) && good;
+    });
+
+    // the workers are gone: their pools live with the ones of this process
+    SharedHandle handle = pools[kWorkers-1][kSlots-1].handle();
+    good = exists(handle) && (pools[kWorkers-1][(kBatches-1) % kSlots].data<float>()[0] == kWorkers*kBatches-1) && good;
+    pools.clear();
+    good = !exists(handle) && good;
+    ok = good && ok;
+    std::cout << "shared memory, pools of " << kSlots << " tensors: " << mb/t_pool << " MB/s"
+              << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    bool good = true;
+    std::vector<Worker> workers;
+    SharedHandle last;
+    Tensor kept;
+    double t = seconds([&]() {
+      for(int w = 0; w < kWorkers; w++) {
+        workers.push_back(spawn(w, kNew));
+      }
+      for(int b = 0; b < kBatches; b++) {
+        for(int w = 0; w < kWorkers; w++) {
+          SharedHandle handle;
+          good = readAll(workers[w].data, &handle, sizeof(handle)) && good;
+          Tensor y = Tensor::shared(handle);
+          good = writeAll(workers[w].ack, "", 1) && good;
+          good = (sum(y).value<double>() == double(w*kBatches+b)*kRows*kCols) && good;
+          last = handle;
+          kept = y;
+        }
+      }
+      good = join(workers) && good;
+    });
+
+    // the workers are gone: the last batch lives with the tensor of this
+    // process, the others with their worker
+    good = exists(last) && (kept.data<float>()[kRows*kCols-1] == kWorkers*kBatches-1) && good;
+    kept = Tensor();
+    good = !exists(last) && good;
+    bool rejected = false;
+    try {
+      Tensor::shared(last);
+    } catch(std::runtime_error& e) {
+      rejected = true;
+    }
+    good = rejected && good;
+    ok = good && ok;
+    std::cout << "shared memory, a new tensor per batch: " << mb/t << " MB/s" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    bool good = true;
+    std::vector<Worker> workers;
+    Tensor y({kRows, kCols}, kFloat);
+    double t = seconds([&]() {
+      for(int w = 0; w < kWorkers; w++) {
+        workers.push_back(spawn(w, kPipe));
+      }
+      for(int b = 0; b < kBatches; b++) {
+        for(int w = 0; w < kWorkers; w++) {
+          good = readAll(workers[w].data, y.data<float>(), kRows*kCols*sizeof(float)) && good;
+          good = (sum(y).value<double>() == double(w*kBatches+b)*kRows*kCols) && good;
+        }
+      }
+      good = join(workers) && good;
+    });
+    ok = good && ok;
+    std::cout << "pipe: " << mb/t << " MB/s (pools: speedup " << t/t_pool << ")" << (good ? "" : " FAILED") << std::endl;
+  }
+
+  {
+    // a view, opened a second time in this process: the same memory
+    Tensor x = Tensor::shared({6, 4}, kInt32);
+    Tensor v = narrow(transpose(x, 0, 1), 1, 2, 3);
+    SharedHandle handle = v.handle();
+    Tensor y = Tensor::shared(handle);
+    fill_(y, Tensor(7));
+    bool good = (handle.offset == 8) && (y.sizes() == v.sizes()) && (y.strides() == v.strides())
+      && (sum(x).value<int64_t>() == 7*12);
+    bool rejected = false;
+    try {
+      Tensor({3}, kInt32).handle();
+    } catch(std::invalid_argument& e) {
+      rejected = true;
+    }
+    good = rejected && good;
+    // handles of another process, crafted: strides and storage sizes whose
+    // products overflow
+    SharedHandle crafted = handle;
+    crafted.dim = 1;
+    crafted.sizes[0] = 3;
+    crafted.strides[0] = (int64_t)1 << 62;
+    for(int k = 0; k < 2; k++) {
+      rejected = false;
+      try {
+        Tensor::shared(crafted);
+      } catch(std::runtime_error& e) {
+        rejected = true;
+      }
+      good = rejected && good;
+      crafted.strides[0] = 1;
+      crafted.storageSize = ((int64_t)1 << 62) + 1;
+    }
+    rejected = false;
+    try {
+      Tensor::shared({(int64_t)1 << 31, (int64_t)1 << 31}, kDouble);
+    } catch(std::invalid_argument& e) {
+      rejected = true;
+    }
+    good = rejected && good;
+    x = Tensor();
+    v = Tensor();
+    good = exists(handle) && good;
+    y = Tensor();
+    good = !exists(handle) && good;
+    ok = good && ok;
+    std::cout << "views, handle of a tensor of the heap, crafted handles: " << (good ? "ok" : "FAILED") << std::endl;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <utility>
+
+using namespace xt;
+
+// sort and topk go through the slice-parallel code of THTensorMath: radix
+// sort of long slices (all the threads on a single one), heap for a small k,
+// quickselect otherwise; compared here to std::sort, and to std::nth_element
+// followed by std::sort of the k elements (the former topk), on pairs of
+// (value, index)
+// run with OMP_NUM_THREADS to change the number of threads; returns 1 on a
+// wrong result
+
+template<typename T>
+static Tensor random(TensorType type, int64_t rows, int64_t cols)
+{
+  Tensor x = zeros({rows, cols}, type);
+  T* x_p = x.data<T>();
+  std::mt19937_64 gen(1);
+  std::uniform_real_distribution<double> uniform(-1000, 1000);
+  for(int64_t i = 0; i < rows*cols; i++) {
+    x_p[i] = std::is_floating_point<T>::value ? (T)uniform(gen) : (T)gen();
+  }
+  return x;
+}
+
+template<typename T>
+static bool before(T a, T b, bool descending)
+{
+  return descending ? b < a : a < b;
+}
+
+// each slice of r holds the k best values of the slice of x (in order if
+// ordered), and ri the indices of these values in x
+template<typename T>
+static bool check(const Tensor& x, const Tensor& r, const Tensor& ri, int dim,
+                  int64_t k, bool descending, bool ordered)
+{
+  int64_t n = x.size(dim);
+  int64_t slices = numel(x)/n;
+  const T* x_p = x.data<T>();
+  const T* r_p = r.data<T>();
+  const int64_t* ri_p = ri.data<int64_t>();
+  int64_t xs = x.stride(dim), rs = r.stride(dim);
+  int64_t xo = x.stride(1-dim), ro = r.stride(1-dim);
+  std::vector<T> all(n);
+  std::vector<bool> seen(n);
+  for(int64_t s = 0; s < slices; s++) {
+    for(int64_t j = 0; j < n; j++) {
+      all[j] = x_p[s*xo+j*xs];
+    }
+    auto order = [&](T a, T b) { return before(a, b, descending); };
+    std::nth_element(all.begin(), all.begin()+k-1, all.end(), order);
+    std::sort(all.begin(), all.begin()+k, order);
+    std::fill(seen.begin(), seen.end(), false);
+    std::vector<T> got(k);
+    for(int64_t j = 0; j < k; j++) {
+      int64_t index = ri_p[s*ro+j*rs];
+      got[j] = r_p[s*ro+j*rs];
+      if(index < 0 || index >= n || seen[index] || x_p[s*xo+index*xs] != got[j]) {
+        std::cout << "   wrong index " << index << " at " << s << ", " << j << std::endl;
+        return false;
+      }
+      seen[index] = true;
+    }
+    if(!ordered) {
+      std::sort(got.begin(), got.end(), order);
+    }
+    for(int64_t j = 0; j < k; j++) {
+      if(got[j] != all[j]) {
+        std::cout << "   wrong value " << got[j] << " at " << s << ", " << j
+                  << " instead of " << all[j] << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template<typename T>
+static bool bench_sort(TensorType type, const char* desc, int64_t rows, int64_t cols, int dim)
+{
+  const int64_t nrep = 3;
+  Tensor x = random<T>(type, rows, cols);
+  int64_t n = x.size(dim);
+  int64_t slices = rows*cols/n;
+  bool ok = true;
+  std::vector<std::pair<T, int64_t>> pairs(n);
+  const T* x_p = x.data<T>();
+  int64_t xs = x.stride(dim), xo = x.stride(1-dim);
+
+  std::cout << desc << ", " << rows << "x" << cols << " along " << dim << ":";
+  for(bool descending : {false, true}) {
+    Tensor r, ri;
+    double t = seconds(nrep, [&]() { sort_(r, ri, x, dim, descending ? kDescend : kAscend); });
+    double t_ref = seconds(nrep, [&]() {
+      for(int64_t s = 0; s < slices; s++) {
+        for(int64_t j = 0; j < n; j++) {
+          pairs[j] = std::make_pair(x_p[s*xo+j*xs], j);
+        }
+        if(descending) {
+          std::sort(pairs.begin(), pairs.end(), std::greater<std::pair<T, int64_t>>());
+        } else {
+          std::sort(pairs.begin(), pairs.end());
+        }
+      }
+    });
+    bool good = check<T>(x, r, ri, dim, n, descending, true);
+    ok = good && ok;
+    std::cout << (descending ? " descending " : " ascending ") << rows*cols/t*1e-6 << " Melem/s"
+              << " (std::sort " << rows*cols/t_ref*1e-6 << ", speedup " << t_ref/t << ")"
+              << (good ? "" : " FAILED");
+  }
+  std::cout << std::endl;
+  return ok;
+}
+
+template<typename T>
+static bool bench_topk(TensorType type, int64_t rows, int64_t cols, const std::vector<int64_t>& ks)
+{
+  const int64_t nrep = 3;
+  Tensor x = random<T>(type, rows, cols);
+  const T* x_p = x.data<T>();
+  bool ok = true;
+  std::vector<std::pair<T, int64_t>> pairs(cols);
+
+  std::cout << "topk, " << rows << "x" << cols << ":" << std::endl;
+  for(int64_t k : ks) {
+    for(bool largest : {true, false}) {
+      Tensor r, ri;
+      double t = seconds(nrep, [&]() { topk_(r, ri, x, k, 1, largest, true); });
+      double t_ref = seconds(nrep, [&]() {
+        for(int64_t s = 0; s < rows; s++) {
+          for(int64_t j = 0; j < cols; j++) {
+            pairs[j] = std::make_pair(x_p[s*cols+j], j);
+          }
+          if(largest) {
+            std::nth_element(pairs.begin(), pairs.begin()+k-1, pairs.end(), std::greater<std::pair<T, int64_t>>());
+            std::sort(pairs.begin(), pairs.begin()+k, std::greater<std::pair<T, int64_t>>());
+          } else {
+            std::nth_element(pairs.begin(), pairs.begin()+k-1, pairs.end());
+            std::sort(pairs.begin(), pairs.begin()+k);
+          }
+        }
+      });
+      bool good = check<T>(x, r, ri, 1, k, largest, true);
+      Tensor u, ui;
+      topk_(u, ui, x, k, 1, largest, false);
+      good = check<T>(x, u, ui, 1, k, largest, false) && good;
+      ok = good && ok;
+      std::cout << "   k=" << k << (largest ? " largest " : " smallest ")
+                << rows*cols/t*1e-6 << " Melem/s"
+                << " (nth_element " << rows*cols/t_ref*1e-6 << ", speedup " << t_ref/t << ")"
+                << (good ? "" : " FAILED") << std::endl;
+    }
+  }
+  return ok;
+}
+
+// NaNs come last in ascending order, first in descending order, and are
+// larger than everything for topk
+static bool check_nan(int64_t n)
+{
+  Tensor x = random<float>(kFloat, 1, n);
+  float* x_p = x.data<float>();
+  int64_t nnan = 0;
+  for(int64_t i = 0; i < n; i += 7) {
+    x_p[i] = NAN;
+    nnan++;
+  }
+  bool ok = true;
+  Tensor r, ri;
+  sort_(r, ri, x, 1, kAscend);
+  for(int64_t i = 0; i < n; i++) {
+    ok = ok && (std::isnan(r.data<float>()[i]) == (i >= n-nnan));
+    ok = ok && (i == 0 || i >= n-nnan || r.data<float>()[i-1] <= r.data<float>()[i]);
+  }
+  sort_(r, ri, x, 1, kDescend);
+  for(int64_t i = 0; i < n; i++) {
+    ok = ok && (std::isnan(r.data<float>()[i]) == (i < nnan));
+    ok = ok && (i <= nnan || r.data<float>()[i-1] >= r.data<float>()[i]);
+  }
+  for(int64_t k : {(int64_t)1, nnan/2, nnan+5, n}) {
+    topk_(r, ri, x, k, 1, true, true);
+    for(int64_t i = 0; i < k; i++) {
+      ok = ok && (std::isnan(r.data<float>()[i]) == (i < nnan));
+      ok = ok && std::isnan(x_p[ri.data<int64_t>()[i]]) == (i < nnan);
+    }
+    topk_(r, ri, x, k, 1, false, true);
+    for(int64_t i = 0; i < k; i++) {
+      ok = ok && (std::isnan(r.data<float>()[i]) == (i >= n-nnan));
+    }
+  }
+  std::cout << "NaNs, " << n << " elements: " << (ok ? "ok" : "FAILED") << std::endl;
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+  // single large slices
+  ok = bench_sort<float>(kFloat, "float", 1, 10000000, 1) && ok;
+  ok = bench_sort<double>(kDouble, "double", 1, 4000000, 1) && ok;
+  ok = bench_sort<int32_t>(kInt32, "int32", 1, 10000000, 1) && ok;
+  ok = bench_sort<int64_t>(kInt64, "int64", 1, 4000000, 1) && ok;
+  ok = bench_sort<int16_t>(kInt16, "int16", 1, 1000000, 1) && ok;
+  // many slices, contiguous or strided, short (quicksort) or long (radix)
+  ok = bench_sort<float>(kFloat, "float", 4096, 1024, 1) && ok;
+  ok = bench_sort<float>(kFloat, "float", 1024, 4096, 0) && ok;
+  ok = bench_sort<float>(kFloat, "float", 100000, 100, 1) && ok;
+  ok = bench_sort<int8_t>(kInt8, "int8", 1000, 5000, 1) && ok;
+
+  ok = bench_topk<float>(kFloat, 1, 10000000, {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000}) && ok;
+  ok = bench_topk<float>(kFloat, 256, 32000, {1, 5, 50, 500, 5000, 32000}) && ok;
+  ok = bench_topk<int32_t>(kInt32, 256, 32000, {1, 50, 32000}) && ok;
+
+  ok = check_nan(100) && ok;
+  ok = check_nan(1000000) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "xttensor.h"
+#include "bench.h"
+#include "TH.h"
+#undef THTensor
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace xt;
+
+// 512MB of records (256x256 floats, record r filled with r) read out of the
+// page cache in batches of 8, each followed by some work on the batch (sums,
+// as long as the read of a batch), best of 3 runs: on the compute thread with
+// THFile_readFloatRaw, and with a StreamReader (in turns), in order and
+// shuffled; the time of the reads which the work hides is reported
+// also checks the records of each batch, a pass with repeats and a short
+// last batch, a pass started over another and an empty index
+// returns 1 on a wrong result
+
+static const int64_t kRecords = 2048, kRows = 256, kCols = 256, kBatch = 8;
+
+static void evict(const std::string& filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// best of 3, each out of the page cache
+template<typename F>
+static double cold(const std::string& filename, F func)
+{
+  double t = 1e30;
+  for(int i = 0; i < 3; i++) {
+    evict(filename);
+    t = std::min(t, seconds(func));
+  }
+  return t;
+}
+
+// best of 3 of each of f and g, each out of the page cache, in turns (the
+// speed of the disk drifts over the run)
+template<typename F, typename G>
+static void cold(const std::string& filename, F f, G g, double& t_f, double& t_g)
+{
+  t_f = t_g = 1e30;
+  for(int i = 0; i < 3; i++) {
+    evict(filename);
+    t_f = std::min(t_f, seconds(f));
+    evict(filename);
+    t_g = std::min(t_g, seconds(g));
+  }
+}
+
+static double work(const Tensor& batch, int k)
+{
+  double s = 0;
+  for(int i = 0; i < k; i++) {
+    s += sum(batch).value<double>();
+  }
+  return s;
+}
+
+// the rows of batch b of the pass over index are their records
+static bool check(const Tensor& batch, const std::vector<int64_t>& index, int64_t b)
+{
+  int64_t rows = std::min(kBatch, (int64_t)index.size() - b*kBatch);
+  if(batch.size(0) != rows) {
+    return false;
+  }
+  const float* p = batch.data<float>();
+  const int64_t n = kRows*kCols;
+  for(int64_t i = 0; i < rows; i++) {
+    float r = (float)index[b*kBatch + i];
+    if(p[i*n] != r || p[i*n + n/2] != r || p[i*n + n-1] != r) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool pass(StreamReader& reader, const std::vector<int64_t>& index, int k, double& sink)
+{
+  bool good = true;
+  int64_t b = 0;
+  Tensor batch;
+  while(reader.next(batch)) {
+    good = check(batch, index, b++) && good;
+    sink += work(batch, k);
+  }
+  return good && b == ((int64_t)index.size() + kBatch-1)/kBatch;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+  const std::string filename = "xt-test.stream";
+  const int64_t n = kRows*kCols;
+  const int64_t batches = kRecords/kBatch;
+  const double mb = kRecords*n*sizeof(float)/double(1 << 20);
+
+  {
+    Tensor record({kRows, kCols}, kFloat);
+    THFile* file = THDiskFile_new(filename.c_str(), "w", 0);
+    THFile_binary(file);
+    for(int64_t r = 0; r < kRecords; r++) {
+      float* p = record.data<float>();
+      std::fill(p, p+n, (float)r);
+      THFile_writeFloatRaw(file, p, n);
+    }
+    THFile_close(file);
+    THFile_free(file);
+  }
+  std::vector<int64_t> ordered(kRecords), shuffled(kRecords);
+  for(int64_t r = 0; r < kRecords; r++) {
+    ordered[r] = r;
+  }
+  shuffled = ordered;
+  std::mt19937_64 random(42);
+  std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+  // the reads alone, on the compute thread: the records of each batch
+  // (seek and read for a shuffled pass)
+  Tensor batch({kBatch, kRows, kCols}, kFloat);
+  auto readAll = [&](const std::vector<int64_t>* index, int k, double& sink) {
+    THFile* file = THDiskFile_new(filename.c_str(), "r", 0);
+    THFile_binary(file);
+    for(int64_t b = 0; b < batches; b++) {
+      if(index) {
+        for(int64_t i = 0; i < kBatch; i++) {
+          THFile_seek(file, (*index)[b*kBatch + i]*n*sizeof(float));
+          THFile_readFloatRaw(file, batch.data<float>() + i*n, n);
+        }
+      } else {
+        THFile_readFloatRaw(file, batch.data<float>(), kBatch*n);
+      }
+      sink += work(batch, k);
+    }
+    THFile_close(file);
+    THFile_free(file);
+  };
+  double sink = 0;
+  double t_io = cold(filename, [&]() { readAll(nullptr, 0, sink); });
+  double t_io_shuffled = cold(filename, [&]() { readAll(&shuffled, 0, sink); });
+  // work as long as the shuffled reads
+  double t_sum = seconds([&]() { sink += work(batch, 16); })/16;
+  int k = std::max(1, (int)(t_io_shuffled/batches/t_sum + 0.5));
+  double t_work = cold(filename, [&]() { for(int64_t b = 0; b < batches; b++) { sink += work(batch, k); } });
+
+  StreamReader reader(filename, {kRows, kCols}, kFloat, kBatch);
+  bool good = reader.size() == kRecords;
+  double t_sync, t_stream, t_sync_shuffled, t_shuffled;
+  cold(filename, [&]() { readAll(nullptr, k, sink); }, [&]() {
+      reader.start();
+      good = pass(reader, ordered, k, sink) && good;
+    }, t_sync, t_stream);
+  cold(filename, [&]() { readAll(&shuffled, k, sink); }, [&]() {
+      reader.start(shuffled);
+      good = pass(reader, shuffled, k, sink) && good;
+    }, t_sync_shuffled, t_shuffled);
+
+  // repeats and a short last batch; a pass ended by another
+  std::vector<int64_t> some = {5, 5, 6, 7, 1000, 3, 4, 2047, 0, 1, 2, 17, 16};
+  reader.start(some);
+  good = pass(reader, some, 0, sink) && good;
+  reader.start();
+  Tensor first;
+  good = reader.next(first) && check(first, ordered, 0) && good;
+  reader.shuffle(7);
+  int64_t count = 0;
+  while(reader.next(first)) {
+    count += first.size(0);
+  }
+  good = (count == kRecords) && good;
+  reader.start(some);
+  good = pass(reader, some, 0, sink) && good;
+  // an empty index (a subset of nothing): no batch, not all the records
+  reader.start(std::vector<int64_t>());
+  good = !reader.next(first) && good;
+
+  // of the time of the reads, what the work hides
+  auto hidden = [&](double t, double io) { return 100*(io + t_work - t)/io; };
+  std::cout << "reads: in order " << mb/t_io << " MB/s, shuffled " << mb/t_io_shuffled << " MB/s; work "
+            << t_work << " s (" << k << " sums per batch)" << std::endl;
+  std::cout << "in order: reads then work " << t_sync << " s (" << hidden(t_sync, t_io) << "% of the reads hidden), "
+            << "StreamReader " << t_stream << " s (" << hidden(t_stream, t_io) << "%)" << std::endl;
+  std::cout << "shuffled: reads then work " << t_sync_shuffled << " s (" << hidden(t_sync_shuffled, t_io_shuffled)
+            << "%), StreamReader " << t_shuffled << " s (" << hidden(t_shuffled, t_io_shuffled) << "%)"
+            << (good ? "" : " FAILED") << std::endl;
+  ok = good && ok;
+  std::remove(filename.c_str());
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <functional>
+
+using namespace xt;
+
+// exp, log, tanh, sigmoid and rsqrt of contiguous float/double tensors go
+// through the SIMD kernels of THVector; their error is measured here in
+// units in the last place (ulp) against libm evaluated in a wider type, and
+// checked against the bounds documented in THVector.h
+// the scalar libm error is shown for reference
+// run with TH_NO_AVX2=1, TH_NO_AVX=1 and/or TH_NO_SSE=1 to check the other
+// implementations; returns 1 if a bound is exceeded
+
+struct Function
+{
+  const char* name;
+  double bound; // ulp
+  std::function<void(Tensor&, const Tensor&)> apply;
+  std::function<float(float)> libmf;
+  std::function<double(double)> libm;
+  std::function<long double(long double)> exact;
+};
+
+static const Function functions[] = {
+  {"exp", 1.5,
+   [](Tensor& r, const Tensor& x) { exp_(r, x); },
+   [](float x) { return std::exp(x); },
+   [](double x) { return std::exp(x); },
+   [](long double x) { return std::exp(x); }},
+  {"log", 1,
+   [](Tensor& r, const Tensor& x) { log_(r, x); },
+   [](float x) { return std::log(x); },
+   [](double x) { return std::log(x); },
+   [](long double x) { return std::log(x); }},
+  {"tanh", 2,
+   [](Tensor& r, const Tensor& x) { tanh_(r, x); },
+   [](float x) { return std::tanh(x); },
+   [](double x) { return std::tanh(x); },
+   [](long double x) { return std::tanh(x); }},
+  {"sigmoid", 3,
+   [](Tensor& r, const Tensor& x) { sigmoid_(r, x); },
+   [](float x) { return 1.0f/(1.0f+std::exp(-x)); },
+   [](double x) { return 1.0/(1.0+std::exp(-x)); },
+   [](long double x) { return x < 0 ? std::exp(x)/(1+std::exp(x)) : 1/(1+std::exp(-x)); }},
+  {"rsqrt", 1.5,
+   [](Tensor& r, const Tensor& x) { rsqrt_(r, x); },
+   [](float x) { return 1.0f/std::sqrt(x); },
+   [](double x) { return 1.0/std::sqrt(x); },
+   [](long double x) { return 1/std::sqrt(x); }}
+};
+
+// distance between y and the exact value, in ulp of the exact value
+// (subnormal ulp below the normal range)
+template<typename T>
+static double ulp_error(T y, long double exact)
+{
+  typedef std::numeric_limits<T> limits;
+  if(std::isnan(exact) || std::isnan(y)) {
+    return (std::isnan(exact) && std::isnan(y)) ? 0 : INFINITY;
+  }
+  if(std::fabs(exact) > (long double)limits::max()) {
+    // overflows in T: anything within 1 ulp of max rounds to inf
+    long double ulp = std::ldexp((long double)1, limits::max_exponent-limits::digits);
+    if(std::isinf(y)) {
+      return (std::signbit(y) == std::signbit(exact)) ? 0 : INFINITY;
+    }
+    return std::fabs(y-exact)/ulp;
+  }
+  if(std::isinf(y)) {
+    return INFINITY;
+  }
+  int e = (exact == 0) ? limits::min_exponent : std::ilogb(exact)+1;
+  if(e < limits::min_exponent) {
+    e = limits::min_exponent;
+  }
+  long double ulp = std::ldexp((long double)1, e-limits::digits);
+  return (double)(std::fabs((long double)y-exact)/ulp);
+}
+
+// float: every 257th bit pattern (all magnitudes, both signs, nans included)
+static Tensor float_inputs()
+{
+  const uint64_t stride = 257;
+  int64_t n = (int64_t)(((((uint64_t)1) << 32)+stride-1)/stride) + 6;
+  Tensor x = zeros({n}, kFloat);
+  float* x_p = x.data<float>();
+  int64_t i = 0;
+  for(uint64_t b = 0; b < (((uint64_t)1) << 32); b += stride) {
+    uint32_t bits = (uint32_t)b;
+    std::memcpy(&x_p[i++], &bits, sizeof(float));
+  }
+  const float special[] = {0.0f, -0.0f, INFINITY, -INFINITY, NAN, 1.0f};
+  for(float v : special) {
+    x_p[i++] = v;
+  }
+  return narrow(x, 0, 0, i);
+}
+
+// double: random bit patterns, plus uniform values where the functions vary
+static Tensor double_inputs()
+{
+  const int64_t n = 1 << 22;
+  Tensor x = zeros({n+6}, kDouble);
+  double* x_p = x.data<double>();
+  std::mt19937_64 gen(1);
+  std::uniform_real_distribution<double> uniform(-40, 40);
+  for(int64_t i = 0; i < n; i += 2) {
+    uint64_t bits = gen();
+    std::memcpy(&x_p[i], &bits, sizeof(double));
+    x_p[i+1] = uniform(gen);
+  }
+  const double special[] = {0.0, -0.0, INFINITY, -INFINITY, NAN, 1.0};
+  for(int64_t i = 0; i < 6; i++) {
+    x_p[n+i] = special[i];
+  }
+  return x;
+}
+
+template<typename T, typename L>
+static bool check(const Function& f, const Tensor& x, L libm)
+{
+  Tensor r;
+  f.apply(r, x);
+  int64_t n = numel(x);
+  const T* x_p = x.data<T>();
+  const T* r_p = r.data<T>();
+  double err = 0, err_libm = 0;
+  T worst = 0;
+  for(int64_t i = 0; i < n; i++) {
+    long double exact = f.exact(x_p[i]);
+    double e = ulp_error<T>(r_p[i], exact);
+    if(e > err) {
+      err = e;
+      worst = x_p[i];
+    }
+    err_libm = std::max(err_libm, ulp_error<T>(libm(x_p[i]), exact));
+  }
+
+  // throughput on values in a typical range
+  const int64_t m = 1 << 20;
+  bool positive = (strcmp(f.name, "log") == 0) || (strcmp(f.name, "rsqrt") == 0);
+  Tensor y = zeros({m}, x.type());
+  Tensor z = zeros({m}, x.type());
+  T* y_p = y.data<T>();
+  T* z_p = z.data<T>();
+  for(int64_t i = 0; i < m; i++) {
+    y_p[i] = positive ? (T)(i+1)/m*16 : (T)i/m*16-8;
+  }
+  double t_simd = seconds(20, [&]() { f.apply(z, y); });
+  double t_libm = seconds(20, [&]() {
+    for(int64_t i = 0; i < m; i++) {
+      z_p[i] = libm(y_p[i]);
+    }
+  });
+
+  bool ok = (err <= f.bound);
+  std::cout << "   " << f.name << ": max error " << err << " ulp"
+            << " (at " << worst << ", bound " << f.bound << ", libm " << err_libm << "), "
+            << m/t_simd*1e-6 << " Melem/s"
+            << " (libm " << m/t_libm*1e-6 << ")"
+            << (ok ? "" : " FAILED") << std::endl;
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(9);
+  {
+    std::cout << "float:" << std::endl;
+    Tensor x = float_inputs();
+    for(const Function& f : functions) {
+      ok = check<float>(f, x, f.libmf) && ok;
+    }
+  }
+  {
+    std::cout << "double:" << std::endl;
+    Tensor x = double_inputs();
+    for(const Function& f : functions) {
+      ok = check<double>(f, x, f.libm) && ok;
+    }
+  }
+  return ok ? 0 : 1;
+}
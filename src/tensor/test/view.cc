@@ -0,0 +1,90 @@
+#include "xttensor.h"
+#include "bench.h"
+#include <iostream>
+
+using namespace xt;
+
+// throughput of view creation (select, narrow, transpose, unfold of the TH
+// tensor header only, no data touched) on tensors of 2, 4 and 6 dimensions;
+// sizes and strides up to TH_TENSOR_INLINE_DIMS dimensions are kept in the
+// TH tensor, which makes a view a single allocation
+// then shape queries, sizes()/strides() (no copy) against size()/stride()
+// (std::vector), and resize to the current shape; also checks that braced
+// lists stored in an IntList stay valid
+// returns 1 on a wrong result
+
+static bool bench(const std::vector<int64_t>& sizes)
+{
+  const int64_t nrep = 1000000;
+  Tensor x = zeros(sizes, kFloat);
+  int64_t dim = x.dim();
+  int64_t n = sizes[0];
+  int64_t i = 0;
+  bool ok = true;
+
+  std::cout << dim << " dims:";
+  Tensor r;
+  double t = seconds(nrep, [&]() { r = select(x, 0, i++ % n); });
+  ok = (r.dim() == dim-1 || dim == 1) && ok;
+  std::cout << " select " << 1/t*1e-6 << " M/s";
+  t = seconds(nrep, [&]() { r = narrow(x, 0, i++ % (n-1), 1); });
+  ok = (r.dim() == dim && r.size(0) == 1) && ok;
+  std::cout << ", narrow " << 1/t*1e-6 << " M/s";
+  t = seconds(nrep, [&]() { r = transpose(x, 0, dim-1); });
+  ok = (r.size(0) == sizes[dim-1] && r.stride(dim-1) == x.stride(0)) && ok;
+  std::cout << ", transpose " << 1/t*1e-6 << " M/s";
+  t = seconds(nrep, [&]() { r = unfold(x, dim-1, 2, 1); });
+  ok = (r.dim() == dim+1 && r.size(dim) == 2) && ok;
+  std::cout << ", unfold " << 1/t*1e-6 << " M/s";
+
+  // rows of rows, as in a loop over a batch
+  int64_t count = 0;
+  t = seconds(10, [&]() {
+    for(int64_t j = 0; j < n; j++) {
+      Tensor row = select(x, 0, j);
+      for(int64_t k = 0; k < row.size(0); k++) {
+        count += numel(select(row, 0, k));
+      }
+    }
+  });
+  ok = (count == 11*numel(x)) && ok;
+  std::cout << ", nested select " << n*(sizes[1]+1)/t*1e-6 << " M/s" << (ok ? "" : " FAILED") << std::endl;
+  return ok;
+}
+
+static bool bench_shape()
+{
+  const int64_t nrep = 1000000;
+  Tensor x = zeros({64, 16, 8, 8}, kFloat);
+  int64_t n = 0, n_ref = 0;
+  double t = seconds(nrep, [&]() {
+    IntList sizes = x.sizes(), strides = x.strides();
+    n += sizes[0]*strides[0];
+  });
+  double t_ref = seconds(nrep, [&]() {
+    std::vector<int64_t> sizes = x.size(), strides = x.stride();
+    n_ref += sizes[0]*strides[0];
+  });
+  bool ok = (n == n_ref) && (x.sizes() == IntList({64, 16, 8, 8})) && (x.strides() == x.stride());
+  std::cout << "shape: sizes()+strides() " << t*1e9 << " ns (size()+stride() " << t_ref*1e9 << " ns)";
+  t = seconds(nrep, [&]() { x.resize({64, 16, 8, 8}); });
+  ok = (x.size() == std::vector<int64_t>{64, 16, 8, 8}) && ok;
+  // a braced list is held by the IntList, which can be stored and copied
+  IntList shape = {32, 32, 64};
+  IntList copy = shape;
+  Tensor y = zeros(copy, kFloat);
+  ok = (y.sizes() == shape) && (copy == std::vector<int64_t>{32, 32, 64}) && ok;
+  std::cout << ", resize to the same shape " << t*1e9 << " ns" << (ok ? "" : " FAILED") << std::endl;
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  std::cout.precision(4);
+  ok = bench({1000, 100}) && ok;
+  ok = bench({64, 16, 8, 8}) && ok;
+  ok = bench({16, 16, 2, 2, 2, 2}) && ok; // above TH_TENSOR_INLINE_DIMS: on the heap
+  ok = bench_shape() && ok;
+  return ok ? 0 : 1;
+}
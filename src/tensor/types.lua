@@ -151,6 +151,9 @@ for _, device in ipairs{"cpu", "gpu"} do
       end
       function Tensor:read()
          local txt = {}
+         if self.returned then -- output tensor: allocated on first use, then reused
+            table.insert(txt, string.format("if(%s.device() == kUnknown) { %s.resize(%s, k%s); }", self:ccarg(), self:ccarg(), ttype.xt, device:upper()))
+         end
          table.insert(txt, string.format("TH%sTensor *%s = %s.THTensor<TH%sTensor>();", subname, self:carg(), self:ccarg(), subname))
          if self.dim then
             table.insert(txt, string.format('if(TH%sTensor_nDimension(%s%s) != %s) { throw std::invalid_argument("%d-dim tensor expected"); }', subname, device == "cpu" and "" or "thcstate(), ", self:carg(), self.dim, self.dim))
@@ -190,19 +193,16 @@ local LongArg = {}
 types.mt.LongArg = LongArg
 
 function LongArg:decl()
-   return string.format("std::vector<int64_t> %s", self:ccarg())
+   return string.format("IntList %s", self:ccarg())
 end
 
+-- storage on the caller's memory (see THLongStorage_view__): no allocation
 function LongArg:read()
-   local txt = {}
---   std::unique_ptr<THLongStorage>
-   table.insert(txt, string.format("auto %s = std::unique_ptr<THLongStorage, std::function<void (THLongStorage*)>>(THLongStorage_newWithSize(%s.size()), THLongStorage_free);", self:carg(), self:ccarg()));
-   table.insert(txt, string.format("for(uint64_t i = 0; i < %s.size(); i++) { %s->data[i] = %s[i]; };", self:ccarg(), self:carg(), self:ccarg()))
-   return table.concat(txt, "\n")
+   return string.format("THLongStorage %s = THLongStorage_view__(%s);", self:carg(), self:ccarg())
 end
 
 function LongArg:call()
-   return string.format("%s.get()", self:carg())
+   return string.format("&%s", self:carg())
 end
 
 function LongArg:signature()
@@ -1,3 +1,8 @@
 #include "xt/Tensor.h"
 #include "xt/TensorTH.h"
 #include "xt/dispatch.h"
+#include "xt/Expression.h"
+#include "xt/Arena.h"
+#include "xt/Archive.h"
+#include "xt/Stream.h"
+#include "xt/SharedPool.h"